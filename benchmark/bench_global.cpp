@@ -0,0 +1,136 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bench_global.hpp"
+
+#include <orcus/json_global.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+
+namespace orcus { namespace bench {
+
+stop_watch::stop_watch() : m_start(std::chrono::steady_clock::now()) {}
+
+void stop_watch::restart()
+{
+    m_start = std::chrono::steady_clock::now();
+}
+
+double stop_watch::elapsed() const
+{
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - m_start;
+    return d.count();
+}
+
+stack_printer::stack_printer(const char* msg) : m_msg(msg)
+{
+    std::fprintf(stdout, "%s: --begin\n", m_msg.c_str());
+    m_watch.restart();
+}
+
+stack_printer::~stack_printer()
+{
+    double duration = m_watch.elapsed();
+    std::fprintf(stdout, "%s: --end (duration: %g sec)\n", m_msg.c_str(), duration);
+}
+
+sample_stats compute_stats(std::vector<double> samples)
+{
+    sample_stats ret;
+    if (samples.empty())
+        return ret;
+
+    std::sort(samples.begin(), samples.end());
+
+    ret.count = samples.size();
+    ret.min = samples.front();
+    ret.max = samples.back();
+    ret.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / ret.count;
+
+    size_t mid = ret.count / 2;
+    ret.median = (ret.count % 2) ? samples[mid] : (samples[mid-1] + samples[mid]) / 2.0;
+
+    return ret;
+}
+
+void results::add(
+    const std::string& input, const std::string& format, size_t input_size,
+    const std::string& phase, std::vector<double> samples)
+{
+    m_entries.push_back({input, format, input_size, phase, std::move(samples)});
+}
+
+bool results::empty() const
+{
+    return m_entries.empty();
+}
+
+void results::print(std::ostream& os) const
+{
+    std::string prev_input;
+
+    for (const entry& e : m_entries)
+    {
+        if (e.input != prev_input)
+        {
+            os << e.input << " (" << e.format << ", " << e.input_size << " bytes)" << std::endl;
+            prev_input = e.input;
+        }
+
+        sample_stats stats = compute_stats(e.samples);
+        os << "  " << std::left << std::setw(12) << e.phase << std::right
+           << " min: " << std::setw(10) << stats.min
+           << " median: " << std::setw(10) << stats.median
+           << " mean: " << std::setw(10) << stats.mean
+           << " max: " << std::setw(10) << stats.max
+           << " (sec, n=" << stats.count << ")" << std::endl;
+    }
+}
+
+void results::write_json(std::ostream& os) const
+{
+    os << "{\"results\": [";
+
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        const entry& e = *it;
+        sample_stats stats = compute_stats(e.samples);
+
+        if (it != m_entries.begin())
+            os << ',';
+
+        os << std::endl;
+        os << "  {\"input\": \"" << json::escape_string(e.input) << "\", ";
+        os << "\"format\": \"" << e.format << "\", ";
+        os << "\"size\": " << e.input_size << ", ";
+        os << "\"phase\": \"" << e.phase << "\", ";
+        os << "\"min\": " << stats.min << ", ";
+        os << "\"median\": " << stats.median << ", ";
+        os << "\"mean\": " << stats.mean << ", ";
+        os << "\"max\": " << stats.max << ", ";
+        os << "\"samples\": [";
+
+        for (size_t i = 0; i < e.samples.size(); ++i)
+        {
+            if (i)
+                os << ", ";
+            os << e.samples[i];
+        }
+
+        os << "]}";
+    }
+
+    os << std::endl << "]}" << std::endl;
+}
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
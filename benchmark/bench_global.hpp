@@ -0,0 +1,101 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_BENCHMARK_BENCH_GLOBAL_HPP
+#define INCLUDED_ORCUS_BENCHMARK_BENCH_GLOBAL_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+namespace orcus { namespace bench {
+
+/**
+ * Monotonic timer that measures the wall-clock time elapsed since its
+ * construction or its last restart.
+ */
+class stop_watch
+{
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    stop_watch();
+
+    void restart();
+
+    /**
+     * @return elapsed time in seconds.
+     */
+    double elapsed() const;
+};
+
+/**
+ * Prints the duration of the enclosing scope to stdout upon destruction.
+ */
+class stack_printer
+{
+    std::string m_msg;
+    stop_watch m_watch;
+
+public:
+    explicit stack_printer(const char* msg);
+    ~stack_printer();
+};
+
+struct sample_stats
+{
+    size_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double median = 0.0;
+};
+
+sample_stats compute_stats(std::vector<double> samples);
+
+/**
+ * Collection of timing results, each of which records the samples of a
+ * single phase (import, or one of the dumpers) run against one input.
+ */
+class results
+{
+    struct entry
+    {
+        std::string input;
+        std::string format;
+        size_t input_size;
+        std::string phase;
+        std::vector<double> samples;
+    };
+
+    std::vector<entry> m_entries;
+
+public:
+    void add(
+        const std::string& input, const std::string& format, size_t input_size,
+        const std::string& phase, std::vector<double> samples);
+
+    bool empty() const;
+
+    /**
+     * Print a human-readable summary, one line per phase.
+     */
+    void print(std::ostream& os) const;
+
+    /**
+     * Write all results as a single JSON object, suitable for consumption
+     * by automated tools.
+     */
+    void write_json(std::ostream& os) const;
+};
+
+}}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,231 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bench_global.hpp"
+
+#include <orcus/spreadsheet/document.hpp>
+#include <orcus/spreadsheet/sheet.hpp>
+#include <orcus/pstring.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <functional>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+using namespace orcus;
+
+namespace po = boost::program_options;
+
+namespace {
+
+const char* help_program =
+"Time the setting and getting of cell formats in a sheet, using the access "
+"patterns typical of spreadsheet imports.";
+
+const char* help_repeat =
+"Number of times to repeat each timed phase.";
+
+const char* help_rows =
+"Number of rows to format.";
+
+const char* help_cols =
+"Number of columns to format.";
+
+const char* help_output =
+"Path to a file to write the results to, in JSON format.";
+
+using spreadsheet::row_t;
+using spreadsheet::col_t;
+
+struct bench_config
+{
+    size_t repeat = 5;
+    row_t rows = 100000;
+    col_t cols = 20;
+};
+
+/**
+ * Each pattern sets the formats of a sheet in one particular way.
+ */
+struct pattern
+{
+    const char* name;
+    std::function<void(const bench_config&, spreadsheet::sheet&)> set;
+};
+
+std::vector<pattern> patterns = {
+    {
+        // Cell-by-cell in row order, with each column having its own format
+        // that only changes every so often.  This is what the s attribute of
+        // the c elements in an xlsx sheet typically looks like.
+        "row-major-cells",
+        [](const bench_config& config, spreadsheet::sheet& sh)
+        {
+            for (row_t row = 0; row < config.rows; ++row)
+                for (col_t col = 0; col < config.cols; ++col)
+                    sh.set_format(row, col, 1 + col % 4 + (row / 100) % 2);
+        }
+    },
+    {
+        // Cell-by-cell in row order, with alternating formats in each row.
+        "row-major-striped",
+        [](const bench_config& config, spreadsheet::sheet& sh)
+        {
+            for (row_t row = 0; row < config.rows; ++row)
+                for (col_t col = 0; col < config.cols; ++col)
+                    sh.set_format(row, col, 1 + (row + col) % 2);
+        }
+    },
+    {
+        // Entire columns at once, as with column formats.
+        "column-ranges",
+        [](const bench_config& config, spreadsheet::sheet& sh)
+        {
+            for (col_t col = 0; col < config.cols; ++col)
+                sh.set_format(0, col, config.rows - 1, col, 1 + col % 4);
+        }
+    },
+    {
+        // Scattered single cells across the full width of the sheet.
+        "scattered",
+        [](const bench_config& config, spreadsheet::sheet& sh)
+        {
+            std::mt19937 gen(0);
+            std::uniform_int_distribution<row_t> row_dist(0, config.rows - 1);
+            std::uniform_int_distribution<col_t> col_dist(0, 16383);
+
+            size_t n = size_t(config.rows) * config.cols / 100;
+            for (size_t i = 0; i < n; ++i)
+                sh.set_format(row_dist(gen), col_dist(gen), 1 + i % 8);
+        }
+    },
+};
+
+std::vector<double> time_runs(size_t repeat, const std::function<void()>& func)
+{
+    std::vector<double> samples;
+    samples.reserve(repeat);
+
+    for (size_t i = 0; i < repeat; ++i)
+    {
+        bench::stop_watch sw;
+        func();
+        samples.push_back(sw.elapsed());
+    }
+
+    return samples;
+}
+
+void run_pattern(const bench_config& config, const pattern& pat, bench::results& res)
+{
+    spreadsheet::range_size_t ss{1048576, 16384};
+    std::unique_ptr<spreadsheet::document> doc;
+    spreadsheet::sheet* sh = nullptr;
+
+    size_t cell_count = size_t(config.rows) * config.cols;
+
+    std::vector<double> samples = time_runs(config.repeat,
+        [&]()
+        {
+            doc = std::make_unique<spreadsheet::document>(ss);
+            sh = doc->append_sheet(pstring("Sheet1"));
+            pat.set(config, *sh);
+        }
+    );
+
+    res.add(pat.name, "cell-format", cell_count, "set", std::move(samples));
+
+    // Query every cell in row order, as the dumpers do.
+    size_t sum = 0;
+    samples = time_runs(config.repeat,
+        [&]()
+        {
+            for (row_t row = 0; row < config.rows; ++row)
+                for (col_t col = 0; col < config.cols; ++col)
+                    sum += sh->get_cell_format(row, col);
+        }
+    );
+
+    res.add(pat.name, "cell-format", cell_count, "get", std::move(samples));
+
+    // Make sure the queries don't get optimized away.
+    if (!sum)
+        cerr << pat.name << ": no formatted cells found in the queried range." << endl;
+}
+
+}
+
+int main(int argc, char** argv) try
+{
+    po::options_description desc("Options");
+    desc.add_options()
+        ("help,h", "Print this help.")
+        ("repeat,n", po::value<size_t>()->default_value(5), help_repeat)
+        ("rows", po::value<row_t>()->default_value(100000), help_rows)
+        ("cols", po::value<col_t>()->default_value(20), help_cols)
+        ("output,o", po::value<std::string>(), help_output);
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+        po::notify(vm);
+    }
+    catch (const std::exception& e)
+    {
+        // Unknown options.
+        cerr << e.what() << endl;
+        cerr << desc;
+        return EXIT_FAILURE;
+    }
+
+    if (vm.count("help"))
+    {
+        cout << "Usage: cell-format-bench [options]" << endl << endl;
+        cout << help_program << endl << endl << desc;
+        return EXIT_SUCCESS;
+    }
+
+    bench_config config;
+    config.repeat = std::max<size_t>(vm["repeat"].as<size_t>(), 1);
+    config.rows = std::max<row_t>(vm["rows"].as<row_t>(), 1);
+    config.cols = std::max<col_t>(vm["cols"].as<col_t>(), 1);
+
+    bench::results res;
+
+    for (const pattern& pat : patterns)
+        run_pattern(config, pat, res);
+
+    res.print(cout);
+
+    if (vm.count("output"))
+    {
+        std::string outpath = vm["output"].as<std::string>();
+        std::ofstream of(outpath.data());
+        if (!of)
+        {
+            cerr << "failed to open " << outpath << " for writing." << endl;
+            return EXIT_FAILURE;
+        }
+
+        res.write_json(of);
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e)
+{
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
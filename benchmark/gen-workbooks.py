@@ -0,0 +1,417 @@
+#!/usr/bin/env python3
+########################################################################
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+########################################################################
+
+"""Generate synthetic workbooks for the import benchmarks.
+
+The same content is written in every format supported by the benchmark
+driver, so that the timings of the different import filters can be compared
+against each other.  The content is fully determined by the command-line
+arguments; running the script twice with the same arguments produces
+byte-identical files.
+"""
+
+import argparse
+import gzip
+import io
+import os
+import random
+import sys
+import zipfile
+from xml.sax.saxutils import escape, quoteattr
+
+
+# Fixed timestamp for all zip entries, to keep the output reproducible.
+ZIP_DATE_TIME = (1980, 1, 1, 0, 0, 0)
+
+
+def col_name(col):
+    """Convert a 0-based column index to its A1-style column name."""
+    s = ""
+    col += 1
+    while col:
+        col, rem = divmod(col - 1, 26)
+        s = chr(ord('A') + rem) + s
+    return s
+
+
+class Cell(object):
+
+    STRING = 0
+    NUMBER = 1
+    FORMULA = 2
+
+    def __init__(self, type, value, formula=None):
+        self.type = type
+        self.value = value  # string value, or number for number & formula cells
+        self.formula = formula  # formula expression without the leading '='
+
+
+class Workbook(object):
+    """Synthetic workbook content.
+
+    Each sheet is a dense block of rows x cols cells.  The first row is a
+    header row of strings.  Each remaining cell is a string, a number or a
+    formula referencing the cell immediately above it, with the ratio of each
+    type controlled by the arguments.  String values are drawn from a pool of
+    a limited number of unique values, so that shared strings get exercised.
+    """
+
+    def __init__(self, args):
+        rng = random.Random(args.seed)
+        self.rows = args.rows
+        self.cols = args.cols
+        self.strings = ["str-{:06d}-{}".format(i, rng.choice(["alpha", "beta", "gamma", "delta"]))
+                        for i in range(args.unique_strings)]
+        self.sheets = list()
+
+        for sheet_index in range(args.sheets):
+            name = "Sheet{}".format(sheet_index + 1)
+            rows = list()
+            rows.append([Cell(Cell.STRING, "Column {}".format(col_name(c))) for c in range(args.cols)])
+
+            for r in range(1, args.rows):
+                row = list()
+                for c in range(args.cols):
+                    v = rng.random()
+                    if v < args.string_ratio:
+                        row.append(Cell(Cell.STRING, rng.choice(self.strings)))
+                    elif r > 1 and v < args.string_ratio + args.formula_ratio:
+                        above = rows[-1][c]
+                        base = above.value if above.type != Cell.STRING else 0.0
+                        # The cached result is computed here so that no
+                        # recalculation is needed to get the same values.
+                        row.append(Cell(Cell.FORMULA, base + 1.0, "{}{}+1".format(col_name(c), r)))
+                    else:
+                        row.append(Cell(Cell.NUMBER, float(rng.randint(0, 999999)) / 100.0))
+                rows.append(row)
+
+            self.sheets.append((name, rows))
+
+    @staticmethod
+    def format_number(v):
+        return repr(v)
+
+
+def write_zip(path, entries):
+    with zipfile.ZipFile(path, "w") as zf:
+        for name, content, compress in entries:
+            info = zipfile.ZipInfo(name, date_time=ZIP_DATE_TIME)
+            info.compress_type = zipfile.ZIP_DEFLATED if compress else zipfile.ZIP_STORED
+            zf.writestr(info, content)
+
+
+def write_xlsx(wb, path):
+    sst_index = dict()
+    sst = list()
+    for _, rows in wb.sheets:
+        for row in rows:
+            for cell in row:
+                if cell.type == Cell.STRING and cell.value not in sst_index:
+                    sst_index[cell.value] = len(sst)
+                    sst.append(cell.value)
+
+    entries = list()
+
+    ct = io.StringIO()
+    ct.write('<?xml version="1.0" encoding="UTF-8" standalone="yes"?>\n')
+    ct.write('<Types xmlns="http://schemas.openxmlformats.org/package/2006/content-types">')
+    ct.write('<Default Extension="rels" ContentType="application/vnd.openxmlformats-package.relationships+xml"/>')
+    ct.write('<Default Extension="xml" ContentType="application/xml"/>')
+    ct.write('<Override PartName="/xl/workbook.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml"/>')
+    for i in range(len(wb.sheets)):
+        ct.write('<Override PartName="/xl/worksheets/sheet{}.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml"/>'.format(i + 1))
+    ct.write('<Override PartName="/xl/sharedStrings.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml"/>')
+    ct.write('</Types>')
+    entries.append(("[Content_Types].xml", ct.getvalue(), True))
+
+    entries.append(("_rels/.rels",
+        '<?xml version="1.0" encoding="UTF-8" standalone="yes"?>\n'
+        '<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">'
+        '<Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="xl/workbook.xml"/>'
+        '</Relationships>', True))
+
+    wbx = io.StringIO()
+    wbx.write('<?xml version="1.0" encoding="UTF-8" standalone="yes"?>\n')
+    wbx.write('<workbook xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" '
+              'xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships"><sheets>')
+    for i, (name, _) in enumerate(wb.sheets):
+        wbx.write('<sheet name={} sheetId="{}" r:id="rId{}"/>'.format(quoteattr(name), i + 1, i + 1))
+    wbx.write('</sheets></workbook>')
+    entries.append(("xl/workbook.xml", wbx.getvalue(), True))
+
+    rels = io.StringIO()
+    rels.write('<?xml version="1.0" encoding="UTF-8" standalone="yes"?>\n')
+    rels.write('<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">')
+    for i in range(len(wb.sheets)):
+        rels.write('<Relationship Id="rId{}" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet" '
+                   'Target="worksheets/sheet{}.xml"/>'.format(i + 1, i + 1))
+    rels.write('<Relationship Id="rId{}" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings" '
+               'Target="sharedStrings.xml"/>'.format(len(wb.sheets) + 1))
+    rels.write('</Relationships>')
+    entries.append(("xl/_rels/workbook.xml.rels", rels.getvalue(), True))
+
+    for i, (_, rows) in enumerate(wb.sheets):
+        sx = io.StringIO()
+        sx.write('<?xml version="1.0" encoding="UTF-8" standalone="yes"?>\n')
+        sx.write('<worksheet xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main">')
+        sx.write('<dimension ref="A1:{}{}"/><sheetData>'.format(col_name(wb.cols - 1), wb.rows))
+        for r, row in enumerate(rows):
+            sx.write('<row r="{}">'.format(r + 1))
+            for c, cell in enumerate(row):
+                ref = "{}{}".format(col_name(c), r + 1)
+                if cell.type == Cell.STRING:
+                    sx.write('<c r="{}" t="s"><v>{}</v></c>'.format(ref, sst_index[cell.value]))
+                elif cell.type == Cell.NUMBER:
+                    sx.write('<c r="{}"><v>{}</v></c>'.format(ref, Workbook.format_number(cell.value)))
+                else:
+                    sx.write('<c r="{}"><f>{}</f><v>{}</v></c>'.format(
+                        ref, cell.formula, Workbook.format_number(cell.value)))
+            sx.write('</row>')
+        sx.write('</sheetData></worksheet>')
+        entries.append(("xl/worksheets/sheet{}.xml".format(i + 1), sx.getvalue(), True))
+
+    ss = io.StringIO()
+    ss.write('<?xml version="1.0" encoding="UTF-8" standalone="yes"?>\n')
+    ss.write('<sst xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" uniqueCount="{}">'.format(len(sst)))
+    for s in sst:
+        ss.write('<si><t>{}</t></si>'.format(escape(s)))
+    ss.write('</sst>')
+    entries.append(("xl/sharedStrings.xml", ss.getvalue(), True))
+
+    write_zip(path, entries)
+
+
+def write_ods(wb, path):
+    entries = list()
+    entries.append(("mimetype", "application/vnd.oasis.opendocument.spreadsheet", False))
+    entries.append(("META-INF/manifest.xml",
+        '<?xml version="1.0" encoding="UTF-8"?>\n'
+        '<manifest:manifest xmlns:manifest="urn:oasis:names:tc:opendocument:xmlns:manifest:1.0" manifest:version="1.2">'
+        '<manifest:file-entry manifest:full-path="/" manifest:media-type="application/vnd.oasis.opendocument.spreadsheet"/>'
+        '<manifest:file-entry manifest:full-path="content.xml" manifest:media-type="text/xml"/>'
+        '</manifest:manifest>', True))
+
+    cx = io.StringIO()
+    cx.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+    cx.write('<office:document-content '
+             'xmlns:office="urn:oasis:names:tc:opendocument:xmlns:office:1.0" '
+             'xmlns:table="urn:oasis:names:tc:opendocument:xmlns:table:1.0" '
+             'xmlns:text="urn:oasis:names:tc:opendocument:xmlns:text:1.0" '
+             'xmlns:of="urn:oasis:names:tc:opendocument:xmlns:of:1.2" '
+             'office:version="1.2"><office:body><office:spreadsheet>')
+    for name, rows in wb.sheets:
+        cx.write('<table:table table:name={}>'.format(quoteattr(name)))
+        for r, row in enumerate(rows):
+            cx.write('<table:table-row>')
+            for c, cell in enumerate(row):
+                if cell.type == Cell.STRING:
+                    cx.write('<table:table-cell office:value-type="string"><text:p>{}</text:p></table:table-cell>'.format(
+                        escape(cell.value)))
+                elif cell.type == Cell.NUMBER:
+                    v = Workbook.format_number(cell.value)
+                    cx.write('<table:table-cell office:value-type="float" office:value="{}"><text:p>{}</text:p></table:table-cell>'.format(v, v))
+                else:
+                    v = Workbook.format_number(cell.value)
+                    cx.write('<table:table-cell table:formula="of:=[.{}{}]+1" office:value-type="float" office:value="{}">'
+                             '<text:p>{}</text:p></table:table-cell>'.format(col_name(c), r, v, v))
+            cx.write('</table:table-row>')
+        cx.write('</table:table>')
+    cx.write('</office:spreadsheet></office:body></office:document-content>')
+    entries.append(("content.xml", cx.getvalue(), True))
+
+    write_zip(path, entries)
+
+
+def write_xls_xml(wb, path):
+    with open(path, "w", encoding="utf-8") as f:
+        f.write('<?xml version="1.0"?>\n')
+        f.write('<Workbook xmlns="urn:schemas-microsoft-com:office:spreadsheet"\n'
+                ' xmlns:ss="urn:schemas-microsoft-com:office:spreadsheet">\n')
+        for name, rows in wb.sheets:
+            f.write(' <Worksheet ss:Name={}>\n'.format(quoteattr(name)))
+            f.write('  <Table ss:ExpandedColumnCount="{}" ss:ExpandedRowCount="{}">\n'.format(wb.cols, wb.rows))
+            for row in rows:
+                f.write('   <Row>')
+                for cell in row:
+                    if cell.type == Cell.STRING:
+                        f.write('<Cell><Data ss:Type="String">{}</Data></Cell>'.format(escape(cell.value)))
+                    elif cell.type == Cell.NUMBER:
+                        f.write('<Cell><Data ss:Type="Number">{}</Data></Cell>'.format(
+                            Workbook.format_number(cell.value)))
+                    else:
+                        f.write('<Cell ss:Formula="=R[-1]C+1"><Data ss:Type="Number">{}</Data></Cell>'.format(
+                            Workbook.format_number(cell.value)))
+                f.write('</Row>\n')
+            f.write('  </Table>\n')
+            f.write(' </Worksheet>\n')
+        f.write('</Workbook>\n')
+
+
+def write_gnumeric(wb, path):
+    buf = io.StringIO()
+    buf.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+    buf.write('<gnm:Workbook xmlns:gnm="http://www.gnumeric.org/v10.dtd">\n')
+    buf.write('  <gnm:SheetNameIndex>\n')
+    for name, _ in wb.sheets:
+        buf.write('    <gnm:SheetName>{}</gnm:SheetName>\n'.format(escape(name)))
+    buf.write('  </gnm:SheetNameIndex>\n')
+    buf.write('  <gnm:Sheets>\n')
+    for name, rows in wb.sheets:
+        buf.write('    <gnm:Sheet>\n')
+        buf.write('      <gnm:Name>{}</gnm:Name>\n'.format(escape(name)))
+        buf.write('      <gnm:MaxCol>{}</gnm:MaxCol>\n'.format(wb.cols - 1))
+        buf.write('      <gnm:MaxRow>{}</gnm:MaxRow>\n'.format(wb.rows - 1))
+        buf.write('      <gnm:Cells>\n')
+        for r, row in enumerate(rows):
+            for c, cell in enumerate(row):
+                if cell.type == Cell.STRING:
+                    buf.write('        <gnm:Cell Row="{}" Col="{}" ValueType="60">{}</gnm:Cell>\n'.format(
+                        r, c, escape(cell.value)))
+                elif cell.type == Cell.NUMBER:
+                    buf.write('        <gnm:Cell Row="{}" Col="{}" ValueType="40">{}</gnm:Cell>\n'.format(
+                        r, c, Workbook.format_number(cell.value)))
+                else:
+                    buf.write('        <gnm:Cell Row="{}" Col="{}">={}</gnm:Cell>\n'.format(r, c, cell.formula))
+        buf.write('      </gnm:Cells>\n')
+        buf.write('    </gnm:Sheet>\n')
+    buf.write('  </gnm:Sheets>\n')
+    buf.write('</gnm:Workbook>\n')
+
+    # mtime is fixed so that the gzip header does not vary between runs.
+    with open(path, "wb") as f:
+        with gzip.GzipFile(filename="", mode="wb", fileobj=f, mtime=0) as gz:
+            gz.write(buf.getvalue().encode("utf-8"))
+
+
+def write_csv(wb, path):
+    # CSV holds only one sheet, and has no notion of formulas.
+    _, rows = wb.sheets[0]
+    with open(path, "w", encoding="utf-8", newline="") as f:
+        for row in rows:
+            values = list()
+            for cell in row:
+                if cell.type == Cell.STRING:
+                    values.append('"{}"'.format(cell.value.replace('"', '""')))
+                else:
+                    values.append(Workbook.format_number(cell.value))
+            f.write(",".join(values))
+            f.write("\n")
+
+
+def write_json(wb, path):
+    # The records of the first sheet, as an array of objects keyed by the
+    # header values.  This maps to a single range on import.
+    _, rows = wb.sheets[0]
+    header = [cell.value for cell in rows[0]]
+
+    with open(path, "w", encoding="utf-8") as f:
+        f.write('{"records": [\n')
+        for i, row in enumerate(rows[1:]):
+            fields = list()
+            for key, cell in zip(header, row):
+                if cell.type == Cell.STRING:
+                    v = '"{}"'.format(cell.value)
+                else:
+                    v = Workbook.format_number(cell.value)
+                fields.append('"{}": {}'.format(key, v))
+            f.write("  {")
+            f.write(", ".join(fields))
+            f.write("}")
+            f.write(",\n" if i < len(rows) - 2 else "\n")
+        f.write("]}\n")
+
+
+def write_yaml(wb, path):
+    _, rows = wb.sheets[0]
+    header = [cell.value for cell in rows[0]]
+
+    with open(path, "w", encoding="utf-8") as f:
+        f.write("records:\n")
+        for row in rows[1:]:
+            prefix = "  - "
+            for key, cell in zip(header, row):
+                if cell.type == Cell.STRING:
+                    v = '"{}"'.format(cell.value)
+                else:
+                    v = Workbook.format_number(cell.value)
+                f.write('{}{}: {}\n'.format(prefix, key, v))
+                prefix = "    "
+
+
+def write_xml_mapped(wb, path, map_path):
+    _, rows = wb.sheets[0]
+
+    with open(path, "w", encoding="utf-8") as f:
+        f.write('<?xml version="1.0"?>\n')
+        f.write('<data>\n')
+        f.write('  <records>\n')
+        for row in rows[1:]:
+            f.write('    <record>')
+            for c, cell in enumerate(row):
+                if cell.type == Cell.STRING:
+                    v = escape(cell.value)
+                else:
+                    v = Workbook.format_number(cell.value)
+                f.write('<f{}>{}</f{}>'.format(c, v, c))
+            f.write('</record>\n')
+        f.write('  </records>\n')
+        f.write('</data>\n')
+
+    with open(map_path, "w", encoding="utf-8") as f:
+        f.write('<?xml version="1.0"?>\n')
+        f.write('<map xmlns="http://gitorious.org/orcus/xml-map">\n')
+        f.write('    <sheet name="data"/>\n')
+        f.write('    <range sheet="data" row="0" column="0">\n')
+        for c in range(wb.cols):
+            f.write('        <field path="/data/records/record/f{}"/>\n'.format(c))
+        f.write('        <row-group path="/data/records/record"/>\n')
+        f.write('    </range>\n')
+        f.write('</map>\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate synthetic workbooks in all formats used by the import benchmarks.")
+    parser.add_argument("--sheets", type=int, default=2, help="Number of sheets.")
+    parser.add_argument("--rows", type=int, default=10000, help="Number of rows per sheet, including the header row.")
+    parser.add_argument("--cols", type=int, default=20, help="Number of columns per sheet.")
+    parser.add_argument("--string-ratio", type=float, default=0.3, help="Ratio of string cells.")
+    parser.add_argument("--formula-ratio", type=float, default=0.1, help="Ratio of formula cells.")
+    parser.add_argument("--unique-strings", type=int, default=1000, help="Number of unique string values.")
+    parser.add_argument("--seed", type=int, default=0, help="Seed for the random number generator.")
+    parser.add_argument("--prefix", type=str, default="bench", help="File name prefix of the generated files.")
+    parser.add_argument("outdir", type=str, help="Directory to write the generated files to.")
+    args = parser.parse_args()
+
+    if args.sheets < 1 or args.rows < 2 or args.cols < 1 or args.unique_strings < 1:
+        print("at least 1 sheet, 2 rows, 1 column and 1 unique string are required.", file=sys.stderr)
+        sys.exit(1)
+
+    if args.string_ratio + args.formula_ratio > 1.0:
+        print("the sum of the string and formula ratios must not exceed 1.", file=sys.stderr)
+        sys.exit(1)
+
+    os.makedirs(args.outdir, exist_ok=True)
+    wb = Workbook(args)
+
+    def outpath(suffix):
+        return os.path.join(args.outdir, args.prefix + suffix)
+
+    write_xlsx(wb, outpath(".xlsx"))
+    write_ods(wb, outpath(".ods"))
+    write_xls_xml(wb, outpath("-xls.xml"))
+    write_gnumeric(wb, outpath(".gnumeric"))
+    write_csv(wb, outpath(".csv"))
+    write_json(wb, outpath(".json"))
+    write_yaml(wb, outpath(".yaml"))
+    write_xml_mapped(wb, outpath("-mapped.xml"), outpath("-map.xml"))
+
+
+if __name__ == "__main__":
+    main()
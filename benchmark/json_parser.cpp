@@ -1,3 +1,4 @@
+#include "bench_global.hpp"
 
 #include <orcus/stream.hpp>
 #include <orcus/json_parser.hpp>
@@ -8,45 +9,12 @@
 #include <iostream>
 #include <stdio.h>
 #include <string>
-#include <sys/time.h>
 
 #define SIMULATE_PROCESSING_OVERHEAD 0
 
 using namespace std;
 using namespace orcus;
 
-namespace {
-
-class stack_printer
-{
-public:
-    explicit stack_printer(const char* msg) :
-        m_msg(msg)
-    {
-        fprintf(stdout, "%s: --begin\n", m_msg.c_str());
-        m_start_time = get_time();
-    }
-
-    ~stack_printer()
-    {
-        double end_time = get_time();
-        fprintf(stdout, "%s: --end (duration: %g sec)\n", m_msg.c_str(), (end_time-m_start_time));
-    }
-
-private:
-    double get_time() const
-    {
-        timeval tv;
-        gettimeofday(&tv, NULL);
-        return tv.tv_sec + tv.tv_usec / 1000000.0;
-    }
-
-    ::std::string m_msg;
-    double m_start_time;
-};
-
-}
-
 class handler
 {
     string_pool m_pool;
@@ -176,7 +144,7 @@ int main(int argc, char** argv)
     handler hdl;
 
     {
-        stack_printer __stack_printer__("parsing");
+        bench::stack_printer __stack_printer__("parsing");
         orcus::json_parser<handler> parser(content.data(), content.size(), hdl);
         parser.parse();
     }
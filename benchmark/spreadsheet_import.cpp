@@ -0,0 +1,507 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bench_global.hpp"
+
+#include <orcus/format_detection.hpp>
+#include <orcus/stream.hpp>
+#include <orcus/config.hpp>
+#include <orcus/xml_namespace.hpp>
+#include <orcus/orcus_csv.hpp>
+#include <orcus/orcus_xml.hpp>
+#include <orcus/orcus_json.hpp>
+#include <orcus/json_document_tree.hpp>
+#include <orcus/yaml_document_tree.hpp>
+#include <orcus/spreadsheet/document.hpp>
+#include <orcus/spreadsheet/factory.hpp>
+
+#ifdef __ORCUS_XLSX
+#include <orcus/orcus_xlsx.hpp>
+#endif
+#ifdef __ORCUS_ODS
+#include <orcus/orcus_ods.hpp>
+#endif
+#ifdef __ORCUS_XLS_XML
+#include <orcus/orcus_xls_xml.hpp>
+#endif
+#ifdef __ORCUS_GNUMERIC
+#include <orcus/orcus_gnumeric.hpp>
+#endif
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <functional>
+
+using namespace std;
+using namespace orcus;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+namespace {
+
+const char* help_program =
+"Import each input file repeatedly and time the import as well as each of the "
+"document dumpers.  The input format is detected from the file content, except "
+"for JSON and YAML files which are identified by their file extensions.  An XML "
+"file that is not in the Excel 2003 XML format is imported via XML mapping.";
+
+const char* help_repeat =
+"Number of times to repeat each timed phase.";
+
+const char* help_dump =
+"Comma-separated list of dump formats to time.  Use 'none' to skip the dumpers.";
+
+const char* help_map =
+"Map definition file to use for XML-mapped inputs.  When not given, a map "
+"definition is detected from the input content.  JSON inputs always use a "
+"detected map definition for their mapped import.";
+
+const char* help_output =
+"Path to a file to write the results to, in JSON format.";
+
+const char* help_sheet_size =
+"Sheet size in the form of ROWSxCOLUMNS.";
+
+const char* help_dedup_styles =
+"Store identical style entries only once during spreadsheet imports.";
+
+enum class input_kind { spreadsheet, xml_mapped, json, yaml };
+
+struct bench_config
+{
+    size_t repeat = 5;
+    std::vector<dump_format_t> dump_formats;
+    std::string map_path;
+    spreadsheet::range_size_t sheet_size{1048576, 16384};
+    bool dedup_styles = false;
+    fs::path work_dir;
+};
+
+std::vector<dump_format_t> parse_dump_formats(const std::string& s)
+{
+    std::vector<dump_format_t> ret;
+    std::istringstream is(s);
+    std::string name;
+
+    while (std::getline(is, name, ','))
+    {
+        dump_format_t fmt = to_dump_format_enum(name.data(), name.size());
+
+        switch (fmt)
+        {
+            case dump_format_t::none:
+                return std::vector<dump_format_t>();
+            case dump_format_t::unknown:
+            case dump_format_t::xml:
+            {
+                std::ostringstream os;
+                os << "unsupported dump format: '" << name << "'";
+                throw std::invalid_argument(os.str());
+            }
+            default:
+                ret.push_back(fmt);
+        }
+    }
+
+    return ret;
+}
+
+std::string to_string(dump_format_t fmt)
+{
+    for (const auto& entry : get_dump_format_entries())
+    {
+        if (entry.second == fmt)
+            return entry.first.str();
+    }
+
+    return "unknown";
+}
+
+std::unique_ptr<iface::import_filter> create_filter(
+    format_t type, spreadsheet::iface::import_factory* factory)
+{
+    switch (type)
+    {
+#ifdef __ORCUS_XLSX
+        case format_t::xlsx:
+            return std::make_unique<orcus_xlsx>(factory);
+#endif
+#ifdef __ORCUS_ODS
+        case format_t::ods:
+            return std::make_unique<orcus_ods>(factory);
+#endif
+#ifdef __ORCUS_XLS_XML
+        case format_t::xls_xml:
+            return std::make_unique<orcus_xls_xml>(factory);
+#endif
+#ifdef __ORCUS_GNUMERIC
+        case format_t::gnumeric:
+            return std::make_unique<orcus_gnumeric>(factory);
+#endif
+        case format_t::csv:
+            return std::make_unique<orcus_csv>(factory);
+        default:
+            ;
+    }
+
+    return nullptr;
+}
+
+/**
+ * Run the passed function the specified number of times and return the
+ * duration of each run.
+ */
+std::vector<double> time_runs(size_t repeat, const std::function<void()>& func)
+{
+    std::vector<double> samples;
+    samples.reserve(repeat);
+
+    for (size_t i = 0; i < repeat; ++i)
+    {
+        bench::stop_watch sw;
+        func();
+        samples.push_back(sw.elapsed());
+    }
+
+    return samples;
+}
+
+void time_dumpers(
+    const bench_config& config, const spreadsheet::document& doc,
+    const std::string& input, const std::string& format, size_t input_size,
+    bench::results& res)
+{
+    for (dump_format_t fmt : config.dump_formats)
+    {
+        std::string name = to_string(fmt);
+        fs::path outpath = config.work_dir / name;
+
+        std::vector<double> samples = time_runs(config.repeat,
+            [&]()
+            {
+                fs::remove_all(outpath);
+                doc.dump(fmt, outpath.string());
+            }
+        );
+
+        res.add(input, format, input_size, "dump:" + name, std::move(samples));
+    }
+}
+
+void run_spreadsheet(
+    const bench_config& config, format_t type, const std::string& input,
+    const file_content& content, bench::results& res)
+{
+    std::ostringstream os;
+    os << type;
+    std::string format = os.str();
+
+    {
+        // Check whether or not this build includes the filter.
+        spreadsheet::document probe_doc(config.sheet_size);
+        spreadsheet::import_factory probe_factory(probe_doc);
+
+        if (!create_filter(type, &probe_factory))
+        {
+            cerr << input << ": skipped as the " << format << " filter is not available in this build." << endl;
+            return;
+        }
+    }
+
+    std::unique_ptr<spreadsheet::document> doc;
+
+    std::vector<double> samples = time_runs(config.repeat,
+        [&]()
+        {
+            doc = std::make_unique<spreadsheet::document>(config.sheet_size);
+            spreadsheet::import_factory factory(*doc);
+            factory.set_deduplicate_styles(config.dedup_styles);
+            std::unique_ptr<iface::import_filter> filter = create_filter(type, &factory);
+            filter->read_stream(content.data(), content.size());
+        }
+    );
+
+    res.add(input, format, content.size(), "import", std::move(samples));
+    time_dumpers(config, *doc, input, format, content.size(), res);
+}
+
+/**
+ * Import via either orcus_xml or orcus_json, both of which share the same
+ * map definition interface.
+ */
+template<typename _Filter>
+void run_mapped(
+    const bench_config& config, const char* format, const std::string& input,
+    const file_content& content, const std::string& map_path, bench::results& res,
+    const std::function<std::unique_ptr<_Filter>(spreadsheet::import_factory&)>& create)
+{
+    std::unique_ptr<file_content> map_content;
+    if (!map_path.empty())
+        map_content = std::make_unique<file_content>(map_path.data());
+
+    std::unique_ptr<spreadsheet::document> doc;
+
+    std::vector<double> samples = time_runs(config.repeat,
+        [&]()
+        {
+            doc = std::make_unique<spreadsheet::document>(config.sheet_size);
+            spreadsheet::import_factory factory(*doc);
+            std::unique_ptr<_Filter> app = create(factory);
+
+            if (map_content)
+                app->read_map_definition(map_content->data(), map_content->size());
+            else
+                app->detect_map_definition(content.data(), content.size());
+
+            app->read_stream(content.data(), content.size());
+        }
+    );
+
+    res.add(input, format, content.size(), "import", std::move(samples));
+    time_dumpers(config, *doc, input, format, content.size(), res);
+}
+
+/**
+ * Time the loading of a document tree and the dumping of it to each of its
+ * supported output formats.
+ */
+template<typename _Tree, typename _LoadFunc>
+void run_tree(
+    const bench_config& config, const char* format, const std::string& input,
+    const file_content& content, bench::results& res, _LoadFunc load,
+    const std::vector<std::pair<const char*, std::function<std::string(const _Tree&)>>>& dumpers)
+{
+    std::unique_ptr<_Tree> tree;
+
+    std::vector<double> samples = time_runs(config.repeat,
+        [&]()
+        {
+            tree = std::make_unique<_Tree>();
+            load(*tree);
+        }
+    );
+
+    res.add(input, format, content.size(), "load", std::move(samples));
+
+    if (config.dump_formats.empty())
+        return;
+
+    for (const auto& dumper : dumpers)
+    {
+        samples = time_runs(config.repeat, [&]() { dumper.second(*tree); });
+        res.add(input, format, content.size(), std::string("dump:") + dumper.first, std::move(samples));
+    }
+}
+
+input_kind to_input_kind(const fs::path& path, format_t detected)
+{
+    std::string ext = path.extension().string();
+
+    if (ext == ".json")
+        return input_kind::json;
+
+    if (ext == ".yaml" || ext == ".yml")
+        return input_kind::yaml;
+
+    if (detected == format_t::unknown && ext == ".xml")
+        return input_kind::xml_mapped;
+
+    return input_kind::spreadsheet;
+}
+
+void run_input(const bench_config& config, const std::string& input, bench::results& res)
+{
+    file_content content(input.data());
+    format_t detected = detect(
+        reinterpret_cast<const unsigned char*>(content.data()), content.size());
+
+    switch (to_input_kind(input, detected))
+    {
+        case input_kind::spreadsheet:
+        {
+            if (detected == format_t::unknown)
+                // Anything that is not detected as one of the other formats
+                // gets imported as CSV.
+                detected = format_t::csv;
+
+            run_spreadsheet(config, detected, input, content, res);
+            break;
+        }
+        case input_kind::xml_mapped:
+        {
+            xmlns_repository repo;
+            run_mapped<orcus_xml>(
+                config, "xml-mapped", input, content, config.map_path, res,
+                [&repo](spreadsheet::import_factory& factory)
+                {
+                    return std::make_unique<orcus_xml>(repo, &factory, nullptr);
+                }
+            );
+            break;
+        }
+        case input_kind::json:
+        {
+            json_config jc;
+
+            run_tree<json::document_tree>(
+                config, "json", input, content, res,
+                [&](json::document_tree& tree) { tree.load(content.data(), content.size(), jc); },
+                {
+                    { "json", [](const json::document_tree& tree) { return tree.dump(); } },
+                    { "xml",  [](const json::document_tree& tree) { return tree.dump_xml(); } },
+                }
+            );
+
+            run_mapped<orcus_json>(
+                config, "json-mapped", input, content, std::string(), res,
+                [](spreadsheet::import_factory& factory)
+                {
+                    return std::make_unique<orcus_json>(&factory);
+                }
+            );
+            break;
+        }
+        case input_kind::yaml:
+        {
+            run_tree<yaml::document_tree>(
+                config, "yaml", input, content, res,
+                [&](yaml::document_tree& tree) { tree.load(content.data(), content.size()); },
+                {
+                    { "yaml", [](const yaml::document_tree& tree) { return tree.dump_yaml(); } },
+                    { "json", [](const yaml::document_tree& tree) { return tree.dump_json(); } },
+                }
+            );
+            break;
+        }
+    }
+}
+
+spreadsheet::range_size_t parse_sheet_size(const std::string& s)
+{
+    spreadsheet::range_size_t ret;
+    char sep = 0;
+    std::istringstream is(s);
+    is >> ret.rows >> sep >> ret.columns;
+
+    if (!is || sep != 'x' || ret.rows <= 0 || ret.columns <= 0)
+    {
+        std::ostringstream os;
+        os << "invalid sheet size: '" << s << "'";
+        throw std::invalid_argument(os.str());
+    }
+
+    return ret;
+}
+
+}
+
+int main(int argc, char** argv) try
+{
+    po::options_description desc("Options");
+    desc.add_options()
+        ("help,h", "Print this help.")
+        ("repeat,n", po::value<size_t>()->default_value(5), help_repeat)
+        ("dump,d", po::value<std::string>()->default_value("check,csv,flat,html,json"), help_dump)
+        ("map,m", po::value<std::string>(), help_map)
+        ("output,o", po::value<std::string>(), help_output)
+        ("sheet-size", po::value<std::string>(), help_sheet_size)
+        ("dedup-styles", help_dedup_styles);
+
+    po::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("input", po::value<std::vector<std::string>>(), "input files");
+
+    po::options_description cmd_opt;
+    cmd_opt.add(desc).add(hidden);
+
+    po::positional_options_description po_desc;
+    po_desc.add("input", -1);
+
+    po::variables_map vm;
+    try
+    {
+        po::store(
+            po::command_line_parser(argc, argv).options(cmd_opt).positional(po_desc).run(), vm);
+        po::notify(vm);
+    }
+    catch (const std::exception& e)
+    {
+        // Unknown options.
+        cerr << e.what() << endl;
+        cerr << desc;
+        return EXIT_FAILURE;
+    }
+
+    if (vm.count("help") || !vm.count("input"))
+    {
+        cout << "Usage: spreadsheet-import-bench [options] FILE..." << endl << endl;
+        cout << help_program << endl << endl << desc;
+        return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    bench_config config;
+    config.repeat = std::max<size_t>(vm["repeat"].as<size_t>(), 1);
+    config.dump_formats = parse_dump_formats(vm["dump"].as<std::string>());
+
+    if (vm.count("map"))
+        config.map_path = vm["map"].as<std::string>();
+
+    if (vm.count("sheet-size"))
+        config.sheet_size = parse_sheet_size(vm["sheet-size"].as<std::string>());
+
+    config.dedup_styles = vm.count("dedup-styles") > 0;
+
+    // All dumper output goes to a scratch directory which gets removed at
+    // the end.
+    config.work_dir = fs::temp_directory_path() / fs::unique_path("orcus-bench-%%%%-%%%%");
+    fs::create_directories(config.work_dir);
+
+    bench::results res;
+
+    try
+    {
+        for (const std::string& input : vm["input"].as<std::vector<std::string>>())
+            run_input(config, input, res);
+    }
+    catch (...)
+    {
+        fs::remove_all(config.work_dir);
+        throw;
+    }
+
+    fs::remove_all(config.work_dir);
+
+    res.print(cout);
+
+    if (vm.count("output"))
+    {
+        std::string outpath = vm["output"].as<std::string>();
+        std::ofstream of(outpath.data());
+        if (!of)
+        {
+            cerr << "failed to open " << outpath << " for writing." << endl;
+            return EXIT_FAILURE;
+        }
+
+        res.write_json(of);
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e)
+{
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -10,8 +10,10 @@
 
 #include "orcus/env.hpp"
 #include "orcus/types.hpp"
+#include "orcus/spreadsheet/types.hpp"
 
 #include <string>
+#include <vector>
 
 namespace orcus {
 
@@ -35,6 +37,85 @@ struct ORCUS_DLLPUBLIC config
         bool split_to_multiple_sheets;
     };
 
+    /**
+     * configuration settings specific to the ODS format. This struct must be
+     * POD.
+     */
+    struct ods_config
+    {
+        /**
+         * Number of threads to parse the tables in the content part with.
+         * When it's more than one, the tables get located by a quick scan
+         * of the content part first, then get parsed in parallel.  Otherwise
+         * the whole content part gets parsed in one pass on the calling
+         * thread.
+         */
+        size_t thread_count;
+    };
+
+    /**
+     * configuration settings specific to the xlsx format. This struct must be
+     * POD.
+     */
+    struct xlsx_config
+    {
+        /**
+         * Maximum number of bytes of parts to inflate ahead of time on a
+         * background thread, while the part before them is being parsed.
+         * Setting it to zero disables the prefetching, in which case each
+         * part gets inflated right before it gets parsed.
+         */
+        size_t prefetch_buffer_size;
+    };
+
+    /**
+     * Scope of the import, to restrict the import to a subset of the source
+     * document.  Sheets, rows and columns that fall outside of the scope get
+     * skipped by the import filter as early as possible, before any of their
+     * content gets converted or interned.  The default scope imports
+     * everything.
+     *
+     * Note that excluded sheets still get created in the destination
+     * document so that sheet indices and references to them stay intact,
+     * but their content is not imported.  Likewise, the imported cells stay
+     * at their original positions.
+     */
+    struct ORCUS_DLLPUBLIC import_scope
+    {
+        /**
+         * Names of the sheets to import.  When empty, all sheets get
+         * imported.
+         */
+        std::vector<std::string> sheet_names;
+
+        /** First row to import (0-based). */
+        spreadsheet::row_t first_row;
+
+        /** Last row to import (0-based).  Negative value means no limit. */
+        spreadsheet::row_t last_row;
+
+        /** First column to import (0-based). */
+        spreadsheet::col_t first_column;
+
+        /** Last column to import (0-based).  Negative value means no limit. */
+        spreadsheet::col_t last_column;
+
+        /**
+         * Columns (0-based) to keep.  When non-empty, only the columns listed
+         * here get imported, in addition to being restricted by the column
+         * window.
+         */
+        std::vector<spreadsheet::col_t> columns;
+
+        import_scope();
+
+        /**
+         * @return true if this scope restricts the import in any way, false
+         *         otherwise.
+         */
+        bool is_restricted() const;
+    };
+
     /**
      * Enable or disable runtime debug output to stdout or stderr.
      */
@@ -47,9 +128,13 @@ struct ORCUS_DLLPUBLIC config
      */
     bool structure_check;
 
+    import_scope scope;
+
     union
     {
         csv_config csv;
+        ods_config ods;
+        xlsx_config xlsx;
 
         // TODO : add config for other formats as needed.
     };
@@ -0,0 +1,55 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_DETAIL_SHA256_HPP
+#define INCLUDED_ORCUS_DETAIL_SHA256_HPP
+
+#include "orcus/env.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+namespace orcus { namespace detail {
+
+/**
+ * Computes the SHA-256 digest of a byte sequence fed to it in one or more
+ * pieces.
+ */
+class ORCUS_PSR_DLLPUBLIC sha256
+{
+    uint32_t m_state[8];
+    uint64_t m_length;
+    unsigned char m_block[64];
+    size_t m_block_size;
+
+    void process_block(const unsigned char* p);
+
+public:
+    sha256();
+
+    /**
+     * Feed the next piece of the byte sequence.
+     *
+     * @param p pointer to the first byte of the piece.
+     * @param n size of the piece.
+     */
+    void update(const char* p, size_t n);
+
+    /**
+     * Finish the computation.  No more bytes can be fed afterward.
+     *
+     * @return digest as a string of 64 lower-case hexadecimal digits.
+     */
+    std::string hex_digest();
+};
+
+}}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
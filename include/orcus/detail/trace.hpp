@@ -0,0 +1,75 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_DETAIL_TRACE_HPP
+#define INCLUDED_ORCUS_DETAIL_TRACE_HPP
+
+#include "orcus/env.hpp"
+
+#include <cstdint>
+
+namespace orcus { namespace detail { namespace trace {
+
+/**
+ * Records the time spent during its lifetime as one span, while recording
+ * is on.  All strings passed to it must outlive the recorded spans, which
+ * in practice means string literals or the names returned by
+ * std::type_info::name().
+ */
+class ORCUS_PSR_DLLPUBLIC scoped_span
+{
+    const char* mp_category;
+    const char* mp_name;
+    const char* mp_detail;
+    uint64_t m_start;
+
+public:
+    /**
+     * @param category category of the span.
+     * @param name name of the span.
+     * @param detail mangled name of a type to qualify the name of the span
+     *               with, or nullptr.
+     */
+    scoped_span(const char* category, const char* name, const char* detail = nullptr);
+    ~scoped_span();
+
+    scoped_span(const scoped_span&) = delete;
+    scoped_span& operator= (const scoped_span&) = delete;
+};
+
+}}}
+
+#define ORCUS_TRACE_CONCAT_IMPL(a, b) a##b
+#define ORCUS_TRACE_CONCAT(a, b) ORCUS_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef __ORCUS_TRACE
+
+#include <typeinfo>
+
+/**
+ * Record the rest of the enclosing scope as a span.
+ */
+#define ORCUS_TRACE_SPAN(category, span_name) \
+    ::orcus::detail::trace::scoped_span ORCUS_TRACE_CONCAT(_orcus_trace_span_, __LINE__)(category, span_name)
+
+/**
+ * Record the rest of the enclosing scope as a span qualified by the dynamic
+ * type of an object.
+ */
+#define ORCUS_TRACE_SPAN_TYPE(category, span_name, obj) \
+    ::orcus::detail::trace::scoped_span ORCUS_TRACE_CONCAT(_orcus_trace_span_, __LINE__)(category, span_name, typeid(obj).name())
+
+#else
+
+#define ORCUS_TRACE_SPAN(category, span_name) ((void)0)
+#define ORCUS_TRACE_SPAN_TYPE(category, span_name, obj) ((void)0)
+
+#endif
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
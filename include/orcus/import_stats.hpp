@@ -0,0 +1,153 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_IMPORT_STATS_HPP
+#define INCLUDED_ORCUS_IMPORT_STATS_HPP
+
+#include "orcus/env.hpp"
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+namespace orcus {
+
+/**
+ * Statistics collected by an import filter during its last import.  All
+ * durations are wall-clock times in seconds, and all sizes are in bytes.
+ * Not every filter goes through every phase; the phases not applicable to
+ * the filter remain zero.
+ */
+struct ORCUS_DLLPUBLIC import_stats
+{
+    struct phase
+    {
+        double duration = 0.0;
+
+        /** Number of bytes processed during the phase. */
+        size_t bytes = 0;
+
+        /** Number of times the phase has been entered. */
+        size_t count = 0;
+    };
+
+    /**
+     * Statistics of a single part (stream) of a package-based format.
+     */
+    struct part
+    {
+        std::string path;
+        size_t size = 0;
+        double inflate_duration = 0.0;
+        double parse_duration = 0.0;
+    };
+
+    /**
+     * Number of cells imported by type.  A value passed to the sheet for
+     * auto detection is counted under the type it ends up with.
+     */
+    struct cell_counts
+    {
+        size_t numeric = 0;
+        size_t string = 0;
+        size_t boolean = 0;
+        size_t date_time = 0;
+        size_t formula = 0;
+    };
+
+    /**
+     * Number of cell strings added to the document, either through the
+     * shared strings or as values of auto-detected string cells.
+     */
+    struct string_counts
+    {
+        /** Number of strings newly added to the string pool. */
+        size_t interned = 0;
+
+        /** Number of strings that were already present in the string pool. */
+        size_t deduplicated = 0;
+    };
+
+    struct style_counts
+    {
+        /** Number of style entries stored in the styles store. */
+        size_t stored = 0;
+
+        /** Number of style entries found identical to a stored entry. */
+        size_t deduplicated = 0;
+    };
+
+    /** The entire import, from start to finish. */
+    phase total;
+
+    /** Loading of the zip archive's central directory. */
+    phase zip_directory;
+
+    /** Decompression of all parts.  The bytes are uncompressed bytes. */
+    phase inflate;
+
+    /** Parsing of all parts, including the shared strings and styles. */
+    phase parse;
+
+    /** Parsing of the shared strings part, as a subset of the parse phase. */
+    phase shared_strings;
+
+    /** Parsing of the styles part, as a subset of the parse phase. */
+    phase styles;
+
+    /** Insertion of formula cells deferred until all parts are parsed. */
+    phase formulas;
+
+    /**
+     * Recalculation of formula cells.  This is a subset of the finalize
+     * phase, and is only recorded when the import factory supports it.
+     */
+    phase recalc;
+
+    /** Finalization of the document by the import factory. */
+    phase finalize;
+
+    std::vector<part> parts;
+
+    /**
+     * The cell, string and style entry counts are recorded by the import
+     * factory, rather than by the filter, so that they are comparable across
+     * formats.  They are only recorded when the factory is a
+     * spreadsheet::import_factory that has been given this instance via
+     * spreadsheet::import_factory::set_stats().
+     */
+    cell_counts cells;
+    string_counts strings;
+
+    /** Only recorded when style deduplication is enabled. */
+    style_counts style_entries;
+
+    /**
+     * Add the decompression time of a part, and create an entry for the part
+     * if one does not yet exist.
+     */
+    void add_inflate(const std::string& path, size_t size, double duration);
+
+    /**
+     * Add the parse time of a part, and create an entry for the part if one
+     * does not yet exist.
+     */
+    void add_parse(const std::string& path, size_t size, double duration);
+
+    /**
+     * Clear all collected statistics.
+     */
+    void reset();
+
+    void dump(std::ostream& os) const;
+};
+
+}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -17,6 +17,7 @@
 namespace orcus {
 
 struct config;
+struct import_stats;
 
 namespace iface {
 
@@ -39,6 +40,22 @@ public:
 
     void set_config(const orcus::config& v);
     const orcus::config& get_config() const;
+
+    /**
+     * Get the statistics collected during the last import.  The statistics
+     * get reset at the start of each import.
+     *
+     * @return statistics of the last import.
+     */
+    const import_stats& get_stats() const;
+
+    /**
+     * Get the mutable statistics store, for the filter implementation and
+     * the import factory to record their statistics in.
+     *
+     * @return mutable statistics of the current or last import.
+     */
+    import_stats& get_stats();
 };
 
 class ORCUS_DLLPUBLIC document_dumper
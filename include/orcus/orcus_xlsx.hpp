@@ -11,6 +11,9 @@
 #include "interface.hpp"
 
 #include <memory>
+#include <string>
+#include <vector>
+#include <iosfwd>
 
 namespace orcus {
 
@@ -22,6 +25,48 @@ struct xlsx_rel_pivot_cache_info;
 struct xlsx_rel_pivot_cache_record_info;
 struct orcus_xlsx_impl;
 class xlsx_opc_handler;
+class zip_archive_stream;
+
+/**
+ * Summary information of an xlsx workbook, collected by reading only the
+ * workbook part, the relationship parts, the leading segment of each sheet
+ * part, and the central directory of the zip package.  No cell data is
+ * parsed.
+ */
+struct ORCUS_DLLPUBLIC xlsx_workbook_metadata
+{
+    /** Size information of a single part stored in the package. */
+    struct part
+    {
+        std::string path;
+        size_t size_compressed = 0;
+        size_t size_uncompressed = 0;
+    };
+
+    struct sheet
+    {
+        std::string name;
+        std::string path;      /// path of the sheet part within the package.
+        std::string dimension; /// used range as stored in the sheet, e.g. 'A1:D20'.
+        std::string code_name;
+        std::string tab_color; /// ARGB value of the tab color if any.
+        size_t size_compressed = 0;
+        size_t size_uncompressed = 0;
+    };
+
+    struct defined_name
+    {
+        std::string name;
+        std::string expression;
+        int sheet_scope = -1; /// 0-based sheet index, or -1 if global.
+    };
+
+    std::vector<sheet> sheets;
+    std::vector<defined_name> defined_names;
+    std::vector<part> parts;
+
+    void dump(std::ostream& os) const;
+};
 
 class ORCUS_DLLPUBLIC orcus_xlsx : public iface::import_filter
 {
@@ -38,6 +83,28 @@ public:
 
     static bool detect(const unsigned char* blob, size_t size);
 
+    /**
+     * Scan an xlsx file for its workbook metadata without importing its
+     * content.  Each sheet part is read only up to the beginning of its cell
+     * data.
+     *
+     * @param filepath path to the file to scan.
+     *
+     * @return metadata of the workbook.
+     */
+    static xlsx_workbook_metadata read_metadata(const std::string& filepath);
+
+    /**
+     * Scan an in-memory xlsx stream for its workbook metadata without
+     * importing its content.
+     *
+     * @param content pointer to the first byte of the stream.
+     * @param len size of the stream.
+     *
+     * @return metadata of the workbook.
+     */
+    static xlsx_workbook_metadata read_metadata(const char* content, size_t len);
+
     virtual void read_file(const std::string& filepath);
     virtual void read_stream(const char* content, size_t len);
 
@@ -45,6 +112,8 @@ public:
 
 private:
 
+    void read_file_impl(std::unique_ptr<zip_archive_stream>&& stream);
+
     void set_formulas_to_doc();
 
     void read_workbook(const std::string& dir_path, const std::string& file_name);
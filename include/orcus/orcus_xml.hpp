@@ -9,6 +9,7 @@
 #define INCLUDED_ORCUS_ORCUS_XML_HPP
 
 #include "env.hpp"
+#include "types.hpp"
 #include "spreadsheet/types.hpp"
 
 #include <ostream>
@@ -59,8 +60,14 @@ public:
      * @param sheet sheet index (0-based) of the linked cell location.
      * @param row row index (0-based) of the linked cell location.
      * @param col column index (0-based) of the linked cell location.
+     * @param value_type type of the linked value.  When the type is known,
+     *                   the value is converted directly to the cell value of
+     *                   that type, rather than having its type determined
+     *                   from its content.
      */
-    void set_cell_link(const pstring& xpath, const pstring& sheet, spreadsheet::row_t row, spreadsheet::col_t col);
+    void set_cell_link(
+        const pstring& xpath, const pstring& sheet, spreadsheet::row_t row, spreadsheet::col_t col,
+        xml_value_t value_type = xml_value_t::unknown);
 
     /**
      * Initiate the mapping definition of a linked range.  The definition will
@@ -79,8 +86,13 @@ public:
      * @param xpath path to the element or attribute to link as a field.
      * @param label custom header label to use in lieu of the name of the
      *              linked entity.
+     * @param value_type type of the values in the field.  When the type is
+     *                   known, each value is converted directly to the cell
+     *                   value of that type, rather than having its type
+     *                   determined from its content.
      */
-    void append_field_link(const pstring& xpath, const pstring& label);
+    void append_field_link(
+        const pstring& xpath, const pstring& label, xml_value_t value_type = xml_value_t::unknown);
 
     /**
      * Set the element located in the specified path as a row group in the
@@ -113,6 +125,27 @@ public:
      */
     void read_stream(const char* p, size_t n);
 
+    /**
+     * Feed the next chunk of the source XML document.  The document can be
+     * split into chunks of any size at any position.  Only the part of the
+     * document that has not yet been parsed is kept in memory, which makes it
+     * possible to import a document much larger than the available memory.
+     *
+     * Call {@link finish_stream} once the last chunk has been fed.  Note that
+     * the {@link write} method requires the entire source document, and
+     * cannot be used with a document that has been read in chunks.
+     *
+     * @param p pointer to the buffer containing the next chunk.
+     * @param n size of the buffer.
+     */
+    void feed_stream(const char* p, size_t n);
+
+    /**
+     * Signal the end of the source XML document fed via {@link feed_stream}.
+     * It throws if the document ends prematurely.
+     */
+    void finish_stream();
+
     /**
      * Read an XML stream that contains an entire set of mapping rules.
      *
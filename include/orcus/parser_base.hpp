@@ -16,6 +16,7 @@
 #include <cstddef>
 #include <cassert>
 #include <functional>
+#include <limits>
 
 namespace orcus {
 
@@ -42,17 +43,30 @@ class ORCUS_PSR_DLLPUBLIC parser_base
 protected:
     using numeric_parser_type = std::function<double(const char*&, size_t)>;
 
-    const char* const mp_begin;
+    const char* mp_begin;
     const char* mp_char;
     const char* mp_end;
     const bool m_transient_stream;
 
 private:
+    std::ptrdiff_t m_offset_base;
     std::function<double(const char*&, size_t)> m_func_parse_numeric;
 
 protected:
     parser_base(const char* p, size_t n, bool transient_stream);
 
+    /**
+     * Point the parser to a new segment of the character stream.  This is
+     * for parsers that receive their input in multiple segments rather than
+     * in one contiguous buffer.
+     *
+     * @param p pointer to the first character of the new segment.
+     * @param n length of the new segment.
+     * @param offset offset of the first character of the new segment from
+     *               the beginning of the whole stream.
+     */
+    void reset_stream(const char* p, size_t n, std::ptrdiff_t offset);
+
     void set_numeric_parser(const numeric_parser_type& func)
     {
         m_func_parse_numeric = func;
@@ -107,6 +121,31 @@ protected:
      */
     double parse_double();
 
+    /**
+     * Same as parse_double(), except that the numeric parser is specified as
+     * a policy at compile time instead of the one set at run time, which
+     * allows the call to the numeric parser to be inlined.  The numeric
+     * parser set via set_numeric_parser() has no effect on this call.
+     *
+     * @tparam _NumericPolicy type that provides a static <code>double
+     *                        parse(const char*& p, size_t max_length)</code>
+     *                        function with the same semantics as the numeric
+     *                        parser function.
+     *
+     * @return double value on success, or NaN on failure.
+     */
+    template<typename _NumericPolicy>
+    double parse_double()
+    {
+        const char* p = mp_char;
+        double val = _NumericPolicy::parse(p, available_size());
+        if (p == mp_char)
+            return std::numeric_limits<double>::quiet_NaN();
+
+        mp_char = p;
+        return val;
+    }
+
     /**
      * Determine the number of characters remaining <strong>after</strong> the
      * current character.  For instance, if the current character is on the
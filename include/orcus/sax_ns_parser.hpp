@@ -10,6 +10,7 @@
 
 #include "sax_parser.hpp"
 #include "xml_namespace.hpp"
+#include "string_pool.hpp"
 #include "global.hpp"
 
 #include <unordered_set>
@@ -124,6 +125,8 @@ public:
     void parse();
 
 private:
+    template<typename> friend class sax_ns_push_parser;
+
     /**
      * Re-route callbacks from the internal sax_parser into sax_ns_parser
      * callbacks.
@@ -140,10 +143,23 @@ private:
         xmlns_context& m_ns_cxt;
         handler_type& m_handler;
 
+        /**
+         * When set, element names and namespace aliases that need to
+         * outlive the current token are interned in this pool, for streams
+         * that get discarded as they are parsed.
+         */
+        string_pool* mp_name_pool;
+
         bool m_declaration;
 
+        pstring intern(const pstring& s)
+        {
+            return mp_name_pool ? mp_name_pool->intern(s).first : s;
+        }
+
     public:
-        handler_wrapper(xmlns_context& ns_cxt, handler_type& handler) : m_ns_cxt(ns_cxt), m_handler(handler), m_declaration(false) {}
+        handler_wrapper(xmlns_context& ns_cxt, handler_type& handler, string_pool* name_pool = nullptr) :
+            m_ns_cxt(ns_cxt), m_handler(handler), mp_name_pool(name_pool), m_declaration(false) {}
 
         void doctype(const sax::doctype_declaration& dtd)
         {
@@ -167,7 +183,7 @@ private:
             m_scopes.push_back(std::make_unique<__sax::elem_scope>());
             __sax::elem_scope& scope = *m_scopes.back();
             scope.ns = m_ns_cxt.get(elem.ns);
-            scope.name = elem.name;
+            scope.name = intern(elem.name);
             scope.ns_keys.swap(m_ns_keys);
 
             m_elem.ns = scope.ns;
@@ -232,8 +248,9 @@ private:
                 // Namespace alias
                 if (!attr.name.empty())
                 {
-                    m_ns_cxt.push(attr.name, attr.value);
-                    m_ns_keys.insert(attr.name);
+                    pstring key = intern(attr.name);
+                    m_ns_cxt.push(key, attr.value);
+                    m_ns_keys.insert(key);
                 }
                 return;
             }
@@ -277,6 +294,53 @@ void sax_ns_parser<_Handler>::parse()
     m_parser.parse();
 }
 
+/**
+ * Push-mode variant of sax_ns_parser, which receives the stream in
+ * successive chunks.  See sax_push_parser for details.
+ */
+template<typename _Handler>
+class sax_ns_push_parser
+{
+    typedef typename sax_ns_parser<_Handler>::handler_wrapper handler_wrapper;
+
+public:
+    typedef _Handler handler_type;
+
+    sax_ns_push_parser(xmlns_context& ns_cxt, handler_type& handler);
+    ~sax_ns_push_parser();
+
+    void feed(const char* p, size_t n);
+    void finish();
+
+private:
+    string_pool m_name_pool;
+    handler_wrapper m_wrapper;
+    sax_push_parser<handler_wrapper> m_parser;
+};
+
+template<typename _Handler>
+sax_ns_push_parser<_Handler>::sax_ns_push_parser(xmlns_context& ns_cxt, handler_type& handler) :
+    m_wrapper(ns_cxt, handler, &m_name_pool), m_parser(m_wrapper)
+{
+}
+
+template<typename _Handler>
+sax_ns_push_parser<_Handler>::~sax_ns_push_parser()
+{
+}
+
+template<typename _Handler>
+void sax_ns_push_parser<_Handler>::feed(const char* p, size_t n)
+{
+    m_parser.feed(p, n);
+}
+
+template<typename _Handler>
+void sax_ns_push_parser<_Handler>::finish()
+{
+    m_parser.finish();
+}
+
 }
 
 #endif
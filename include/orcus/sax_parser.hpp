@@ -10,6 +10,9 @@
 
 #include "sax_parser_base.hpp"
 
+#include <cstring>
+#include <string>
+
 namespace orcus {
 
 struct sax_parser_default_config
@@ -127,6 +130,31 @@ public:
 
     void parse();
 
+protected:
+
+    /**
+     * Constructor for a push-mode parser, which receives its stream later
+     * in one or more segments.  The stream is always treated as transient.
+     */
+    sax_parser(handler_type& handler);
+
+    /**
+     * Parse a segment of the stream.  The segment must consist only of
+     * complete tokens, except for the last segment of the stream.
+     *
+     * @param p pointer to the first character of the segment.
+     * @param n length of the segment.
+     * @param offset offset of the segment from the beginning of the stream.
+     * @param first whether or not this is the first segment of the stream.
+     */
+    void parse_segment(const char* p, size_t n, std::ptrdiff_t offset, bool first);
+
+    /**
+     * @return true once the root element has been closed, after which the
+     *         rest of the stream is ignored.
+     */
+    bool root_elem_closed() const { return !m_root_elem_open; }
+
 private:
 
     /**
@@ -165,6 +193,13 @@ sax_parser<_Handler,_Config>::sax_parser(
 {
 }
 
+template<typename _Handler, typename _Config>
+sax_parser<_Handler,_Config>::sax_parser(handler_type& handler) :
+    sax::parser_base(nullptr, 0, true),
+    m_handler(handler)
+{
+}
+
 template<typename _Handler, typename _Config>
 sax_parser<_Handler,_Config>::~sax_parser()
 {
@@ -182,6 +217,24 @@ void sax_parser<_Handler,_Config>::parse()
     assert(m_buffer_pos == 0);
 }
 
+template<typename _Handler, typename _Config>
+void sax_parser<_Handler,_Config>::parse_segment(
+    const char* p, size_t n, std::ptrdiff_t offset, bool first)
+{
+    reset_stream(p, n, offset);
+
+    if (first)
+    {
+        m_nest_level = 0;
+        header();
+        skip_space_and_control();
+    }
+
+    body();
+
+    assert(m_buffer_pos == 0);
+}
+
 template<typename _Handler, typename _Config>
 void sax_parser<_Handler,_Config>::header()
 {
@@ -406,7 +459,7 @@ template<typename _Handler, typename _Config>
 void sax_parser<_Handler,_Config>::cdata()
 {
     size_t len = remains();
-    assert(len > 3);
+    assert(len >= 3);
 
     // Parse until we reach ']]>'.
     const char* p0 = mp_char;
@@ -510,24 +563,20 @@ template<typename _Handler, typename _Config>
 void sax_parser<_Handler,_Config>::characters()
 {
     const char* p0 = mp_char;
-    for (; has_char(); next())
-    {
-        if (cur_char() == '<')
-            break;
+    skip_to_either('<', '&');
 
-        if (cur_char() == '&')
-        {
-            // Text span with one or more encoded characters. Parse using cell buffer.
-            cell_buffer& buf = get_cell_buffer();
-            buf.reset();
-            buf.append(p0, mp_char-p0);
-            characters_with_encoded_char(buf);
-            if (buf.empty())
-                m_handler.characters(pstring(), transient_stream());
-            else
-                m_handler.characters(pstring(buf.get(), buf.size()), true);
-            return;
-        }
+    if (has_char() && cur_char() == '&')
+    {
+        // Text span with one or more encoded characters. Parse using cell buffer.
+        cell_buffer& buf = get_cell_buffer();
+        buf.reset();
+        buf.append(p0, mp_char-p0);
+        characters_with_encoded_char(buf);
+        if (buf.empty())
+            m_handler.characters(pstring(), transient_stream());
+        else
+            m_handler.characters(pstring(buf.get(), buf.size()), true);
+        return;
     }
 
     if (mp_char > p0)
@@ -573,6 +622,95 @@ void sax_parser<_Handler,_Config>::attribute()
     m_handler.attribute(attr);
 }
 
+/**
+ * Push-mode variant of sax_parser.  Rather than taking the whole stream at
+ * once, it receives the stream in successive chunks of arbitrary sizes, and
+ * passes to its handler the same callbacks that sax_parser would.  A token
+ * that spans multiple chunks is held back until it is complete, and the
+ * part of the stream that has been parsed is discarded.  Since no part of
+ * the stream outlives the callbacks, all values passed to the handler are
+ * flagged as transient.
+ */
+template<typename _Handler, typename _Config = sax_parser_default_config>
+class sax_push_parser : private sax_parser<_Handler,_Config>
+{
+    typedef sax_parser<_Handler,_Config> parser_type;
+
+public:
+    typedef _Handler handler_type;
+    typedef _Config config_type;
+
+    sax_push_parser(handler_type& handler);
+    ~sax_push_parser();
+
+    /**
+     * Pass the next chunk of the stream.  All tokens that have been
+     * completed with this chunk get parsed before the call returns.
+     *
+     * @param p pointer to the first character of the chunk.
+     * @param n length of the chunk.
+     */
+    void feed(const char* p, size_t n);
+
+    /**
+     * Signal the end of the stream, and parse whatever has been held back.
+     */
+    void finish();
+
+private:
+    std::string m_buffer;
+    sax::push_scanner m_scanner;
+    std::ptrdiff_t m_offset;
+    bool m_started;
+};
+
+template<typename _Handler, typename _Config>
+sax_push_parser<_Handler,_Config>::sax_push_parser(handler_type& handler) :
+    parser_type(handler), m_offset(0), m_started(false)
+{
+}
+
+template<typename _Handler, typename _Config>
+sax_push_parser<_Handler,_Config>::~sax_push_parser()
+{
+}
+
+template<typename _Handler, typename _Config>
+void sax_push_parser<_Handler,_Config>::feed(const char* p, size_t n)
+{
+    if (!n || this->root_elem_closed())
+        return;
+
+    m_buffer.append(p, n);
+    size_t len = m_scanner.scan(m_buffer.data(), m_buffer.size());
+    if (!len)
+        return;
+
+    // The first segment must include the first tag, or the header check
+    // would fail on leading blanks.
+    if (!m_started && !std::memchr(m_buffer.data(), '<', len))
+        return;
+
+    this->parse_segment(m_buffer.data(), len, m_offset, !m_started);
+    m_started = true;
+    m_offset += len;
+
+    m_buffer.erase(0, len);
+    m_scanner.consume(len);
+}
+
+template<typename _Handler, typename _Config>
+void sax_push_parser<_Handler,_Config>::finish()
+{
+    if (!this->root_elem_closed())
+        this->parse_segment(m_buffer.data(), m_buffer.size(), m_offset, !m_started);
+
+    m_started = true;
+    m_offset += m_buffer.size();
+    m_buffer.clear();
+    m_scanner.reset();
+}
+
 }
 
 #endif
@@ -78,6 +78,20 @@ ORCUS_PSR_DLLPUBLIC char decode_xml_encoded_char(const char* p, size_t n);
  */
 ORCUS_PSR_DLLPUBLIC std::string decode_xml_unicode_char(const char* p, size_t n);
 
+/**
+ * Same as the above, except that the UTF-8 sequence gets written to a
+ * caller-provided buffer instead of being returned as a string.
+ *
+ * @param p pointer to the first character of encoded name
+ * @param n length of encoded name
+ * @param out buffer to write the UTF-8 sequence to.  It must have room for
+ *            at least 4 characters.
+ *
+ * @return number of characters written to the buffer, or 0 if decoding
+ *         fails.
+ */
+ORCUS_PSR_DLLPUBLIC size_t decode_xml_unicode_char(const char* p, size_t n, char* out);
+
 /**
  * Element properties passed by sax_parser to its handler's open_element()
  * and close_element() calls.
@@ -105,6 +119,53 @@ struct parser_attribute
     bool transient;  // whether or not the attribute value is on a temporary buffer.
 };
 
+/**
+ * Scanner used by the push-mode parsers to find, within a partially
+ * received XML stream, the longest leading segment that consists only of
+ * complete tokens, i.e. tags, declarations, comments, CDATA sections and
+ * text runs.  A text run is complete only when the '<' that follows it has
+ * been received.
+ *
+ * Each scan resumes where the previous one left off, so a large token that
+ * arrives in many small chunks still gets scanned only once.
+ */
+class ORCUS_PSR_DLLPUBLIC push_scanner
+{
+    enum class token_type { none, markup, text, tag, comment, cdata };
+
+    token_type m_type;
+    size_t m_token_begin; /// start position of the token being scanned.
+    size_t m_pos;         /// position where the next scan resumes.
+    char m_quote;         /// quote character of the attribute value being scanned, or 0.
+
+public:
+    push_scanner();
+
+    /**
+     * Scan the pending data.
+     *
+     * @param p pointer to the first character of the pending data.  It must
+     *          be the same data as in the previous call, with optionally
+     *          more data appended to it.
+     * @param n length of the pending data.
+     *
+     * @return length of the leading segment that consists only of complete
+     *         tokens.
+     */
+    size_t scan(const char* p, size_t n);
+
+    /**
+     * Notify the scanner that the leading segment of specified length has
+     * been removed from the pending data.
+     *
+     * @param n length of the removed segment.  It must not exceed the value
+     *          returned from the last call to scan().
+     */
+    void consume(size_t n);
+
+    void reset();
+};
+
 class ORCUS_PSR_DLLPUBLIC parser_base : public ::orcus::parser_base
 {
     struct impl;
@@ -201,6 +262,12 @@ protected:
 
     void expects_next(const char* p, size_t n);
 
+    /**
+     * Move the current position to the first occurrence of either of the
+     * two characters, or to the end of the stream if neither is found.
+     */
+    void skip_to_either(char c1, char c2);
+
     void parse_encoded_char(cell_buffer& buf);
     void value_with_encoded_char(cell_buffer& buf, pstring& str, char quote_char);
 
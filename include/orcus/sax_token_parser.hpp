@@ -14,6 +14,7 @@
 
 #include "types.hpp"
 #include "sax_ns_parser.hpp"
+#include "detail/trace.hpp"
 
 namespace orcus {
 
@@ -140,6 +141,7 @@ public:
     void parse();
 
 private:
+    template<typename> friend class sax_token_push_parser;
 
     /**
      * Re-route callbacks from the internal sax_ns_parser into the
@@ -212,9 +214,58 @@ sax_token_parser<_Handler>::~sax_token_parser()
 template<typename _Handler>
 void sax_token_parser<_Handler>::parse()
 {
+    ORCUS_TRACE_SPAN("parse", "sax_token_parser::parse");
     m_parser.parse();
 }
 
+/**
+ * Push-mode variant of sax_token_parser, which receives the stream in
+ * successive chunks.  See sax_push_parser for details.
+ */
+template<typename _Handler>
+class sax_token_push_parser
+{
+    typedef typename sax_token_parser<_Handler>::handler_wrapper handler_wrapper;
+
+public:
+    typedef _Handler handler_type;
+
+    sax_token_push_parser(const tokens& _tokens, xmlns_context& ns_cxt, handler_type& handler);
+    ~sax_token_push_parser();
+
+    void feed(const char* p, size_t n);
+    void finish();
+
+private:
+    handler_wrapper m_wrapper;
+    sax_ns_push_parser<handler_wrapper> m_parser;
+};
+
+template<typename _Handler>
+sax_token_push_parser<_Handler>::sax_token_push_parser(
+    const tokens& _tokens, xmlns_context& ns_cxt, handler_type& handler) :
+    m_wrapper(_tokens, handler),
+    m_parser(ns_cxt, m_wrapper)
+{
+}
+
+template<typename _Handler>
+sax_token_push_parser<_Handler>::~sax_token_push_parser()
+{
+}
+
+template<typename _Handler>
+void sax_token_push_parser<_Handler>::feed(const char* p, size_t n)
+{
+    m_parser.feed(p, n);
+}
+
+template<typename _Handler>
+void sax_token_push_parser<_Handler>::finish()
+{
+    m_parser.finish();
+}
+
 }
 
 #endif
@@ -11,6 +11,8 @@
 #include "orcus/env.hpp"
 
 #include <cstdint>
+#include <cstddef>
+#include <string>
 
 namespace orcus { namespace spreadsheet {
 
@@ -23,6 +25,32 @@ struct ORCUS_SPM_DLLPUBLIC document_config
      */
     int8_t output_precision;
 
+    /**
+     * Estimated amount of memory in bytes the cell values of all sheets may
+     * occupy before the cell values of the sheets not being accessed get
+     * spilled to disk.  They get read back when the sheets are accessed
+     * again.  A value of 0 keeps all cell values in memory.
+     */
+    size_t spill_threshold;
+
+    /**
+     * Directory to spill the cell values to.  The system's temporary
+     * directory is used when it's empty.
+     */
+    std::string spill_directory;
+
+    /**
+     * Character to separate the fields with when dumping sheets as CSV.
+     */
+    char csv_separator;
+
+    /**
+     * Character to quote the string fields with when dumping sheets as CSV.
+     * A quote character within a field gets doubled.  It must differ from
+     * the separator.
+     */
+    char csv_quote;
+
     document_config();
     document_config(const document_config& r);
     ~document_config();
@@ -12,6 +12,7 @@
 #include "orcus/interface.hpp"
 #include "orcus/spreadsheet/types.hpp"
 
+#include <cstdint>
 #include <ostream>
 #include <memory>
 
@@ -75,9 +76,23 @@ public:
      */
     void clear();
 
+    /**
+     * Make sure that the cell values of a sheet are in the model context,
+     * reading them back from disk if they have been spilled.  The cell
+     * values of other sheets may get spilled as a result, which invalidates
+     * any iterators over them.  It does nothing unless the spill threshold
+     * is set in the document configuration.
+     *
+     * @param sheet_pos index of the sheet whose cell values are to be
+     *                  accessed.
+     */
+    void page_in_sheet(sheet_t sheet_pos) const;
+
     /**
      * Calculate those formula cells that have been newly inserted and have
-     * not yet been calculated.
+     * not yet been calculated.  The cell values of all sheets get read back
+     * beforehand if they have been spilled, since the formula cells may
+     * refer to any of them.
      */
     void recalc_formula_cells();
 
@@ -98,6 +113,12 @@ public:
 
     void dump_json(const ::std::string& outdir) const;
 
+    /**
+     * Dump each sheet as a CSV file named [sheet name].csv, using the
+     * separator and quote characters of the document configuration.
+     *
+     * @param outdir output directory.
+     */
     void dump_csv(const std::string& outdir) const;
 
     /**
@@ -106,6 +127,55 @@ public:
      */
     virtual void dump_check(std::ostream& os) const override;
 
+    /**
+     * Save the document content to a binary snapshot file, which can be
+     * loaded back much faster than re-importing the original file.  A
+     * snapshot is only meant to be loaded by the same version of the
+     * library that has saved it.
+     *
+     * The size and the digest of the source the document was imported from
+     * can be stored along with the content, so that a snapshot only gets
+     * loaded for the source it was saved from.
+     *
+     * @param filepath path of the snapshot file to write to.
+     * @param source_size size of the source in bytes.
+     * @param source_digest digest of the source, or an empty string if the
+     *                      snapshot is not tied to any source.
+     */
+    void save_snapshot(
+        const std::string& filepath, uint64_t source_size = 0,
+        const std::string& source_digest = std::string()) const;
+
+    /**
+     * Replace the document content with the content of a snapshot file
+     * previously saved by save_snapshot().  The formula cells are restored
+     * with their cached results, if any.  When the snapshot cannot be
+     * loaded, an exception is thrown and the document is left unchanged.
+     *
+     * @param filepath path of the snapshot file to load.
+     * @param source_size size of the source the snapshot is expected to
+     *                    have been saved from.
+     * @param source_digest digest of the source the snapshot is expected to
+     *                      have been saved from.  When it is not empty, a
+     *                      snapshot whose stored source size or digest
+     *                      differs is rejected.
+     */
+    void load_snapshot(
+        const std::string& filepath, uint64_t source_size = 0,
+        const std::string& source_digest = std::string());
+
+    /**
+     * Save the document content as an Excel 2007 XML workbook.  The cell
+     * values, and the formulas along with their cached results, get saved,
+     * but the cell formats do not.  The sheets get written and compressed
+     * in parallel.
+     *
+     * @param filepath path of the file to write to.
+     * @param thread_count maximum number of threads to write the sheets
+     *                     with.
+     */
+    void save_xlsx(const std::string& filepath, size_t thread_count = 1) const;
+
     sheet_t get_sheet_index(const pstring& name) const;
     pstring get_sheet_name(sheet_t sheet_pos) const;
 
@@ -146,6 +216,15 @@ public:
 private:
     void insert_dirty_cell(const ixion::abs_address_t& pos);
 
+    /**
+     * Account for the cell values about to be inserted into a sheet, to keep
+     * the cell values of all sheets within the spill threshold.
+     *
+     * @param sheet_pos index of the sheet the cell values get inserted into.
+     * @param size estimated amount of memory the cell values occupy.
+     */
+    void add_cell_size(sheet_t sheet_pos, size_t size);
+
 private:
     std::unique_ptr<document_impl> mp_impl;
 };
@@ -17,6 +17,7 @@
 namespace orcus {
 
 class string_pool;
+struct import_stats;
 
 namespace spreadsheet {
 
@@ -63,6 +64,26 @@ public:
     void set_recalc_formula_cells(bool b);
 
     void set_formula_error_policy(formula_error_policy_t policy);
+
+    /**
+     * Set the statistics instance to record into.  The factory records the
+     * number of imported cells by type, the number of strings interned
+     * versus deduplicated, the number of style entries when the styles get
+     * deduplicated, and the time spent re-calculating formula cells during
+     * finalization.  Pass nullptr to stop recording.
+     *
+     * @param stats pointer to the statistics instance, typically the one
+     *              owned by the import filter.
+     */
+    void set_stats(import_stats* stats);
+
+    /**
+     * When setting this flag to true, identical style entries are stored
+     * only once.  See import_styles::set_deduplicate() for details.
+     *
+     * @param b value of this flag.
+     */
+    void set_deduplicate_styles(bool b);
 };
 
 class ORCUS_SPM_DLLPUBLIC import_styles : public iface::import_styles
@@ -73,6 +94,37 @@ public:
     import_styles(styles& styles, string_pool& sp);
     virtual ~import_styles() override;
 
+    /**
+     * When setting this flag to true, each committed font, fill, border,
+     * protection, cell style format and cell format entry gets stored only
+     * when no identical entry has been stored before.  The index returned by
+     * each commit method remains the position of the entry in the order of
+     * the commits, and is mapped to the index of the stored entry when
+     * referenced by other entries or passed to the sheet.  This flag must be
+     * set before any entries get committed.  It is false by default.
+     *
+     * @param b value of this flag.
+     */
+    void set_deduplicate(bool b);
+
+    /**
+     * Set the statistics instance to record the numbers of stored and
+     * deduplicated style entries.  Pass nullptr to stop recording.
+     *
+     * @param stats pointer to the statistics instance.
+     */
+    void set_stats(import_stats* stats);
+
+    /**
+     * Map a cell format index returned by commit_cell_xf() to the index of
+     * the cell format entry in the styles store.
+     *
+     * @param index cell format index as returned by commit_cell_xf().
+     *
+     * @return index of the cell format entry in the styles store.
+     */
+    size_t get_cell_format_index(size_t index) const;
+
     virtual void set_font_count(size_t n) override;
     virtual void set_font_bold(bool b) override;
     virtual void set_font_italic(bool b) override;
@@ -27,10 +27,20 @@ class import_sheet_view;
 /**
  * Interface class designed to be derived by the implementor.
  */
-class import_shared_strings
+class ORCUS_DLLPUBLIC import_shared_strings
 {
 public:
-    ORCUS_DLLPUBLIC virtual ~import_shared_strings() = 0;
+    virtual ~import_shared_strings() = 0;
+
+    /**
+     * Set the number of unique strings expected to be appended, so that the
+     * implementor can reserve storage ahead of time.  This is only a hint;
+     * the actual number of strings may differ.  The default implementation
+     * does nothing.
+     *
+     * @param n expected number of unique strings.
+     */
+    virtual void set_count(size_t n);
 
     /**
      * Append new string to the string list.  Order of insertion is important
@@ -825,6 +835,16 @@ public:
      *         sheet.
      */
     virtual range_size_t get_sheet_size() const = 0;
+
+    /**
+     * Set the range expected to contain all the data of the sheet, as stored
+     * in the source document ahead of the cell data.  The implementor may use
+     * it to reserve storage.  This is only a hint; cells may still be set
+     * outside this range.  The default implementation does nothing.
+     *
+     * @param range expected data range of the sheet.
+     */
+    virtual void set_data_range_hint(const range_t& range);
 };
 
 class import_global_settings
@@ -224,6 +224,104 @@ struct ORCUS_SPM_DLLPUBLIC pivot_cache_field_t
     pivot_cache_field_t(pivot_cache_field_t&& other);
 };
 
+/**
+ * Result of grouping the records of a pivot cache by the values of one or
+ * more of its fields, and aggregating the values of another field for each
+ * group.  All members store one element per group.
+ */
+struct ORCUS_SPM_DLLPUBLIC pivot_cache_aggregate_t
+{
+    /**
+     * Values of the group fields for each group, in the order the fields
+     * were specified.  The groups are ordered by the records they first
+     * appear in.
+     */
+    std::vector<pivot_cache_record_t> keys;
+
+    /**
+     * Sum of the numeric values of the data field.  Values referencing a
+     * shared item are resolved through the items of the field.
+     */
+    std::vector<double> sums;
+
+    /** Number of non-blank values of the data field. */
+    std::vector<size_t> counts;
+};
+
+/**
+ * Column-oriented store of pivot cache records.  Each field gets its own
+ * column, which stores shared item indices as 32-bit integers and numeric
+ * values as plain doubles as long as all its values are of the same type.
+ * Only a column that mixes value types stores a type tag for each value.
+ * Character values get interned and dictionary-encoded per column, and
+ * date-time values are packed into 64 bits with a precision of one
+ * microsecond.
+ *
+ * Records are appended one value at a time; a record with fewer values
+ * than the other records gets padded with blank values.
+ */
+class ORCUS_SPM_DLLPUBLIC pivot_cache_records
+{
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+
+public:
+    pivot_cache_records(string_pool& sp);
+    pivot_cache_records(pivot_cache_records&& other);
+    ~pivot_cache_records();
+
+    pivot_cache_records& operator= (pivot_cache_records&& other);
+
+    void reserve(size_t n);
+
+    void append_value(const pivot_cache_record_value_t& v);
+    void append_value_numeric(double v);
+    void append_value_character(const char* p, size_t n);
+    void append_value_shared_item(size_t index);
+
+    /**
+     * Commit the values appended since the last commit as a new record.
+     */
+    void commit_record();
+
+    size_t get_record_count() const;
+
+    /**
+     * @return number of columns, which is the number of values in the
+     *         longest record.
+     */
+    size_t get_field_count() const;
+
+    /**
+     * Retrieve a single record value.
+     *
+     * @param record 0-based index of the record.
+     * @param field 0-based index of the field.
+     *
+     * @return record value, or a value of unknown type if either index is
+     *         out-of-range.
+     */
+    pivot_cache_record_value_t get_value(size_t record, size_t field) const;
+
+    pivot_cache_record_t get_record(size_t record) const;
+
+    /**
+     * Group the records by the values of the group fields, and compute the
+     * sum and the count of the values of the data field for each group.
+     *
+     * @param group_fields 0-based indices of the fields to group the records
+     *                     by.  When empty, all records form a single group.
+     * @param data_field 0-based index of the field to aggregate.
+     * @param fields field definitions, used to resolve the shared items
+     *               referenced by the data field.
+     *
+     * @return aggregated values for each group.
+     */
+    pivot_cache_aggregate_t aggregate(
+        const std::vector<size_t>& group_fields, size_t data_field,
+        const std::vector<pivot_cache_field_t>& fields) const;
+};
+
 class ORCUS_SPM_DLLPUBLIC pivot_cache
 {
     struct impl;
@@ -246,6 +344,13 @@ public:
 
     void insert_records(records_type record);
 
+    /**
+     * Replace the records with the ones stored in columns.
+     *
+     * @param records record store to move into the cache.
+     */
+    void insert_records(pivot_cache_records records);
+
     size_t get_field_count() const;
 
     /**
@@ -260,7 +365,26 @@ public:
 
     pivot_cache_id_t get_id() const;
 
+    size_t get_record_count() const;
+
+    const pivot_cache_records& get_records() const;
+
+    /**
+     * Get all records in row-oriented form.  They get built from the
+     * column store on the first call, which takes considerably more memory
+     * than the column store itself.  Use get_records() or aggregate() on
+     * large caches instead.
+     *
+     * @return all records of this cache.
+     */
     const records_type& get_all_records() const;
+
+    /**
+     * Group the records by the values of the group fields, and compute the
+     * sum and the count of the values of the data field for each group.
+     * Refer to pivot_cache_records::aggregate() for the details.
+     */
+    pivot_cache_aggregate_t aggregate(const std::vector<size_t>& group_fields, size_t data_field) const;
 };
 
 class ORCUS_SPM_DLLPUBLIC pivot_collection
@@ -22,6 +22,7 @@ namespace ixion { class model_context; }
 namespace orcus {
 
 class string_pool;
+struct import_stats;
 
 namespace spreadsheet {
 
@@ -47,6 +48,9 @@ typedef std::vector<format_run> format_runs_t;
 
 /**
  * This class handles global pool of string instances.
+ *
+ * It does not override set_count(), since the strings get stored in the
+ * ixion model context which has no means to reserve storage for them.
  */
 class ORCUS_SPM_DLLPUBLIC import_shared_strings : public iface::import_shared_strings
 {
@@ -82,6 +86,12 @@ public:
 
     void dump() const;
 
+    /**
+     * Set the statistics instance to record the number of strings interned
+     * versus deduplicated into.  Pass nullptr to stop recording.
+     */
+    void set_stats(import_stats* stats);
+
 private:
     orcus::string_pool& m_string_pool;
     ixion::model_context& m_cxt;
@@ -97,6 +107,7 @@ private:
     format_run      m_cur_format;
     format_runs_t* mp_cur_format_runs;
     str_index_map_type m_set;
+    import_stats* mp_stats;
 };
 
 }}
@@ -12,6 +12,7 @@
 #include "orcus/spreadsheet/types.hpp"
 
 #include <ostream>
+#include <ixion/types.hpp>
 #include <ixion/address.hpp>
 #include <ixion/formula_tokens.hpp>
 #include <ixion/formula_result.hpp>
@@ -27,6 +28,13 @@ class document;
 struct sheet_impl;
 struct auto_filter_t;
 
+namespace detail {
+
+class snapshot_writer;
+class snapshot_reader;
+
+}
+
 /**
  * This class represents a single sheet instance in the internal document
  * model.
@@ -42,7 +50,20 @@ public:
     sheet(document& doc, sheet_t sheet_index);
     virtual ~sheet();
 
-    void set_auto(row_t row, col_t col, const char* p, size_t n);
+    /**
+     * Set a value whose type is to be detected.  It gets stored as a
+     * numeric value when it parses as one in its entirety, or as a string
+     * value otherwise.
+     *
+     * @param row row position of the cell.
+     * @param col column position of the cell.
+     * @param p pointer to the first character of the value.
+     * @param n length of the value.
+     *
+     * @return type of the value stored, or ixion::celltype_t::empty when
+     *         the value is empty and nothing got stored.
+     */
+    ixion::celltype_t set_auto(row_t row, col_t col, const char* p, size_t n);
     void set_string(row_t row, col_t col, size_t sindex);
     void set_value(row_t row, col_t col, double value);
     void set_bool(row_t row, col_t col, bool value);
@@ -69,6 +90,16 @@ public:
 
     void set_merge_cell_range(const range_t& range);
 
+    /**
+     * Set the range expected to contain all the data of this sheet.  Only
+     * the column storage of the cell formats gets reserved from it; the
+     * cell values are stored in the ixion model context, which cannot be
+     * pre-sized.  Cells may still be set outside of the range.
+     *
+     * @param range expected data range of this sheet.
+     */
+    void set_data_range_hint(const range_t& range);
+
     void fill_down_cells(row_t src_row, col_t src_col, row_t range_size);
 
     /**
@@ -110,6 +141,34 @@ public:
     void dump_json(std::ostream& os) const;
     void dump_csv(std::ostream& os) const;
 
+    /**
+     * Write the content of this sheet as part of a document snapshot.  Used
+     * by document::save_snapshot().
+     */
+    void write_snapshot(detail::snapshot_writer& writer) const;
+
+    /**
+     * Read the content of this sheet back from a document snapshot.  Used by
+     * document::load_snapshot().  The sheet is expected to be empty.
+     */
+    void read_snapshot(detail::snapshot_reader& reader);
+
+    /**
+     * Write the cell values of this sheet to a stream, and remove them from
+     * the model context.  Used by the document to spill the cell values to
+     * disk.
+     */
+    void spill_cells(std::ostream& os);
+
+    /**
+     * Put the cell values written by spill_cells() back into the model
+     * context.
+     *
+     * @param p pointer to the buffer holding the written cell values.
+     * @param n size of the buffer.
+     */
+    void restore_cells(const char* p, size_t n);
+
     /**
      * Get the cell format ID of specified cell.
      */
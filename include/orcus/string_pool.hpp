@@ -73,6 +73,15 @@ public:
 
     size_t size() const;
 
+    /**
+     * Reserve enough room to hold at least the specified number of strings
+     * without rehashing.  Use this when the number of strings to be interned
+     * is known in advance, e.g. from a count stored in the source document.
+     *
+     * @param n total number of strings expected to be stored.
+     */
+    void reserve(size_t n);
+
     void swap(string_pool& other);
 
     /**
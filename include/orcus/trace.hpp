@@ -0,0 +1,73 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_TRACE_HPP
+#define INCLUDED_ORCUS_TRACE_HPP
+
+#include "orcus/env.hpp"
+
+#include <cstdlib>
+#include <iosfwd>
+
+namespace orcus { namespace trace {
+
+/**
+ * Check whether the library was built with its hot paths instrumented for
+ * tracing.  When it was not, no spans get recorded by the library itself
+ * even while recording is on.
+ *
+ * @return true if the library was built with tracing enabled, false
+ *         otherwise.
+ */
+ORCUS_PSR_DLLPUBLIC bool is_available();
+
+/**
+ * Start recording the spans.  Each thread records its spans into its own
+ * ring buffer of a fixed capacity, and the oldest spans of a thread get
+ * overwritten once its buffer is full.  The buffer of a finished thread
+ * gets reused by the next thread that records a span.
+ */
+ORCUS_PSR_DLLPUBLIC void start();
+
+/**
+ * Stop recording the spans.  The spans recorded so far are kept until
+ * clear() gets called.
+ */
+ORCUS_PSR_DLLPUBLIC void stop();
+
+/**
+ * @return true if the spans are being recorded, false otherwise.
+ */
+ORCUS_PSR_DLLPUBLIC bool is_recording();
+
+/**
+ * Discard all spans recorded so far.
+ */
+ORCUS_PSR_DLLPUBLIC void clear();
+
+/**
+ * @return number of spans currently held in the ring buffers of all
+ *         threads.
+ */
+ORCUS_PSR_DLLPUBLIC size_t get_span_count();
+
+/**
+ * Write all recorded spans in the Chrome trace event format, which can be
+ * loaded into chrome://tracing or Perfetto.  Each span is written as a
+ * complete event, with its timestamp and duration in microseconds.  It is
+ * safe to call this while spans are being recorded, though spans that get
+ * overwritten during the call will be left out.
+ *
+ * @param os output stream to write the trace events to.
+ */
+ORCUS_PSR_DLLPUBLIC void write_chrome_trace(std::ostream& os);
+
+}}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
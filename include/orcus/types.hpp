@@ -428,7 +428,20 @@ enum class dump_format_t
     flat,
     html,
     json,
-    xml
+    xml,
+    xlsx
+};
+
+/**
+ * Type of the values stored in an XML element or attribute that is linked to
+ * cells.  When the type is unknown, it is determined for each value
+ * individually.
+ */
+enum class xml_value_t
+{
+    unknown = 0,
+    numeric,
+    string
 };
 
 struct ORCUS_PSR_DLLPUBLIC length_t
@@ -24,6 +24,12 @@ struct ORCUS_DLLPUBLIC xml_table_range_t
     std::vector<std::string> paths;
     std::vector<std::string> row_groups;
 
+    /**
+     * Type of the values of each field inferred from the content, stored in
+     * the same order as the paths.
+     */
+    std::vector<xml_value_t> value_types;
+
     xml_table_range_t();
     ~xml_table_range_t();
 };
@@ -69,8 +75,17 @@ public:
         bool repeat;
         bool has_content;
 
+        /**
+         * Type of the content inferred from all occurrences of the element.
+         * It is unknown when the element has no content, or when its content
+         * is a mix of numeric and non-numeric values.
+         */
+        xml_value_t value_type;
+
         element();
-        element(const entity_name& _name, bool _repeat, bool _has_content);
+        element(
+            const entity_name& _name, bool _repeat, bool _has_content,
+            xml_value_t _value_type = xml_value_t::unknown);
     };
 
     struct walker_impl;
@@ -141,6 +156,18 @@ public:
          */
         entity_names_type get_attributes();
 
+        /**
+         * Get the type of the values of an attribute that belongs to the
+         * current element, inferred from all occurrences of the attribute.
+         *
+         * @param name name of the attribute.
+         *
+         * @return type of the attribute values, or xml_value_t::unknown if
+         *         the attribute only has empty values, or a mix of numeric
+         *         and non-numeric values.
+         */
+        xml_value_t get_attribute_value_type(const entity_name& name);
+
         /**
          * Get a numerical, 0-based index of given XML namespace.
          *
@@ -28,6 +28,29 @@ class ORCUS_PSR_DLLPUBLIC xml_writer
     void close_current_element();
 
 public:
+    /**
+     * Specifies how the writer keeps the element names and attribute values
+     * passed to it until it needs them.
+     */
+    enum class string_mode
+    {
+        /**
+         * Intern them with the writer's own string pool.  The names
+         * returned by pop_element() remain valid for the lifetime of the
+         * writer, but the pool keeps growing with every distinct string
+         * written.
+         */
+        intern,
+
+        /**
+         * Copy them into buffers that get released as soon as they are no
+         * longer needed, which keeps the memory use bounded regardless of
+         * the size of the output.  The name returned by pop_element() is
+         * only valid until the next call to pop_element().
+         */
+        transient
+    };
+
     class ORCUS_PSR_DLLPUBLIC scope
     {
         friend class xml_writer;
@@ -48,6 +71,16 @@ public:
     xml_writer& operator= (const xml_writer&) = delete;
 
     xml_writer(xmlns_repository& ns_repo, std::ostream& os);
+
+    /**
+     * Constructor.
+     *
+     * @param ns_repo namespace repository to use.
+     * @param os stream to write the content to.
+     * @param mode how to keep the element names and attribute values.
+     *             Namespace aliases and values are always interned.
+     */
+    xml_writer(xmlns_repository& ns_repo, std::ostream& os, string_mode mode);
     xml_writer(xml_writer&& other);
 
     xml_writer& operator= (xml_writer&& other);
@@ -11,6 +11,7 @@
 #include "env.hpp"
 #include <cstdlib>
 #include <exception>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -31,6 +32,81 @@ public:
     virtual const char* what() const throw();
 };
 
+/**
+ * Size and compression information of a single file entry, as recorded in
+ * the central directory of a zip archive.
+ */
+struct ORCUS_PSR_DLLPUBLIC zip_file_entry_stat
+{
+    size_t size_compressed;
+    size_t size_uncompressed;
+    bool compressed;
+
+    zip_file_entry_stat();
+};
+
+/**
+ * Backend used to inflate deflate-compressed file entries.
+ */
+enum class zip_inflate_backend_t
+{
+    /** Pick the fastest backend available in this build. */
+    automatic,
+    /** zlib, which is always available. */
+    zlib,
+    /** libdeflate, available only when orcus is built with it. */
+    libdeflate
+};
+
+/**
+ * Buffer that stores the uncompressed content of a file entry.  Unlike
+ * std::vector, its storage does not get zero-initialized upon allocation,
+ * which saves one full pass over the memory when it is about to be
+ * overwritten by the inflated data anyway.  The content is always followed
+ * by a null terminator which is not counted in its size.
+ */
+class ORCUS_PSR_DLLPUBLIC zip_file_entry_buffer
+{
+    std::unique_ptr<unsigned char[]> m_data;
+    size_t m_size;
+
+public:
+    zip_file_entry_buffer();
+    zip_file_entry_buffer(const zip_file_entry_buffer&) = delete;
+    zip_file_entry_buffer(zip_file_entry_buffer&& other);
+    ~zip_file_entry_buffer();
+
+    zip_file_entry_buffer& operator= (const zip_file_entry_buffer&) = delete;
+    zip_file_entry_buffer& operator= (zip_file_entry_buffer&& other);
+
+    /**
+     * Allocate storage for the specified number of bytes plus the null
+     * terminator.  Any existing content gets discarded, and the new content
+     * is left uninitialized except for the null terminator.
+     *
+     * @param size number of bytes to allocate.
+     */
+    void allocate(size_t size);
+
+    /**
+     * Shrink the size of the content without re-allocating the storage.
+     *
+     * @param size new size, which must not exceed the current size.
+     */
+    void truncate(size_t size);
+
+    void clear();
+
+    unsigned char* data() { return m_data.get(); }
+    const unsigned char* data() const { return m_data.get(); }
+
+    unsigned char& operator[] (size_t pos) { return m_data[pos]; }
+    const unsigned char& operator[] (size_t pos) const { return m_data[pos]; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+};
+
 class ORCUS_PSR_DLLPUBLIC zip_archive
 {
     zip_archive_impl* mp_impl;
@@ -43,6 +119,27 @@ public:
     zip_archive(zip_archive_stream* stream);
     ~zip_archive();
 
+    /**
+     * Check whether or not a specific inflate backend is available in this
+     * build.
+     *
+     * @param backend inflate backend to check.
+     *
+     * @return true if the backend is available, false otherwise.
+     */
+    static bool is_inflate_backend_available(zip_inflate_backend_t backend);
+
+    /**
+     * Set the backend to use to inflate compressed file entries.  Unless
+     * set, the fastest backend available gets used.
+     *
+     * @param backend inflate backend to use.
+     *
+     * @exception zip_error if the specified backend is not available in this
+     *            build.
+     */
+    void set_inflate_backend(zip_inflate_backend_t backend);
+
     /**
      * Loading involves the parsing of the central directory of a zip archive
      * (located toward the end of the stream) and building of file entry data
@@ -83,6 +180,17 @@ public:
      */
     size_t get_file_entry_count() const;
 
+    /**
+     * Get the size and compression information of a file entry.  This
+     * information comes from the central directory and is available without
+     * reading the entry's data stream.
+     *
+     * @param index file entry index
+     *
+     * @return size and compression information of the file entry.
+     */
+    zip_file_entry_stat get_file_entry_stat(size_t index) const;
+
     /**
      * Retrieve data stream of specified file entry into buffer. The retrieved
      * data stream gets uncompressed if the original stream is compressed.
@@ -95,6 +203,37 @@ public:
      * @return true if successful, false otherwise.
      */
     bool read_file_entry(const pstring& entry_name, std::vector<unsigned char>& buf) const;
+
+    /**
+     * Retrieve data stream of specified file entry into buffer.  This is
+     * equivalent to the variant that takes std::vector, except that the
+     * buffer does not get zero-initialized prior to receiving the data, and
+     * that the size of the buffer after the call does not include the null
+     * terminator.
+     *
+     * @param entry_name file entry name
+     * @param buf buffer to put the retrieved data stream into.
+     *
+     * @return true if successful, false otherwise.
+     */
+    bool read_file_entry(const pstring& entry_name, zip_file_entry_buffer& buf) const;
+
+    /**
+     * Retrieve only the leading part of the data stream of specified file
+     * entry.  The compressed stream gets read and uncompressed
+     * incrementally, and the reading stops as soon as the requested number
+     * of bytes has been produced.  The size of the buffer after the call
+     * equals the number of bytes retrieved, which may be less than the
+     * requested size when the entry is shorter.
+     *
+     * @param entry_name file entry name
+     * @param buf buffer to put the retrieved data stream into.
+     * @param max_size maximum number of uncompressed bytes to retrieve.
+     *
+     * @return true if successful, false otherwise.
+     */
+    bool read_file_entry_head(
+        const pstring& entry_name, std::vector<unsigned char>& buf, size_t max_size) const;
 };
 
 }
@@ -0,0 +1,113 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_ZIP_ARCHIVE_WRITER_HPP
+#define INCLUDED_ORCUS_ZIP_ARCHIVE_WRITER_HPP
+
+#include "env.hpp"
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace orcus {
+
+/**
+ * Compresses the content of a single zip file entry as it gets written to
+ * its stream, so that the uncompressed content never needs to be held in
+ * memory as a whole.  Each instance is independent of any archive, which
+ * allows several entries to be compressed on separate threads before they
+ * get added to an archive in order.
+ */
+class ORCUS_PSR_DLLPUBLIC zip_entry_deflater
+{
+    friend class zip_archive_writer;
+
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+
+public:
+    zip_entry_deflater(const zip_entry_deflater&) = delete;
+    zip_entry_deflater& operator= (const zip_entry_deflater&) = delete;
+
+    /**
+     * Constructor.
+     *
+     * @param name name of the file entry, including its directory path.
+     */
+    zip_entry_deflater(std::string name);
+    zip_entry_deflater(zip_entry_deflater&& other);
+    ~zip_entry_deflater();
+
+    const std::string& get_name() const;
+
+    /**
+     * @return stream to write the uncompressed content of the entry to.
+     */
+    std::ostream& get_stream();
+
+    /**
+     * Compress the content remaining in the stream buffer, and end the
+     * compressed stream.  Nothing may be written to the stream afterward.
+     * Calling it more than once has no effect.
+     */
+    void finish();
+};
+
+/**
+ * Writes a zip archive to a stream, one file entry at a time.  All entries
+ * get deflated.  The stream only needs to support sequential writes.
+ */
+class ORCUS_PSR_DLLPUBLIC zip_archive_writer
+{
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+
+public:
+    zip_archive_writer(const zip_archive_writer&) = delete;
+    zip_archive_writer& operator= (const zip_archive_writer&) = delete;
+
+    zip_archive_writer(std::ostream& os);
+
+    /**
+     * Destructor.  Note that it does not write the central directory; call
+     * close() to complete the archive.
+     */
+    ~zip_archive_writer();
+
+    /**
+     * Compress and add a new file entry.
+     *
+     * @param name name of the file entry, including its directory path.
+     * @param p pointer to the content of the entry.
+     * @param n size of the content.
+     */
+    void add_file_entry(const std::string& name, const char* p, size_t n);
+
+    /**
+     * Add a new file entry whose content has been compressed by a deflater.
+     * The deflater gets finished first if it has not been already.
+     *
+     * @param entry deflater holding the compressed content of the entry.
+     */
+    void add_file_entry(zip_entry_deflater& entry);
+
+    /**
+     * Write the central directory to complete the archive.  No more entries
+     * may be added afterward.
+     *
+     * @exception zip_error if the archive exceeds the limits of the zip
+     *            format without the ZIP64 extension.
+     */
+    void close();
+};
+
+}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
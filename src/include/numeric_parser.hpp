@@ -209,6 +209,29 @@ public:
     }
 };
 
+/**
+ * Numeric parser policy to use with parser_base::parse_double<>(), for
+ * parsing numeric values without going through the numeric parser set at
+ * run time.
+ */
+template<typename _Trait>
+struct numeric_parser_policy
+{
+    /**
+     * Parse a numeric value, and move the position past it on success.
+     *
+     * @return a finite value upon successful parsing, else NaN is returned.
+     */
+    static double parse(const char*& p, size_t max_length)
+    {
+        numeric_parser<_Trait> parser(p, p + max_length);
+        double v = parser.parse();
+        if (!std::isnan(v))
+            p = parser.get_char_position();
+        return v;
+    }
+};
+
 }} // namespace orcus::detail
 
 #endif
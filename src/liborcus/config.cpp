@@ -9,6 +9,15 @@
 
 namespace orcus {
 
+config::import_scope::import_scope() :
+    first_row(0), last_row(-1), first_column(0), last_column(-1) {}
+
+bool config::import_scope::is_restricted() const
+{
+    return !sheet_names.empty() || first_row > 0 || last_row >= 0 ||
+        first_column > 0 || last_column >= 0 || !columns.empty();
+}
+
 config::config(format_t input) :
     input_format(input),
     debug(false),
@@ -22,10 +31,14 @@ config::config(format_t input) :
             csv.header_row_size = 0;
             csv.split_to_multiple_sheets = false;
             break;
-        case format_t::gnumeric:
         case format_t::ods:
-        case format_t::xls_xml:
+            ods.thread_count = 0;
+            break;
         case format_t::xlsx:
+            xlsx.prefetch_buffer_size = 64 * 1024 * 1024;
+            break;
+        case format_t::gnumeric:
+        case format_t::xls_xml:
         case format_t::unknown:
         default:
             ;
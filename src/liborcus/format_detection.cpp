@@ -6,6 +6,10 @@
  */
 
 #include "orcus/format_detection.hpp"
+#include "orcus/zip_archive.hpp"
+#include "orcus/zip_archive_stream.hpp"
+
+#include "zip_detection.hpp"
 
 #include <iostream>
 
@@ -50,16 +54,47 @@ using namespace std;
 
 namespace orcus {
 
-format_t detect(const unsigned char* buffer, size_t length)
+namespace {
+
+/**
+ * Load the central directory of a zip package only once, and have each
+ * zip-based format examine the same archive instance.
+ */
+format_t detect_zip_package(const unsigned char* buffer, size_t length)
 {
+    zip_archive_stream_blob stream(buffer, length);
+    zip_archive archive(&stream);
+    try
+    {
+        archive.load();
+    }
+    catch (const zip_error&)
+    {
+        // Not a valid zip archive.
+        return format_t::unknown;
+    }
+
 #if ODS_ENABLED
-    if (orcus_ods::detect(buffer, length))
+    if (detect_ods_package(archive))
         return format_t::ods;
 #endif
 #if XLSX_ENABLED
-    if (orcus_xlsx::detect(buffer, length))
+    if (detect_xlsx_package(archive))
         return format_t::xlsx;
 #endif
+
+    return format_t::unknown;
+}
+
+}
+
+format_t detect(const unsigned char* buffer, size_t length)
+{
+#if ODS_ENABLED || XLSX_ENABLED
+    if (has_zip_signature(buffer, length))
+        // None of the other formats can start with a zip signature.
+        return detect_zip_package(buffer, length);
+#endif
 #if GNUMERIC_ENABLED
     if (orcus_gnumeric::detect(buffer, length))
         return format_t::gnumeric;
@@ -8,7 +8,9 @@
 #include "orcus/format_detection.hpp"
 #include "orcus/stream.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <string>
 
@@ -37,9 +39,64 @@ void test_detect_formats()
     }
 }
 
+/**
+ * Wrap the content in a gzip stream made of stored deflate blocks, which
+ * are not compressed.
+ */
+std::string make_stored_gzip(const std::string& content)
+{
+    auto push_uint = [](std::string& s, uint32_t v, int n)
+    {
+        for (int i = 0; i < n; ++i, v >>= 8)
+            s.push_back(static_cast<char>(v & 0xFF));
+    };
+
+    std::string gz = { '\x1f', '\x8b', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff' };
+
+    size_t pos = 0;
+    do
+    {
+        uint32_t len = std::min<size_t>(content.size() - pos, 0xFFFF);
+        bool final_block = pos + len == content.size();
+        gz.push_back(final_block ? 1 : 0);
+        push_uint(gz, len, 2);
+        push_uint(gz, ~len, 2);
+        gz.append(content, pos, len);
+        pos += len;
+    }
+    while (pos < content.size());
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (unsigned char c : content)
+    {
+        crc ^= c;
+        for (int i = 0; i < 8; ++i)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+
+    push_uint(gz, ~crc, 4);
+    push_uint(gz, content.size(), 4);
+    return gz;
+}
+
+void test_detect_gzip_non_gnumeric()
+{
+    // A large gzip-compressed xml stream whose root element is not
+    // <gnm:Workbook> must not be detected as a gnumeric document.
+    std::string xml = "<?xml version=\"1.0\"?><root>";
+    while (xml.size() < 4 * 1024 * 1024)
+        xml += "<a>b</a>";
+    xml += "</root>";
+
+    std::string gz = make_stored_gzip(xml);
+    format_t detected = detect(reinterpret_cast<const unsigned char*>(gz.data()), gz.size());
+    assert(detected == format_t::unknown);
+}
+
 int main()
 {
     test_detect_formats();
+    test_detect_gzip_non_gnumeric();
     return EXIT_SUCCESS;
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -116,6 +116,7 @@ private:
 gnumeric_cell_context::gnumeric_cell_context(session_context& session_cxt, const tokens& tokens, spreadsheet::iface::import_factory* factory, spreadsheet::iface::import_sheet* sheet) :
     xml_context_base(session_cxt, tokens),
     mp_factory(factory),
+    m_chars_transient(false),
     mp_sheet(sheet)
 {
 }
@@ -146,6 +147,8 @@ void gnumeric_cell_context::start_element(xmlns_id_t ns, xml_token_t name, const
     {
         switch (name)
         {
+            case XML_Cells:
+                break;
             case XML_Cell:
                 start_cell(attrs);
                 break;
@@ -163,6 +166,9 @@ bool gnumeric_cell_context::end_element(xmlns_id_t ns, xml_token_t name)
     {
         switch (name)
         {
+            case XML_Cells:
+                flush_strings();
+                break;
             case XML_Cell:
                 end_cell();
                 break;
@@ -175,8 +181,14 @@ bool gnumeric_cell_context::end_element(xmlns_id_t ns, xml_token_t name)
 
 void gnumeric_cell_context::characters(const pstring& str, bool transient)
 {
+    m_chars_transient = transient;
+
     if (transient)
-        chars = m_pool.intern(str).first;
+    {
+        m_chars_buffer.reset();
+        m_chars_buffer.append(str.get(), str.size());
+        chars = pstring(m_chars_buffer.get(), m_chars_buffer.size());
+    }
     else
         chars = str;
 }
@@ -206,12 +218,12 @@ void gnumeric_cell_context::end_cell()
         break;
         case cell_type_string:
         {
-            spreadsheet::iface::import_shared_strings* shared_strings = mp_factory->get_shared_strings();
-            if (!shared_strings)
-                break;
-
-            size_t id = shared_strings->add(chars.get(), chars.size());
-            mp_sheet->set_string(row, col, id);
+            // The strings get added in batches, and their cells get set
+            // afterward.
+            m_strings.push_back(chars, m_chars_transient);
+            m_string_cells.push_back({row, col});
+            if (m_strings.size() >= string_batch::flush_size)
+                flush_strings();
         }
         break;
         case cell_type_formula:
@@ -270,5 +282,25 @@ void gnumeric_cell_context::end_cell()
     mp_cell_data.reset();
 }
 
+void gnumeric_cell_context::flush_strings()
+{
+    if (m_strings.empty())
+        return;
+
+    spreadsheet::iface::import_shared_strings* shared_strings = mp_factory->get_shared_strings();
+    if (shared_strings)
+    {
+        const pstring* strs = m_strings.get();
+        for (size_t i = 0, n = m_strings.size(); i < n; ++i)
+        {
+            size_t sid = shared_strings->add(strs[i].get(), strs[i].size());
+            mp_sheet->set_string(m_string_cells[i].row, m_string_cells[i].col, sid);
+        }
+    }
+
+    m_strings.clear();
+    m_string_cells.clear();
+}
+
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -9,8 +9,12 @@
 #define INCLUDED_ORCUS_GNUMERIC_CELL_CONTEXT_HPP
 
 #include "xml_context_base.hpp"
+#include "string_batch.hpp"
 
-#include "orcus/string_pool.hpp"
+#include "orcus/cell_buffer.hpp"
+#include "orcus/spreadsheet/types.hpp"
+
+#include <vector>
 
 namespace orcus {
 
@@ -40,17 +44,38 @@ public:
 private:
     void start_cell(const xml_attrs_t& attrs);
     void end_cell();
+
+    /**
+     * Add the strings of the string cells collected so far to the shared
+     * strings store, and set them to their cells.
+     */
+    void flush_strings();
+
 private:
+    struct string_cell
+    {
+        spreadsheet::row_t row;
+        spreadsheet::col_t col;
+    };
+
     spreadsheet::iface::import_factory* mp_factory;
 
     std::unique_ptr<gnumeric_cell_data> mp_cell_data;
 
-    string_pool m_pool;
+    /**
+     * Stores the transient characters, which are only valid for the duration
+     * of the characters() call.
+     */
+    cell_buffer m_chars_buffer;
 
     /**
     * Used for temporary storage of characters
     */
     pstring chars;
+    bool m_chars_transient;
+
+    string_batch m_strings;
+    std::vector<string_cell> m_string_cells;
 
     spreadsheet::iface::import_sheet* mp_sheet;
 };
@@ -215,9 +215,13 @@ void test_cell_string()
     attrs.push_back(xml_token_attr_t(NS_gnumeric_gnm, XML_Row, "10", false));
     attrs.push_back(xml_token_attr_t(NS_gnumeric_gnm, XML_Col, "321", false));
     attrs.push_back(xml_token_attr_t(NS_gnumeric_gnm, XML_ValueType, "60", false));
+    context.start_element(ns, XML_Cells, orcus::xml_attrs_t());
     context.start_element(ns, elem, attrs);
     context.characters("14 char string", false);
     context.end_element(ns, elem);
+
+    // String cells get set at the end of the cells element.
+    context.end_element(ns, XML_Cells);
 }
 
 void test_shared_formula_with_string()
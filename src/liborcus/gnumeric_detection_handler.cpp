@@ -33,6 +33,13 @@ public:
     virtual void start_element(xmlns_id_t ns, xml_token_t name, const::std::vector<xml_token_attr_t>& /*attrs*/)
     {
         xml_token_pair_t parent = push_stack(ns, name);
+
+        // Reject the stream right away when its root element is not
+        // <gnm:Workbook>, rather than reading it to the end.
+        if (parent.first == XMLNS_UNKNOWN_ID && parent.second == XML_UNKNOWN_TOKEN &&
+            (ns != NS_gnumeric_gnm || name != XML_Workbook))
+            throw detection_result(false);
+
         if (ns == NS_gnumeric_gnm)
         {
             switch (name)
@@ -0,0 +1,90 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "import_scope_filter.hpp"
+
+#include "orcus/pstring.hpp"
+
+#include <algorithm>
+
+namespace orcus {
+
+import_scope_filter::import_scope_filter() :
+    m_first_row(0), m_last_row(-1), m_first_col(0), m_last_col(-1), m_restricted(false) {}
+
+import_scope_filter::import_scope_filter(const config::import_scope& scope) :
+    import_scope_filter()
+{
+    reset(scope);
+}
+
+void import_scope_filter::reset(const config::import_scope& scope)
+{
+    m_sheet_names = scope.sheet_names;
+    m_first_row = std::max<spreadsheet::row_t>(0, scope.first_row);
+    m_last_row = scope.last_row;
+    m_first_col = std::max<spreadsheet::col_t>(0, scope.first_column);
+    m_last_col = scope.last_column;
+    m_restricted = scope.is_restricted();
+
+    m_column_mask.clear();
+
+    if (scope.columns.empty())
+        return;
+
+    spreadsheet::col_t max_col = *std::max_element(scope.columns.begin(), scope.columns.end());
+    if (max_col < 0)
+    {
+        // None of the listed columns is valid.  Exclude all columns.
+        m_last_col = 0;
+        m_first_col = 1;
+        return;
+    }
+
+    m_column_mask.resize(max_col+1, false);
+    for (spreadsheet::col_t col : scope.columns)
+    {
+        if (col >= 0)
+            m_column_mask[col] = true;
+    }
+}
+
+bool import_scope_filter::is_sheet_included(const pstring& name) const
+{
+    if (m_sheet_names.empty())
+        return true;
+
+    return std::any_of(m_sheet_names.begin(), m_sheet_names.end(),
+        [&name](const std::string& v) { return name == v; }
+    );
+}
+
+bool import_scope_filter::is_column_range_included(spreadsheet::col_t first, spreadsheet::col_t last) const
+{
+    if (last < m_first_col || (m_last_col >= 0 && first > m_last_col))
+        return false;
+
+    if (m_column_mask.empty())
+        return true;
+
+    first = std::max(first, m_first_col);
+    if (m_last_col >= 0)
+        last = std::min(last, m_last_col);
+    last = std::min<spreadsheet::col_t>(last, m_column_mask.size()-1);
+
+    for (spreadsheet::col_t col = first; col <= last; ++col)
+    {
+        if (m_column_mask[col])
+            return true;
+    }
+
+    return false;
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
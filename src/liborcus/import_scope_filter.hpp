@@ -0,0 +1,93 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_IMPORT_SCOPE_FILTER_HPP
+#define INCLUDED_ORCUS_IMPORT_SCOPE_FILTER_HPP
+
+#include "orcus/config.hpp"
+
+#include <vector>
+
+namespace orcus {
+
+class pstring;
+
+/**
+ * Pre-processed form of config::import_scope, used by the import filters to
+ * quickly decide whether or not to skip a sheet, a row or a cell.
+ */
+class import_scope_filter
+{
+    std::vector<std::string> m_sheet_names;
+    std::vector<bool> m_column_mask; /// only used when specific columns are given.
+    spreadsheet::row_t m_first_row;
+    spreadsheet::row_t m_last_row;
+    spreadsheet::col_t m_first_col;
+    spreadsheet::col_t m_last_col;
+    bool m_restricted;
+
+public:
+    import_scope_filter();
+    import_scope_filter(const config::import_scope& scope);
+
+    void reset(const config::import_scope& scope);
+
+    bool is_restricted() const { return m_restricted; }
+
+    bool is_sheet_included(const pstring& name) const;
+
+    bool is_row_included(spreadsheet::row_t row) const
+    {
+        return m_first_row <= row && (m_last_row < 0 || row <= m_last_row);
+    }
+
+    /**
+     * @return true if at least one row in the specified range is included,
+     *         false otherwise.
+     */
+    bool is_row_range_included(spreadsheet::row_t first, spreadsheet::row_t last) const
+    {
+        return m_first_row <= last && (m_last_row < 0 || first <= m_last_row);
+    }
+
+    /**
+     * @return true if the specified row is past the last row to import,
+     *         which means that no more rows will ever be included.
+     */
+    bool is_past_last_row(spreadsheet::row_t row) const
+    {
+        return m_last_row >= 0 && row > m_last_row;
+    }
+
+    bool is_column_included(spreadsheet::col_t col) const
+    {
+        if (col < m_first_col || (m_last_col >= 0 && col > m_last_col))
+            return false;
+
+        if (m_column_mask.empty())
+            return true;
+
+        return size_t(col) < m_column_mask.size() && m_column_mask[col];
+    }
+
+    /**
+     * @return true if at least one column in the specified range is
+     *         included, false otherwise.
+     */
+    bool is_column_range_included(spreadsheet::col_t first, spreadsheet::col_t last) const;
+
+    bool is_cell_included(spreadsheet::row_t row, spreadsheet::col_t col) const
+    {
+        return !m_restricted || (is_row_included(row) && is_column_included(col));
+    }
+};
+
+}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,117 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/import_stats.hpp"
+
+#include <ostream>
+
+namespace orcus {
+
+namespace {
+
+import_stats::part& get_part(std::vector<import_stats::part>& parts, const std::string& path)
+{
+    // A part is normally parsed right after it has been decompressed, so
+    // start looking from the most recent entry.
+    for (auto it = parts.rbegin(); it != parts.rend(); ++it)
+    {
+        if (it->path == path)
+            return *it;
+    }
+
+    parts.emplace_back();
+    parts.back().path = path;
+    return parts.back();
+}
+
+void dump_phase(std::ostream& os, const char* name, const import_stats::phase& ph)
+{
+    if (!ph.count)
+        return;
+
+    os << "  " << name << ":" << std::endl;
+    os << "    duration: " << ph.duration << std::endl;
+    os << "    bytes: " << ph.bytes << std::endl;
+    os << "    count: " << ph.count << std::endl;
+}
+
+}
+
+void import_stats::add_inflate(const std::string& path, size_t size, double duration)
+{
+    part& p = get_part(parts, path);
+    p.size = size;
+    p.inflate_duration += duration;
+
+    inflate.duration += duration;
+    inflate.bytes += size;
+    ++inflate.count;
+}
+
+void import_stats::add_parse(const std::string& path, size_t size, double duration)
+{
+    part& p = get_part(parts, path);
+    p.size = size;
+    p.parse_duration += duration;
+
+    parse.duration += duration;
+    parse.bytes += size;
+    ++parse.count;
+}
+
+void import_stats::reset()
+{
+    *this = import_stats();
+}
+
+void import_stats::dump(std::ostream& os) const
+{
+    os << "phases:" << std::endl;
+    dump_phase(os, "total", total);
+    dump_phase(os, "zip-directory", zip_directory);
+    dump_phase(os, "inflate", inflate);
+    dump_phase(os, "parse", parse);
+    dump_phase(os, "shared-strings", shared_strings);
+    dump_phase(os, "styles", styles);
+    dump_phase(os, "formulas", formulas);
+    dump_phase(os, "recalc", recalc);
+    dump_phase(os, "finalize", finalize);
+
+    if (!parts.empty())
+    {
+        os << "parts:" << std::endl;
+        for (const part& p : parts)
+        {
+            os << "  - path: " << p.path << std::endl;
+            os << "    size: " << p.size << std::endl;
+            os << "    inflate: " << p.inflate_duration << std::endl;
+            os << "    parse: " << p.parse_duration << std::endl;
+        }
+    }
+
+    os << "cells:" << std::endl;
+    os << "  numeric: " << cells.numeric << std::endl;
+    os << "  string: " << cells.string << std::endl;
+    os << "  boolean: " << cells.boolean << std::endl;
+    os << "  date-time: " << cells.date_time << std::endl;
+    os << "  formula: " << cells.formula << std::endl;
+
+    os << "strings:" << std::endl;
+    os << "  interned: " << strings.interned << std::endl;
+    os << "  deduplicated: " << strings.deduplicated << std::endl;
+
+    if (style_entries.stored || style_entries.deduplicated)
+    {
+        os << "style-entries:" << std::endl;
+        os << "  stored: " << style_entries.stored << std::endl;
+        os << "  deduplicated: " << style_entries.deduplicated << std::endl;
+    }
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,95 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_IMPORT_STATS_TIMER_HPP
+#define INCLUDED_ORCUS_IMPORT_STATS_TIMER_HPP
+
+#include "orcus/import_stats.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace orcus {
+
+class stop_watch
+{
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    stop_watch() : m_start(std::chrono::steady_clock::now()) {}
+
+    /**
+     * @return time elapsed since the construction in seconds.
+     */
+    double elapsed() const
+    {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - m_start;
+        return d.count();
+    }
+};
+
+/**
+ * Adds the time elapsed during its lifetime to one phase of the import
+ * statistics.  It does nothing when no statistics instance is given.
+ */
+class phase_timer
+{
+    import_stats::phase* mp_phase;
+    size_t m_bytes;
+    stop_watch m_watch;
+
+public:
+    phase_timer(import_stats* stats, import_stats::phase import_stats::*ph, size_t bytes = 0) :
+        mp_phase(stats ? &(stats->*ph) : nullptr), m_bytes(bytes) {}
+
+    ~phase_timer()
+    {
+        stop();
+    }
+
+    /**
+     * Record the elapsed time now rather than at destruction.  Calling it
+     * more than once has no effect.
+     */
+    void stop()
+    {
+        if (!mp_phase)
+            return;
+
+        mp_phase->duration += m_watch.elapsed();
+        mp_phase->bytes += m_bytes;
+        ++mp_phase->count;
+        mp_phase = nullptr;
+    }
+};
+
+/**
+ * Adds the time elapsed during its lifetime to the parse time of a part.
+ */
+class part_parse_timer
+{
+    import_stats* mp_stats;
+    const std::string& m_path;
+    size_t m_size;
+    stop_watch m_watch;
+
+public:
+    part_parse_timer(import_stats* stats, const std::string& path, size_t size) :
+        mp_stats(stats), m_path(path), m_size(size) {}
+
+    ~part_parse_timer()
+    {
+        if (mp_stats)
+            mp_stats->add_parse(m_path, m_size, m_watch.elapsed());
+    }
+};
+
+}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
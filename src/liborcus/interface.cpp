@@ -8,12 +8,14 @@
 #include "orcus/interface.hpp"
 #include "orcus/config.hpp"
 #include "orcus/global.hpp"
+#include "orcus/import_stats.hpp"
 
 namespace orcus { namespace iface {
 
 struct import_filter::impl
 {
     orcus::config m_config;
+    import_stats m_stats;
 
     impl(format_t input) : m_config(input) {}
 };
@@ -32,6 +34,16 @@ const config& import_filter::get_config() const
     return mp_impl->m_config;
 }
 
+const import_stats& import_filter::get_stats() const
+{
+    return mp_impl->m_stats;
+}
+
+import_stats& import_filter::get_stats()
+{
+    return mp_impl->m_stats;
+}
+
 document_dumper::~document_dumper() {}
 
 }}
@@ -11,6 +11,7 @@
 #include "odf_styles_context.hpp"
 #include "session_context.hpp"
 #include "ods_session_data.hpp"
+#include "import_stats_timer.hpp"
 
 #include "orcus/global.hpp"
 #include "orcus/spreadsheet/import_interface.hpp"
@@ -287,7 +288,12 @@ ods_content_xml_context::ods_content_xml_context(session_context& session_cxt, c
     m_row(0), m_col(0),
     m_para_index(0),
     m_has_content(false),
-    m_styles(),
+    m_skip_table(false),
+    m_skip_row(false),
+    m_skip_cell(false),
+    m_separate_tables(false),
+    m_styles_store(),
+    m_styles(m_styles_store),
     m_child_para(session_cxt, tokens, factory->get_shared_strings(), m_styles),
     m_child_dde_links(session_cxt, tokens)
 {
@@ -299,6 +305,28 @@ ods_content_xml_context::ods_content_xml_context(session_context& session_cxt, c
     }
 }
 
+ods_content_xml_context::ods_content_xml_context(
+    session_context& session_cxt, const tokens& tokens, const ods_content_xml_context& parent,
+    ss::sheet_t sheet_index, ss::iface::import_sheet* sheet, ss::iface::import_shared_strings* strings) :
+    xml_context_base(session_cxt, tokens),
+    mp_factory(nullptr),
+    m_row(0), m_col(0),
+    m_para_index(0),
+    m_has_content(false),
+    m_skip_table(false),
+    m_skip_row(false),
+    m_skip_cell(false),
+    m_separate_tables(false),
+    m_styles_store(),
+    m_styles(parent.m_styles),
+    m_cell_format_map(parent.m_cell_format_map),
+    m_child_para(session_cxt, tokens, strings, m_styles),
+    m_child_dde_links(session_cxt, tokens)
+{
+    m_table_sheet.sheet = sheet;
+    m_table_sheet.index = sheet_index;
+}
+
 ods_content_xml_context::~ods_content_xml_context()
 {
 }
@@ -306,7 +334,9 @@ ods_content_xml_context::~ods_content_xml_context()
 bool ods_content_xml_context::can_handle_element(xmlns_id_t ns, xml_token_t name) const
 {
     if (ns == NS_odf_text && name == XML_p)
-        return false;
+        // Paragraphs of skipped cells get ignored by this context, to avoid
+        // interning their strings.
+        return m_skip_cell;
 
     if (ns == NS_odf_office && name == XML_automatic_styles)
         return false;
@@ -414,6 +444,10 @@ void ods_content_xml_context::start_element(xmlns_id_t ns, xml_token_t name, con
 {
     xml_token_pair_t parent = push_stack(ns, name);
 
+    if (m_skip_cell && ns == NS_odf_text)
+        // Content of a cell outside the import scope.
+        return;
+
     if (ns == NS_odf_office)
     {
         switch (name)
@@ -504,7 +538,8 @@ bool ods_content_xml_context::end_element(xmlns_id_t ns, xml_token_t name)
             case XML_body:
                 break;
             case XML_spreadsheet:
-                end_spreadsheet();
+                if (!m_separate_tables)
+                    end_spreadsheet();
                 break;
             default:
                 ;
@@ -547,6 +582,16 @@ void ods_content_xml_context::characters(const pstring& /*str*/, bool /*transien
 {
 }
 
+void ods_content_xml_context::set_separate_tables(bool b)
+{
+    m_separate_tables = b;
+}
+
+const std::vector<ss::iface::import_sheet*>& ods_content_xml_context::get_tables() const
+{
+    return m_tables;
+}
+
 void ods_content_xml_context::start_null_date(const xml_attrs_t& attrs)
 {
     spreadsheet::iface::import_global_settings* gs = mp_factory->get_global_settings();
@@ -562,22 +607,41 @@ void ods_content_xml_context::start_null_date(const xml_attrs_t& attrs)
 
 void ods_content_xml_context::start_table(const xml_token_pair_t& parent, const xml_attrs_t& attrs)
 {
-    static const xml_elem_set_t expected = {
-        { NS_odf_office, XML_spreadsheet },
-        { NS_odf_table, XML_dde_link },
-    };
-    xml_element_expected(parent, expected);
+    // The only table this context parses is the root element.
+    bool table_root = m_table_sheet.sheet && parent == xml_token_pair_t(XMLNS_UNKNOWN_ID, XML_UNKNOWN_TOKEN);
+
+    if (!table_root)
+    {
+        static const xml_elem_set_t expected = {
+            { NS_odf_office, XML_spreadsheet },
+            { NS_odf_table, XML_dde_link },
+        };
+        xml_element_expected(parent, expected);
+    }
 
-    if (parent == xml_token_pair_t(NS_odf_office, XML_spreadsheet))
+    if (table_root || parent == xml_token_pair_t(NS_odf_office, XML_spreadsheet))
     {
         table_attr_parser parser = for_each(attrs.begin(), attrs.end(), table_attr_parser());
         const pstring& name = parser.get_name();
-        m_tables.push_back(mp_factory->append_sheet(m_tables.size(), name.get(), name.size()));
-        m_cur_sheet.sheet = m_tables.back();
-        m_cur_sheet.index = m_tables.size() - 1;
+
+        if (table_root)
+            m_cur_sheet = m_table_sheet;
+        else
+        {
+            m_tables.push_back(mp_factory->append_sheet(m_tables.size(), name.get(), name.size()));
+            m_cur_sheet.sheet = m_tables.back();
+            m_cur_sheet.index = m_tables.size() - 1;
+        }
+
+        m_scope.reset(get_config().scope);
+        m_skip_table = !m_scope.is_sheet_included(name);
 
         if (get_config().debug)
+        {
             cout << "start table " << name << endl;
+            if (m_skip_table)
+                cout << "table is outside the import scope. skipping." << endl;
+        }
 
         m_row = m_col = 0;
     }
@@ -590,6 +654,8 @@ void ods_content_xml_context::start_table(const xml_token_pair_t& parent, const
 
 void ods_content_xml_context::end_table()
 {
+    m_skip_table = false;
+
     if (m_cur_sheet.sheet)
     {
         if (get_config().debug)
@@ -691,6 +757,13 @@ void ods_content_xml_context::start_row(const xml_attrs_t& attrs)
     if (get_config().debug)
         cout << "row: (style='" << style_name << "')" << endl;
 
+    m_skip_row = m_skip_table;
+    if (!m_skip_row && m_scope.is_restricted())
+    {
+        int row_last = m_row + std::max(m_row_attr.number_rows_repeated, 1L) - 1;
+        m_skip_row = !m_scope.is_row_range_included(m_row, row_last);
+    }
+
     if (!m_cur_sheet.sheet)
         return;
 
@@ -728,23 +801,60 @@ void ods_content_xml_context::end_row()
 void ods_content_xml_context::start_cell(const xml_attrs_t& attrs)
 {
     m_cell_attr = cell_attr();
+
+    if (m_skip_row || m_scope.is_restricted())
+    {
+        // Only pick up the column repeat count first, and decide whether or
+        // not to skip this cell before parsing any of its values.
+        for (const xml_token_attr_t& attr : attrs)
+        {
+            if (attr.ns == NS_odf_table && attr.name == XML_number_columns_repeated)
+                m_cell_attr.number_columns_repeated = to_long(attr.value);
+        }
+
+        int col_last = m_col + std::max(m_cell_attr.number_columns_repeated, 1L) - 1;
+        m_skip_cell = m_skip_row || !m_scope.is_column_range_included(m_col, col_last);
+
+        if (m_skip_cell)
+            return;
+    }
+
     for_each(attrs.begin(), attrs.end(), cell_attr_parser(get_session_context(), m_cell_attr));
 }
 
 void ods_content_xml_context::end_cell()
 {
+    if (m_skip_cell)
+    {
+        m_col += std::max(m_cell_attr.number_columns_repeated, 1L);
+        m_skip_cell = false;
+        m_has_content = false;
+        return;
+    }
+
+    // When the import scope is restricted, a repeated cell may only be
+    // partially in scope.
+    bool check_scope = m_scope.is_restricted();
+
     name2id_type::const_iterator it = m_cell_format_map.find(m_cell_attr.style_name);
     if (m_cur_sheet.sheet && it != m_cell_format_map.end())
-        m_cur_sheet.sheet->set_format(m_row, m_col, it->second);
+    {
+        if (!check_scope || m_scope.is_cell_included(m_row, m_col))
+            m_cur_sheet.sheet->set_format(m_row, m_col, it->second);
+    }
 
-    push_cell_value();
+    if (!check_scope || m_scope.is_cell_included(m_row, m_col))
+        push_cell_value();
 
     ++m_col;
     if (m_cell_attr.number_columns_repeated > 1)
     {
         int col_upper = m_col + m_cell_attr.number_columns_repeated - 2;
         for (; m_col <= col_upper; ++m_col)
-            push_cell_value();
+        {
+            if (!check_scope || m_scope.is_cell_included(m_row, m_col))
+                push_cell_value();
+        }
     }
     m_has_content = false;
 }
@@ -868,6 +978,9 @@ void ods_content_xml_context::end_spreadsheet()
     // Push all formula cells.  Formula cells needs to be processed after all
     // the sheet data have been imported, else 3D reference would fail to
     // resolve.
+    import_stats* stats = get_session_context().mp_stats;
+    phase_timer timer(stats, &import_stats::formulas);
+
     for (ods_session_data::formula& data : ods_data.m_formulas)
     {
         if (data.sheet < 0 || static_cast<size_t>(data.sheet) >= m_tables.size())
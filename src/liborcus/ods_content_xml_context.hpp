@@ -12,6 +12,7 @@
 #include "odf_para_context.hpp"
 #include "ods_dde_links_context.hpp"
 #include "odf_styles.hpp"
+#include "import_scope_filter.hpp"
 #include "orcus/spreadsheet/types.hpp"
 
 #include <vector>
@@ -23,6 +24,7 @@ namespace spreadsheet { namespace iface {
 
 class import_factory;
 class import_sheet;
+class import_shared_strings;
 
 }}
 
@@ -64,6 +66,24 @@ public:
     };
 
     ods_content_xml_context(session_context& session_cxt, const tokens& tokens, spreadsheet::iface::import_factory* factory);
+
+    /**
+     * Construct a context that parses a single table element on its own, as
+     * the root element of the stream.  The sheet for the table must already
+     * exist, and the automatic styles get picked up from the context that
+     * has parsed the rest of the content, which must outlive this context.
+     * It doesn't access the import factory.
+     *
+     * @param parent context that has parsed the rest of the content.
+     * @param sheet_index index of the sheet for the table.
+     * @param sheet sheet to import the table into.
+     * @param strings shared strings to pass the cell strings to.
+     */
+    ods_content_xml_context(
+        session_context& session_cxt, const tokens& tokens, const ods_content_xml_context& parent,
+        spreadsheet::sheet_t sheet_index, spreadsheet::iface::import_sheet* sheet,
+        spreadsheet::iface::import_shared_strings* strings);
+
     virtual ~ods_content_xml_context();
 
     virtual bool can_handle_element(xmlns_id_t ns, xml_token_t name) const;
@@ -74,6 +94,25 @@ public:
     virtual bool end_element(xmlns_id_t ns, xml_token_t name);
     virtual void characters(const pstring& str, bool transient);
 
+    /**
+     * Specify whether or not the tables are parsed by separate contexts.
+     * When true, the named expressions and the formula cells don't get
+     * pushed at the end of the spreadsheet element; call end_spreadsheet()
+     * once all tables have been parsed.
+     */
+    void set_separate_tables(bool b);
+
+    /**
+     * @return sheets created for the tables, in order of appearance.
+     */
+    const std::vector<spreadsheet::iface::import_sheet*>& get_tables() const;
+
+    /**
+     * Push the named expressions and the formula cells stored in the
+     * session data.
+     */
+    void end_spreadsheet();
+
 private:
     void start_null_date(const xml_attrs_t& attrs);
 
@@ -97,12 +136,11 @@ private:
 
     void push_cell_value();
 
-    void end_spreadsheet();
-
 private:
     spreadsheet::iface::import_factory* mp_factory;
     std::vector<spreadsheet::iface::import_sheet*> m_tables;
     sheet_data m_cur_sheet;
+    sheet_data m_table_sheet; /// sheet of the only table to parse, if any.
 
     std::unique_ptr<xml_context_base> mp_child;
 
@@ -114,7 +152,14 @@ private:
     size_t m_para_index;
     bool m_has_content;
 
-    odf_styles_map_type m_styles; /// map storing all automatic styles by their names.
+    import_scope_filter m_scope; /// scope of the sheets and cells to import.
+    bool m_skip_table:1; /// whether or not the current table is outside the import scope.
+    bool m_skip_row:1;   /// whether or not the current row is outside the import scope.
+    bool m_skip_cell:1;  /// whether or not the current cell is outside the import scope.
+    bool m_separate_tables:1; /// whether or not the tables are parsed by separate contexts.
+
+    odf_styles_map_type m_styles_store; /// automatic styles picked up by this context.
+    odf_styles_map_type& m_styles; /// map storing all automatic styles by their names.
     name2id_type m_cell_format_map; /// map of style names to cell format (xf) IDs.
 
     text_para_context m_child_para;
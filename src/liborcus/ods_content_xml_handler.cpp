@@ -27,5 +27,10 @@ void ods_content_xml_handler::end_document()
 {
 }
 
+ods_content_xml_context& ods_content_xml_handler::get_context()
+{
+    return static_cast<ods_content_xml_context&>(get_root_context());
+}
+
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -33,6 +33,8 @@ public:
 
     virtual void start_document();
     virtual void end_document();
+
+    ods_content_xml_context& get_context();
 };
 
 }
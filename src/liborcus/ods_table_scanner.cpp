@@ -0,0 +1,370 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ods_table_scanner.hpp"
+#include "odf_namespace_types.hpp"
+
+#include "orcus/parser_global.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace orcus {
+
+namespace {
+
+bool is_name_end(char c)
+{
+    return is_blank(c) || c == '>' || c == '/';
+}
+
+const char* find_char(const char* p, const char* end, char c)
+{
+    return static_cast<const char*>(std::memchr(p, c, end - p));
+}
+
+const char* find_str(const char* p, const char* end, const char* s, size_t n)
+{
+    const char* it = std::search(p, end, s, s + n);
+    return it == end ? nullptr : it;
+}
+
+/**
+ * Check if the name of the tag that begins at the specified position
+ * matches a given name.
+ */
+bool match_name(const char* p, const char* end, const pstring& name)
+{
+    size_t n = name.size();
+    return size_t(end - p) > n && !std::memcmp(p, name.get(), n) && is_name_end(p[n]);
+}
+
+/**
+ * Skip a comment, a CDATA section or a processing instruction.
+ *
+ * @param p position of the '<' that begins it.
+ *
+ * @return position right after it, or nullptr if it's something else, such
+ *         as a document type declaration, or it is not terminated.
+ */
+const char* skip_special(const char* p, const char* end)
+{
+    size_t n = end - p;
+
+    if (n >= 4 && !std::strncmp(p, "<!--", 4))
+    {
+        const char* it = find_str(p + 4, end, "-->", 3);
+        return it ? it + 3 : nullptr;
+    }
+
+    if (n >= 9 && !std::strncmp(p, "<![CDATA[", 9))
+    {
+        const char* it = find_str(p + 9, end, "]]>", 3);
+        return it ? it + 3 : nullptr;
+    }
+
+    if (n >= 2 && p[1] == '?')
+    {
+        const char* it = find_str(p + 2, end, "?>", 2);
+        return it ? it + 2 : nullptr;
+    }
+
+    return nullptr;
+}
+
+/**
+ * Find the '>' that ends the current tag.  Attribute values may contain
+ * '>' but never '<', so only the quoted values need special care.
+ */
+const char* find_tag_end(const char* p, const char* end)
+{
+    char quote = 0;
+    for (; p != end; ++p)
+    {
+        if (quote)
+        {
+            if (*p == quote)
+                quote = 0;
+            continue;
+        }
+
+        if (*p == '"' || *p == '\'')
+            quote = *p;
+        else if (*p == '>')
+            return p;
+    }
+
+    return nullptr;
+}
+
+}
+
+ods_table_scanner::ods_table_scanner(const char* p, size_t n) :
+    mp_begin(p), mp_end(p + n), m_spreadsheet_depth(0) {}
+
+bool ods_table_scanner::scan()
+{
+    m_decls.clear();
+    m_decl_marks.clear();
+    m_spreadsheet_depth = 0;
+    m_tables.clear();
+    m_table_decls.clear();
+
+    const char* p = mp_begin;
+    while (p != mp_end)
+    {
+        p = find_char(p, mp_end, '<');
+        if (!p)
+            break;
+
+        if (p + 1 == mp_end)
+            return false;
+
+        switch (p[1])
+        {
+            case '/':
+            {
+                if (!scan_end_tag(p))
+                    return false;
+
+                if (m_spreadsheet_depth && m_decl_marks.size() < m_spreadsheet_depth)
+                    // The spreadsheet element has ended.  No more tables to
+                    // find beyond this point.
+                    return true;
+                break;
+            }
+            case '!':
+            case '?':
+            {
+                p = skip_special(p, mp_end);
+                if (!p)
+                    return false;
+                break;
+            }
+            default:
+                if (!scan_start_tag(p))
+                    return false;
+        }
+    }
+
+    return true;
+}
+
+const std::vector<ods_table_scanner::table>& ods_table_scanner::get_tables() const
+{
+    return m_tables;
+}
+
+const std::vector<ods_table_scanner::ns_decl>& ods_table_scanner::get_ns_decls() const
+{
+    return m_table_decls;
+}
+
+bool ods_table_scanner::scan_start_tag(const char*& p)
+{
+    const char* tag = p;
+    const char* it = p + 1;
+    while (it != mp_end && !is_name_end(*it))
+        ++it;
+
+    if (it == mp_end)
+        return false;
+
+    pstring qname(tag + 1, it - tag - 1);
+    size_t decl_mark = m_decls.size();
+    bool empty_elem = false;
+
+    // Go through the attributes to pick up the namespace declarations.
+    while (true)
+    {
+        while (it != mp_end && is_blank(*it))
+            ++it;
+
+        if (it == mp_end)
+            return false;
+
+        if (*it == '>')
+        {
+            ++it;
+            break;
+        }
+
+        if (*it == '/')
+        {
+            ++it;
+            if (it == mp_end || *it != '>')
+                return false;
+
+            ++it;
+            empty_elem = true;
+            break;
+        }
+
+        const char* name_begin = it;
+        while (it != mp_end && *it != '=' && !is_blank(*it))
+            ++it;
+
+        pstring name(name_begin, it - name_begin);
+
+        while (it != mp_end && is_blank(*it))
+            ++it;
+
+        if (it == mp_end || *it != '=')
+            return false;
+
+        ++it;
+        while (it != mp_end && is_blank(*it))
+            ++it;
+
+        if (it == mp_end || (*it != '"' && *it != '\''))
+            return false;
+
+        char quote = *it++;
+        const char* value_begin = it;
+        it = find_char(it, mp_end, quote);
+        if (!it)
+            return false;
+
+        pstring value(value_begin, it - value_begin);
+        ++it;
+
+        if (name == "xmlns")
+            m_decls.emplace_back(pstring(), value);
+        else if (name.size() > 6 && !std::strncmp(name.get(), "xmlns:", 6))
+            m_decls.emplace_back(pstring(name.get() + 6, name.size() - 6), value);
+    }
+
+    pstring alias, local = qname;
+    const char* colon = find_char(qname.get(), qname.get() + qname.size(), ':');
+    if (colon)
+    {
+        alias = pstring(qname.get(), colon - qname.get());
+        local = pstring(colon + 1, qname.get() + qname.size() - colon - 1);
+    }
+
+    pstring ns = resolve_ns(alias);
+    size_t depth = m_decl_marks.size();
+
+    if (m_spreadsheet_depth && depth == m_spreadsheet_depth && local == "table" && ns == NS_odf_table)
+    {
+        table t;
+        t.start = tag - mp_begin;
+        t.body_start = it - mp_begin;
+
+        if (empty_elem)
+            t.body_end = t.end = t.body_start;
+        else if (!scan_table_body(it, qname, t))
+            return false;
+
+        if (m_tables.empty())
+            m_table_decls.assign(m_decls.begin(), m_decls.begin() + decl_mark);
+
+        m_tables.push_back(t);
+        m_decls.resize(decl_mark);
+        p = it;
+        return true;
+    }
+
+    if (!m_spreadsheet_depth && local == "spreadsheet" && ns == NS_odf_office)
+        m_spreadsheet_depth = depth + 1;
+
+    if (empty_elem)
+        m_decls.resize(decl_mark);
+    else
+        m_decl_marks.push_back(decl_mark);
+
+    p = it;
+    return true;
+}
+
+bool ods_table_scanner::scan_end_tag(const char*& p)
+{
+    const char* it = find_char(p, mp_end, '>');
+    if (!it || m_decl_marks.empty())
+        return false;
+
+    m_decls.resize(m_decl_marks.back());
+    m_decl_marks.pop_back();
+    p = it + 1;
+    return true;
+}
+
+bool ods_table_scanner::scan_table_body(const char*& p, const pstring& qname, table& t)
+{
+    // Tables may be nested, e.g. in cells, so count the levels of the
+    // elements of the same name.
+    size_t level = 1;
+    const char* it = p;
+
+    while (true)
+    {
+        it = find_char(it, mp_end, '<');
+        if (!it || it + 1 == mp_end)
+            return false;
+
+        switch (it[1])
+        {
+            case '/':
+            {
+                if (match_name(it + 2, mp_end, qname) && !--level)
+                {
+                    const char* tag_end = find_char(it, mp_end, '>');
+                    if (!tag_end)
+                        return false;
+
+                    t.body_end = it - mp_begin;
+                    t.end = tag_end + 1 - mp_begin;
+                    p = tag_end + 1;
+                    return true;
+                }
+
+                ++it;
+                break;
+            }
+            case '!':
+            case '?':
+            {
+                it = skip_special(it, mp_end);
+                if (!it)
+                    return false;
+                break;
+            }
+            default:
+            {
+                if (!match_name(it + 1, mp_end, qname))
+                {
+                    ++it;
+                    break;
+                }
+
+                const char* tag_end = find_tag_end(it + 1 + qname.size(), mp_end);
+                if (!tag_end)
+                    return false;
+
+                if (tag_end[-1] != '/')
+                    ++level;
+
+                it = tag_end + 1;
+            }
+        }
+    }
+}
+
+pstring ods_table_scanner::resolve_ns(const pstring& alias) const
+{
+    for (auto it = m_decls.rbegin(); it != m_decls.rend(); ++it)
+    {
+        if (it->first == alias)
+            return it->second;
+    }
+
+    return pstring();
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,83 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_ODS_TABLE_SCANNER_HPP
+#define INCLUDED_ORCUS_ODS_TABLE_SCANNER_HPP
+
+#include "orcus/pstring.hpp"
+
+#include <vector>
+#include <utility>
+
+namespace orcus {
+
+/**
+ * Locates the top-level table elements in the content.xml part of an ods
+ * package, without parsing the content of the part.  It only looks at the
+ * markup around the tables, and within each table it only looks for the
+ * tags that open or close another table element of the same name.
+ */
+class ods_table_scanner
+{
+public:
+    /**
+     * Positions of one table element, as offsets from the beginning of the
+     * stream.  For an empty element, both the body start and end positions
+     * are equal to the end position.
+     */
+    struct table
+    {
+        size_t start;      /// position of the '<' of the start tag.
+        size_t body_start; /// position right after the start tag.
+        size_t body_end;   /// position of the '<' of the end tag.
+        size_t end;        /// position right after the end tag.
+    };
+
+    /** pair of namespace alias and namespace URI. */
+    typedef std::pair<pstring, pstring> ns_decl;
+
+    ods_table_scanner(const char* p, size_t n);
+
+    /**
+     * Scan the stream.
+     *
+     * @return true if the stream has been scanned successfully, or false if
+     *         it contains constructs that the scan doesn't handle, in which
+     *         case the stream needs to be parsed as a whole.
+     */
+    bool scan();
+
+    const std::vector<table>& get_tables() const;
+
+    /**
+     * @return namespace declarations in scope at the table elements, made
+     *         by their ancestor elements.  Outer declarations come first.
+     */
+    const std::vector<ns_decl>& get_ns_decls() const;
+
+private:
+    bool scan_start_tag(const char*& p);
+    bool scan_end_tag(const char*& p);
+    bool scan_table_body(const char*& p, const pstring& qname, table& t);
+
+    pstring resolve_ns(const pstring& alias) const;
+
+    const char* mp_begin;
+    const char* mp_end;
+
+    std::vector<ns_decl> m_decls; /// declarations of all currently open elements.
+    std::vector<size_t> m_decl_marks; /// size of m_decls before each open element.
+    size_t m_spreadsheet_depth;
+
+    std::vector<table> m_tables;
+    std::vector<ns_decl> m_table_decls;
+};
+
+}
+
+#endif
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,153 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ods_table_scanner.hpp"
+
+#include <iostream>
+#include <string>
+#include <cassert>
+
+using namespace std;
+using namespace orcus;
+
+namespace {
+
+const char* content_head =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+    "<office:document-content"
+    " xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+    " xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\""
+    " xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\">"
+    "<office:automatic-styles xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\">"
+    "<style:style style:name=\"ce1\"/>"
+    "</office:automatic-styles>"
+    "<office:body><office:spreadsheet>";
+
+const char* content_tail =
+    "</office:spreadsheet></office:body></office:document-content>";
+
+pstring get_range(const std::string& s, size_t start, size_t end)
+{
+    return pstring(s.data() + start, end - start);
+}
+
+}
+
+void test_tables()
+{
+    std::string table1 =
+        "<table:table table:name=\"A&gt;B\">"
+        "<table:table-row><table:table-cell><text:p>&lt;table:table&gt;</text:p></table:table-cell></table:table-row>"
+        "</table:table>";
+
+    std::string table2 = "<table:table table:name='Empty'/>";
+
+    std::string table3 =
+        "<table:table table:name=\"Nested\">"
+        "<table:table-row><table:table-cell>"
+        "<table:table table:name=\"sub\"><table:table-row/></table:table>"
+        "<table:table table:name=\"sub2\" table:print=\"a/>b\"/>"
+        "</table:table-cell></table:table-row>"
+        "<!-- </table:table> -->"
+        "</table:table >";
+
+    std::string content = content_head;
+    content += table1;
+    content += "<table:named-expressions/>";
+    content += table2;
+    content += table3;
+    content += content_tail;
+
+    ods_table_scanner scanner(content.data(), content.size());
+    bool success = scanner.scan();
+    assert(success);
+
+    const std::vector<ods_table_scanner::table>& tables = scanner.get_tables();
+    assert(tables.size() == 3);
+
+    const ods_table_scanner::table* t = &tables[0];
+    assert(get_range(content, t->start, t->end) == table1);
+    assert(get_range(content, t->start, t->body_start) == "<table:table table:name=\"A&gt;B\">");
+    assert(get_range(content, t->body_end, t->end) == "</table:table>");
+
+    t = &tables[1];
+    assert(get_range(content, t->start, t->end) == table2);
+    assert(t->body_start == t->end);
+    assert(t->body_end == t->end);
+
+    t = &tables[2];
+    assert(get_range(content, t->start, t->end) == table3);
+    assert(get_range(content, t->body_end, t->end) == "</table:table >");
+
+    // Only the declarations of the ancestors are in scope.
+    const std::vector<ods_table_scanner::ns_decl>& decls = scanner.get_ns_decls();
+    assert(decls.size() == 3);
+    assert(decls[0].first == "office");
+    assert(decls[1].first == "table");
+    assert(decls[1].second == "urn:oasis:names:tc:opendocument:xmlns:table:1.0");
+    assert(decls[2].first == "text");
+}
+
+void test_aliases()
+{
+    // The table elements are identified by their namespace, not by their
+    // alias.  Tables outside the spreadsheet element don't count.
+    std::string content =
+        "<doc xmlns=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\">"
+        "<body><spreadsheet xmlns:t=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\">"
+        "<t:table t:name=\"1\"><t:table-row/></t:table>"
+        "<t:dde-links><t:dde-link><t:table/></t:dde-link></t:dde-links>"
+        "<t:table t:name=\"2\"></t:table>"
+        "</spreadsheet></body>"
+        "<table:table xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\"/>"
+        "</doc>";
+
+    ods_table_scanner scanner(content.data(), content.size());
+    bool success = scanner.scan();
+    assert(success);
+
+    const std::vector<ods_table_scanner::table>& tables = scanner.get_tables();
+    assert(tables.size() == 2);
+    assert(get_range(content, tables[0].start, tables[0].end) == "<t:table t:name=\"1\"><t:table-row/></t:table>");
+    assert(get_range(content, tables[1].start, tables[1].end) == "<t:table t:name=\"2\"></t:table>");
+
+    const std::vector<ods_table_scanner::ns_decl>& decls = scanner.get_ns_decls();
+    assert(decls.size() == 2);
+    assert(decls[0].first.empty());
+    assert(decls[1].first == "t");
+}
+
+void test_unsupported()
+{
+    const char* contents[] = {
+        // Document type declarations may declare entities.
+        "<!DOCTYPE doc [<!ENTITY a \"b\">]><doc/>",
+        // Unterminated table.
+        "<office:spreadsheet xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+        " xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\"><table:table>",
+        // Unterminated attribute value.
+        "<doc a=\"b>",
+    };
+
+    for (const char* content : contents)
+    {
+        std::string s = content;
+        ods_table_scanner scanner(s.data(), s.size());
+        assert(!scanner.scan());
+    }
+}
+
+int main()
+{
+    test_tables();
+    test_aliases();
+    test_unsupported();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -14,6 +14,9 @@ const xmlns_id_t NS_ooxml_r    = "http://schemas.openxmlformats.org/officeDocume
 const xmlns_id_t NS_ooxml_xdr  = "http://schemas.openxmlformats.org/drawingml/2006/spreadsheetDrawing";
 const xmlns_id_t NS_ooxml_xlsx = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
 
+const xmlns_id_t NS_ooxml_r_strict    = "http://purl.oclc.org/ooxml/officeDocument/relationships";
+const xmlns_id_t NS_ooxml_xlsx_strict = "http://purl.oclc.org/ooxml/spreadsheetml/main";
+
 const xmlns_id_t NS_opc_ct  = "http://schemas.openxmlformats.org/package/2006/content-types";
 const xmlns_id_t NS_opc_rel = "http://schemas.openxmlformats.org/package/2006/relationships";
 
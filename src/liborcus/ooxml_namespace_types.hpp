@@ -17,6 +17,13 @@ extern const xmlns_id_t NS_ooxml_r;
 extern const xmlns_id_t NS_ooxml_xlsx;
 extern const xmlns_id_t NS_ooxml_xdr;
 
+/**
+ * Namespaces of the Strict conformance class, which replace their
+ * Transitional counterparts.
+ */
+extern const xmlns_id_t NS_ooxml_r_strict;
+extern const xmlns_id_t NS_ooxml_xlsx_strict;
+
 extern const xmlns_id_t NS_opc_ct;
 extern const xmlns_id_t NS_opc_rel;
 
@@ -0,0 +1,180 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "opc_part_prefetcher.hpp"
+
+#include "orcus/pstring.hpp"
+
+#include <algorithm>
+
+namespace orcus {
+
+opc_part_prefetcher::opc_part_prefetcher(const zip_archive& archive, size_t budget) :
+    m_archive(archive), m_budget(budget), m_in_flight_discarded(false), m_buffered_size(0), m_stop(false)
+{
+    for (size_t i = 0, n = m_archive.get_file_entry_count(); i < n; ++i)
+    {
+        pstring name = m_archive.get_file_entry_name(i);
+        m_entry_sizes.emplace(name.str(), m_archive.get_file_entry_stat(i).size_uncompressed);
+    }
+
+    m_thread = std::thread(&opc_part_prefetcher::run, this);
+}
+
+opc_part_prefetcher::~opc_part_prefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+bool opc_part_prefetcher::can_start_next()
+{
+    while (!m_pending.empty())
+    {
+        size_t size = m_entry_sizes[m_pending.front()];
+        if (size <= m_budget)
+            return m_buffered_size + size <= m_budget;
+
+        // This part would never fit.  Leave it for the reader to inflate.
+        m_pending.pop_front();
+    }
+
+    return false;
+}
+
+void opc_part_prefetcher::run()
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+
+    while (true)
+    {
+        m_cond.wait(lock, [this] { return m_stop || can_start_next(); });
+
+        if (m_stop)
+            return;
+
+        m_in_flight = m_pending.front();
+        m_pending.pop_front();
+        lock.unlock();
+
+        part content;
+
+        try
+        {
+            std::lock_guard<std::mutex> lock_archive(m_mtx_archive);
+            content.found = m_archive.read_file_entry(m_in_flight, content.buffer);
+        }
+        catch (...)
+        {
+            content.error = std::current_exception();
+        }
+
+        lock.lock();
+
+        if (!m_in_flight_discarded)
+        {
+            m_buffered_size += content.buffer.size();
+            m_ready.emplace(std::move(m_in_flight), std::move(content));
+        }
+
+        m_in_flight.clear();
+        m_in_flight_discarded = false;
+        m_cond.notify_all();
+    }
+}
+
+void opc_part_prefetcher::remove_pending(const std::string& path)
+{
+    auto it = std::find(m_pending.begin(), m_pending.end(), path);
+    if (it != m_pending.end())
+        m_pending.erase(it);
+}
+
+void opc_part_prefetcher::prefetch(const std::vector<std::string>& paths)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    // Insert in reverse so that the first path ends up at the front.
+    for (auto it = paths.rbegin(); it != paths.rend(); ++it)
+    {
+        const std::string& path = *it;
+
+        if (!m_entry_sizes.count(path) || m_ready.count(path) || path == m_in_flight)
+            continue;
+
+        remove_pending(path);
+        m_pending.push_front(path);
+    }
+
+    m_cond.notify_all();
+}
+
+bool opc_part_prefetcher::read(const std::string& path, zip_file_entry_buffer& buf)
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_cond.wait(lock, [this, &path] { return m_in_flight != path; });
+
+    auto it = m_ready.find(path);
+    if (it != m_ready.end())
+    {
+        part content = std::move(it->second);
+        m_ready.erase(it);
+        m_buffered_size -= content.buffer.size();
+        lock.unlock();
+        m_cond.notify_all();
+
+        if (content.error)
+            std::rethrow_exception(content.error);
+
+        buf = std::move(content.buffer);
+        return content.found;
+    }
+
+    // Not prefetched.  Read it here, and make sure it won't be read again.
+    remove_pending(path);
+    lock.unlock();
+
+    std::lock_guard<std::mutex> lock_archive(m_mtx_archive);
+    return m_archive.read_file_entry(path, buf);
+}
+
+void opc_part_prefetcher::discard(const std::string& path)
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+    remove_pending(path);
+
+    if (path == m_in_flight)
+    {
+        // Drop it as soon as it's done.
+        m_in_flight_discarded = true;
+        return;
+    }
+
+    auto it = m_ready.find(path);
+    if (it == m_ready.end())
+        return;
+
+    m_buffered_size -= it->second.buffer.size();
+    m_ready.erase(it);
+    lock.unlock();
+    m_cond.notify_all();
+}
+
+size_t opc_part_prefetcher::get_buffered_size()
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_buffered_size;
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,127 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_OPC_PART_PREFETCHER_HPP
+#define INCLUDED_ORCUS_OPC_PART_PREFETCHER_HPP
+
+#include "orcus/zip_archive.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace orcus {
+
+/**
+ * Inflates the parts of a zip archive on a background thread ahead of the
+ * time they get requested, so that inflating the next parts overlaps with
+ * parsing the current one.  The total size of the inflated parts waiting to
+ * be picked up never exceeds the memory budget.
+ *
+ * All reads from the archive must go through an instance of this class for
+ * as long as it's alive, since the archive stream can only be read from one
+ * thread at a time.
+ */
+class opc_part_prefetcher
+{
+    struct part
+    {
+        zip_file_entry_buffer buffer;
+        std::exception_ptr error;
+        bool found = false;
+    };
+
+    const zip_archive& m_archive;
+    const size_t m_budget;
+
+    /** Uncompressed size of each file entry in the archive. */
+    std::unordered_map<std::string, size_t> m_entry_sizes;
+
+    std::mutex m_mtx_archive;
+    std::mutex m_mtx;
+    std::condition_variable m_cond;
+
+    std::deque<std::string> m_pending;
+    std::unordered_map<std::string, part> m_ready;
+    std::string m_in_flight;
+    bool m_in_flight_discarded;
+    size_t m_buffered_size;
+    bool m_stop;
+
+    std::thread m_thread;
+
+    void run();
+
+    /**
+     * Check whether the worker can start inflating the next pending part
+     * without exceeding the budget.  Pending parts too large to ever fit
+     * get dropped along the way.  Must be called with the lock held.
+     */
+    bool can_start_next();
+
+    void remove_pending(const std::string& path);
+
+public:
+    /**
+     * @param archive archive to read the parts from.  It must stay alive
+     *                during the life cycle of this instance.
+     * @param budget maximum number of bytes of inflated parts to hold
+     *               while they wait to be picked up.
+     */
+    opc_part_prefetcher(const zip_archive& archive, size_t budget);
+    ~opc_part_prefetcher();
+
+    opc_part_prefetcher(const opc_part_prefetcher&) = delete;
+    opc_part_prefetcher& operator= (const opc_part_prefetcher&) = delete;
+
+    /**
+     * Queue parts to inflate ahead of time.  The parts get inflated in the
+     * order given, before any parts queued previously, as they are expected
+     * to be read before those.  Paths that are already queued or inflated,
+     * or that don't exist in the archive, get ignored.
+     *
+     * @param paths full paths of the parts within the archive.
+     */
+    void prefetch(const std::vector<std::string>& paths);
+
+    /**
+     * Retrieve the content of a part.  If the part has been inflated ahead
+     * of time, its buffer gets handed over.  If it's being inflated, it
+     * waits for it to finish.  Otherwise the part gets inflated on the
+     * calling thread.
+     *
+     * @param path full path of the part within the archive.
+     * @param buf buffer to put the content of the part into.
+     *
+     * @return true if successful, false otherwise.
+     */
+    bool read(const std::string& path, zip_file_entry_buffer& buf);
+
+    /**
+     * Notify that a part won't be read, to release its buffer if it has
+     * been inflated ahead of time, or to take it off the queue otherwise.
+     *
+     * @param path full path of the part within the archive.
+     */
+    void discard(const std::string& path);
+
+    /**
+     * @return total size of the inflated parts waiting to be picked up.
+     */
+    size_t get_buffered_size();
+};
+
+}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
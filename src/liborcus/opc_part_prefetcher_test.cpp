@@ -0,0 +1,178 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "opc_part_prefetcher.hpp"
+
+#include "orcus/zip_archive_writer.hpp"
+#include "orcus/zip_archive_stream.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace orcus;
+
+namespace {
+
+/**
+ * Each part is 1000 bytes long, filled with its own number.
+ */
+constexpr size_t part_size = 1000;
+constexpr size_t part_count = 6;
+
+string get_part_name(size_t i)
+{
+    return "xl/part" + to_string(i) + ".xml";
+}
+
+string create_archive()
+{
+    ostringstream os;
+    zip_archive_writer writer(os);
+
+    for (size_t i = 0; i < part_count; ++i)
+    {
+        string content(part_size, '0' + i);
+        writer.add_file_entry(get_part_name(i), content.data(), content.size());
+    }
+
+    string large(part_size * 10, 'L');
+    writer.add_file_entry("xl/large.xml", large.data(), large.size());
+    writer.close();
+
+    return os.str();
+}
+
+string read_part(opc_part_prefetcher& prefetcher, const string& path)
+{
+    zip_file_entry_buffer buf;
+    bool res = prefetcher.read(path, buf);
+    assert(res);
+    return string(reinterpret_cast<const char*>(buf.data()), buf.size());
+}
+
+/**
+ * Wait for the background thread to settle with the specified amount of
+ * buffered data.
+ */
+void wait_for_buffered_size(opc_part_prefetcher& prefetcher, size_t expected, size_t budget)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        size_t size = prefetcher.get_buffered_size();
+        assert(size <= budget);
+        if (size == expected)
+            return;
+
+        this_thread::sleep_for(chrono::milliseconds(5));
+    }
+
+    assert(!"buffered size never reached the expected value");
+}
+
+void test_read()
+{
+    string data = create_archive();
+    zip_archive_stream_blob strm(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+    zip_archive archive(&strm);
+    archive.load();
+
+    opc_part_prefetcher prefetcher(archive, part_size * part_count);
+    prefetcher.prefetch({ get_part_name(0), get_part_name(1), "xl/no-such-part.xml", get_part_name(2) });
+
+    for (size_t i = 0; i < part_count; ++i)
+        // Parts 3 and onward were not prefetched.
+        assert(read_part(prefetcher, get_part_name(i)) == string(part_size, '0' + i));
+
+    // Part 0 was handed over, so this read goes to the archive directly.
+    assert(read_part(prefetcher, get_part_name(0)) == string(part_size, '0'));
+
+    zip_file_entry_buffer buf;
+    assert(!prefetcher.read("xl/no-such-part.xml", buf));
+    assert(prefetcher.get_buffered_size() == 0);
+}
+
+void test_budget()
+{
+    string data = create_archive();
+    zip_archive_stream_blob strm(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+    zip_archive archive(&strm);
+    archive.load();
+
+    // Room for two and a half parts.
+    const size_t budget = part_size * 5 / 2;
+    opc_part_prefetcher prefetcher(archive, budget);
+
+    vector<string> paths;
+    for (size_t i = 0; i < part_count; ++i)
+        paths.push_back(get_part_name(i));
+
+    // The large part never fits in the budget and gets skipped.
+    paths.insert(paths.begin() + 1, "xl/large.xml");
+
+    prefetcher.prefetch(paths);
+    wait_for_buffered_size(prefetcher, part_size * 2, budget);
+
+    assert(read_part(prefetcher, get_part_name(0)) == string(part_size, '0'));
+    wait_for_buffered_size(prefetcher, part_size * 2, budget);
+
+    assert(read_part(prefetcher, "xl/large.xml") == string(part_size * 10, 'L'));
+
+    // Discarding a prefetched part makes room for the next one.
+    prefetcher.discard(get_part_name(1));
+    wait_for_buffered_size(prefetcher, part_size * 2, budget);
+
+    for (size_t i = 2; i < part_count; ++i)
+        assert(read_part(prefetcher, get_part_name(i)) == string(part_size, '0' + i));
+
+    wait_for_buffered_size(prefetcher, 0, budget);
+}
+
+void test_prefetch_order()
+{
+    string data = create_archive();
+    zip_archive_stream_blob strm(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+    zip_archive archive(&strm);
+    archive.load();
+
+    const size_t budget = part_size;
+    opc_part_prefetcher prefetcher(archive, budget);
+
+    prefetcher.prefetch({ get_part_name(0), get_part_name(1) });
+    wait_for_buffered_size(prefetcher, part_size, budget);
+
+    // Parts queued later are expected to be read sooner, and go to the
+    // front of the queue.
+    prefetcher.prefetch({ get_part_name(4), get_part_name(5) });
+    assert(read_part(prefetcher, get_part_name(0)) == string(part_size, '0'));
+    wait_for_buffered_size(prefetcher, part_size, budget);
+
+    // Part 4 must be the one buffered.  Discarding part 1 which is still
+    // queued doesn't change that.
+    prefetcher.discard(get_part_name(1));
+    assert(prefetcher.get_buffered_size() == part_size);
+    prefetcher.discard(get_part_name(4));
+    wait_for_buffered_size(prefetcher, part_size, budget);
+    prefetcher.discard(get_part_name(5));
+    wait_for_buffered_size(prefetcher, 0, budget);
+}
+
+}
+
+int main()
+{
+    test_read();
+    test_budget();
+    test_prefetch_order();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
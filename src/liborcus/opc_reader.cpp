@@ -6,11 +6,14 @@
  */
 
 #include "opc_reader.hpp"
+#include "opc_part_prefetcher.hpp"
 #include "xml_stream_parser.hpp"
 
 #include "ooxml_global.hpp"
 #include "opc_context.hpp"
 #include "ooxml_tokens.hpp"
+#include "session_context.hpp"
+#include "import_stats_timer.hpp"
 
 #include "orcus/config.hpp"
 
@@ -52,26 +55,44 @@ opc_reader::opc_reader(const config& opt, xmlns_repository& ns_repo, session_con
     m_handler(handler),
     m_opc_rel_handler(new opc_relations_context(m_session_cxt, opc_tokens)) {}
 
+opc_reader::~opc_reader() {}
+
 void opc_reader::read_file(std::unique_ptr<zip_archive_stream>&& stream)
 {
     m_archive_stream.reset(stream.release());
     m_archive.reset(new zip_archive(m_archive_stream.get()));
 
-    m_archive->load();
+    {
+        phase_timer timer(m_session_cxt.mp_stats, &import_stats::zip_directory);
+        m_archive->load();
+    }
 
     m_dir_stack.push_back(string()); // push root directory.
 
+    if (m_config.xlsx.prefetch_buffer_size)
+        mp_prefetcher = std::make_unique<opc_part_prefetcher>(*m_archive, m_config.xlsx.prefetch_buffer_size);
+
     if (m_config.debug)
         list_content();
     read_content();
 
+    mp_prefetcher.reset();
     m_archive.reset();
     m_archive_stream.reset();
 }
 
-bool opc_reader::open_zip_stream(const string& path, vector<unsigned char>& buf)
+bool opc_reader::open_zip_stream(const string& path, zip_file_entry_buffer& buf)
 {
-    return m_archive->read_file_entry(path.c_str(), buf);
+    // With prefetching, the elapsed time only covers the wait for the part
+    // to become available.
+    stop_watch sw;
+    bool res = mp_prefetcher ?
+        mp_prefetcher->read(path, buf) : m_archive->read_file_entry(path.c_str(), buf);
+
+    if (res && m_session_cxt.mp_stats)
+        m_session_cxt.mp_stats->add_inflate(path, buf.size(), sw.elapsed());
+
+    return res;
 }
 
 void opc_reader::read_part(const pstring& path, const schema_t type, opc_rel_extra* data)
@@ -138,6 +159,14 @@ void opc_reader::read_part(const pstring& path, const schema_t type, opc_rel_ext
             cout << "---" << endl;
             cout << "unhandled relationship type: " << type << endl;
         }
+
+        // The handler is done with this part and its relationship file,
+        // whether or not it has read them.
+        if (mp_prefetcher)
+        {
+            mp_prefetcher->discard(full_path);
+            mp_prefetcher->discard(resolve_file_path(cur_dir + "_rels/", file_name + ".rels"));
+        }
     }
 
     // Unwind to the original directory.
@@ -172,6 +201,8 @@ void opc_reader::check_relation_part(
     if (m_config.debug)
         for_each(rels.begin(), rels.end(), print_opc_rel());
 
+    prefetch_parts(rels);
+
     for_each(rels.begin(), rels.end(),
         [&](opc_rel_t& v)
         {
@@ -225,6 +256,8 @@ void opc_reader::read_content()
     if (m_config.debug)
         for_each(rels.begin(), rels.end(), print_opc_rel());
 
+    prefetch_parts(rels);
+
     for_each(rels.begin(), rels.end(),
         [this](opc_rel_t& v)
         {
@@ -236,7 +269,7 @@ void opc_reader::read_content()
 void opc_reader::read_content_types()
 {
     string filepath("[Content_Types].xml");
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!open_zip_stream(filepath, buffer))
         return;
 
@@ -251,7 +284,11 @@ void opc_reader::read_content_types()
         new opc_content_types_context(m_session_cxt, opc_tokens));
 
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(m_session_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     opc_content_types_context& context =
         static_cast<opc_content_types_context&>(handler->get_context());
@@ -265,7 +302,7 @@ void opc_reader::read_relations(const char* path, vector<opc_rel_t>& rels)
     if (m_config.debug)
         cout << "relation file path: " << filepath << endl;
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!open_zip_stream(filepath, buffer))
         return;
 
@@ -279,10 +316,47 @@ void opc_reader::read_relations(const char* path, vector<opc_rel_t>& rels)
         static_cast<opc_relations_context&>(m_opc_rel_handler.get_context());
     context.init();
     parser.set_handler(&m_opc_rel_handler);
-    parser.parse();
+
+    {
+        part_parse_timer timer(m_session_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
+
     context.pop_rels(rels);
 }
 
+void opc_reader::prefetch_parts(const vector<opc_rel_t>& rels)
+{
+    if (!mp_prefetcher)
+        return;
+
+    string cur_dir = get_current_dir();
+    vector<string> paths;
+    paths.reserve(rels.size() * 2);
+
+    for (const opc_rel_t& rel : rels)
+    {
+        // Resolve the path the same way read_part() does.
+        string target = rel.target.str();
+        string::size_type pos = target.rfind('/');
+        string dir = cur_dir, file_name = target;
+        if (pos != string::npos)
+        {
+            dir += target.substr(0, pos + 1);
+            file_name = target.substr(pos + 1);
+        }
+
+        string full_path = resolve_file_path(dir, file_name);
+        if (m_handled_parts.count(full_path) > 0)
+            continue;
+
+        paths.push_back(full_path);
+        paths.push_back(resolve_file_path(dir + "_rels/", file_name + ".rels"));
+    }
+
+    mp_prefetcher->prefetch(paths);
+}
+
 string opc_reader::get_current_dir() const
 {
     string pwd;
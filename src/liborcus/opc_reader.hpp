@@ -22,6 +22,7 @@
 namespace orcus {
 
 struct config;
+class opc_part_prefetcher;
 
 class xmlns_repository;
 struct session_context;
@@ -68,9 +69,10 @@ public:
     };
 
     opc_reader(const config& opt, xmlns_repository& ns_repo, session_context& session_cxt, part_handler& handler);
+    ~opc_reader();
 
     void read_file(std::unique_ptr<zip_archive_stream>&& stream);
-    bool open_zip_stream(const std::string& path, std::vector<unsigned char>& buf);
+    bool open_zip_stream(const std::string& path, zip_file_entry_buffer& buf);
 
     /**
      * Read an xml part inside package.  The path is relative to the relation
@@ -102,6 +104,13 @@ private:
     void read_content_types();
     void read_relations(const char* path, std::vector<opc_rel_t>& rels);
 
+    /**
+     * Queue the parts referenced by the relations, along with their own
+     * relation files, to be inflated ahead of time, in the order they are
+     * expected to be read.
+     */
+    void prefetch_parts(const std::vector<opc_rel_t>& rels);
+
     std::string get_current_dir() const;
 
 private:
@@ -112,6 +121,7 @@ private:
 
     std::unique_ptr<zip_archive> m_archive;
     std::unique_ptr<zip_archive_stream> m_archive_stream;
+    std::unique_ptr<opc_part_prefetcher> mp_prefetcher;
 
     xml_simple_stream_handler m_opc_rel_handler;
 
@@ -15,6 +15,9 @@
 #include "orcus/config.hpp"
 #include "orcus/string_pool.hpp"
 
+#include "import_scope_filter.hpp"
+#include "import_stats_timer.hpp"
+
 #include <cstring>
 #include <iostream>
 
@@ -38,21 +41,27 @@ struct header_cell
 
 class max_row_size_reached {};
 
+class last_row_in_scope_reached {};
+
 class orcus_csv_handler
 {
 public:
     orcus_csv_handler(spreadsheet::iface::import_factory& factory, const orcus::config& app_config) :
         m_factory(factory),
         m_app_config(app_config),
+        m_scope(app_config.scope),
         mp_sheet(nullptr),
         m_sheet(0),
         m_row(0),
-        m_col(0) {}
+        m_col(0),
+        m_skip_sheet(false),
+        m_skip_row(false) {}
 
     void begin_parse()
     {
         std::string sheet_name = get_sheet_name();
         mp_sheet = m_factory.append_sheet(m_sheet, sheet_name.data(), sheet_name.size());
+        m_skip_sheet = !m_scope.is_sheet_included(sheet_name);
     }
 
     void end_parse() {}
@@ -70,17 +79,27 @@ public:
             ++m_sheet;
             std::string sheet_name = get_sheet_name();
             mp_sheet = m_factory.append_sheet(m_sheet, sheet_name.data(), sheet_name.size());
+            m_skip_sheet = !m_scope.is_sheet_included(sheet_name);
             m_row = 0;
 
             if (!m_header_cells.empty())
             {
                 // Duplicate the header rows from the first sheet.
                 for (const header_cell& c : m_header_cells)
-                    mp_sheet->set_auto(c.row, c.col, c.value.data(), c.value.size());
+                {
+                    if (!m_skip_sheet && m_scope.is_cell_included(c.row, c.col))
+                        mp_sheet->set_auto(c.row, c.col, c.value.data(), c.value.size());
+                }
 
                 m_row += m_app_config.csv.header_row_size;
             }
         }
+
+        if (m_scope.is_past_last_row(m_row) && !m_app_config.csv.split_to_multiple_sheets)
+            // No more rows to import.
+            throw last_row_in_scope_reached();
+
+        m_skip_row = m_skip_sheet || (m_scope.is_restricted() && !m_scope.is_row_included(m_row));
     }
 
     void end_row()
@@ -100,7 +119,9 @@ public:
             m_header_cells.emplace_back(m_row, m_col, v);
         }
 
-        mp_sheet->set_auto(m_row, m_col, p, n);
+        if (!m_skip_row && m_scope.is_cell_included(m_row, m_col))
+            mp_sheet->set_auto(m_row, m_col, p, n);
+
         ++m_col;
     }
 
@@ -123,10 +144,13 @@ private:
 
     spreadsheet::iface::import_factory& m_factory;
     const config& m_app_config;
+    import_scope_filter m_scope;
     spreadsheet::iface::import_sheet* mp_sheet;
     spreadsheet::sheet_t m_sheet;
     spreadsheet::row_t m_row;
     spreadsheet::col_t m_col;
+    bool m_skip_sheet;
+    bool m_skip_row;
 };
 
 }
@@ -137,9 +161,7 @@ orcus_csv::orcus_csv(spreadsheet::iface::import_factory* factory) :
 void orcus_csv::read_file(const string& filepath)
 {
     file_content fc(filepath.data());
-    parse(fc.data(), fc.size());
-
-    mp_factory->finalize();
+    read_stream(fc.data(), fc.size());
 }
 
 void orcus_csv::read_stream(const char* content, size_t len)
@@ -147,8 +169,13 @@ void orcus_csv::read_stream(const char* content, size_t len)
     if (!content)
         return;
 
+    import_stats& stats = get_stats();
+    stats.reset();
+    phase_timer total_timer(&stats, &import_stats::total, len);
+
     parse(content, len);
 
+    phase_timer timer(&stats, &import_stats::finalize);
     mp_factory->finalize();
 }
 
@@ -168,6 +195,7 @@ void orcus_csv::parse(const char* content, size_t len)
     config.delimiters.push_back(',');
     config.text_qualifier = '"';
     csv_parser<orcus_csv_handler> parser(content, len, handler, config);
+    phase_timer timer(&get_stats(), &import_stats::parse, len);
     try
     {
         parser.parse();
@@ -177,6 +205,10 @@ void orcus_csv::parse(const char* content, size_t len)
         // The parser has decided to end the import due to the destination
         // sheet being full.
     }
+    catch (const last_row_in_scope_reached&)
+    {
+        // The rest of the content is outside the import scope.
+    }
     catch (const csv::parse_error& e)
     {
         cout << "parse failed: " << e.what() << endl;
@@ -10,6 +10,7 @@
 #include "orcus/spreadsheet/import_interface.hpp"
 #include "orcus/stream.hpp"
 #include "orcus/config.hpp"
+#include "orcus/exception.hpp"
 
 #include "xml_stream_parser.hpp"
 #include "gnumeric_handler.hpp"
@@ -17,6 +18,7 @@
 #include "gnumeric_namespace_types.hpp"
 #include "gnumeric_detection_handler.hpp"
 #include "session_context.hpp"
+#include "import_stats_timer.hpp"
 #include "detection_result.hpp"
 
 #define ORCUS_DEBUG_GNUMERIC 0
@@ -27,6 +29,7 @@
 
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/device/array.hpp>
 
 using namespace std;
 
@@ -55,6 +58,76 @@ bool decompress_gzip(const char* buffer, size_t size, string& decompressed)
     return true;
 }
 
+/**
+ * Decompresses the leading segment of a gzip stream, and extends it on
+ * demand.  The compressed stream gets pulled through a single decompressor,
+ * so that extending the segment only inflates the bytes that follow it.
+ */
+class gzip_head_reader
+{
+    boost::iostreams::filtering_istream m_is;
+    string m_buf;
+    bool m_complete;
+
+public:
+    gzip_head_reader(const char* buffer, size_t size) : m_complete(false)
+    {
+        m_is.push(boost::iostreams::gzip_decompressor());
+        m_is.push(boost::iostreams::array_source(buffer, size));
+    }
+
+    /**
+     * Extend the decompressed segment up to the specified size.
+     *
+     * @return false if the stream fails to decompress, true otherwise.
+     */
+    bool extend(size_t size)
+    {
+        if (m_complete || size <= m_buf.size())
+            return true;
+
+        size_t pos = m_buf.size();
+        m_buf.resize(size);
+
+        try
+        {
+            m_is.read(&m_buf[pos], size - pos);
+        }
+        catch (const exception&)
+        {
+            return false;
+        }
+
+        if (m_is.bad())
+            return false;
+
+        m_buf.resize(pos + m_is.gcount());
+
+        // When the segment is shorter than requested, the whole stream has
+        // been decompressed.
+        m_complete = m_buf.size() < size;
+        return true;
+    }
+
+    const string& get() const { return m_buf; }
+
+    bool complete() const { return m_complete; }
+};
+
+/**
+ * Initial size of the leading segment to decompress during detection.  It
+ * gets doubled each time the segment turns out to be too short to reach the
+ * first sheet element.
+ */
+constexpr size_t detection_head_size = 16 * 1024;
+
+/**
+ * Maximum size of the leading segment to decompress during detection.  A
+ * gnumeric document whose first sheet element lies beyond it is not
+ * detected.
+ */
+constexpr size_t detection_max_head_size = 1024 * 1024;
+
 }
 
 struct orcus_gnumeric_impl
@@ -72,6 +145,7 @@ orcus_gnumeric::orcus_gnumeric(spreadsheet::iface::import_factory* factory) :
     mp_impl(new orcus_gnumeric_impl(factory))
 {
     mp_impl->m_ns_repo.add_predefined_values(NS_gnumeric_all);
+    mp_impl->m_cxt.mp_stats = &get_stats();
 }
 
 orcus_gnumeric::~orcus_gnumeric()
@@ -87,6 +161,7 @@ void orcus_gnumeric::read_content_xml(const char* p, size_t size)
         mp_impl->m_cxt, gnumeric_tokens, mp_impl->mp_factory);
 
     parser.set_handler(handler.get());
+    phase_timer timer(&get_stats(), &import_stats::parse, size);
     parser.parse();
 }
 
@@ -94,31 +169,58 @@ bool orcus_gnumeric::detect(const unsigned char* buffer, size_t size)
 {
     // Detect gnumeric format that's already in memory.
 
-    string decompressed;
-    if (!decompress_gzip(reinterpret_cast<const char*>(buffer), size, decompressed))
+    // gzip magic number.
+    if (size < 2 || buffer[0] != 0x1f || buffer[1] != 0x8b)
         return false;
 
-    if (decompressed.empty())
-        return false;
+    gzip_head_reader reader(reinterpret_cast<const char*>(buffer), size);
 
-    // Parse this xml stream for detection.
-    config opt(format_t::gnumeric);
-    xmlns_repository ns_repo;
-    ns_repo.add_predefined_values(NS_gnumeric_all);
-    session_context cxt;
-    xml_stream_parser parser(opt, ns_repo, gnumeric_tokens, &decompressed[0], decompressed.size());
-    gnumeric_detection_handler handler(cxt, gnumeric_tokens);
-    parser.set_handler(&handler);
-
-    try
+    for (size_t head_size = detection_head_size; head_size <= detection_max_head_size; head_size *= 2)
     {
-        parser.parse();
+        if (!reader.extend(head_size))
+            return false;
+
+        const string& decompressed = reader.get();
+        if (decompressed.empty())
+            return false;
+
+        bool complete = reader.complete();
+
+        // Parse this xml stream for detection.
+        config opt(format_t::gnumeric);
+        xmlns_repository ns_repo;
+        ns_repo.add_predefined_values(NS_gnumeric_all);
+        session_context cxt;
+        xml_stream_parser parser(opt, ns_repo, gnumeric_tokens, decompressed.data(), decompressed.size());
+        gnumeric_detection_handler handler(cxt, gnumeric_tokens);
+        parser.set_handler(&handler);
+
+        try
+        {
+            parser.parse();
+        }
+        catch (const detection_result& res)
+        {
+            return res.get_result();
+        }
+        catch (const parse_error& e)
+        {
+            // A segment cut short makes the parser fail at its very end.
+            // Any other error means the stream is not a gnumeric document.
+            if (complete || e.offset() < std::ptrdiff_t(decompressed.size()))
+                return false;
+        }
+        catch (...)
+        {
+            return false;
+        }
+
+        if (complete)
+            break;
+
+        // The segment ended before the detection was concluded.  Try again
+        // with a longer segment.
     }
-    catch (const detection_result& res)
-    {
-        return res.get_result();
-    }
-    catch (...) {}
 
     return false;
 }
@@ -141,12 +243,24 @@ void orcus_gnumeric::read_stream(const char* content, size_t len)
     if (!content || !len)
         return;
 
+    import_stats& stats = get_stats();
+    stats.reset();
+    phase_timer total_timer(&stats, &import_stats::total, len);
+
     string file_content;
-    if (!decompress_gzip(content, len, file_content))
-        return;
+    {
+        stop_watch watch;
+        if (!decompress_gzip(content, len, file_content))
+            return;
+
+        stats.inflate.duration += watch.elapsed();
+        stats.inflate.bytes += file_content.size();
+        ++stats.inflate.count;
+    }
 
     read_content_xml(file_content.c_str(), file_content.length());
 
+    phase_timer timer(&stats, &import_stats::finalize);
     mp_impl->mp_factory->finalize();
 }
 
@@ -10,21 +10,55 @@
 #include "orcus/zip_archive.hpp"
 #include "orcus/zip_archive_stream.hpp"
 
+#include "orcus/exception.hpp"
+#include "orcus/detail/thread.hpp"
+
 #include "xml_stream_parser.hpp"
+#include "xml_stream_handler.hpp"
 #include "ods_content_xml_handler.hpp"
+#include "ods_content_xml_context.hpp"
 #include "ods_session_data.hpp"
+#include "ods_table_scanner.hpp"
 #include "odf_tokens.hpp"
 #include "odf_namespace_types.hpp"
 #include "session_context.hpp"
+#include "spreadsheet_iface_buffer.hpp"
+#include "import_stats_timer.hpp"
+#include "zip_detection.hpp"
 
 #include <cstdlib>
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <deque>
+#include <memory>
 
 using namespace std;
 
 namespace orcus {
 
+namespace {
+
+/**
+ * Everything needed to parse one table on a separate thread.  The table's
+ * content gets recorded in buffers, to be passed on to the import factory
+ * on the calling thread afterward.
+ */
+struct table_task
+{
+    session_context cxt;
+    shared_strings_buffer strings;
+    sheet_buffer sheet;
+    std::exception_ptr error;
+
+    table_task(spreadsheet::iface::import_sheet& dest) :
+        cxt(new ods_session_data), sheet(dest) {}
+};
+
+}
+
 struct orcus_ods::impl
 {
     xmlns_repository m_ns_repo;
@@ -33,13 +67,144 @@ struct orcus_ods::impl
 
     impl(spreadsheet::iface::import_factory* im_factory) :
         m_cxt(new ods_session_data), mp_factory(im_factory) {}
+
+    void read_content_by_table(
+        const config& conf, const char* p, size_t size, const ods_table_scanner& scanner,
+        size_t thread_count);
+
+    void parse_table(
+        const config& conf, const char* p, const ods_table_scanner& scanner, size_t index,
+        const ods_content_xml_context& parent, table_task& task);
 };
 
+void orcus_ods::impl::read_content_by_table(
+    const config& conf, const char* p, size_t size, const ods_table_scanner& scanner,
+    size_t thread_count)
+{
+    const std::vector<ods_table_scanner::table>& tables = scanner.get_tables();
+
+    // Parse everything but the bodies of the tables first.  This picks up
+    // the automatic styles and creates all the sheets in order.
+    std::string content;
+    size_t pos = 0;
+    for (const ods_table_scanner::table& t : tables)
+    {
+        content.append(p + pos, t.body_start - pos);
+        pos = t.body_end;
+    }
+    content.append(p + pos, size - pos);
+
+    xml_stream_parser parser(conf, m_ns_repo, odf_tokens, content.data(), content.size());
+    ods_content_xml_handler handler(m_cxt, odf_tokens, mp_factory);
+    ods_content_xml_context& cxt = handler.get_context();
+    cxt.set_separate_tables(true);
+    parser.set_handler(&handler);
+    parser.parse();
+
+    const std::vector<spreadsheet::iface::import_sheet*>& sheets = cxt.get_tables();
+    if (sheets.size() != tables.size())
+        throw general_error("orcus_ods: the tables found in content.xml don't match the parsed sheets.");
+
+    std::vector<std::unique_ptr<table_task>> tasks;
+    tasks.reserve(tables.size());
+    for (spreadsheet::iface::import_sheet* sheet : sheets)
+    {
+        if (!sheet)
+            throw general_error("orcus_ods: failed to create a sheet for a table.");
+
+        tasks.push_back(std::make_unique<table_task>(*sheet));
+    }
+
+    std::atomic<size_t> next_table(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next_table++; i < tasks.size(); i = next_table++)
+        {
+            try
+            {
+                parse_table(conf, p, scanner, i, cxt, *tasks[i]);
+            }
+            catch (...)
+            {
+                tasks[i]->error = std::current_exception();
+            }
+        }
+    };
+
+    {
+        std::vector<detail::thread::scoped_guard> threads;
+        size_t n = std::min(thread_count, tasks.size());
+        threads.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            threads.emplace_back(std::thread(worker));
+    }
+
+    // Pass the content of all tables on to the factory in order, so that
+    // the strings get the same indices as they would in a single pass.
+    spreadsheet::iface::import_shared_strings* strings = mp_factory->get_shared_strings();
+    ods_session_data& ods_data = static_cast<ods_session_data&>(*m_cxt.mp_data);
+    std::deque<ods_session_data::named_exp> named_exps;
+
+    for (std::unique_ptr<table_task>& task : tasks)
+    {
+        if (task->error)
+            std::rethrow_exception(task->error);
+
+        std::vector<size_t> string_ids;
+        if (strings)
+            string_ids = task->strings.replay(*strings);
+
+        task->sheet.replay(string_ids);
+
+        ods_session_data& table_data = static_cast<ods_session_data&>(*task->cxt.mp_data);
+        ods_data.m_formulas.insert(
+            ods_data.m_formulas.end(), table_data.m_formulas.begin(), table_data.m_formulas.end());
+        named_exps.insert(
+            named_exps.end(), table_data.m_named_exps.begin(), table_data.m_named_exps.end());
+
+        // The formulas and named expressions may reference strings in the
+        // table's pool.
+        m_cxt.m_string_pool.merge(task->cxt.m_string_pool);
+    }
+
+    // Sheet-local named expressions precede the global ones when parsed in
+    // one pass.
+    ods_data.m_named_exps.insert(ods_data.m_named_exps.begin(), named_exps.begin(), named_exps.end());
+
+    cxt.end_spreadsheet();
+}
+
+void orcus_ods::impl::parse_table(
+    const config& conf, const char* p, const ods_table_scanner& scanner, size_t index,
+    const ods_content_xml_context& parent, table_task& task)
+{
+    const ods_table_scanner::table& t = scanner.get_tables()[index];
+    if (t.body_start == t.body_end)
+        // Empty table.
+        return;
+
+    // The namespace repository is not safe to share between threads.
+    xmlns_repository ns_repo;
+    ns_repo.add_predefined_values(NS_odf_all);
+
+    xml_stream_parser parser(conf, ns_repo, odf_tokens, p + t.start, t.end - t.start);
+    for (const ods_table_scanner::ns_decl& decl : scanner.get_ns_decls())
+        parser.declare_ns(decl.first, decl.second);
+
+    xml_stream_handler handler(
+        new ods_content_xml_context(
+            task.cxt, odf_tokens, parent, index, &task.sheet, &task.strings));
+
+    parser.set_handler(&handler);
+    parser.parse();
+}
+
 orcus_ods::orcus_ods(spreadsheet::iface::import_factory* factory) :
     iface::import_filter(format_t::ods),
     mp_impl(std::make_unique<impl>(factory))
 {
     mp_impl->m_ns_repo.add_predefined_values(NS_odf_all);
+    mp_impl->m_cxt.mp_stats = &get_stats();
 }
 
 orcus_ods::~orcus_ods() {}
@@ -61,18 +226,38 @@ void orcus_ods::list_content(const zip_archive& archive)
 
 void orcus_ods::read_content(const zip_archive& archive)
 {
-    vector<unsigned char> buf;
-    if (!archive.read_file_entry("content.xml", buf))
+    const std::string filepath = "content.xml";
+    zip_file_entry_buffer buf;
+    stop_watch watch;
+    if (!archive.read_file_entry(filepath, buf))
     {
         cout << "failed to get stat on content.xml" << endl;
         return;
     }
 
+    import_stats& stats = get_stats();
+    stats.add_inflate(filepath, buf.size(), watch.elapsed());
+
+    part_parse_timer timer(&stats, filepath, buf.size());
     read_content_xml(&buf[0], buf.size());
 }
 
 void orcus_ods::read_content_xml(const unsigned char* p, size_t size)
 {
+    const config& conf = get_config();
+    if (conf.ods.thread_count > 1)
+    {
+        const char* content = reinterpret_cast<const char*>(p);
+        ods_table_scanner scanner(content, size);
+
+        // With fewer than two tables there is nothing to parse in parallel.
+        if (scanner.scan() && scanner.get_tables().size() > 1)
+        {
+            mp_impl->read_content_by_table(conf, content, size, scanner, conf.ods.thread_count);
+            return;
+        }
+    }
+
     threaded_xml_stream_parser parser(
         get_config(), mp_impl->m_ns_repo, odf_tokens,
         reinterpret_cast<const char*>(p), size);
@@ -85,31 +270,17 @@ void orcus_ods::read_content_xml(const unsigned char* p, size_t size)
     mp_impl->m_cxt.m_string_pool.merge(this_pool);
 }
 
-bool orcus_ods::detect(const unsigned char* blob, size_t size)
+bool detect_ods_package(const zip_archive& archive)
 {
-    zip_archive_stream_blob stream(blob, size);
-    zip_archive archive(&stream);
-    try
-    {
-        archive.load();
-    }
-    catch (const zip_error&)
-    {
-        // Not a valid zip archive.
-        return false;
-    }
+    const char* mimetype = "application/vnd.oasis.opendocument.spreadsheet";
+    size_t n = strlen(mimetype);
 
+    // Only the leading segment of the 'mimetype' entry is needed.
     vector<unsigned char> buf;
-    if (!archive.read_file_entry("mimetype", buf))
+    if (!archive.read_file_entry_head("mimetype", buf, n))
         // Failed to read 'mimetype' entry.
         return false;
 
-    if (buf.empty())
-        // mimetype is empty.
-        return false;
-
-    const char* mimetype = "application/vnd.oasis.opendocument.spreadsheet";
-    size_t n = strlen(mimetype);
     if (buf.size() < n)
         return false;
 
@@ -120,6 +291,23 @@ bool orcus_ods::detect(const unsigned char* blob, size_t size)
     return true;
 }
 
+bool orcus_ods::detect(const unsigned char* blob, size_t size)
+{
+    zip_archive_stream_blob stream(blob, size);
+    zip_archive archive(&stream);
+    try
+    {
+        archive.load();
+    }
+    catch (const zip_error&)
+    {
+        // Not a valid zip archive.
+        return false;
+    }
+
+    return detect_ods_package(archive);
+}
+
 void orcus_ods::read_file(const std::string& filepath)
 {
     zip_archive_stream_fd stream(filepath.data());
@@ -135,8 +323,16 @@ void orcus_ods::read_stream(const char* content, size_t len)
 
 void orcus_ods::read_file_impl(zip_archive_stream* stream)
 {
+    import_stats& stats = get_stats();
+    stats.reset();
+    phase_timer total_timer(&stats, &import_stats::total, stream->size());
+
     zip_archive archive(stream);
-    archive.load();
+    {
+        phase_timer timer(&stats, &import_stats::zip_directory);
+        archive.load();
+    }
+
     if (get_config().debug)
         list_content(archive);
 
@@ -151,7 +347,10 @@ void orcus_ods::read_file_impl(zip_archive_stream* stream)
 
     read_content(archive);
 
-    mp_impl->mp_factory->finalize();
+    {
+        phase_timer timer(&stats, &import_stats::finalize);
+        mp_impl->mp_factory->finalize();
+    }
 
     if (gs)
         // This grammar will be used
@@ -16,6 +16,7 @@
 #include "xls_xml_handler.hpp"
 #include "xls_xml_detection_handler.hpp"
 #include "session_context.hpp"
+#include "import_stats_timer.hpp"
 #include "xls_xml_tokens.hpp"
 #include "xls_xml_namespace_types.hpp"
 #include "detection_result.hpp"
@@ -36,11 +37,14 @@ struct orcus_xls_xml::impl
 
     impl(spreadsheet::iface::import_factory* factory) : mp_factory(factory) {}
 
-    void read_stream(const char* content, size_t len, const config& cnf)
+    void read_stream(const char* content, size_t len, const config& cnf, import_stats& stats)
     {
         if (!content || !len)
             return;
 
+        stats.reset();
+        phase_timer total_timer(&stats, &import_stats::total, len);
+
         spreadsheet::iface::import_global_settings* gs =
             mp_factory->get_global_settings();
 
@@ -57,6 +61,7 @@ struct orcus_xls_xml::impl
         parser.set_handler(handler.get());
         try
         {
+            phase_timer timer(&stats, &import_stats::parse, len);
             parser.parse();
         }
         catch (const parse_error& e)
@@ -66,6 +71,7 @@ struct orcus_xls_xml::impl
             return;
         }
 
+        phase_timer timer(&stats, &import_stats::finalize);
         mp_factory->finalize();
     }
 };
@@ -75,6 +81,7 @@ orcus_xls_xml::orcus_xls_xml(spreadsheet::iface::import_factory* factory) :
     mp_impl(std::make_unique<impl>(factory))
 {
     mp_impl->m_ns_repo.add_predefined_values(NS_xls_xml_all);
+    mp_impl->m_cxt.mp_stats = &get_stats();
 }
 
 orcus_xls_xml::~orcus_xls_xml() {}
@@ -109,7 +116,7 @@ void orcus_xls_xml::read_file(const string& filepath)
         return;
 
     content.convert_to_utf8();
-    mp_impl->read_stream(content.data(), content.size(), get_config());
+    mp_impl->read_stream(content.data(), content.size(), get_config(), get_stats());
 }
 
 void orcus_xls_xml::read_stream(const char* content, size_t len)
@@ -119,7 +126,7 @@ void orcus_xls_xml::read_stream(const char* content, size_t len)
         return;
 
     mem_content.convert_to_utf8();
-    mp_impl->read_stream(mem_content.data(), mem_content.size(), get_config());
+    mp_impl->read_stream(mem_content.data(), mem_content.size(), get_config(), get_stats());
 }
 
 const char* orcus_xls_xml::get_name() const
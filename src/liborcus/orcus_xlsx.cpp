@@ -30,6 +30,10 @@
 #include "ooxml_global.hpp"
 #include "spreadsheet_iface_util.hpp"
 #include "ooxml_content_types.hpp"
+#include "import_scope_filter.hpp"
+#include "xlsx_metadata_scanner.hpp"
+#include "zip_detection.hpp"
+#include "import_stats_timer.hpp"
 
 #include <cstdlib>
 #include <iostream>
@@ -127,7 +131,10 @@ struct orcus_xlsx::impl
         m_cxt(new xlsx_session_data),
         mp_factory(factory),
         m_opc_handler(parent),
-        m_opc_reader(parent.get_config(), m_ns_repo, m_cxt, m_opc_handler) {}
+        m_opc_reader(parent.get_config(), m_ns_repo, m_cxt, m_opc_handler)
+    {
+        m_cxt.mp_stats = &parent.get_stats();
+    }
 };
 
 orcus_xlsx::orcus_xlsx(spreadsheet::iface::import_factory* factory) :
@@ -151,22 +158,10 @@ orcus_xlsx::orcus_xlsx(spreadsheet::iface::import_factory* factory) :
 
 orcus_xlsx::~orcus_xlsx() {}
 
-bool orcus_xlsx::detect(const unsigned char* blob, size_t size)
+bool detect_xlsx_package(const zip_archive& archive)
 {
-    zip_archive_stream_blob stream(blob, size);
-    zip_archive archive(&stream);
-    try
-    {
-        archive.load();
-    }
-    catch (const zip_error&)
-    {
-        // Not a valid zip archive.
-        return false;
-    }
-
     // Find and parse [Content_Types].xml which is required for OPC package.
-    vector<unsigned char> buf;
+    zip_file_entry_buffer buf;
     if (!archive.read_file_entry("[Content_Types].xml", buf))
         // Failed to read the contnet types entry.
         return false;
@@ -199,33 +194,80 @@ bool orcus_xlsx::detect(const unsigned char* blob, size_t size)
     return std::find(parts.begin(), parts.end(), workbook_part) != parts.end();
 }
 
-void orcus_xlsx::read_file(const string& filepath)
+bool orcus_xlsx::detect(const unsigned char* blob, size_t size)
 {
-    std::unique_ptr<zip_archive_stream> stream(new zip_archive_stream_fd(filepath.c_str()));
-    mp_impl->m_opc_reader.read_file(std::move(stream));
+    zip_archive_stream_blob stream(blob, size);
+    zip_archive archive(&stream);
+    try
+    {
+        archive.load();
+    }
+    catch (const zip_error&)
+    {
+        // Not a valid zip archive.
+        return false;
+    }
 
-    // Formulas need to be inserted to the document after the shared string
-    // table get imported, because tokenization of formulas may add new shared
-    // string instances.
-    set_formulas_to_doc();
+    return detect_xlsx_package(archive);
+}
 
-    mp_impl->mp_factory->finalize();
+void orcus_xlsx::read_file(const string& filepath)
+{
+    std::unique_ptr<zip_archive_stream> stream(new zip_archive_stream_fd(filepath.c_str()));
+    read_file_impl(std::move(stream));
 }
 
 void orcus_xlsx::read_stream(const char* content, size_t len)
 {
     std::unique_ptr<zip_archive_stream> stream(new zip_archive_stream_blob(
                 reinterpret_cast<const unsigned char*>(content), len));
+    read_file_impl(std::move(stream));
+}
+
+void orcus_xlsx::read_file_impl(std::unique_ptr<zip_archive_stream>&& stream)
+{
+    import_stats& stats = get_stats();
+    stats.reset();
+    phase_timer total_timer(&stats, &import_stats::total, stream->size());
+
     mp_impl->m_opc_reader.read_file(std::move(stream));
 
-    // Formulas need to be inserted to the document after the shared string
-    // table get imported, because tokenization of formulas may add new shared
-    // string instances.
-    set_formulas_to_doc();
+    {
+        // Formulas need to be inserted to the document after the shared
+        // string table get imported, because tokenization of formulas may
+        // add new shared string instances.
+        phase_timer timer(&stats, &import_stats::formulas);
+        set_formulas_to_doc();
+    }
 
+    phase_timer timer(&stats, &import_stats::finalize);
     mp_impl->mp_factory->finalize();
 }
 
+xlsx_workbook_metadata orcus_xlsx::read_metadata(const std::string& filepath)
+{
+    zip_archive_stream_fd stream(filepath.c_str());
+    zip_archive archive(&stream);
+    archive.load();
+
+    xlsx_workbook_metadata data;
+    xlsx_metadata_scanner scanner(archive);
+    scanner.scan(data);
+    return data;
+}
+
+xlsx_workbook_metadata orcus_xlsx::read_metadata(const char* content, size_t len)
+{
+    zip_archive_stream_blob stream(reinterpret_cast<const unsigned char*>(content), len);
+    zip_archive archive(&stream);
+    archive.load();
+
+    xlsx_workbook_metadata data;
+    xlsx_metadata_scanner scanner(archive);
+    scanner.scan(data);
+    return data;
+}
+
 const char* orcus_xlsx::get_name() const
 {
     static const char* name = "xlsx";
@@ -347,7 +389,7 @@ void orcus_xlsx::read_workbook(const string& dir_path, const string& file_name)
     if (get_config().debug)
         cout << "read_workbook: file path = " << filepath << endl;
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
         return;
 
@@ -361,7 +403,11 @@ void orcus_xlsx::read_workbook(const string& dir_path, const string& file_name)
         get_config(), mp_impl->m_ns_repo, ooxml_tokens,
         reinterpret_cast<const char*>(&buffer[0]), buffer.size());
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     // Get sheet info from the context instance.
     xlsx_workbook_context& context =
@@ -434,7 +480,16 @@ void orcus_xlsx::read_sheet(const string& dir_path, const string& file_name, xls
         cout << "read_sheet: file path = " << filepath << endl;
     }
 
-    vector<unsigned char> buffer;
+    if (!import_scope_filter(get_config().scope).is_sheet_included(data->name))
+    {
+        // This sheet is outside the import scope. Skip the whole part without
+        // decompressing it.
+        if (get_config().debug)
+            cout << "sheet '" << data->name << "' is outside the import scope. skipping." << endl;
+        return;
+    }
+
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
         return;
 
@@ -469,7 +524,11 @@ void orcus_xlsx::read_sheet(const string& dir_path, const string& file_name, xls
         mp_impl->m_cxt, ooxml_tokens, data->id-1, *resolver, *sheet);
 
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     opc_rel_extras_t table_info;
     handler->pop_rel_extras(table_info);
@@ -486,7 +545,7 @@ void orcus_xlsx::read_shared_strings(const string& dir_path, const string& file_
         cout << "read_shared_strings: file path = " << filepath << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
         return;
 
@@ -497,12 +556,18 @@ void orcus_xlsx::read_shared_strings(const string& dir_path, const string& file_
         get_config(), mp_impl->m_ns_repo, ooxml_tokens,
         reinterpret_cast<const char*>(&buffer[0]), buffer.size());
 
-    auto handler = std::make_unique<xml_simple_stream_handler>(
-        new xlsx_shared_strings_context(
-            mp_impl->m_cxt, ooxml_tokens, mp_impl->mp_factory->get_shared_strings()));
+    auto* context = new xlsx_shared_strings_context(
+        mp_impl->m_cxt, ooxml_tokens, mp_impl->mp_factory->get_shared_strings());
+    context->set_part_size(buffer.size());
+    auto handler = std::make_unique<xml_simple_stream_handler>(context);
 
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        phase_timer phase(mp_impl->m_cxt.mp_stats, &import_stats::shared_strings, buffer.size());
+        parser.parse();
+    }
 }
 
 void orcus_xlsx::read_styles(const string& dir_path, const string& file_name)
@@ -519,7 +584,7 @@ void orcus_xlsx::read_styles(const string& dir_path, const string& file_name)
         // Client code doesn't support styles.
         return;
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
         return;
 
@@ -535,7 +600,12 @@ void orcus_xlsx::read_styles(const string& dir_path, const string& file_name)
             mp_impl->m_cxt, ooxml_tokens, mp_impl->mp_factory->get_styles()));
 
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        phase_timer phase(mp_impl->m_cxt.mp_stats, &import_stats::styles, buffer.size());
+        parser.parse();
+    }
 }
 
 void orcus_xlsx::read_table(const std::string& dir_path, const std::string& file_name, xlsx_rel_table_info* data)
@@ -562,7 +632,7 @@ void orcus_xlsx::read_table(const std::string& dir_path, const std::string& file
         cout << "read_table: file path = " << filepath << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
     {
         cerr << "failed to open zip stream: " << filepath << endl;
@@ -579,7 +649,11 @@ void orcus_xlsx::read_table(const std::string& dir_path, const std::string& file
         get_config(), mp_impl->m_ns_repo, ooxml_tokens,
         reinterpret_cast<const char*>(&buffer[0]), buffer.size());
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     handler.reset();
 }
@@ -606,7 +680,7 @@ void orcus_xlsx::read_pivot_cache_def(
             << "; cache id = " << data->id << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
     {
         cerr << "failed to open zip stream: " << filepath << endl;
@@ -630,7 +704,11 @@ void orcus_xlsx::read_pivot_cache_def(
         get_config(), mp_impl->m_ns_repo, ooxml_tokens,
         reinterpret_cast<const char*>(&buffer[0]), buffer.size());
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     opc_rel_extras_t pcache_info = handler->pop_rel_extras();
 
@@ -659,7 +737,7 @@ void orcus_xlsx::read_pivot_cache_rec(
         cout << "read_pivot_cache_rec: file path = " << filepath << "; cache id = " << data->id << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
     {
         cerr << "failed to open zip stream: " << filepath << endl;
@@ -682,7 +760,11 @@ void orcus_xlsx::read_pivot_cache_rec(
         get_config(), mp_impl->m_ns_repo, ooxml_tokens,
         reinterpret_cast<const char*>(&buffer[0]), buffer.size());
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     handler.reset();
 }
@@ -696,7 +778,7 @@ void orcus_xlsx::read_pivot_table(const std::string& dir_path, const std::string
         cout << "read_pivot_table: file path = " << filepath << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
     {
         cerr << "failed to open zip stream: " << filepath << endl;
@@ -712,7 +794,11 @@ void orcus_xlsx::read_pivot_table(const std::string& dir_path, const std::string
         get_config(), mp_impl->m_ns_repo, ooxml_tokens,
         reinterpret_cast<const char*>(&buffer[0]), buffer.size());
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     handler.reset();
     mp_impl->m_opc_reader.check_relation_part(file_name, nullptr);
@@ -727,7 +813,7 @@ void orcus_xlsx::read_rev_headers(const std::string& dir_path, const std::string
         cout << "read_rev_headers: file path = " << filepath << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
     {
         cerr << "failed to open zip stream: " << filepath << endl;
@@ -745,7 +831,11 @@ void orcus_xlsx::read_rev_headers(const std::string& dir_path, const std::string
         new xlsx_revheaders_context(mp_impl->m_cxt, ooxml_tokens));
 
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     handler.reset();
     mp_impl->m_opc_reader.check_relation_part(file_name, nullptr);
@@ -760,7 +850,7 @@ void orcus_xlsx::read_rev_log(const std::string& dir_path, const std::string& fi
         cout << "read_rev_log: file path = " << filepath << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
     {
         cerr << "failed to open zip stream: " << filepath << endl;
@@ -778,7 +868,11 @@ void orcus_xlsx::read_rev_log(const std::string& dir_path, const std::string& fi
         new xlsx_revlog_context(mp_impl->m_cxt, ooxml_tokens));
 
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     handler.reset();
 }
@@ -792,7 +886,7 @@ void orcus_xlsx::read_drawing(const std::string& dir_path, const std::string& fi
         cout << "read_drawing: file path = " << filepath << endl;
     }
 
-    vector<unsigned char> buffer;
+    zip_file_entry_buffer buffer;
     if (!mp_impl->m_opc_reader.open_zip_stream(filepath, buffer))
     {
         cerr << "failed to open zip stream: " << filepath << endl;
@@ -809,7 +903,11 @@ void orcus_xlsx::read_drawing(const std::string& dir_path, const std::string& fi
         get_config(), mp_impl->m_ns_repo, ooxml_tokens,
         reinterpret_cast<const char*>(&buffer[0]), buffer.size());
     parser.set_handler(handler.get());
-    parser.parse();
+
+    {
+        part_parse_timer timer(mp_impl->m_cxt.mp_stats, filepath, buffer.size());
+        parser.parse();
+    }
 
     handler.reset();
 }
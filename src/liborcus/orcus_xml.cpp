@@ -14,6 +14,7 @@
 #include "orcus/string_pool.hpp"
 
 #include "orcus_xml_impl.hpp"
+#include "string_helper.hpp"
 
 #define ORCUS_DEBUG_XML 0
 
@@ -50,8 +51,15 @@ class xml_data_sax_handler
     std::vector<sax_ns_parser_attribute> m_attrs;
     std::vector<scope> m_scopes;
 
-    string_pool m_pool;
+    /**
+     * Buffer to store transient character content.  It only ever holds the
+     * content of the current element, which keeps the memory footprint of
+     * the handler bounded regardless of the size of the source document.
+     */
+    std::string m_chars_buf;
+
     spreadsheet::iface::import_factory& m_factory;
+    spreadsheet::iface::import_shared_strings* mp_shared_strings;
     xml_map_tree::const_element_list_type& m_link_positions;
     const xml_map_tree& m_map_tree;
     xml_map_tree::walker m_map_tree_walker;
@@ -73,25 +81,65 @@ private:
         return nullptr;
     }
 
-    void set_single_link_cell(const xml_map_tree::cell_reference& ref, const pstring& val)
+    /**
+     * Set a linked value to a cell.  When the type of the linked value is
+     * known, the value gets converted directly to the cell value of that
+     * type, instead of going through set_auto().
+     */
+    void set_cell_value(
+        spreadsheet::iface::import_sheet& sheet, spreadsheet::row_t row, spreadsheet::col_t col,
+        xml_value_t value_type, const pstring& val)
+    {
+        switch (value_type)
+        {
+            case xml_value_t::numeric:
+            {
+                double v;
+                if (string_helper::to_numeric(val, v))
+                {
+                    sheet.set_value(row, col, v);
+                    return;
+                }
+                break;
+            }
+            case xml_value_t::string:
+            {
+                if (mp_shared_strings && !val.empty())
+                {
+                    size_t sid = mp_shared_strings->add(val.get(), val.size());
+                    sheet.set_string(row, col, sid);
+                    return;
+                }
+                break;
+            }
+            default:
+                ;
+        }
+
+        // Either the type is unknown, or the value does not match the type.
+        sheet.set_auto(row, col, val.get(), val.size());
+    }
+
+    void set_single_link_cell(const xml_map_tree::linkable& link, const pstring& val)
     {
+        const xml_map_tree::cell_reference& ref = *link.cell_ref;
         spreadsheet::iface::import_sheet* sheet = m_factory.get_sheet(ref.pos.sheet.get(), ref.pos.sheet.size());
         if (sheet)
-            sheet->set_auto(ref.pos.row, ref.pos.col, val.get(), val.size());
+            set_cell_value(*sheet, ref.pos.row, ref.pos.col, link.value_type, val);
     }
 
-    void set_field_link_cell(xml_map_tree::field_in_range& field, const pstring& val)
+    void set_field_link_cell(const xml_map_tree::linkable& link, const pstring& val)
     {
+        const xml_map_tree::field_in_range& field = *link.field_ref;
         assert(field.ref);
         assert(!field.ref->pos.sheet.empty());
 
         const xml_map_tree::cell_position& pos = field.ref->pos;
         spreadsheet::iface::import_sheet* sheet = m_factory.get_sheet(pos.sheet.get(), pos.sheet.size());
         if (sheet)
-            sheet->set_auto(
-               pos.row + field.ref->row_position,
-               pos.col + field.column_pos,
-               val.get(), val.size());
+            set_cell_value(
+               *sheet, pos.row + field.ref->row_position, pos.col + field.column_pos,
+               link.value_type, val);
     }
 
 public:
@@ -100,6 +148,7 @@ public:
         xml_map_tree::const_element_list_type& link_positions,
         const xml_map_tree& map_tree) :
         m_factory(factory),
+        mp_shared_strings(factory.get_shared_strings()),
         m_link_positions(link_positions),
         m_map_tree(map_tree),
         m_map_tree_walker(map_tree.get_tree_walker()),
@@ -154,11 +203,11 @@ public:
                 switch (linked_attr.ref_type)
                 {
                     case xml_map_tree::reference_cell:
-                        set_single_link_cell(*linked_attr.cell_ref, val_trimmed);
+                        set_single_link_cell(linked_attr, val_trimmed);
                         break;
                     case xml_map_tree::reference_range_field:
                     {
-                        set_field_link_cell(*linked_attr.field_ref, val_trimmed);
+                        set_field_link_cell(linked_attr, val_trimmed);
                         break;
                     }
                     default:
@@ -185,12 +234,12 @@ public:
             {
                 case xml_map_tree::reference_cell:
                 {
-                    set_single_link_cell(*mp_current_elem->cell_ref, m_current_chars);
+                    set_single_link_cell(*mp_current_elem, m_current_chars);
                     break;
                 }
                 case xml_map_tree::reference_range_field:
                 {
-                    set_field_link_cell(*mp_current_elem->field_ref, m_current_chars);
+                    set_field_link_cell(*mp_current_elem, m_current_chars);
                     break;
                 }
                 default:
@@ -261,7 +310,10 @@ public:
 
         m_current_chars = val.trim();
         if (transient)
-            m_current_chars = m_pool.intern(m_current_chars).first;
+        {
+            m_chars_buf.assign(m_current_chars.get(), m_current_chars.size());
+            m_current_chars = m_chars_buf;
+        }
     }
 
     void attribute(const pstring& /*name*/, const pstring& /*val*/)
@@ -486,6 +538,31 @@ struct less_by_opening_elem_pos
 
 } // anonymous namespace
 
+struct orcus_xml::impl::stream_reader
+{
+    xmlns_context ns_cxt;
+    xml_data_sax_handler handler;
+    sax_ns_push_parser<xml_data_sax_handler> parser;
+
+    stream_reader(impl& parent) :
+        ns_cxt(parent.ns_repo.create_context()),
+        handler(*parent.im_factory, parent.link_positions, parent.map_tree),
+        parser(ns_cxt, handler) {}
+};
+
+// The constructor and destructor of the impl are defined here, where the
+// stream reader is a complete type.
+
+orcus_xml::impl::impl(xmlns_repository& _ns_repo) :
+    im_factory(nullptr),
+    ex_factory(nullptr),
+    ns_repo(_ns_repo),
+    ns_cxt_map(ns_repo.create_context()),
+    map_tree(ns_repo),
+    sheet_count(0) {}
+
+orcus_xml::impl::~impl() {}
+
 orcus_xml::orcus_xml(xmlns_repository& ns_repo, spreadsheet::iface::import_factory* im_fact, spreadsheet::iface::export_factory* ex_fact) :
     mp_impl(std::make_unique<impl>(ns_repo))
 {
@@ -500,10 +577,12 @@ void orcus_xml::set_namespace_alias(const pstring& alias, const pstring& uri, bo
     mp_impl->map_tree.set_namespace_alias(alias, uri, default_ns);
 }
 
-void orcus_xml::set_cell_link(const pstring& xpath, const pstring& sheet, spreadsheet::row_t row, spreadsheet::col_t col)
+void orcus_xml::set_cell_link(
+    const pstring& xpath, const pstring& sheet, spreadsheet::row_t row, spreadsheet::col_t col,
+    xml_value_t value_type)
 {
     pstring sheet_safe = mp_impl->map_tree.intern_string(sheet);
-    mp_impl->map_tree.set_cell_link(xpath, xml_map_tree::cell_position(sheet_safe, row, col));
+    mp_impl->map_tree.set_cell_link(xpath, xml_map_tree::cell_position(sheet_safe, row, col), value_type);
 }
 
 void orcus_xml::start_range(const pstring& sheet, spreadsheet::row_t row, spreadsheet::col_t col)
@@ -513,9 +592,9 @@ void orcus_xml::start_range(const pstring& sheet, spreadsheet::row_t row, spread
     mp_impl->map_tree.start_range(mp_impl->cur_range_ref);
 }
 
-void orcus_xml::append_field_link(const pstring& xpath, const pstring& label)
+void orcus_xml::append_field_link(const pstring& xpath, const pstring& label, xml_value_t value_type)
 {
-    mp_impl->map_tree.append_range_field_link(xpath, label);
+    mp_impl->map_tree.append_range_field_link(xpath, label, value_type);
 }
 
 void orcus_xml::set_range_row_group(const pstring& xpath)
@@ -543,44 +622,35 @@ void orcus_xml::read_stream(const char* p, size_t n)
     read_impl(strm);
 }
 
-void orcus_xml::read_impl(const pstring& strm)
+void orcus_xml::feed_stream(const char* p, size_t n)
 {
-    if (strm.empty())
-        return;
-
-    // Insert the range headers and reset the row size counters.
-    xml_map_tree::range_ref_map_type& range_refs = mp_impl->map_tree.get_range_references();
-
-    for (const auto& ref_pair : range_refs)
+    if (!mp_impl->stream)
     {
-        const xml_map_tree::cell_position& ref = ref_pair.first;
-        xml_map_tree::range_reference& range_ref = *ref_pair.second;
-        range_ref.row_position = 1; // Reset the row offset.
+        // First chunk of a new source document.
+        mp_impl->insert_range_headers();
+        mp_impl->stream = std::make_unique<impl::stream_reader>(*mp_impl);
+    }
 
-        spreadsheet::iface::import_sheet* sheet =
-            mp_impl->im_factory->get_sheet(ref.sheet.get(), ref.sheet.size());
+    mp_impl->stream->parser.feed(p, n);
+}
 
-        if (!sheet)
-            continue;
+void orcus_xml::finish_stream()
+{
+    if (!mp_impl->stream)
+        return;
 
-        spreadsheet::row_t row = ref.row;
-        spreadsheet::col_t col = ref.col;
+    // Discard the parser state even when the document ends prematurely, so
+    // that the next call to feed_stream() starts a new document.
+    std::unique_ptr<impl::stream_reader> stream = std::move(mp_impl->stream);
+    stream->parser.finish();
+}
 
-        for (const xml_map_tree::linkable* e : range_ref.field_nodes)
-        {
-            if (e->label.empty())
-            {
-                // No custom header label. Create a label from the name of the linkable.
-                std::string s = e->name.to_string(mp_impl->ns_repo);
-                if (!s.empty())
-                    sheet->set_auto(row, col, s.data(), s.size());
-            }
-            else
-                sheet->set_auto(row, col, e->label.data(), e->label.size());
+void orcus_xml::read_impl(const pstring& strm)
+{
+    if (strm.empty())
+        return;
 
-            ++col;
-        }
-    }
+    mp_impl->insert_range_headers();
 
     // Parse the content xml.
     xmlns_context ns_cxt = mp_impl->ns_repo.create_context(); // new ns context for the content xml stream.
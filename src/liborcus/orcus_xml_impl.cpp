@@ -6,16 +6,46 @@
  */
 
 #include "orcus_xml_impl.hpp"
+#include "orcus/spreadsheet/import_interface.hpp"
 
 namespace orcus {
 
-orcus_xml::impl::impl(xmlns_repository& _ns_repo) :
-    im_factory(nullptr),
-    ex_factory(nullptr),
-    ns_repo(_ns_repo),
-    ns_cxt_map(ns_repo.create_context()),
-    map_tree(ns_repo),
-    sheet_count(0) {}
+void orcus_xml::impl::insert_range_headers()
+{
+    // Insert the range headers and reset the row size counters.
+    xml_map_tree::range_ref_map_type& range_refs = map_tree.get_range_references();
+
+    for (const auto& ref_pair : range_refs)
+    {
+        const xml_map_tree::cell_position& ref = ref_pair.first;
+        xml_map_tree::range_reference& range_ref = *ref_pair.second;
+        range_ref.row_position = 1; // Reset the row offset.
+
+        spreadsheet::iface::import_sheet* sheet =
+            im_factory->get_sheet(ref.sheet.get(), ref.sheet.size());
+
+        if (!sheet)
+            continue;
+
+        spreadsheet::row_t row = ref.row;
+        spreadsheet::col_t col = ref.col;
+
+        for (const xml_map_tree::linkable* e : range_ref.field_nodes)
+        {
+            if (e->label.empty())
+            {
+                // No custom header label. Create a label from the name of the linkable.
+                std::string s = e->name.to_string(ns_repo);
+                if (!s.empty())
+                    sheet->set_auto(row, col, s.data(), s.size());
+            }
+            else
+                sheet->set_auto(row, col, e->label.data(), e->label.size());
+
+            ++col;
+        }
+    }
+}
 
 }
 
@@ -41,7 +41,19 @@ struct orcus_xml::impl
 
     xml_map_tree::cell_position cur_range_ref;
 
+    /** Parser state of the source document being fed in chunks. */
+    struct stream_reader;
+    std::unique_ptr<stream_reader> stream;
+
     explicit impl(xmlns_repository& _ns_repo);
+    ~impl();
+
+    /**
+     * Insert the header row of every linked range, and reset the row
+     * positions of the ranges.  This gets called before the content of the
+     * source document gets imported.
+     */
+    void insert_range_headers();
 };
 
 }
@@ -24,6 +24,32 @@ namespace orcus {
 
 namespace {
 
+xml_value_t to_xml_value_type(const pstring& s)
+{
+    if (s == "numeric")
+        return xml_value_t::numeric;
+
+    if (s == "string")
+        return xml_value_t::string;
+
+    return xml_value_t::unknown;
+}
+
+const char* to_string(xml_value_t type)
+{
+    switch (type)
+    {
+        case xml_value_t::numeric:
+            return "numeric";
+        case xml_value_t::string:
+            return "string";
+        default:
+            ;
+    }
+
+    return nullptr;
+}
+
 class xml_map_sax_handler
 {
     struct scope
@@ -73,6 +99,7 @@ void xml_map_sax_handler::start_element(const sax::parser_element& elem)
     pstring xpath, sheet, label;
     spreadsheet::row_t row = -1;
     spreadsheet::col_t col = -1;
+    xml_value_t value_type = xml_value_t::unknown;
 
     if (elem.name == "ns")
     {
@@ -105,9 +132,11 @@ void xml_map_sax_handler::start_element(const sax::parser_element& elem)
                 row = strtol(attr.value.get(), nullptr, 10);
             else if (attr.name == "column")
                 col = strtol(attr.value.get(), nullptr, 10);
+            else if (attr.name == "type")
+                value_type = to_xml_value_type(attr.value);
         }
 
-        m_app.set_cell_link(xpath, sheet, row, col);
+        m_app.set_cell_link(xpath, sheet, row, col, value_type);
     }
     else if (elem.name == "range")
     {
@@ -131,9 +160,11 @@ void xml_map_sax_handler::start_element(const sax::parser_element& elem)
                 xpath = attr.value;
             else if (attr.name == "label")
                 label = attr.value;
+            else if (attr.name == "type")
+                value_type = to_xml_value_type(attr.value);
         }
 
-        m_app.append_field_link(xpath, label);
+        m_app.append_field_link(xpath, label, value_type);
     }
     else if (elem.name == "row-group")
     {
@@ -206,8 +237,8 @@ void orcus_xml::detect_map_definition(const char* p, size_t n)
         // Push the linked range.
         start_range(sheet_name, 0, 0);
 
-        for (const auto& path : range.paths)
-            append_field_link(path, pstring());
+        for (size_t i = 0; i < range.paths.size(); ++i)
+            append_field_link(range.paths[i], pstring(), range.value_types[i]);
 
         for (const auto& row_group : range.row_groups)
             set_range_row_group(row_group);
@@ -263,9 +294,14 @@ void orcus_xml::write_map_definition(const char* p, size_t n, std::ostream& out)
         writer.add_attribute({default_ns, "column"}, "0");
         auto range_scope = writer.push_element_scope({default_ns, "range"});
 
-        for (const auto& path : range.paths)
+        for (size_t i = 0; i < range.paths.size(); ++i)
         {
-            writer.add_attribute({default_ns, "path"}, path);
+            writer.add_attribute({default_ns, "path"}, range.paths[i]);
+
+            const char* type = to_string(range.value_types[i]);
+            if (type)
+                writer.add_attribute({default_ns, "type"}, type);
+
             writer.push_element_scope({default_ns, "field"});
         }
 
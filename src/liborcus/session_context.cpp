@@ -11,8 +11,8 @@ namespace orcus {
 
 session_context::custom_data::~custom_data() {}
 
-session_context::session_context() : mp_data(nullptr) {}
-session_context::session_context(custom_data* data) : mp_data(data) {}
+session_context::session_context() : mp_data(nullptr), mp_stats(nullptr) {}
+session_context::session_context(custom_data* data) : mp_data(data), mp_stats(nullptr) {}
 
 session_context::~session_context()
 {
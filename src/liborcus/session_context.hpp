@@ -15,6 +15,8 @@
 
 namespace orcus {
 
+struct import_stats;
+
 struct session_context
 {
     session_context(const session_context&) = delete;
@@ -33,6 +35,12 @@ struct session_context
 
     std::unique_ptr<custom_data> mp_data;
 
+    /**
+     * Statistics of the current import, or nullptr if the statistics are not
+     * being collected.
+     */
+    import_stats* mp_stats;
+
     session_context();
     session_context(custom_data* data);
     ~session_context();
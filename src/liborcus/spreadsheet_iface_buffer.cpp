@@ -0,0 +1,438 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "spreadsheet_iface_buffer.hpp"
+
+#include "orcus/string_pool.hpp"
+#include "orcus/pstring.hpp"
+#include "orcus/exception.hpp"
+
+#include <sstream>
+
+namespace ss = orcus::spreadsheet;
+
+namespace orcus {
+
+namespace {
+
+enum class string_op_type
+{
+    append,
+    add,
+    segment_font,
+    segment_bold,
+    segment_italic,
+    segment_font_name,
+    segment_font_size,
+    segment_font_color,
+    append_segment,
+    commit_segments
+};
+
+struct string_op
+{
+    string_op_type type;
+    pstring str;
+    size_t index;  /// font index, or flag value.
+    double value;  /// font size.
+    ss::color_elem_t color[4]; /// alpha, red, green and blue.
+
+    string_op(string_op_type _type) :
+        type(_type), index(0), value(0.0), color{0, 0, 0, 0} {}
+};
+
+enum class cell_op_type
+{
+    set_auto,
+    set_string,
+    set_value,
+    set_bool,
+    set_date_time,
+    set_format,
+    set_format_range,
+    fill_down_cells,
+    set_data_range_hint,
+    set_column_width,
+    set_column_hidden,
+    set_row_height,
+    set_row_hidden,
+    set_merge_cell_range
+};
+
+struct cell_op
+{
+    cell_op_type type;
+    ss::row_t row;
+    ss::col_t col;
+
+    /**
+     * String index, xf index, flag value, length unit, row count, or
+     * position of the extra data of the operation in one of the side stores.
+     */
+    size_t index;
+
+    /** Numeric value, column width or row height. */
+    double value;
+
+    cell_op(cell_op_type _type, ss::row_t _row, ss::col_t _col, size_t _index = 0, double _value = 0.0) :
+        type(_type), row(_row), col(_col), index(_index), value(_value) {}
+};
+
+struct format_range
+{
+    ss::range_t range;
+    size_t xf;
+};
+
+/**
+ * Data shared between the sheet buffer and its sheet properties buffer.
+ * All operations go into the same list to preserve their order.
+ */
+struct cell_ops
+{
+    std::vector<cell_op> ops;
+    std::vector<pstring> strings;
+    std::vector<date_time_t> date_times;
+    std::vector<format_range> format_ranges;
+    std::vector<ss::range_t> ranges;
+    string_pool pool;
+};
+
+class sheet_properties_buffer : public ss::iface::import_sheet_properties
+{
+    cell_ops& m_data;
+
+public:
+    sheet_properties_buffer(cell_ops& data) : m_data(data) {}
+
+    virtual void set_column_width(ss::col_t col, double width, orcus::length_unit_t unit) override
+    {
+        m_data.ops.emplace_back(cell_op_type::set_column_width, 0, col, size_t(unit), width);
+    }
+
+    virtual void set_column_hidden(ss::col_t col, bool hidden) override
+    {
+        m_data.ops.emplace_back(cell_op_type::set_column_hidden, 0, col, hidden);
+    }
+
+    virtual void set_row_height(ss::row_t row, double height, orcus::length_unit_t unit) override
+    {
+        m_data.ops.emplace_back(cell_op_type::set_row_height, row, 0, size_t(unit), height);
+    }
+
+    virtual void set_row_hidden(ss::row_t row, bool hidden) override
+    {
+        m_data.ops.emplace_back(cell_op_type::set_row_hidden, row, 0, hidden);
+    }
+
+    virtual void set_merge_cell_range(const ss::range_t& range) override
+    {
+        m_data.ops.emplace_back(cell_op_type::set_merge_cell_range, 0, 0, m_data.ranges.size());
+        m_data.ranges.push_back(range);
+    }
+};
+
+}
+
+struct shared_strings_buffer::impl
+{
+    std::vector<string_op> m_ops;
+    string_pool m_pool;
+    size_t m_count;
+
+    impl() : m_count(0) {}
+
+    void push_string(string_op_type type, const char* s, size_t n)
+    {
+        m_ops.emplace_back(type);
+        m_ops.back().str = m_pool.intern(s, n).first;
+    }
+};
+
+shared_strings_buffer::shared_strings_buffer() : mp_impl(std::make_unique<impl>()) {}
+
+shared_strings_buffer::~shared_strings_buffer() {}
+
+size_t shared_strings_buffer::append(const char* s, size_t n)
+{
+    mp_impl->push_string(string_op_type::append, s, n);
+    return mp_impl->m_count++;
+}
+
+size_t shared_strings_buffer::add(const char* s, size_t n)
+{
+    mp_impl->push_string(string_op_type::add, s, n);
+    return mp_impl->m_count++;
+}
+
+void shared_strings_buffer::set_segment_font(size_t font_index)
+{
+    mp_impl->m_ops.emplace_back(string_op_type::segment_font);
+    mp_impl->m_ops.back().index = font_index;
+}
+
+void shared_strings_buffer::set_segment_bold(bool b)
+{
+    mp_impl->m_ops.emplace_back(string_op_type::segment_bold);
+    mp_impl->m_ops.back().index = b;
+}
+
+void shared_strings_buffer::set_segment_italic(bool b)
+{
+    mp_impl->m_ops.emplace_back(string_op_type::segment_italic);
+    mp_impl->m_ops.back().index = b;
+}
+
+void shared_strings_buffer::set_segment_font_name(const char* s, size_t n)
+{
+    mp_impl->push_string(string_op_type::segment_font_name, s, n);
+}
+
+void shared_strings_buffer::set_segment_font_size(double point)
+{
+    mp_impl->m_ops.emplace_back(string_op_type::segment_font_size);
+    mp_impl->m_ops.back().value = point;
+}
+
+void shared_strings_buffer::set_segment_font_color(
+    ss::color_elem_t alpha, ss::color_elem_t red, ss::color_elem_t green, ss::color_elem_t blue)
+{
+    mp_impl->m_ops.emplace_back(string_op_type::segment_font_color);
+    string_op& op = mp_impl->m_ops.back();
+    op.color[0] = alpha;
+    op.color[1] = red;
+    op.color[2] = green;
+    op.color[3] = blue;
+}
+
+void shared_strings_buffer::append_segment(const char* s, size_t n)
+{
+    mp_impl->push_string(string_op_type::append_segment, s, n);
+}
+
+size_t shared_strings_buffer::commit_segments()
+{
+    mp_impl->m_ops.emplace_back(string_op_type::commit_segments);
+    return mp_impl->m_count++;
+}
+
+std::vector<size_t> shared_strings_buffer::replay(ss::iface::import_shared_strings& dest) const
+{
+    std::vector<size_t> ids;
+    ids.reserve(mp_impl->m_count);
+
+    for (const string_op& op : mp_impl->m_ops)
+    {
+        switch (op.type)
+        {
+            case string_op_type::append:
+                ids.push_back(dest.append(op.str.get(), op.str.size()));
+                break;
+            case string_op_type::add:
+                ids.push_back(dest.add(op.str.get(), op.str.size()));
+                break;
+            case string_op_type::segment_font:
+                dest.set_segment_font(op.index);
+                break;
+            case string_op_type::segment_bold:
+                dest.set_segment_bold(op.index != 0);
+                break;
+            case string_op_type::segment_italic:
+                dest.set_segment_italic(op.index != 0);
+                break;
+            case string_op_type::segment_font_name:
+                dest.set_segment_font_name(op.str.get(), op.str.size());
+                break;
+            case string_op_type::segment_font_size:
+                dest.set_segment_font_size(op.value);
+                break;
+            case string_op_type::segment_font_color:
+                dest.set_segment_font_color(op.color[0], op.color[1], op.color[2], op.color[3]);
+                break;
+            case string_op_type::append_segment:
+                dest.append_segment(op.str.get(), op.str.size());
+                break;
+            case string_op_type::commit_segments:
+                ids.push_back(dest.commit_segments());
+                break;
+        }
+    }
+
+    return ids;
+}
+
+struct sheet_buffer::impl
+{
+    ss::iface::import_sheet& m_dest;
+    ss::iface::import_sheet_properties* mp_dest_props;
+    ss::range_size_t m_sheet_size;
+
+    cell_ops m_data;
+    sheet_properties_buffer m_props;
+
+    impl(ss::iface::import_sheet& dest) :
+        m_dest(dest),
+        mp_dest_props(dest.get_sheet_properties()),
+        m_sheet_size(dest.get_sheet_size()),
+        m_props(m_data) {}
+};
+
+sheet_buffer::sheet_buffer(ss::iface::import_sheet& dest) :
+    mp_impl(std::make_unique<impl>(dest)) {}
+
+sheet_buffer::~sheet_buffer() {}
+
+ss::iface::import_sheet_properties* sheet_buffer::get_sheet_properties()
+{
+    return mp_impl->mp_dest_props ? &mp_impl->m_props : nullptr;
+}
+
+void sheet_buffer::set_auto(ss::row_t row, ss::col_t col, const char* p, size_t n)
+{
+    cell_ops& data = mp_impl->m_data;
+    data.ops.emplace_back(cell_op_type::set_auto, row, col, data.strings.size());
+    data.strings.push_back(data.pool.intern(p, n).first);
+}
+
+void sheet_buffer::set_string(ss::row_t row, ss::col_t col, size_t sindex)
+{
+    mp_impl->m_data.ops.emplace_back(cell_op_type::set_string, row, col, sindex);
+}
+
+void sheet_buffer::set_value(ss::row_t row, ss::col_t col, double value)
+{
+    mp_impl->m_data.ops.emplace_back(cell_op_type::set_value, row, col, 0, value);
+}
+
+void sheet_buffer::set_bool(ss::row_t row, ss::col_t col, bool value)
+{
+    mp_impl->m_data.ops.emplace_back(cell_op_type::set_bool, row, col, value);
+}
+
+void sheet_buffer::set_date_time(
+    ss::row_t row, ss::col_t col, int year, int month, int day, int hour, int minute, double second)
+{
+    cell_ops& data = mp_impl->m_data;
+    data.ops.emplace_back(cell_op_type::set_date_time, row, col, data.date_times.size());
+    data.date_times.emplace_back(year, month, day, hour, minute, second);
+}
+
+void sheet_buffer::set_format(ss::row_t row, ss::col_t col, size_t xf_index)
+{
+    mp_impl->m_data.ops.emplace_back(cell_op_type::set_format, row, col, xf_index);
+}
+
+void sheet_buffer::set_format(
+    ss::row_t row_start, ss::col_t col_start, ss::row_t row_end, ss::col_t col_end, size_t xf_index)
+{
+    cell_ops& data = mp_impl->m_data;
+    data.ops.emplace_back(cell_op_type::set_format_range, row_start, col_start, data.format_ranges.size());
+
+    format_range fr;
+    fr.range.first.row = row_start;
+    fr.range.first.column = col_start;
+    fr.range.last.row = row_end;
+    fr.range.last.column = col_end;
+    fr.xf = xf_index;
+    data.format_ranges.push_back(fr);
+}
+
+void sheet_buffer::fill_down_cells(ss::row_t src_row, ss::col_t src_col, ss::row_t range_size)
+{
+    mp_impl->m_data.ops.emplace_back(cell_op_type::fill_down_cells, src_row, src_col, range_size);
+}
+
+ss::range_size_t sheet_buffer::get_sheet_size() const
+{
+    return mp_impl->m_sheet_size;
+}
+
+void sheet_buffer::set_data_range_hint(const ss::range_t& range)
+{
+    cell_ops& data = mp_impl->m_data;
+    data.ops.emplace_back(cell_op_type::set_data_range_hint, 0, 0, data.ranges.size());
+    data.ranges.push_back(range);
+}
+
+void sheet_buffer::replay(const std::vector<size_t>& string_ids) const
+{
+    ss::iface::import_sheet& dest = mp_impl->m_dest;
+    ss::iface::import_sheet_properties* props = mp_impl->mp_dest_props;
+    const cell_ops& data = mp_impl->m_data;
+
+    for (const cell_op& op : data.ops)
+    {
+        switch (op.type)
+        {
+            case cell_op_type::set_auto:
+            {
+                const pstring& s = data.strings[op.index];
+                dest.set_auto(op.row, op.col, s.get(), s.size());
+                break;
+            }
+            case cell_op_type::set_string:
+            {
+                if (op.index >= string_ids.size())
+                {
+                    std::ostringstream os;
+                    os << "sheet_buffer::replay: string index " << op.index << " is not known to the shared strings buffer.";
+                    throw general_error(os.str());
+                }
+
+                dest.set_string(op.row, op.col, string_ids[op.index]);
+                break;
+            }
+            case cell_op_type::set_value:
+                dest.set_value(op.row, op.col, op.value);
+                break;
+            case cell_op_type::set_bool:
+                dest.set_bool(op.row, op.col, op.index != 0);
+                break;
+            case cell_op_type::set_date_time:
+            {
+                const date_time_t& dt = data.date_times[op.index];
+                dest.set_date_time(op.row, op.col, dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second);
+                break;
+            }
+            case cell_op_type::set_format:
+                dest.set_format(op.row, op.col, op.index);
+                break;
+            case cell_op_type::set_format_range:
+            {
+                const format_range& fr = data.format_ranges[op.index];
+                dest.set_format(
+                    fr.range.first.row, fr.range.first.column, fr.range.last.row, fr.range.last.column, fr.xf);
+                break;
+            }
+            case cell_op_type::fill_down_cells:
+                dest.fill_down_cells(op.row, op.col, op.index);
+                break;
+            case cell_op_type::set_data_range_hint:
+                dest.set_data_range_hint(data.ranges[op.index]);
+                break;
+            case cell_op_type::set_column_width:
+                props->set_column_width(op.col, op.value, length_unit_t(op.index));
+                break;
+            case cell_op_type::set_column_hidden:
+                props->set_column_hidden(op.col, op.index != 0);
+                break;
+            case cell_op_type::set_row_height:
+                props->set_row_height(op.row, op.value, length_unit_t(op.index));
+                break;
+            case cell_op_type::set_row_hidden:
+                props->set_row_hidden(op.row, op.index != 0);
+                break;
+            case cell_op_type::set_merge_cell_range:
+                props->set_merge_cell_range(data.ranges[op.index]);
+                break;
+        }
+    }
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
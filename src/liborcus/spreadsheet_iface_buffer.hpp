@@ -0,0 +1,113 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_SPREADSHEET_IFACE_BUFFER_HPP
+#define INCLUDED_ORCUS_SPREADSHEET_IFACE_BUFFER_HPP
+
+#include "orcus/spreadsheet/import_interface.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace orcus {
+
+/**
+ * Records the strings passed to it so that they can be passed on to
+ * another shared strings instance later, in the same order.  This allows
+ * a part of a document to be parsed on a separate thread, away from the
+ * destination instance.
+ *
+ * The string indices it returns are local to this instance.  Use the
+ * indices returned from replay() to map them to the indices in the
+ * destination.
+ */
+class shared_strings_buffer : public spreadsheet::iface::import_shared_strings
+{
+public:
+    shared_strings_buffer();
+    virtual ~shared_strings_buffer() override;
+
+    virtual size_t append(const char* s, size_t n) override;
+    virtual size_t add(const char* s, size_t n) override;
+
+    virtual void set_segment_font(size_t font_index) override;
+    virtual void set_segment_bold(bool b) override;
+    virtual void set_segment_italic(bool b) override;
+    virtual void set_segment_font_name(const char* s, size_t n) override;
+    virtual void set_segment_font_size(double point) override;
+    virtual void set_segment_font_color(
+        spreadsheet::color_elem_t alpha, spreadsheet::color_elem_t red,
+        spreadsheet::color_elem_t green, spreadsheet::color_elem_t blue) override;
+    virtual void append_segment(const char* s, size_t n) override;
+    virtual size_t commit_segments() override;
+
+    /**
+     * Pass all recorded strings on to the destination.
+     *
+     * @param dest destination shared strings instance.
+     *
+     * @return string indices in the destination, indexed by the local string
+     *         indices.
+     */
+    std::vector<size_t> replay(spreadsheet::iface::import_shared_strings& dest) const;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+};
+
+/**
+ * Records the cell values, cell formats and sheet properties passed to it,
+ * so that they can be passed on to the destination sheet later, in the
+ * same order.  The strings set to the cells are expected to be referenced
+ * by the local indices of a shared_strings_buffer instance.
+ *
+ * Only the destination's size and whether it supports sheet properties are
+ * queried at construction.  Other interfaces of the sheet are not
+ * available through the buffer.
+ */
+class sheet_buffer : public spreadsheet::iface::import_sheet
+{
+public:
+    sheet_buffer(spreadsheet::iface::import_sheet& dest);
+    virtual ~sheet_buffer() override;
+
+    virtual spreadsheet::iface::import_sheet_properties* get_sheet_properties() override;
+
+    virtual void set_auto(spreadsheet::row_t row, spreadsheet::col_t col, const char* p, size_t n) override;
+    virtual void set_string(spreadsheet::row_t row, spreadsheet::col_t col, size_t sindex) override;
+    virtual void set_value(spreadsheet::row_t row, spreadsheet::col_t col, double value) override;
+    virtual void set_bool(spreadsheet::row_t row, spreadsheet::col_t col, bool value) override;
+    virtual void set_date_time(
+        spreadsheet::row_t row, spreadsheet::col_t col,
+        int year, int month, int day, int hour, int minute, double second) override;
+    virtual void set_format(spreadsheet::row_t row, spreadsheet::col_t col, size_t xf_index) override;
+    virtual void set_format(
+        spreadsheet::row_t row_start, spreadsheet::col_t col_start,
+        spreadsheet::row_t row_end, spreadsheet::col_t col_end, size_t xf_index) override;
+    virtual void fill_down_cells(spreadsheet::row_t src_row, spreadsheet::col_t src_col, spreadsheet::row_t range_size) override;
+    virtual spreadsheet::range_size_t get_sheet_size() const override;
+    virtual void set_data_range_hint(const spreadsheet::range_t& range) override;
+
+    /**
+     * Pass everything recorded on to the destination sheet.
+     *
+     * @param string_ids mapping of the local string indices to the string
+     *                   indices in the destination, as returned from
+     *                   shared_strings_buffer::replay().
+     */
+    void replay(const std::vector<size_t>& string_ids) const;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+};
+
+}
+
+#endif
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -22,6 +22,8 @@ import_pivot_cache_records::~import_pivot_cache_records() {}
 
 import_shared_strings::~import_shared_strings() {}
 
+void import_shared_strings::set_count(size_t /*n*/) {}
+
 import_styles::~import_styles() {}
 
 import_sheet_properties::~import_sheet_properties() {}
@@ -92,6 +94,8 @@ import_formula* import_sheet::get_formula()
     return nullptr;
 }
 
+void import_sheet::set_data_range_hint(const range_t& /*range*/) {}
+
 import_global_settings::~import_global_settings() {}
 
 import_reference_resolver::~import_reference_resolver() {}
@@ -0,0 +1,62 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "string_batch.hpp"
+
+namespace orcus {
+
+string_batch::string_batch() {}
+string_batch::~string_batch() {}
+
+void string_batch::push_back(const pstring& s, bool transient)
+{
+    if (!transient)
+    {
+        m_entries.push_back({s.get(), 0, s.size()});
+        return;
+    }
+
+    // The buffer may get re-allocated as it grows, so only record the
+    // offset for now.
+    m_entries.push_back({nullptr, m_buffer.size(), s.size()});
+    m_buffer.append(s.get(), s.size());
+}
+
+size_t string_batch::size() const
+{
+    return m_entries.size();
+}
+
+bool string_batch::empty() const
+{
+    return m_entries.empty();
+}
+
+const pstring* string_batch::get()
+{
+    m_strings.clear();
+    m_strings.reserve(m_entries.size());
+
+    for (const entry& e : m_entries)
+    {
+        const char* p = e.p ? e.p : m_buffer.data() + e.offset;
+        m_strings.emplace_back(p, e.size);
+    }
+
+    return m_strings.data();
+}
+
+void string_batch::clear()
+{
+    m_buffer.clear();
+    m_entries.clear();
+    m_strings.clear();
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,78 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_STRING_BATCH_HPP
+#define INCLUDED_ORCUS_STRING_BATCH_HPP
+
+#include "orcus/pstring.hpp"
+
+#include <string>
+#include <vector>
+
+namespace orcus {
+
+/**
+ * Collects strings to pass to the shared string store in one batch.
+ * Strings that point into the stream being parsed are referenced as-is,
+ * while transient strings get copied into a single contiguous buffer owned
+ * by this class, so that collecting them involves no per-string heap
+ * allocation.
+ */
+class string_batch
+{
+    struct entry
+    {
+        /** Pointer to the string, or nullptr if it's in the buffer. */
+        const char* p;
+        /** Offset into the buffer, used only when p is nullptr. */
+        size_t offset;
+        size_t size;
+    };
+
+    std::string m_buffer;
+    std::vector<entry> m_entries;
+    std::vector<pstring> m_strings;
+
+public:
+    /**
+     * Number of strings at which the callers should pass the batch on, to
+     * keep its buffer reasonably small.
+     */
+    static constexpr size_t flush_size = 4096;
+
+    string_batch();
+    ~string_batch();
+
+    /**
+     * Append a string to the batch.
+     *
+     * @param s string to append.
+     * @param transient whether or not the string is transient, in which
+     *                  case it gets copied into the buffer.
+     */
+    void push_back(const pstring& s, bool transient);
+
+    size_t size() const;
+
+    bool empty() const;
+
+    /**
+     * Get the collected strings in the order of their insertion.  The
+     * returned array stays valid until the batch is modified.
+     *
+     * @return pointer to the array of the collected strings.
+     */
+    const pstring* get();
+
+    void clear();
+};
+
+}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
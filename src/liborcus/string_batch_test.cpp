@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "string_batch.hpp"
+
+#include <cstdlib>
+#include <cassert>
+#include <string>
+#include <sstream>
+
+using namespace std;
+using namespace orcus;
+
+namespace {
+
+void test_mixed()
+{
+    std::string stream = "persistent";
+
+    string_batch batch;
+    assert(batch.empty());
+
+    {
+        // Transient strings must be copied, as their source goes away.
+        std::string transient = "transient";
+        batch.push_back(pstring(stream.data(), stream.size()), false);
+        batch.push_back(pstring(transient.data(), transient.size()), true);
+        batch.push_back(pstring(), true);
+        transient = "overwritten";
+    }
+
+    assert(batch.size() == 3);
+
+    const pstring* strs = batch.get();
+    assert(strs[0] == "persistent");
+    assert(strs[0].get() == stream.data());
+    assert(strs[1] == "transient");
+    assert(strs[2].empty());
+
+    batch.clear();
+    assert(batch.empty());
+}
+
+void test_buffer_growth()
+{
+    // Make sure the strings stay valid after the buffer gets re-allocated
+    // multiple times.
+    string_batch batch;
+    const size_t n = 10000;
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::ostringstream os;
+        os << "string " << i;
+        std::string s = os.str();
+        batch.push_back(pstring(s.data(), s.size()), true);
+    }
+
+    assert(batch.size() == n);
+    const pstring* strs = batch.get();
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::ostringstream os;
+        os << "string " << i;
+        assert(strs[i] == os.str());
+    }
+}
+
+}
+
+int main()
+{
+    test_mixed();
+    test_buffer_growth();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -6,6 +6,11 @@
  */
 
 #include "string_helper.hpp"
+#include "orcus/parser_global.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 namespace orcus {
 
@@ -35,6 +40,37 @@ std::vector<pstring> string_helper::split_string(const pstring& str, const char
     return ret;
 }
 
+bool string_helper::to_numeric(const pstring& str, double& val)
+{
+    if (str.empty())
+        return false;
+
+    const char* p = str.get();
+    const char* p_end = p + str.size();
+    double v = parse_numeric(p, str.size());
+    if (p != p_end)
+    {
+        // Fall back to the conversion sheet::set_auto() uses, so that a value
+        // inferred as numeric here is also numeric when it goes through auto
+        // detection.  This is only reached for values such as hexadecimal
+        // ones, infinity and NaN, as well as for non-numeric values.  The
+        // string is copied since it is not null-terminated, but only when it
+        // may start a number for strtod().
+        pstring head = str.trim();
+        if (head.empty() || !std::strchr("+-.0123456789iInN", head[0]))
+            return false;
+
+        std::string s = str.str();
+        char* endptr = nullptr;
+        v = std::strtod(s.data(), &endptr);
+        if (endptr != s.data() + s.size())
+            return false;
+    }
+
+    val = v;
+    return true;
+}
+
 }
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -15,6 +15,18 @@ class string_helper
 {
 public:
     static std::vector<pstring> split_string(const pstring& string, const char separator);
+
+    /**
+     * Parse a string as a numeric value the way strtod() does, which
+     * includes hexadecimal values as well as infinity and NaN.
+     *
+     * @param str string to parse.
+     * @param val parsed value, which is only set on success.
+     *
+     * @return true if the entire string forms a valid number, false
+     *         otherwise.
+     */
+    static bool to_numeric(const pstring& str, double& val);
 };
 
 }
@@ -26,6 +26,7 @@
 #include <fstream>
 #include <cstdlib>
 #include <sstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -90,10 +91,28 @@ public:
 }
 
 xlsx_shared_strings_context::xlsx_shared_strings_context(session_context& session_cxt, const tokens& tokens, spreadsheet::iface::import_shared_strings* strings) :
-    xml_context_base(session_cxt, tokens), mp_strings(strings), m_in_segments(false) {}
+    xml_context_base(session_cxt, tokens), mp_strings(strings), m_part_size(0),
+    m_cur_str_transient(false), m_in_segments(false) {}
 
 xlsx_shared_strings_context::~xlsx_shared_strings_context() {}
 
+void xlsx_shared_strings_context::set_part_size(size_t size)
+{
+    m_part_size = size;
+}
+
+void xlsx_shared_strings_context::flush_strings()
+{
+    if (m_strings.empty())
+        return;
+
+    const pstring* strs = m_strings.get();
+    for (size_t i = 0, n = m_strings.size(); i < n; ++i)
+        mp_strings->append(strs[i].get(), strs[i].size());
+
+    m_strings.clear();
+}
+
 bool xlsx_shared_strings_context::can_handle_element(xmlns_id_t /*ns*/, xml_token_t /*name*/) const
 {
     return true;
@@ -125,6 +144,13 @@ void xlsx_shared_strings_context::start_element(xmlns_id_t ns, xml_token_t name,
 
             if (get_config().debug)
                 cout << "count: " << func.get_count() << "  unique count: " << func.get_unique_count() << endl;
+
+            // The count comes from the file as is.  Each string takes at
+            // least an empty <si/> element, which bounds how many the part
+            // can actually hold.
+            size_t n = std::min<size_t>(func.get_unique_count(), m_part_size / 5);
+            if (n)
+                mp_strings->set_count(n);
         }
         break;
         case XML_si:
@@ -223,15 +249,24 @@ bool xlsx_shared_strings_context::end_element(xmlns_id_t ns, xml_token_t name)
         case XML_si:
         {
             if (m_in_segments)
-                // commit all formatted segments.
+            {
+                // commit all formatted segments, after the unformatted
+                // strings preceding it to preserve the order.
+                flush_strings();
                 mp_strings->commit_segments();
+            }
             else
             {
                 // unformatted text should only have one text segment.
-                mp_strings->append(m_cur_str.get(), m_cur_str.size());
+                m_strings.push_back(m_cur_str, m_cur_str_transient);
+                if (m_strings.size() >= string_batch::flush_size)
+                    flush_strings();
             }
         }
         break;
+        case XML_sst:
+            flush_strings();
+        break;
     }
     return pop_stack(ns, name);
 }
@@ -242,6 +277,7 @@ void xlsx_shared_strings_context::characters(const pstring& str, bool transient)
     if (cur_token.first == NS_ooxml_xlsx && cur_token.second == XML_t)
     {
         m_cur_str = str;
+        m_cur_str_transient = transient;
 
         // In case the string contains carriage returns (CRs), remove them.
         m_cell_buffer.reset();
@@ -270,14 +306,16 @@ void xlsx_shared_strings_context::characters(const pstring& str, bool transient)
                 // Append the tail end.
                 m_cell_buffer.append(p0, std::distance(p0, p));
 
-            m_cur_str = m_pool.intern(
-                m_cell_buffer.get(), m_cell_buffer.size()).first;
-
-            transient = false;
+            m_cur_str = pstring(m_cell_buffer.get(), m_cell_buffer.size());
+            m_cur_str_transient = true;
+        }
+        else if (transient)
+        {
+            // Keep the transient string until the end of the element.  It
+            // gets copied when it's added to the batch.
+            m_cell_buffer.append(m_cur_str.get(), m_cur_str.size());
+            m_cur_str = pstring(m_cell_buffer.get(), m_cell_buffer.size());
         }
-
-        if (transient)
-            m_cur_str = m_pool.intern(m_cur_str).first;
     }
 }
 
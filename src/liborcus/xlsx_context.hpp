@@ -14,6 +14,7 @@
 
 #include "xml_context_base.hpp"
 #include "xlsx_types.hpp"
+#include "string_batch.hpp"
 
 namespace orcus {
 
@@ -40,11 +41,29 @@ public:
     virtual bool end_element(xmlns_id_t ns, xml_token_t name);
     virtual void characters(const pstring& str, bool transient);
 
+    /**
+     * Set the size of the part being parsed, which caps the number of unique
+     * strings passed on as a hint.
+     *
+     * @param size uncompressed size of the part in bytes.
+     */
+    void set_part_size(size_t size);
+
+private:
+    /**
+     * Pass all the unformatted strings collected so far to the shared
+     * strings store.
+     */
+    void flush_strings();
+
 private:
     spreadsheet::iface::import_shared_strings* mp_strings;
+    size_t m_part_size;
     string_pool m_pool;
     cell_buffer m_cell_buffer;
+    string_batch m_strings;
     pstring m_cur_str;
+    bool m_cur_str_transient;
     bool m_in_segments;
 };
 
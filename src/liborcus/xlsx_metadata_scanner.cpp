@@ -0,0 +1,447 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "xlsx_metadata_scanner.hpp"
+#include "ooxml_namespace_types.hpp"
+
+#include "orcus/orcus_xlsx.hpp"
+#include "orcus/zip_archive.hpp"
+#include "orcus/sax_ns_parser.hpp"
+#include "orcus/exception.hpp"
+#include "orcus/pstring.hpp"
+
+#include <unordered_map>
+#include <ostream>
+#include <cstring>
+#include <cstdlib>
+
+namespace orcus {
+
+namespace {
+
+/**
+ * Maximum number of uncompressed bytes to read from the head of each sheet
+ * part.  The sheetPr and dimension elements precede all other content of a
+ * sheet, so this is normally far more than needed.
+ */
+constexpr size_t sheet_head_size = 32 * 1024;
+
+/**
+ * Thrown from within a handler to end the parsing of a part as soon as all
+ * the needed information has been collected.
+ */
+struct scan_stop {};
+
+/**
+ * Namespaces the scanner recognizes.  The package relationships namespace
+ * is the same in both conformance classes.
+ */
+const xmlns_id_t scanner_ns[] = {
+    NS_opc_rel,
+    NS_ooxml_r,
+    NS_ooxml_r_strict,
+    NS_ooxml_xlsx,
+    NS_ooxml_xlsx_strict,
+    nullptr
+};
+
+bool is_xlsx_ns(xmlns_id_t ns)
+{
+    return ns == NS_ooxml_xlsx || ns == NS_ooxml_xlsx_strict;
+}
+
+typedef std::unordered_map<std::string, std::string> attrs_type;
+
+/**
+ * Base handler that collects the attributes of the element about to be
+ * opened, as the parser reports them before the element itself.
+ */
+class attrs_handler : public sax_ns_handler
+{
+protected:
+    attrs_type m_attrs;
+
+    std::string get_attr(const char* name) const
+    {
+        auto it = m_attrs.find(name);
+        return it == m_attrs.end() ? std::string() : it->second;
+    }
+
+public:
+    void attribute(const pstring& /*name*/, const pstring& /*val*/) {}
+
+    void attribute(const sax_ns_parser_attribute& attr)
+    {
+        std::string name;
+        if (!attr.ns_alias.empty())
+        {
+            // Only the relationship id attribute needs its prefix.
+            if ((attr.ns != NS_ooxml_r && attr.ns != NS_ooxml_r_strict) || attr.name != "id")
+                return;
+
+            name = "r:";
+        }
+
+        name += attr.name.str();
+        m_attrs[name] = attr.value.str();
+    }
+
+    void end_element(const sax_ns_parser_element& /*elem*/)
+    {
+        m_attrs.clear();
+    }
+};
+
+struct relationship
+{
+    std::string id;
+    std::string type;
+    std::string target;
+};
+
+class rels_handler : public attrs_handler
+{
+    std::vector<relationship>& m_rels;
+
+public:
+    rels_handler(std::vector<relationship>& rels) : m_rels(rels) {}
+
+    void start_element(const sax_ns_parser_element& elem)
+    {
+        if (elem.ns == NS_opc_rel && elem.name == "Relationship")
+            m_rels.push_back({get_attr("Id"), get_attr("Type"), get_attr("Target")});
+
+        m_attrs.clear();
+    }
+};
+
+struct sheet_entry
+{
+    std::string name;
+    std::string rid;
+};
+
+class workbook_handler : public attrs_handler
+{
+    std::vector<sheet_entry>& m_sheets;
+    std::vector<xlsx_workbook_metadata::defined_name>& m_names;
+    bool m_in_defined_name;
+
+public:
+    workbook_handler(
+        std::vector<sheet_entry>& sheets, std::vector<xlsx_workbook_metadata::defined_name>& names) :
+        m_sheets(sheets), m_names(names), m_in_defined_name(false) {}
+
+    void start_element(const sax_ns_parser_element& elem)
+    {
+        if (is_xlsx_ns(elem.ns))
+        {
+            if (elem.name == "sheet")
+                m_sheets.push_back({get_attr("name"), get_attr("r:id")});
+            else if (elem.name == "definedName")
+            {
+                xlsx_workbook_metadata::defined_name dn;
+                dn.name = get_attr("name");
+                std::string scope = get_attr("localSheetId");
+                if (!scope.empty())
+                    dn.sheet_scope = std::strtol(scope.data(), nullptr, 10);
+
+                m_names.push_back(std::move(dn));
+                m_in_defined_name = true;
+            }
+        }
+
+        m_attrs.clear();
+    }
+
+    void end_element(const sax_ns_parser_element& elem)
+    {
+        if (is_xlsx_ns(elem.ns))
+        {
+            if (elem.name == "definedName")
+                m_in_defined_name = false;
+            else if (elem.name == "definedNames")
+                // Nothing of interest follows the defined names.
+                throw scan_stop();
+        }
+
+        attrs_handler::end_element(elem);
+    }
+
+    void characters(const pstring& val, bool /*transient*/)
+    {
+        if (m_in_defined_name)
+            m_names.back().expression.append(val.data(), val.size());
+    }
+};
+
+/**
+ * Reads the sheetPr and dimension elements at the top of a sheet part, and
+ * stops as soon as any other child of the root element is encountered.
+ */
+class sheet_head_handler : public attrs_handler
+{
+    xlsx_workbook_metadata::sheet& m_sheet;
+    size_t m_depth;
+    bool m_in_sheet_pr;
+
+public:
+    sheet_head_handler(xlsx_workbook_metadata::sheet& sheet) :
+        m_sheet(sheet), m_depth(0), m_in_sheet_pr(false) {}
+
+    void start_element(const sax_ns_parser_element& elem)
+    {
+        ++m_depth;
+
+        if (m_depth == 2)
+        {
+            if (is_xlsx_ns(elem.ns) && elem.name == "sheetPr")
+            {
+                m_in_sheet_pr = true;
+                m_sheet.code_name = get_attr("codeName");
+            }
+            else if (is_xlsx_ns(elem.ns) && elem.name == "dimension")
+                m_sheet.dimension = get_attr("ref");
+            else
+                throw scan_stop();
+        }
+        else if (m_in_sheet_pr && is_xlsx_ns(elem.ns) && elem.name == "tabColor")
+            m_sheet.tab_color = get_attr("rgb");
+
+        m_attrs.clear();
+    }
+
+    void end_element(const sax_ns_parser_element& elem)
+    {
+        --m_depth;
+
+        if (m_depth == 1)
+        {
+            if (is_xlsx_ns(elem.ns) && elem.name == "dimension")
+                // The dimension element always comes after sheetPr.
+                throw scan_stop();
+
+            m_in_sheet_pr = false;
+        }
+
+        attrs_handler::end_element(elem);
+    }
+};
+
+template<typename _Handler>
+void parse_part(const unsigned char* p, size_t n, xmlns_repository& ns_repo, _Handler& hdl)
+{
+    if (!n)
+        return;
+
+    xmlns_context cxt = ns_repo.create_context();
+    sax_ns_parser<_Handler> parser(reinterpret_cast<const char*>(p), n, cxt, hdl);
+
+    try
+    {
+        parser.parse();
+    }
+    catch (const scan_stop&)
+    {
+    }
+}
+
+/**
+ * Resolve a relationship target against the directory of its source part.
+ */
+std::string resolve_path(const std::string& dir, const std::string& target)
+{
+    // A target starting with '/' is relative to the package root.
+    std::string joined = !target.empty() && target[0] == '/' ? target : dir + target;
+    std::vector<std::string> segments;
+    std::string::size_type pos = 0;
+
+    while (pos <= joined.size())
+    {
+        std::string::size_type end = joined.find('/', pos);
+        if (end == std::string::npos)
+            end = joined.size();
+
+        std::string seg = joined.substr(pos, end - pos);
+        if (seg == "..")
+        {
+            if (!segments.empty())
+                segments.pop_back();
+        }
+        else if (!seg.empty() && seg != ".")
+            segments.push_back(std::move(seg));
+
+        pos = end + 1;
+    }
+
+    std::string path;
+    for (const std::string& seg : segments)
+    {
+        if (!path.empty())
+            path += '/';
+        path += seg;
+    }
+
+    return path;
+}
+
+bool ends_with(const std::string& s, const char* suffix)
+{
+    std::string::size_type n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+}
+
+xlsx_metadata_scanner::xlsx_metadata_scanner(const zip_archive& archive) :
+    m_archive(archive)
+{
+    m_ns_repo.add_predefined_values(scanner_ns);
+}
+
+bool xlsx_metadata_scanner::read_part(const std::string& path, zip_file_entry_buffer& buf) const
+{
+    return m_archive.read_file_entry(path.c_str(), buf);
+}
+
+void xlsx_metadata_scanner::scan(xlsx_workbook_metadata& data)
+{
+    // Part sizes all come from the central directory.
+    std::unordered_map<std::string, size_t> part_index;
+
+    for (size_t i = 0, n = m_archive.get_file_entry_count(); i < n; ++i)
+    {
+        xlsx_workbook_metadata::part part;
+        part.path = m_archive.get_file_entry_name(i).str();
+        zip_file_entry_stat stat = m_archive.get_file_entry_stat(i);
+        part.size_compressed = stat.size_compressed;
+        part.size_uncompressed = stat.size_uncompressed;
+        part_index.insert({part.path, data.parts.size()});
+        data.parts.push_back(std::move(part));
+    }
+
+    // Locate the workbook part via the package relationships.
+    std::string workbook_path = "xl/workbook.xml";
+    zip_file_entry_buffer buf;
+    std::vector<unsigned char> head;
+
+    if (read_part("_rels/.rels", buf))
+    {
+        std::vector<relationship> rels;
+        rels_handler hdl(rels);
+        parse_part(buf.data(), buf.size(), m_ns_repo, hdl);
+
+        for (const relationship& rel : rels)
+        {
+            if (ends_with(rel.type, "/officeDocument"))
+            {
+                workbook_path = resolve_path(std::string(), rel.target);
+                break;
+            }
+        }
+    }
+
+    std::string workbook_dir, workbook_name = workbook_path;
+    std::string::size_type pos = workbook_path.rfind('/');
+    if (pos != std::string::npos)
+    {
+        workbook_dir = workbook_path.substr(0, pos + 1);
+        workbook_name = workbook_path.substr(pos + 1);
+    }
+
+    std::vector<relationship> rels;
+    if (read_part(workbook_dir + "_rels/" + workbook_name + ".rels", buf))
+    {
+        rels_handler hdl(rels);
+        parse_part(buf.data(), buf.size(), m_ns_repo, hdl);
+    }
+
+    std::vector<sheet_entry> sheets;
+    if (!read_part(workbook_path, buf))
+        throw xml_structure_error("workbook part not found in the package.");
+
+    workbook_handler wb_hdl(sheets, data.defined_names);
+    parse_part(buf.data(), buf.size(), m_ns_repo, wb_hdl);
+
+    for (const sheet_entry& entry : sheets)
+    {
+        xlsx_workbook_metadata::sheet sheet;
+        sheet.name = entry.name;
+
+        for (const relationship& rel : rels)
+        {
+            if (rel.id == entry.rid)
+            {
+                sheet.path = resolve_path(workbook_dir, rel.target);
+                break;
+            }
+        }
+
+        auto it = part_index.find(sheet.path);
+        if (it != part_index.end())
+        {
+            const xlsx_workbook_metadata::part& part = data.parts[it->second];
+            sheet.size_compressed = part.size_compressed;
+            sheet.size_uncompressed = part.size_uncompressed;
+
+            if (m_archive.read_file_entry_head(sheet.path.c_str(), head, sheet_head_size))
+            {
+                sheet_head_handler hdl(sheet);
+                try
+                {
+                    parse_part(head.data(), head.size(), m_ns_repo, hdl);
+                }
+                catch (const parse_error&)
+                {
+                    // The head segment ended before the parser got to
+                    // anything past the dimension element. Keep whatever
+                    // has been picked up so far.
+                }
+            }
+        }
+
+        data.sheets.push_back(std::move(sheet));
+    }
+}
+
+void xlsx_workbook_metadata::dump(std::ostream& os) const
+{
+    os << "sheets:" << std::endl;
+    for (const sheet& sh : sheets)
+    {
+        os << "  - name: " << sh.name << std::endl;
+        os << "    part: " << sh.path << std::endl;
+        os << "    dimension: " << sh.dimension << std::endl;
+        if (!sh.code_name.empty())
+            os << "    code-name: " << sh.code_name << std::endl;
+        if (!sh.tab_color.empty())
+            os << "    tab-color: " << sh.tab_color << std::endl;
+        os << "    size-compressed: " << sh.size_compressed << std::endl;
+        os << "    size-uncompressed: " << sh.size_uncompressed << std::endl;
+    }
+
+    os << "defined-names:" << std::endl;
+    for (const defined_name& dn : defined_names)
+    {
+        os << "  - name: " << dn.name << std::endl;
+        os << "    expression: " << dn.expression << std::endl;
+        if (dn.sheet_scope >= 0)
+            os << "    sheet-scope: " << dn.sheet_scope << std::endl;
+    }
+
+    os << "parts:" << std::endl;
+    for (const part& p : parts)
+    {
+        os << "  - path: " << p.path << std::endl;
+        os << "    size-compressed: " << p.size_compressed << std::endl;
+        os << "    size-uncompressed: " << p.size_uncompressed << std::endl;
+    }
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
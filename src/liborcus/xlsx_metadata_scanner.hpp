@@ -0,0 +1,44 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_XLSX_METADATA_SCANNER_HPP
+#define INCLUDED_ORCUS_XLSX_METADATA_SCANNER_HPP
+
+#include "orcus/xml_namespace.hpp"
+
+#include <string>
+#include <vector>
+
+namespace orcus {
+
+class zip_archive;
+class zip_file_entry_buffer;
+struct xlsx_workbook_metadata;
+
+/**
+ * Collects the metadata of an xlsx workbook without going through the
+ * import factory.  It only reads the package relationships, the workbook
+ * part and its relationships, and the leading segment of each sheet part
+ * up to the point where the cell data begins.
+ */
+class xlsx_metadata_scanner
+{
+    const zip_archive& m_archive;
+    xmlns_repository m_ns_repo;
+
+    bool read_part(const std::string& path, zip_file_entry_buffer& buf) const;
+
+public:
+    xlsx_metadata_scanner(const zip_archive& archive);
+
+    void scan(xlsx_workbook_metadata& data);
+};
+
+}
+
+#endif
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
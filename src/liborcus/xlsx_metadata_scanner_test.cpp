@@ -0,0 +1,394 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "xlsx_metadata_scanner.hpp"
+
+#include "orcus/orcus_xlsx.hpp"
+#include "orcus/zip_archive.hpp"
+#include "orcus/zip_archive_stream.hpp"
+#include "orcus/zip_archive_writer.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <set>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+
+using namespace std;
+using namespace orcus;
+
+namespace {
+
+typedef std::vector<std::pair<std::string, std::string>> parts_type;
+
+const char* rels_head =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+
+const char* rels_tail = "</Relationships>";
+
+const char* workbook_head =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+    "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
+    " xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">";
+
+const char* sheet_head =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+    "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
+    " xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">";
+
+std::string create_package(const parts_type& parts)
+{
+    std::ostringstream os;
+    zip_archive_writer writer(os);
+    for (const auto& part : parts)
+        writer.add_file_entry(part.first, part.second.data(), part.second.size());
+    writer.close();
+    return os.str();
+}
+
+xlsx_workbook_metadata scan_package(const std::string& package)
+{
+    zip_archive_stream_blob stream(
+        reinterpret_cast<const unsigned char*>(package.data()), package.size());
+    zip_archive archive(&stream);
+    archive.load();
+
+    xlsx_workbook_metadata data;
+    xlsx_metadata_scanner scanner(archive);
+    scanner.scan(data);
+    return data;
+}
+
+std::string get_relationship(const char* id, const char* type, const char* target)
+{
+    std::ostringstream os;
+    os << "<Relationship Id=\"" << id
+        << "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/" << type
+        << "\" Target=\"" << target << "\"/>";
+    return os.str();
+}
+
+}
+
+void test_existing_file()
+{
+    xlsx_workbook_metadata data =
+        orcus_xlsx::read_metadata(SRCDIR"/test/xlsx/named-expression-sheet-local/input.xlsx");
+
+    assert(data.sheets.size() == 2);
+    assert(data.sheets[0].name == "Sheet1");
+    assert(data.sheets[0].path == "xl/worksheets/sheet1.xml");
+    assert(data.sheets[0].dimension == "A1:B7");
+    assert(data.sheets[0].size_uncompressed > 0);
+    assert(data.sheets[1].name == "Sheet2");
+    assert(data.sheets[1].path == "xl/worksheets/sheet2.xml");
+    assert(data.sheets[1].dimension == "A1:B7");
+    assert(data.sheets[1].size_uncompressed > 0);
+
+    // Each sheet has its own 'MyRange'.
+    std::set<int> scopes;
+    for (const xlsx_workbook_metadata::defined_name& dn : data.defined_names)
+    {
+        if (dn.name != "MyRange")
+            continue;
+
+        assert(!dn.expression.empty());
+        scopes.insert(dn.sheet_scope);
+    }
+
+    assert((scopes == std::set<int>{0, 1}));
+
+    data = orcus_xlsx::read_metadata(SRCDIR"/test/xlsx/named-expression/input.xlsx");
+
+    assert(data.sheets.size() == 1);
+    assert(data.sheets[0].name == "Sheet1");
+    assert(data.sheets[0].dimension == "A1:B7");
+
+    std::set<std::string> names;
+    for (const xlsx_workbook_metadata::defined_name& dn : data.defined_names)
+    {
+        assert(dn.sheet_scope == -1);
+        assert(!dn.expression.empty());
+        names.insert(dn.name);
+    }
+
+    assert((names == std::set<std::string>{"MyRange", "MyRange2"}));
+
+    bool workbook_found = false;
+    for (const xlsx_workbook_metadata::part& part : data.parts)
+    {
+        if (part.path == "xl/workbook.xml")
+        {
+            workbook_found = true;
+            assert(part.size_compressed > 0);
+            assert(part.size_uncompressed > 0);
+        }
+    }
+
+    assert(workbook_found);
+}
+
+void test_relative_targets()
+{
+    // The workbook part is referenced with an absolute path, and each sheet
+    // part is referenced with a path going up from the workbook directory.
+    std::string package_rels = rels_head;
+    package_rels += get_relationship("rId1", "officeDocument", "/book/workbook.xml");
+    package_rels += rels_tail;
+
+    std::string workbook_rels = rels_head;
+    workbook_rels += get_relationship("rId1", "worksheet", "../sheets/first.xml");
+    workbook_rels += get_relationship("rId2", "worksheet", "./../book/../sheets/./second.xml");
+    workbook_rels += rels_tail;
+
+    std::string workbook = workbook_head;
+    workbook +=
+        "<sheets>"
+        "<sheet name=\"First\" sheetId=\"1\" r:id=\"rId1\"/>"
+        "<sheet name=\"Second\" sheetId=\"2\" r:id=\"rId2\"/>"
+        "</sheets>"
+        "<definedNames>"
+        "<definedName name=\"Global\">First!$A$1:$B$2</definedName>"
+        "<definedName name=\"Local\" localSheetId=\"1\">Second!$C$3</definedName>"
+        "</definedNames>"
+        "</workbook>";
+
+    std::string sheet1 = sheet_head;
+    sheet1 +=
+        "<sheetPr codeName=\"Code1\"><tabColor rgb=\"FFFF0000\"/></sheetPr>"
+        "<dimension ref=\"A1:B2\"/>"
+        "<sheetData/>"
+        "</worksheet>";
+
+    std::string sheet2 = sheet_head;
+    sheet2 +=
+        "<dimension ref=\"C3\"/>"
+        "<sheetData/>"
+        "</worksheet>";
+
+    std::string package = create_package({
+        { "_rels/.rels", package_rels },
+        { "book/_rels/workbook.xml.rels", workbook_rels },
+        { "book/workbook.xml", workbook },
+        { "sheets/first.xml", sheet1 },
+        { "sheets/second.xml", sheet2 },
+    });
+
+    xlsx_workbook_metadata data = scan_package(package);
+
+    assert(data.sheets.size() == 2);
+
+    const xlsx_workbook_metadata::sheet* sh = &data.sheets[0];
+    assert(sh->name == "First");
+    assert(sh->path == "sheets/first.xml");
+    assert(sh->dimension == "A1:B2");
+    assert(sh->code_name == "Code1");
+    assert(sh->tab_color == "FFFF0000");
+    assert(sh->size_uncompressed == sheet1.size());
+
+    sh = &data.sheets[1];
+    assert(sh->name == "Second");
+    assert(sh->path == "sheets/second.xml");
+    assert(sh->dimension == "C3");
+    assert(sh->code_name.empty());
+    assert(sh->tab_color.empty());
+    assert(sh->size_uncompressed == sheet2.size());
+
+    assert(data.defined_names.size() == 2);
+    assert(data.defined_names[0].name == "Global");
+    assert(data.defined_names[0].expression == "First!$A$1:$B$2");
+    assert(data.defined_names[0].sheet_scope == -1);
+    assert(data.defined_names[1].name == "Local");
+    assert(data.defined_names[1].expression == "Second!$C$3");
+    assert(data.defined_names[1].sheet_scope == 1);
+
+    assert(data.parts.size() == 5);
+}
+
+void test_truncated_sheet_head()
+{
+    std::string package_rels = rels_head;
+    package_rels += get_relationship("rId1", "officeDocument", "xl/workbook.xml");
+    package_rels += rels_tail;
+
+    std::string workbook_rels = rels_head;
+    workbook_rels += get_relationship("rId1", "worksheet", "worksheets/sheet1.xml");
+    workbook_rels += get_relationship("rId2", "worksheet", "worksheets/sheet2.xml");
+    workbook_rels += rels_tail;
+
+    std::string workbook = workbook_head;
+    workbook +=
+        "<sheets>"
+        "<sheet name=\"Long\" sheetId=\"1\" r:id=\"rId1\"/>"
+        "<sheet name=\"Short\" sheetId=\"2\" r:id=\"rId2\"/>"
+        "</sheets>"
+        "</workbook>";
+
+    // The sheetPr element alone is far larger than the head segment being
+    // read, so the parsing ends before the dimension element.
+    std::string sheet1 = sheet_head;
+    sheet1 += "<sheetPr codeName=\"Long\"><tabColor rgb=\"FF00FF00\"/>";
+    for (size_t i = 0; i < 4096; ++i)
+        sheet1 += "<outlinePr summaryBelow=\"0\"/>";
+    sheet1 +=
+        "</sheetPr>"
+        "<dimension ref=\"A1:Z100\"/>"
+        "<sheetData/>"
+        "</worksheet>";
+
+    std::string sheet2 = sheet_head;
+    sheet2 +=
+        "<dimension ref=\"B2:C3\"/>"
+        "<sheetData/>"
+        "</worksheet>";
+
+    std::string package = create_package({
+        { "_rels/.rels", package_rels },
+        { "xl/_rels/workbook.xml.rels", workbook_rels },
+        { "xl/workbook.xml", workbook },
+        { "xl/worksheets/sheet1.xml", sheet1 },
+        { "xl/worksheets/sheet2.xml", sheet2 },
+    });
+
+    xlsx_workbook_metadata data = scan_package(package);
+
+    assert(data.sheets.size() == 2);
+
+    // What precedes the cut is kept, and the size still comes from the
+    // central directory.
+    const xlsx_workbook_metadata::sheet* sh = &data.sheets[0];
+    assert(sh->name == "Long");
+    assert(sh->path == "xl/worksheets/sheet1.xml");
+    assert(sh->code_name == "Long");
+    assert(sh->tab_color == "FF00FF00");
+    assert(sh->dimension.empty());
+    assert(sh->size_uncompressed == sheet1.size());
+
+    // The cut does not affect the next sheet.
+    sh = &data.sheets[1];
+    assert(sh->name == "Short");
+    assert(sh->dimension == "B2:C3");
+}
+
+void test_strict_namespaces()
+{
+    std::string package_rels = rels_head;
+    package_rels +=
+        "<Relationship Id=\"rId1\""
+        " Type=\"http://purl.oclc.org/ooxml/officeDocument/relationships/officeDocument\""
+        " Target=\"xl/workbook.xml\"/>";
+    package_rels += rels_tail;
+
+    std::string workbook_rels = rels_head;
+    workbook_rels +=
+        "<Relationship Id=\"rId1\""
+        " Type=\"http://purl.oclc.org/ooxml/officeDocument/relationships/worksheet\""
+        " Target=\"worksheets/sheet1.xml\"/>";
+    workbook_rels += rels_tail;
+
+    std::string workbook =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+        "<x:workbook xmlns:x=\"http://purl.oclc.org/ooxml/spreadsheetml/main\""
+        " xmlns:rel=\"http://purl.oclc.org/ooxml/officeDocument/relationships\">"
+        "<x:sheets><x:sheet name=\"Strict\" sheetId=\"1\" rel:id=\"rId1\"/></x:sheets>"
+        "<x:definedNames><x:definedName name=\"Name\">Strict!$A$1</x:definedName></x:definedNames>"
+        "</x:workbook>";
+
+    std::string sheet =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+        "<worksheet xmlns=\"http://purl.oclc.org/ooxml/spreadsheetml/main\">"
+        "<sheetPr codeName=\"Code\"/>"
+        "<dimension ref=\"A1:C3\"/>"
+        "<sheetData/>"
+        "</worksheet>";
+
+    std::string package = create_package({
+        { "_rels/.rels", package_rels },
+        { "xl/_rels/workbook.xml.rels", workbook_rels },
+        { "xl/workbook.xml", workbook },
+        { "xl/worksheets/sheet1.xml", sheet },
+    });
+
+    xlsx_workbook_metadata data = scan_package(package);
+
+    assert(data.sheets.size() == 1);
+    assert(data.sheets[0].name == "Strict");
+    assert(data.sheets[0].path == "xl/worksheets/sheet1.xml");
+    assert(data.sheets[0].code_name == "Code");
+    assert(data.sheets[0].dimension == "A1:C3");
+
+    assert(data.defined_names.size() == 1);
+    assert(data.defined_names[0].name == "Name");
+    assert(data.defined_names[0].expression == "Strict!$A$1");
+}
+
+void test_foreign_namespaces()
+{
+    std::string package_rels = rels_head;
+    package_rels += get_relationship("rId1", "officeDocument", "xl/workbook.xml");
+    package_rels += rels_tail;
+
+    std::string workbook_rels = rels_head;
+    workbook_rels += get_relationship("rId1", "worksheet", "worksheets/sheet1.xml");
+    workbook_rels += get_relationship("rId2", "worksheet", "worksheets/sheet2.xml");
+    workbook_rels += rels_tail;
+
+    // Elements and attributes that share their local names with the ones
+    // the scanner reads, but belong to other namespaces.
+    std::string workbook = workbook_head;
+    workbook +=
+        "<sheets xmlns:ext=\"http://example.com/ext\">"
+        "<ext:sheet name=\"Foreign\" r:id=\"rId2\"/>"
+        "<sheet name=\"Native\" sheetId=\"1\" ext:id=\"rId2\" r:id=\"rId1\"/>"
+        "</sheets>"
+        "</workbook>";
+
+    std::string sheet1 = sheet_head;
+    sheet1 +=
+        "<sheetPr codeName=\"Native\"/>"
+        "<dimension ref=\"A1:B2\"/>"
+        "<sheetData/>"
+        "</worksheet>";
+
+    std::string sheet2 = sheet_head;
+    sheet2 +=
+        "<dimension ref=\"D4\"/>"
+        "<sheetData/>"
+        "</worksheet>";
+
+    std::string package = create_package({
+        { "_rels/.rels", package_rels },
+        { "xl/_rels/workbook.xml.rels", workbook_rels },
+        { "xl/workbook.xml", workbook },
+        { "xl/worksheets/sheet1.xml", sheet1 },
+        { "xl/worksheets/sheet2.xml", sheet2 },
+    });
+
+    xlsx_workbook_metadata data = scan_package(package);
+
+    assert(data.sheets.size() == 1);
+    assert(data.sheets[0].name == "Native");
+    assert(data.sheets[0].path == "xl/worksheets/sheet1.xml");
+    assert(data.sheets[0].dimension == "A1:B2");
+}
+
+int main()
+{
+    test_existing_file();
+    test_relative_targets();
+    test_truncated_sheet_head();
+    test_strict_namespaces();
+    test_foreign_namespaces();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
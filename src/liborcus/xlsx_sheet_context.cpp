@@ -223,7 +223,9 @@ xlsx_sheet_context::xlsx_sheet_context(
     m_cur_row(-1),
     m_cur_col(-1),
     m_cur_cell_type(xlsx_ct_numeric),
-    m_cur_cell_xf(0)
+    m_cur_cell_xf(0),
+    m_skip_row(false),
+    m_skip_cell(false)
 {
     init_ooxml_context(*this);
 }
@@ -315,8 +317,30 @@ void xlsx_sheet_context::start_element(xmlns_id_t ns, xml_token_t name, const xm
                 break;
             }
             case XML_dimension:
+            {
                 xml_element_expected(parent, NS_ooxml_xlsx, XML_worksheet);
+
+                // ref contains the used range of the sheet in A1 reference
+                // style.  It comes before the cell data.
+                pstring ref = for_each(
+                    attrs.begin(), attrs.end(), single_attr_getter(m_pool, NS_ooxml_xlsx, XML_ref)).get_value();
+
+                if (ref.empty())
+                    break;
+
+                try
+                {
+                    spreadsheet::range_t range = to_rc_range(m_resolver.resolve_range(ref.get(), ref.size()));
+                    if (range.first.row >= 0 && range.first.column >= 0 &&
+                        range.last.row >= range.first.row && range.last.column >= range.first.column)
+                        m_sheet.set_data_range_hint(range);
+                }
+                catch (const invalid_arg_error&)
+                {
+                    // It's only a hint.  Ignore it if we can't make sense of it.
+                }
                 break;
+            }
             case XML_mergeCells:
                 xml_element_expected(parent, NS_ooxml_xlsx, XML_worksheet);
                 break;
@@ -358,6 +382,7 @@ void xlsx_sheet_context::start_element(xmlns_id_t ns, xml_token_t name, const xm
                 break;
             case XML_sheetData:
                 xml_element_expected(parent, NS_ooxml_xlsx, XML_worksheet);
+                m_scope.reset(get_config().scope);
                 break;
             case XML_sheetFormatPr:
                 xml_element_expected(parent, NS_ooxml_xlsx, XML_worksheet);
@@ -373,6 +398,7 @@ void xlsx_sheet_context::start_element(xmlns_id_t ns, xml_token_t name, const xm
                     ++m_cur_row;
 
                 m_cur_col = -1;
+                m_skip_row = m_scope.is_restricted() && !m_scope.is_row_included(m_cur_row);
 
                 spreadsheet::iface::import_sheet_properties* sheet_props = m_sheet.get_sheet_properties();
                 if (sheet_props)
@@ -449,6 +475,15 @@ bool xlsx_sheet_context::end_element(xmlns_id_t ns, xml_token_t name)
 
 void xlsx_sheet_context::characters(const pstring& str, bool transient)
 {
+    if (m_skip_cell)
+    {
+        // Only the formula expression of a skipped cell may still be needed,
+        // in case it is the master cell of a shared formula.
+        const xml_token_pair_t& elem = get_current_element();
+        if (elem.first != NS_ooxml_xlsx || elem.second != XML_f)
+            return;
+    }
+
     m_cur_str = intern_in_context(str, transient);
 }
 
@@ -705,10 +740,30 @@ void xlsx_sheet_context::start_element_cell(const xml_token_pair_t& parent, cons
 
     m_cur_cell_type = cell_type;
     m_cur_cell_xf = xf;
+    m_skip_cell = m_skip_row || !m_scope.is_cell_included(m_cur_row, m_cur_col);
 }
 
 void xlsx_sheet_context::end_element_cell()
 {
+    if (m_skip_cell)
+    {
+        // The master cell of a shared formula must still be imported since
+        // other cells within the import scope may depend on it.
+        bool shared_master =
+            m_cur_formula.type == spreadsheet::formula_t::shared &&
+            m_cur_formula.shared_id >= 0 && !m_cur_formula.str.empty();
+
+        if (!shared_master)
+        {
+            m_cur_value.clear();
+            m_cur_formula.reset();
+            m_cur_cell_xf = 0;
+            m_cur_cell_type = xlsx_ct_numeric;
+            m_skip_cell = false;
+            return;
+        }
+    }
+
     session_context& cxt = get_session_context();
     xlsx_session_data& session_data = static_cast<xlsx_session_data&>(*cxt.mp_data);
 
@@ -814,6 +869,7 @@ void xlsx_sheet_context::end_element_cell()
     m_cur_formula.reset();
     m_cur_cell_xf = 0;
     m_cur_cell_type = xlsx_ct_numeric;
+    m_skip_cell = false;
 }
 
 void xlsx_sheet_context::push_raw_cell_value()
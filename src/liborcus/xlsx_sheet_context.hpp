@@ -9,6 +9,7 @@
 #define ORCUS_XLSX_SHEET_CONTEXT_HPP
 
 #include "xml_context_base.hpp"
+#include "import_scope_filter.hpp"
 #include "ooxml_types.hpp"
 #include "xlsx_types.hpp"
 
@@ -122,6 +123,10 @@ private:
     pstring      m_cur_value;
     formula m_cur_formula;
 
+    import_scope_filter m_scope; /// scope of the cells to import.
+    bool m_skip_row:1;  /// whether or not the current row is outside the import scope.
+    bool m_skip_cell:1; /// whether or not the current cell is outside the import scope.
+
     array_formula_results_type m_array_formula_results;
 
     /**
@@ -9,6 +9,7 @@
 #include "ooxml_tokens.hpp"
 #include "ooxml_schemas.hpp"
 #include "xlsx_sheet_context.hpp"
+#include "xlsx_context.hpp"
 #include "ooxml_token_constants.hpp"
 #include "xlsx_session_data.hpp"
 #include "orcus/types.hpp"
@@ -47,6 +48,30 @@ class mock_ref_resolver : public import_reference_resolver
     }
 };
 
+class mock_dimension_resolver : public import_reference_resolver
+{
+    virtual src_address_t resolve_address(const char* p, size_t n) override
+    {
+        assert(!"unexpected call");
+        return src_address_t();
+    }
+
+    virtual src_range_t resolve_range(const char* p, size_t n) override
+    {
+        assert(string(p, n) == "B2:D10");
+
+        src_range_t ret;
+        ret.first.sheet = 0;
+        ret.first.row = 1;
+        ret.first.column = 1;
+        ret.last.sheet = 0;
+        ret.last.row = 9;
+        ret.last.column = 3;
+
+        return ret;
+    }
+};
+
 class mock_array_formula : public import_array_formula
 {
 public:
@@ -110,6 +135,45 @@ public:
     }
 };
 
+class mock_sheet3 : public import_sheet
+{
+public:
+    size_t m_value_count = 0;
+
+    virtual void set_value(row_t row, col_t col, double val) override
+    {
+        // Only the second column is within the import scope.
+        assert(row == 0);
+        assert(col == 1);
+        assert(val == 7.0);
+        ++m_value_count;
+    }
+};
+
+class mock_sheet4 : public import_sheet
+{
+public:
+    range_t m_hint;
+    size_t m_hint_count = 0;
+
+    virtual void set_data_range_hint(const range_t& range) override
+    {
+        m_hint = range;
+        ++m_hint_count;
+    }
+};
+
+class mock_shared_strings : public import_shared_strings
+{
+public:
+    size_t m_count = 0;
+
+    virtual void set_count(size_t n) override
+    {
+        m_count = n;
+    }
+};
+
 class mock_sheet_properties : public import_sheet_properties
 {
 public:
@@ -266,6 +330,100 @@ void test_hidden_row()
     context.end_element(ns, elem);
 }
 
+void test_cell_import_scope()
+{
+    mock_sheet3 sheet;
+    mock_ref_resolver resolver;
+    session_context cxt(new xlsx_session_data);
+    config opt(format_t::xlsx);
+    opt.structure_check = false;
+    opt.scope.columns.push_back(1);
+
+    orcus::xlsx_sheet_context context(cxt, orcus::ooxml_tokens, 0, resolver, sheet);
+    context.set_config(opt);
+
+    orcus::xmlns_id_t ns = NS_ooxml_xlsx;
+    orcus::xml_attrs_t attrs;
+    context.start_element(ns, XML_sheetData, attrs);
+
+    orcus::xml_attrs_t row_attrs;
+    row_attrs.push_back(orcus::xml_token_attr_t(ns, XML_r, "1", false));
+    context.start_element(ns, XML_row, row_attrs);
+
+    // Cells without addresses are placed on consecutive columns starting
+    // from column 0.
+    for (const char* v : { "5", "7", "9" })
+    {
+        context.start_element(ns, XML_c, attrs);
+        context.start_element(ns, XML_v, attrs);
+        context.characters(v, false);
+        context.end_element(ns, XML_v);
+        context.end_element(ns, XML_c);
+    }
+
+    context.end_element(ns, XML_row);
+    context.end_element(ns, XML_sheetData);
+
+    assert(sheet.m_value_count == 1);
+}
+
+void test_dimension()
+{
+    mock_sheet4 sheet;
+    mock_dimension_resolver resolver;
+    session_context cxt(new xlsx_session_data);
+    config opt(format_t::xlsx);
+    opt.structure_check = false;
+
+    orcus::xlsx_sheet_context context(cxt, orcus::ooxml_tokens, 0, resolver, sheet);
+    context.set_config(opt);
+
+    orcus::xmlns_id_t ns = NS_ooxml_xlsx;
+    orcus::xml_attrs_t attrs;
+    attrs.push_back(orcus::xml_token_attr_t(ns, XML_ref, "B2:D10", false));
+    context.start_element(ns, XML_dimension, attrs);
+    context.end_element(ns, XML_dimension);
+
+    assert(sheet.m_hint_count == 1);
+    assert(sheet.m_hint.first.row == 1);
+    assert(sheet.m_hint.first.column == 1);
+    assert(sheet.m_hint.last.row == 9);
+    assert(sheet.m_hint.last.column == 3);
+}
+
+void test_shared_strings_count()
+{
+    mock_shared_strings strings;
+    session_context cxt(new xlsx_session_data);
+    config opt(format_t::xlsx);
+    opt.structure_check = false;
+
+    orcus::xlsx_shared_strings_context context(cxt, orcus::ooxml_tokens, &strings);
+    context.set_config(opt);
+    context.set_part_size(1000);
+
+    orcus::xmlns_id_t ns = NS_ooxml_xlsx;
+    orcus::xml_attrs_t attrs;
+    attrs.push_back(orcus::xml_token_attr_t(ns, XML_count, "10", false));
+    attrs.push_back(orcus::xml_token_attr_t(ns, XML_uniqueCount, "4", false));
+    context.start_element(ns, XML_sst, attrs);
+    context.end_element(ns, XML_sst);
+
+    assert(strings.m_count == 4);
+
+    // A count the part cannot possibly hold gets capped by the part size.
+    orcus::xlsx_shared_strings_context context2(cxt, orcus::ooxml_tokens, &strings);
+    context2.set_config(opt);
+    context2.set_part_size(1000);
+
+    attrs.clear();
+    attrs.push_back(orcus::xml_token_attr_t(ns, XML_uniqueCount, "4000000000", false));
+    context2.start_element(ns, XML_sst, attrs);
+    context2.end_element(ns, XML_sst);
+
+    assert(strings.m_count == 200);
+}
+
 }
 
 int main()
@@ -275,6 +433,9 @@ int main()
     test_array_formula();
     test_hidden_col();
     test_hidden_row();
+    test_cell_import_scope();
+    test_dimension();
+    test_shared_strings_count();
     return 0;
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
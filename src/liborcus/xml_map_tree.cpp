@@ -39,8 +39,9 @@ void print_element_stack(ostream& os, const T& elem_stack)
 
 }
 
-xml_map_tree::range_field_link::range_field_link(const pstring& _xpath, const pstring& _label) :
-    xpath(_xpath), label(_label) {}
+xml_map_tree::range_field_link::range_field_link(
+    const pstring& _xpath, const pstring& _label, xml_value_t _value_type) :
+    xpath(_xpath), label(_label), value_type(_value_type) {}
 
 xml_map_tree::element_position::element_position() :
     open_begin(0), open_end(0), close_begin(0), close_end(0) {}
@@ -52,7 +53,7 @@ xml_map_tree::range_reference::range_reference(const cell_position& _pos) :
 
 xml_map_tree::linkable::linkable(
     xml_map_tree& parent, const xml_name_t& _name, linkable_node_type _node_type, reference_type _ref_type) :
-    name(_name), node_type(_node_type), ref_type(_ref_type)
+    name(_name), node_type(_node_type), ref_type(_ref_type), value_type(xml_value_t::unknown)
 {
     parent.create_ref_store(*this);
 }
@@ -310,7 +311,7 @@ xmlns_id_t xml_map_tree::get_namespace(const pstring& alias) const
     return m_xmlns_cxt.get(alias);
 }
 
-void xml_map_tree::set_cell_link(const pstring& xpath, const cell_position& ref)
+void xml_map_tree::set_cell_link(const pstring& xpath, const cell_position& ref, xml_value_t value_type)
 {
     if (xpath.empty())
         return;
@@ -338,6 +339,7 @@ void xml_map_tree::set_cell_link(const pstring& xpath, const cell_position& ref)
     }
 
     cell_ref->pos = ref;
+    linked_node.node->value_type = value_type;
 }
 
 void xml_map_tree::start_range(const cell_position& pos)
@@ -346,12 +348,12 @@ void xml_map_tree::start_range(const cell_position& pos)
     m_cur_range_pos = pos;
 }
 
-void xml_map_tree::append_range_field_link(const pstring& xpath, const pstring& label)
+void xml_map_tree::append_range_field_link(const pstring& xpath, const pstring& label, xml_value_t value_type)
 {
     if (xpath.empty())
         return;
 
-    m_cur_range_field_links.emplace_back(xpath, label);
+    m_cur_range_field_links.emplace_back(xpath, label, value_type);
 }
 
 void xml_map_tree::insert_range_field_link(
@@ -370,6 +372,8 @@ void xml_map_tree::insert_range_field_link(
     if (!field.label.empty())
         linked_node.node->label = intern_string(field.label);
 
+    linked_node.node->value_type = field.value_type;
+
     switch (linked_node.node->node_type)
     {
         case node_element:
@@ -41,8 +41,9 @@ class xml_map_tree
     {
         pstring xpath;
         pstring label;
+        xml_value_t value_type;
 
-        range_field_link(const pstring& _xpath, const pstring& _label);
+        range_field_link(const pstring& _xpath, const pstring& _label, xml_value_t _value_type);
     };
 
 public:
@@ -131,6 +132,7 @@ public:
         };
 
         pstring label; // custom header label
+        xml_value_t value_type; // type of the linked values
         mutable pstring ns_alias; // namespace alias used in the content stream.
 
         linkable(const linkable&) = delete;
@@ -234,10 +236,10 @@ public:
     void set_namespace_alias(const pstring& alias, const pstring& uri, bool default_ns);
     xmlns_id_t get_namespace(const pstring& alias) const;
 
-    void set_cell_link(const pstring& xpath, const cell_position& ref);
+    void set_cell_link(const pstring& xpath, const cell_position& ref, xml_value_t value_type = xml_value_t::unknown);
 
     void start_range(const cell_position& pos);
-    void append_range_field_link(const pstring& xpath, const pstring& label);
+    void append_range_field_link(const pstring& xpath, const pstring& label, xml_value_t value_type = xml_value_t::unknown);
     void set_range_row_group(const pstring& xpath);
     void commit_range();
 
@@ -8,6 +8,8 @@
 #include "xml_simple_stream_handler.hpp"
 #include "xml_context_base.hpp"
 
+#include "orcus/detail/trace.hpp"
+
 #include <cassert>
 
 namespace orcus {
@@ -37,17 +39,23 @@ void xml_simple_stream_handler::end_document()
 
 void xml_simple_stream_handler::start_element(const xml_token_element_t& elem)
 {
-    get_current_context().start_element(elem.ns, elem.name, elem.attrs);
+    xml_context_base& cur = get_current_context();
+    ORCUS_TRACE_SPAN_TYPE("context", "start_element", cur);
+    cur.start_element(elem.ns, elem.name, elem.attrs);
 }
 
 void xml_simple_stream_handler::end_element(const xml_token_element_t& elem)
 {
-    get_current_context().end_element(elem.ns, elem.name);
+    xml_context_base& cur = get_current_context();
+    ORCUS_TRACE_SPAN_TYPE("context", "end_element", cur);
+    cur.end_element(elem.ns, elem.name);
 }
 
 void xml_simple_stream_handler::characters(const pstring& str, bool transient)
 {
-    get_current_context().characters(str, transient);
+    xml_context_base& cur = get_current_context();
+    ORCUS_TRACE_SPAN_TYPE("context", "characters", cur);
+    cur.characters(str, transient);
 }
 
 }
@@ -9,6 +9,7 @@
 #include "xml_context_base.hpp"
 
 #include "orcus/exception.hpp"
+#include "orcus/detail/trace.hpp"
 
 namespace orcus {
 
@@ -43,18 +44,27 @@ void xml_stream_handler::start_element(const xml_token_element_t& elem)
     xml_context_base& cur = get_current_context();
     if (!cur.can_handle_element(elem.ns, elem.name))
     {
+        ORCUS_TRACE_SPAN_TYPE("context", "create_child_context", cur);
         xml_context_base* p = cur.create_child_context(elem.ns, elem.name);
         assert(p);
         m_context_stack.push_back(p);
         m_context_stack.back()->set_ns_context(mp_ns_cxt);
     }
 
-    get_current_context().start_element(elem.ns, elem.name, elem.attrs);
+    xml_context_base& handler = get_current_context();
+    ORCUS_TRACE_SPAN_TYPE("context", "start_element", handler);
+    handler.start_element(elem.ns, elem.name, elem.attrs);
 }
 
 void xml_stream_handler::end_element(const xml_token_element_t& elem)
 {
-    bool ended = get_current_context().end_element(elem.ns, elem.name);
+    bool ended = false;
+
+    {
+        xml_context_base& cur = get_current_context();
+        ORCUS_TRACE_SPAN_TYPE("context", "end_element", cur);
+        ended = cur.end_element(elem.ns, elem.name);
+    }
 
     if (ended)
     {
@@ -66,6 +76,7 @@ void xml_stream_handler::end_element(const xml_token_element_t& elem)
             // the two adjacent contexts to communicate with each other.
             context_stack_type::reverse_iterator itr_cur = m_context_stack.rbegin();
             context_stack_type::reverse_iterator itr_par = itr_cur + 1;
+            ORCUS_TRACE_SPAN_TYPE("context", "end_child_context", **itr_par);
             (*itr_par)->end_child_context(elem.ns, elem.name, *itr_cur);
         }
 
@@ -75,7 +86,9 @@ void xml_stream_handler::end_element(const xml_token_element_t& elem)
 
 void xml_stream_handler::characters(const pstring& str, bool transient)
 {
-    get_current_context().characters(str, transient);
+    xml_context_base& cur = get_current_context();
+    ORCUS_TRACE_SPAN_TYPE("context", "characters", cur);
+    cur.characters(str, transient);
 }
 
 void xml_stream_handler::set_ns_context(const xmlns_context* p)
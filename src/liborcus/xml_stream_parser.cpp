@@ -52,6 +52,11 @@ xml_stream_handler* xml_stream_parser_base::get_handler() const
     return mp_handler;
 }
 
+void xml_stream_parser_base::declare_ns(const pstring& alias, const pstring& uri)
+{
+    m_ns_cxt.push(alias, uri);
+}
+
 xml_stream_parser::xml_stream_parser(
     const config& opt,
     xmlns_repository& ns_repo, const tokens& tokens, const char* content, size_t size) :
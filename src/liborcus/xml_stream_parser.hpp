@@ -37,6 +37,13 @@ public:
     void set_handler(xml_stream_handler* handler);
     xml_stream_handler* get_handler() const;
 
+    /**
+     * Declare a namespace before parsing, as if it had been declared by an
+     * ancestor of the root element.  Use this to parse a fragment of a
+     * larger stream.
+     */
+    void declare_ns(const pstring& alias, const pstring& uri);
+
 protected:
     xml_stream_parser_base(
         const config& opt,
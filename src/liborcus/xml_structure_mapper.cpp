@@ -50,11 +50,15 @@ void xml_structure_mapper::traverse()
         {
             std::string attr_path = path + "/@" + m_walker.to_string(attr_name);
             m_current_range.paths.push_back(attr_path);
+            m_current_range.value_types.push_back(m_walker.get_attribute_value_type(attr_name));
         }
 
         if (children.empty() && elem.has_content)
+        {
             // Only add leaf elements to the range, and only those with contents.
             m_current_range.paths.push_back(path);
+            m_current_range.value_types.push_back(elem.value_type);
+        }
     }
 
     for (const auto& child_name : children)
@@ -21,21 +21,59 @@
 #include <cstdio>
 
 #include <unordered_map>
-#include <unordered_set>
 
 namespace orcus {
 
 namespace {
 
+/**
+ * Infers the type of the values of an element or attribute from all the
+ * values seen so far.  When both numeric and non-numeric values are seen,
+ * the type is left unknown so that each value gets its own type.
+ */
+struct value_type_tracker
+{
+    bool numeric = false;
+    bool non_numeric = false;
+
+    void add(const pstring& val)
+    {
+        pstring v = val.trim();
+        if (v.empty())
+            return;
+
+        double dummy;
+        if (string_helper::to_numeric(v, dummy))
+            numeric = true;
+        else
+            non_numeric = true;
+    }
+
+    void merge(const value_type_tracker& other)
+    {
+        numeric = numeric || other.numeric;
+        non_numeric = non_numeric || other.non_numeric;
+    }
+
+    xml_value_t get() const
+    {
+        if (numeric == non_numeric)
+            return xml_value_t::unknown;
+
+        return numeric ? xml_value_t::numeric : xml_value_t::string;
+    }
+};
+
 struct elem_prop;
 typedef std::unordered_map<xml_structure_tree::entity_name, elem_prop*, xml_structure_tree::entity_name::hash> element_store_type;
-typedef std::unordered_set<xml_structure_tree::entity_name, xml_structure_tree::entity_name::hash> attribute_names_type;
+typedef std::unordered_map<xml_structure_tree::entity_name, value_type_tracker, xml_structure_tree::entity_name::hash> attribute_store_type;
+typedef std::vector<std::pair<xml_structure_tree::entity_name, value_type_tracker>> attribute_list_type;
 
 /** Element properties. */
 struct elem_prop
 {
     element_store_type child_elements;
-    attribute_names_type attributes;
+    attribute_store_type attributes;
 
     /** Store child element names in order of appearance. */
     xml_structure_tree::entity_names_type child_element_names;
@@ -56,6 +94,8 @@ struct elem_prop
 
     bool has_content;
 
+    value_type_tracker content_type;
+
     elem_prop(const elem_prop&) = delete;
     elem_prop& operator=(const elem_prop&) = delete;
 
@@ -100,20 +140,19 @@ class xml_sax_handler
     string_pool& m_pool;
     std::unique_ptr<root> mp_root;
     elements_type m_stack;
-    xml_structure_tree::entity_names_type m_attrs;
+    attribute_list_type m_attrs;
 
 private:
     void merge_attributes(elem_prop& prop)
     {
-        xml_structure_tree::entity_names_type::const_iterator it = m_attrs.begin(), it_end = m_attrs.end();
-        for (; it != it_end; ++it)
+        for (const auto& attr : m_attrs)
         {
-            if (prop.attributes.find(*it) == prop.attributes.end())
-            {
-                // New attribute.  Insert it.
-                prop.attributes.insert(*it);
-                prop.attribute_names.push_back(*it);
-            }
+            auto r = prop.attributes.insert(attr);
+            if (r.second)
+                // New attribute.
+                prop.attribute_names.push_back(attr.first);
+            else
+                r.first->second.merge(attr.second);
         }
 
         m_attrs.clear();
@@ -201,13 +240,14 @@ public:
         m_stack.pop_back();
     }
 
-    void characters(const pstring&, bool)
+    void characters(const pstring& val, bool)
     {
         if (m_stack.empty())
             return;
 
         element_ref& current = m_stack.back();
         current.prop->has_content = true;
+        current.prop->content_type.add(val);
     }
 
     void attribute(const pstring&, const pstring&)
@@ -217,7 +257,10 @@ public:
 
     void attribute(const sax_ns_parser_attribute& attr)
     {
-        m_attrs.push_back(xml_structure_tree::entity_name(attr.ns, attr.name));
+        // The attribute value may be transient. Only keep its inferred type.
+        value_type_tracker type;
+        type.add(attr.value);
+        m_attrs.emplace_back(xml_structure_tree::entity_name(attr.ns, attr.name), type);
     }
 
     std::unique_ptr<root> release_root_element()
@@ -348,10 +391,11 @@ size_t xml_structure_tree::entity_name::hash::operator() (const entity_name& val
 }
 
 xml_structure_tree::element::element() :
-    repeat(false), has_content(false) {}
+    repeat(false), has_content(false), value_type(xml_value_t::unknown) {}
 
-xml_structure_tree::element::element(const entity_name& _name, bool _repeat, bool _has_content) :
-    name(_name), repeat(_repeat), has_content(_has_content) {}
+xml_structure_tree::element::element(
+    const entity_name& _name, bool _repeat, bool _has_content, xml_value_t _value_type) :
+    name(_name), repeat(_repeat), has_content(_has_content), value_type(_value_type) {}
 
 xml_structure_tree::walker::walker(const xml_structure_tree::impl& parent_impl) :
     mp_impl(std::make_unique<walker_impl>(parent_impl))
@@ -382,7 +426,7 @@ xml_structure_tree::element xml_structure_tree::walker::root()
     element_ref ref(mp_impl->mp_root->name, &mp_impl->mp_root->prop);
     mp_impl->m_cur_elem = ref;
     mp_impl->m_scopes.push_back(ref);
-    return xml_structure_tree::element(ref.name, false, ref.prop->has_content);
+    return xml_structure_tree::element(ref.name, false, ref.prop->has_content, ref.prop->content_type.get());
 }
 
 xml_structure_tree::element xml_structure_tree::walker::descend(const entity_name& name)
@@ -401,7 +445,7 @@ xml_structure_tree::element xml_structure_tree::walker::descend(const entity_nam
     element_ref ref(name, it->second);
     mp_impl->m_scopes.push_back(ref);
 
-    return element(name, it->second->repeat, it->second->has_content);
+    return element(name, it->second->repeat, it->second->has_content, it->second->content_type.get());
 }
 
 xml_structure_tree::element xml_structure_tree::walker::ascend()
@@ -414,7 +458,7 @@ xml_structure_tree::element xml_structure_tree::walker::ascend()
 
     mp_impl->m_scopes.pop_back();
     const element_ref& ref = mp_impl->m_scopes.back();
-    return element(ref.name, ref.prop->repeat, ref.prop->has_content);
+    return element(ref.name, ref.prop->repeat, ref.prop->has_content, ref.prop->content_type.get());
 }
 
 xml_structure_tree::entity_names_type xml_structure_tree::walker::get_children()
@@ -441,6 +485,20 @@ xml_structure_tree::entity_names_type xml_structure_tree::walker::get_attributes
     return names;
 }
 
+xml_value_t xml_structure_tree::walker::get_attribute_value_type(const entity_name& name)
+{
+    if (mp_impl->m_scopes.empty())
+        throw general_error("Scope is empty.");
+
+    assert(mp_impl->m_scopes.back().prop);
+    const elem_prop& prop = *mp_impl->m_scopes.back().prop;
+    auto it = prop.attributes.find(name);
+    if (it == prop.attributes.end())
+        throw general_error("Specified attribute does not exist.");
+
+    return it->second.get();
+}
+
 size_t xml_structure_tree::walker::get_xmlns_index(xmlns_id_t ns) const
 {
     return mp_impl->m_parent_impl.m_xmlns_cxt.get_index(ns);
@@ -513,7 +571,7 @@ xml_structure_tree::element xml_structure_tree::walker::move_to(const std::strin
 
     std::swap(mp_impl->m_scopes, scopes);
     const element_ref& ref = mp_impl->m_scopes.back();
-    return element(ref.name, ref.prop->repeat, ref.prop->has_content);
+    return element(ref.name, ref.prop->repeat, ref.prop->has_content, ref.prop->content_type.get());
 }
 
 xml_structure_tree::xml_structure_tree(xmlns_context& xmlns_cxt) :
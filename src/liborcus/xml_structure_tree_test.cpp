@@ -12,6 +12,7 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -274,12 +275,93 @@ void test_element_contents()
     }
 }
 
+void test_value_types()
+{
+    const char* content =
+        "<root>"
+        "<entry id=\"1\" code=\"A\" mixed=\"5\" empty=\"\"><num>1.5</num><str>foo</str><mix>12</mix></entry>"
+        "<entry id=\"2\" code=\"B\" mixed=\"five\" empty=\"\"><num> -2e3 </num><str>bar</str><mix>twelve</mix></entry>"
+        "</root>";
+
+    xmlns_repository xmlns_repo;
+    xmlns_context cxt = xmlns_repo.create_context();
+    xml_structure_tree tree(cxt);
+    tree.parse(content, strlen(content));
+
+    auto wkr = tree.get_walker();
+    auto elem = wkr.move_to("/root/entry/num");
+    assert(elem.value_type == xml_value_t::numeric);
+    elem = wkr.move_to("/root/entry/str");
+    assert(elem.value_type == xml_value_t::string);
+    elem = wkr.move_to("/root/entry/mix");
+    assert(elem.value_type == xml_value_t::unknown);
+
+    elem = wkr.move_to("/root/entry");
+    assert(elem.value_type == xml_value_t::unknown);
+
+    using name_type = xml_structure_tree::entity_name;
+    assert(wkr.get_attribute_value_type(name_type(XMLNS_UNKNOWN_ID, "id")) == xml_value_t::numeric);
+    assert(wkr.get_attribute_value_type(name_type(XMLNS_UNKNOWN_ID, "code")) == xml_value_t::string);
+    assert(wkr.get_attribute_value_type(name_type(XMLNS_UNKNOWN_ID, "mixed")) == xml_value_t::unknown);
+    assert(wkr.get_attribute_value_type(name_type(XMLNS_UNKNOWN_ID, "empty")) == xml_value_t::unknown);
+
+    // The detected range should carry the inferred types of its fields.
+    std::vector<xml_table_range_t> ranges;
+    tree.process_ranges([&ranges](xml_table_range_t&& range) { ranges.push_back(std::move(range)); });
+    assert(ranges.size() == 1);
+    const xml_table_range_t& range = ranges[0];
+    assert(range.paths.size() == range.value_types.size());
+
+    for (size_t i = 0; i < range.paths.size(); ++i)
+    {
+        const std::string& path = range.paths[i];
+        xml_value_t type = range.value_types[i];
+
+        if (path == "/root/entry/@id" || path == "/root/entry/num")
+            assert(type == xml_value_t::numeric);
+        else if (path == "/root/entry/@code" || path == "/root/entry/str")
+            assert(type == xml_value_t::string);
+        else
+            assert(type == xml_value_t::unknown);
+    }
+}
+
+void test_value_types_strtod()
+{
+    // Values that sheet::set_auto() treats as numeric must be inferred as
+    // numeric too, and those it treats as strings must not.
+    const char* content =
+        "<root>"
+        "<entry hex=\"0x10\" word=\"1e\"><special>inf</special><tail>12abc</tail></entry>"
+        "<entry hex=\"0X1F\" word=\"e1\"><special>nan</special><tail>3.5.1</tail></entry>"
+        "<entry hex=\"-0x2\" word=\"0x\"><special>-INFINITY</special><tail>1,5</tail></entry>"
+        "</root>";
+
+    xmlns_repository xmlns_repo;
+    xmlns_context cxt = xmlns_repo.create_context();
+    xml_structure_tree tree(cxt);
+    tree.parse(content, strlen(content));
+
+    auto wkr = tree.get_walker();
+    auto elem = wkr.move_to("/root/entry/special");
+    assert(elem.value_type == xml_value_t::numeric);
+    elem = wkr.move_to("/root/entry/tail");
+    assert(elem.value_type == xml_value_t::string);
+
+    elem = wkr.move_to("/root/entry");
+    using name_type = xml_structure_tree::entity_name;
+    assert(wkr.get_attribute_value_type(name_type(XMLNS_UNKNOWN_ID, "hex")) == xml_value_t::numeric);
+    assert(wkr.get_attribute_value_type(name_type(XMLNS_UNKNOWN_ID, "word")) == xml_value_t::string);
+}
+
 int main()
 {
     test_basic();
     test_walker();
     test_walker_path();
     test_element_contents();
+    test_value_types();
+    test_value_types_strtod();
 
     return EXIT_SUCCESS;
 }
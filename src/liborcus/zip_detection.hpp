@@ -0,0 +1,43 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_ZIP_DETECTION_HPP
+#define INCLUDED_ORCUS_ZIP_DETECTION_HPP
+
+#include <cstdlib>
+
+namespace orcus {
+
+class zip_archive;
+
+/**
+ * Check whether or not a byte stream starts with the signature of a local
+ * file header of a zip archive.  This is a cheap test to run before the
+ * central directory gets located.
+ */
+inline bool has_zip_signature(const unsigned char* blob, size_t size)
+{
+    // 0x04034b50 in little endian.
+    return size >= 4 && blob[0] == 0x50 && blob[1] == 0x4b && blob[2] == 0x03 && blob[3] == 0x04;
+}
+
+/**
+ * Check the content of an already-loaded zip archive to see if it's an ODF
+ * spreadsheet package.  Defined in orcus_ods.cpp.
+ */
+bool detect_ods_package(const zip_archive& archive);
+
+/**
+ * Check the content of an already-loaded zip archive to see if it's an
+ * xlsx package.  Defined in orcus_xlsx.cpp.
+ */
+bool detect_xlsx_package(const zip_archive& archive);
+
+}
+
+#endif
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -62,7 +62,12 @@ int main(int argc, char** argv)
 
     try
     {
-        if (parse_import_filter_args(argc, argv, fact, app, doc, &hdl))
+        auto create_filter = [](spreadsheet::import_factory& f)
+        {
+            return std::make_unique<orcus_csv>(&f);
+        };
+
+        if (!parse_import_filter_args(argc, argv, fact, app, doc, &hdl, create_filter))
             return EXIT_FAILURE;
     }
     catch (const std::exception& e)
@@ -8,8 +8,10 @@
 #include "orcus/format_detection.hpp"
 #include "orcus/exception.hpp"
 #include "orcus/stream.hpp"
+#include "orcus/orcus_xlsx.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -18,10 +20,14 @@ using namespace std;
 
 int main(int argc, char** argv) try
 {
-    if (argc != 2)
+    // With --metadata, the workbook metadata also gets printed when the
+    // file is of a format that supports it.
+    bool metadata = argc == 3 && !std::strcmp(argv[1], "--metadata");
+
+    if (argc != 2 && !metadata)
         return EXIT_FAILURE;
 
-    const char* filepath = argv[1];
+    const char* filepath = argv[argc-1];
     file_content content(filepath);
 
     if (content.empty())
@@ -56,9 +62,21 @@ int main(int argc, char** argv) try
     }
     cout << endl;
 
+    if (metadata)
+    {
+        if (detected_type != format_t::xlsx)
+        {
+            cerr << "metadata scan is not supported for this format." << endl;
+            return EXIT_FAILURE;
+        }
+
+        xlsx_workbook_metadata data = orcus_xlsx::read_metadata(content.data(), content.size());
+        data.dump(cout);
+    }
+
     return EXIT_SUCCESS;
 }
-catch (const general_error& e)
+catch (const std::exception& e)
 {
     cerr << e.what() << endl;
     return EXIT_FAILURE;
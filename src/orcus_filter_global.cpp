@@ -10,13 +10,27 @@
 #include "orcus/config.hpp"
 #include "orcus/interface.hpp"
 #include "orcus/global.hpp"
+#include "orcus/exception.hpp"
+#include "orcus/import_stats.hpp"
+#include "orcus/stream.hpp"
+#include "orcus/trace.hpp"
+#include "orcus/detail/sha256.hpp"
 #include "orcus/spreadsheet/factory.hpp"
+#include "orcus/spreadsheet/document.hpp"
+#include "orcus/spreadsheet/config.hpp"
 
 #include <mdds/sorted_string_map.hpp>
 #include <boost/filesystem.hpp>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std;
 using namespace orcus;
@@ -28,6 +42,11 @@ namespace orcus {
 
 extra_args_handler::~extra_args_handler() {}
 
+bool extra_args_handler::handle_input(const std::string& /*infile*/, const po::variables_map& /*vm*/)
+{
+    return false;
+}
+
 namespace {
 
 const std::map<dump_format_t, pstring> descriptions =
@@ -37,15 +56,21 @@ const std::map<dump_format_t, pstring> descriptions =
     std::make_pair(dump_format_t::flat,  "Flat text format that displays document content in grid."),
     std::make_pair(dump_format_t::html,  "HTML format."),
     std::make_pair(dump_format_t::json,  "JSON format."),
+    std::make_pair(dump_format_t::xlsx,  "Excel 2007 XML workbook with the cell values and formulas.  The output path is used as the output file."),
     std::make_pair(dump_format_t::xml,   "This format is currently unsupported."),
     std::make_pair(dump_format_t::none,  "No output to be generated. Maybe useful during development."),
 };
 
 const char* help_program =
-"The FILE must specify a path to an existing file.";
+"The FILE must specify a path to an existing file.  When more than one FILE is "
+"specified, or a manifest is given, the files get processed in batch mode, in "
+"which case the output of each file goes into its own directory, named after the "
+"file, under the output directory.  The exit status is 0 on success, and 1 on "
+"failure.  In batch mode, it is 1 when any of the files fails to get processed.";
 
 const char* help_output =
-"Output directory path, or output file when --dump-check option is used.";
+"Output directory path, or output file when --dump-check option is used.  In "
+"batch mode, it is always the output directory.";
 
 const char* help_dump_check =
 "Dump the content to stdout in a special format used for content verification "
@@ -61,11 +86,89 @@ const char* help_formula_error_policy =
 "Specify whether to abort immediately when the loader fails to parse the first "
 "formula cell ('fail'), or skip the offending cells and continue ('skip').";
 
+const char* help_stats =
+"Print the time spent in each phase of the import, along with the counts of "
+"imported cells and strings, to stderr.";
+
+const char* help_dedup_styles =
+"Store identical style entries only once.  Note that this may change the "
+"indices of the cell formats referenced by the cells.";
+
+const char* help_snapshot_dir =
+"Cache the imported documents as binary snapshots in this directory, keyed by "
+"the SHA-256 digest of the input file content and the import options.  When a "
+"snapshot for the input file already exists, it is loaded in place of the input "
+"file.";
+
 const char* help_row_size =
 "Specify the number of maximum rows in each sheet.";
 
+const char* help_manifest =
+"Text file listing the input files to process, one file path per line.  Empty "
+"lines and lines starting with '#' are ignored.  The files listed get processed "
+"in batch mode, along with any input files specified on the command line.";
+
+const char* help_jobs =
+"Number of input files to process in parallel in batch mode.  It defaults to the "
+"number of hardware threads.";
+
+const char* help_memory_budget =
+"Maximum total size in MiB of the input files being processed at the same time "
+"in batch mode.  It counts the sizes of the files as stored on disk, so the memory "
+"actually used by the import can be many times larger, especially for compressed "
+"formats such as xlsx and ods.  A file larger than the budget only gets processed "
+"while no other file is.  No limit is imposed by default.";
+
+const char* help_spill_threshold =
+"Estimated amount of memory in MiB the cell values of all sheets may occupy.  "
+"Once it's exceeded, the cell values of the sheets not being accessed get "
+"spilled to disk, and read back when the sheets are accessed again.  By "
+"default, all cell values are kept in memory.";
+
+const char* help_spill_dir =
+"Directory to spill the cell values to when --spill-threshold is given.  It "
+"defaults to the system's temporary directory.";
+
+const char* help_csv_separator =
+"Character to separate the fields with when the output format is csv.  It "
+"defaults to ','.";
+
+const char* help_csv_quote =
+"Character to quote the string fields with when the output format is csv.  A "
+"quote character within a field gets doubled.  It defaults to '\"'.";
+
+const char* help_trace =
+"Record the time spent in the parsers and the import filters, and write it to "
+"this file in the Chrome trace event format, to be loaded into chrome://tracing "
+"or Perfetto.  Only available when orcus is built with tracing enabled.";
+
 const char* err_no_input_file = "No input file.";
 
+/**
+ * Identifies the input of an import, to key its snapshot with.
+ */
+struct input_key
+{
+    uint64_t size;
+
+    /**
+     * SHA-256 digest of the file content, with the import settings folded
+     * in, since they too affect the imported content.
+     */
+    std::string digest;
+};
+
+input_key get_input_key(const string& infile, const string& settings)
+{
+    file_content content(infile.data());
+
+    detail::sha256 hash;
+    hash.update(content.data(), content.size());
+    hash.update(settings.data(), settings.size());
+
+    return { content.size(), hash.hex_digest() };
+}
+
 }
 
 std::string gen_help_output_format()
@@ -86,13 +189,319 @@ std::string gen_help_output_format()
     return os.str();
 }
 
+/**
+ * Import the input file, or load its snapshot when one exists in the
+ * snapshot directory.  A snapshot that fails to load gets replaced with the
+ * result of importing the input file.  When no snapshot directory is given,
+ * it simply imports the input file.
+ */
+void import_file(
+    iface::import_filter& app, spreadsheet::document& doc, const string& infile,
+    const string& snapshot_dir, const string& settings, bool recalc)
+{
+    if (snapshot_dir.empty())
+    {
+        app.read_file(infile);
+        return;
+    }
+
+    input_key key = get_input_key(infile, settings);
+
+    std::ostringstream os;
+    os << app.get_name() << '-' << key.digest << ".snapshot";
+
+    fs::path snapshot_path = fs::path(snapshot_dir) / os.str();
+
+    if (fs::exists(snapshot_path))
+    {
+        bool loaded = false;
+
+        try
+        {
+            // The snapshot gets rejected unless it was saved from this very
+            // input.
+            doc.load_snapshot(snapshot_path.string(), key.size, key.digest);
+            loaded = true;
+        }
+        catch (const std::exception& e)
+        {
+            // The document is left intact.  Import the input file instead,
+            // and replace the snapshot.
+            cerr << "failed to load the snapshot '" << snapshot_path.string() << "': " << e.what() << endl;
+        }
+
+        if (loaded)
+        {
+            if (recalc)
+                doc.recalc_formula_cells();
+            return;
+        }
+    }
+
+    app.read_file(infile);
+
+    if (!fs::exists(snapshot_dir))
+        fs::create_directories(snapshot_dir);
+
+    // Write to a temporary file first, so that neither a concurrent reader
+    // nor an interrupted write ever sees a partially written snapshot.
+    fs::path temp_path = snapshot_path;
+    temp_path += fs::unique_path(".%%%%-%%%%-%%%%-%%%%.tmp");
+
+    try
+    {
+        doc.save_snapshot(temp_path.string(), key.size, key.digest);
+        fs::rename(temp_path, snapshot_path);
+    }
+    catch (...)
+    {
+        boost::system::error_code ec;
+        fs::remove(temp_path, ec);
+        throw;
+    }
+}
+
+/**
+ * Caps the total size of the input files, as stored on disk, being processed
+ * at the same time.
+ */
+class memory_budget
+{
+    std::mutex m_mtx;
+    std::condition_variable m_cond;
+    const size_t m_limit;
+    size_t m_used;
+
+public:
+    memory_budget(size_t limit) : m_limit(limit), m_used(0) {}
+
+    void acquire(size_t n)
+    {
+        if (!m_limit)
+            return;
+
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_cond.wait(lock, [this, n] { return !m_used || m_used + n <= m_limit; });
+        m_used += n;
+    }
+
+    void release(size_t n)
+    {
+        if (!m_limit)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_used -= n;
+        }
+
+        m_cond.notify_all();
+    }
+};
+
+/**
+ * Parameters shared by all input files in batch mode.
+ */
+struct batch_params
+{
+    std::vector<string> inputs;
+    string outdir;
+    dump_format_t outformat = dump_format_t::unknown;
+    size_t jobs = 0;
+    size_t memory_budget = 0;
+    string snapshot_dir;
+    string settings;
+    bool recalc = false;
+    bool print_stats = false;
+    config opt{format_t::unknown};
+    spreadsheet::range_size_t sheet_size;
+    spreadsheet::document_config doc_config;
+};
+
+/**
+ * Read the list of input files from a manifest file.
+ */
+void read_manifest(const string& path, std::vector<string>& inputs)
+{
+    std::ifstream file(path.c_str());
+    if (!file)
+        throw general_error("failed to open the manifest file '" + path + "'.");
+
+    string line;
+    while (std::getline(file, line))
+    {
+        pstring trimmed = pstring(line.data(), line.size()).trim();
+        if (trimmed.empty() || trimmed[0] == '#')
+            continue;
+
+        inputs.push_back(trimmed.str());
+    }
+}
+
+/**
+ * Give each input file its own output directory named after the file,
+ * with a numeric suffix appended when the name is already taken by
+ * another input file.  The suffixed names get checked against all the
+ * other names too, since an input file may itself be named like one.
+ */
+std::vector<fs::path> build_output_paths(const string& outdir, const std::vector<string>& inputs)
+{
+    std::vector<string> names;
+    names.reserve(inputs.size());
+    std::unordered_set<string> taken;
+
+    // The first input file with a given name gets that name as is.
+    std::vector<bool> duplicate;
+    duplicate.reserve(inputs.size());
+
+    for (const string& input : inputs)
+    {
+        names.push_back(fs::path(input).filename().string());
+        duplicate.push_back(!taken.insert(names.back()).second);
+    }
+
+    std::unordered_map<string, size_t> next_suffixes;
+    std::vector<fs::path> paths;
+    paths.reserve(inputs.size());
+
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        string name = names[i];
+
+        if (duplicate[i])
+        {
+            size_t& suffix = next_suffixes.emplace(name, 2).first->second;
+            string suffixed;
+            do
+            {
+                suffixed = name + '-' + std::to_string(suffix++);
+            }
+            while (!taken.insert(suffixed).second);
+
+            name = std::move(suffixed);
+        }
+
+        paths.push_back(fs::path(outdir) / name);
+    }
+
+    return paths;
+}
+
+/**
+ * Import one input file into a fresh document and dump it into its output
+ * directory.
+ */
+void process_batch_file(
+    const batch_params& params, const import_filter_creator& create_filter,
+    const std::function<void(spreadsheet::import_factory&)>& setup_factory,
+    const string& infile, const fs::path& outpath, std::mutex& mtx_output)
+{
+    // The factory and the filter refer to the internals of the document, so
+    // all three get created anew for each file.
+    spreadsheet::document doc{params.sheet_size};
+    doc.set_config(params.doc_config);
+    spreadsheet::import_factory fact(doc);
+    setup_factory(fact);
+
+    std::unique_ptr<iface::import_filter> app = create_filter(fact);
+    app->set_config(params.opt);
+
+    if (params.print_stats)
+        fact.set_stats(&app->get_stats());
+
+    import_file(*app, doc, infile, params.snapshot_dir, params.settings, params.recalc);
+
+    if (params.print_stats)
+    {
+        std::lock_guard<std::mutex> lock(mtx_output);
+        cerr << infile << ':' << endl;
+        app->get_stats().dump(cerr);
+    }
+
+    fs::create_directories(outpath);
+
+    switch (params.outformat)
+    {
+        case dump_format_t::check:
+            doc.dump(params.outformat, (outpath / "check.txt").string());
+            break;
+        case dump_format_t::xlsx:
+            doc.dump(params.outformat, (outpath / "content.xlsx").string());
+            break;
+        default:
+            doc.dump(params.outformat, outpath.string());
+    }
+}
+
+/**
+ * Process all input files on a pool of worker threads.  A failure with one
+ * file gets reported and doesn't stop the processing of the other files.
+ *
+ * @return true if all files have been processed successfully, false
+ *         otherwise.
+ */
+bool run_batch(
+    const batch_params& params, const import_filter_creator& create_filter,
+    const std::function<void(spreadsheet::import_factory&)>& setup_factory)
+{
+    std::vector<fs::path> outpaths = build_output_paths(params.outdir, params.inputs);
+
+    memory_budget budget(params.memory_budget * 1024 * 1024);
+    std::mutex mtx_output;
+    std::atomic<size_t> next_input(0);
+    std::atomic<size_t> failed_count(0);
+
+    auto worker = [&]()
+    {
+        for (size_t i = next_input++; i < params.inputs.size(); i = next_input++)
+        {
+            const string& infile = params.inputs[i];
+
+            size_t size = 0;
+            boost::system::error_code ec;
+            uintmax_t file_size = fs::file_size(infile, ec);
+            if (!ec)
+                size = file_size;
+
+            budget.acquire(size);
+
+            try
+            {
+                process_batch_file(params, create_filter, setup_factory, infile, outpaths[i], mtx_output);
+            }
+            catch (const std::exception& e)
+            {
+                ++failed_count;
+                std::lock_guard<std::mutex> lock(mtx_output);
+                cerr << infile << ": " << e.what() << endl;
+            }
+
+            budget.release(size);
+        }
+    };
+
+    size_t jobs = std::min(params.jobs, params.inputs.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < jobs; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (std::thread& t : threads)
+        t.join();
+
+    cerr << params.inputs.size() << " files processed, " << failed_count << " failed." << endl;
+    return failed_count == 0;
+}
+
 bool handle_dump_check(
-    iface::import_filter& app, iface::document_dumper& doc, const string& infile, const string& outfile)
+    iface::import_filter& app, spreadsheet::document& doc, const string& infile, const string& outfile,
+    const string& snapshot_dir, const string& settings, bool recalc)
 {
     if (outfile.empty())
     {
         // Dump to stdout when no output file is specified.
-        app.read_file(infile);
+        import_file(app, doc, infile, snapshot_dir, settings, recalc);
         doc.dump_check(cout);
         return true;
     }
@@ -104,18 +513,53 @@ bool handle_dump_check(
     }
 
     ofstream file(outfile.c_str());
-    app.read_file(infile);
+    import_file(app, doc, infile, snapshot_dir, settings, recalc);
     doc.dump_check(file);
     return true;
 }
 
+/**
+ * Records the trace spans during its lifetime, and writes them to a file at
+ * the end.
+ */
+class trace_recorder
+{
+    std::string m_path;
+
+public:
+    trace_recorder(std::string path) : m_path(std::move(path))
+    {
+        if (!m_path.empty())
+            trace::start();
+    }
+
+    ~trace_recorder()
+    {
+        if (m_path.empty())
+            return;
+
+        trace::stop();
+
+        std::ofstream file(m_path.c_str());
+        if (!file)
+        {
+            cerr << "failed to open the trace file '" << m_path << "'." << endl;
+            return;
+        }
+
+        trace::write_chrome_trace(file);
+    }
+};
+
 bool parse_import_filter_args(
     int argc, char** argv, spreadsheet::import_factory& fact,
-    iface::import_filter& app, iface::document_dumper& doc,
-    extra_args_handler* args_handler)
+    iface::import_filter& app, spreadsheet::document& doc,
+    extra_args_handler* args_handler, const import_filter_creator& create_filter)
 {
     bool debug = false;
     bool recalc_formula_cells = false;
+    bool print_stats = false;
+    bool dedup_styles = false;
 
     po::options_description desc("Options");
     desc.add_options()
@@ -126,14 +570,25 @@ bool parse_import_filter_args(
         ("dump-check", help_dump_check)
         ("output,o", po::value<string>(), help_output)
         ("output-format,f", po::value<string>(), gen_help_output_format().data())
-        ("row-size", po::value<spreadsheet::row_t>(), help_row_size);
+        ("row-size", po::value<spreadsheet::row_t>(), help_row_size)
+        ("snapshot-dir", po::value<string>(), help_snapshot_dir)
+        ("stats", po::bool_switch(&print_stats), help_stats)
+        ("dedup-styles", po::bool_switch(&dedup_styles), help_dedup_styles)
+        ("manifest", po::value<string>(), help_manifest)
+        ("jobs,j", po::value<size_t>(), help_jobs)
+        ("memory-budget", po::value<size_t>(), help_memory_budget)
+        ("spill-threshold", po::value<size_t>(), help_spill_threshold)
+        ("spill-dir", po::value<string>(), help_spill_dir)
+        ("csv-separator", po::value<string>(), help_csv_separator)
+        ("csv-quote", po::value<string>(), help_csv_quote)
+        ("trace", po::value<string>(), help_trace);
 
     if (args_handler)
         args_handler->add_options(desc);
 
     po::options_description hidden("Hidden options");
     hidden.add_options()
-        ("input", po::value<string>(), "input file");
+        ("input", po::value<std::vector<string>>(), "input file");
 
     po::options_description cmd_opt;
     cmd_opt.add(desc).add(hidden);
@@ -158,29 +613,54 @@ bool parse_import_filter_args(
 
     if (vm.count("help"))
     {
-        cout << "Usage: orcus-" << app.get_name() << " [options] FILE" << endl << endl;
+        cout << "Usage: orcus-" << app.get_name() << " [options] FILE..." << endl << endl;
         cout << help_program << endl << endl << desc;
         return true;
     }
 
-    std::string infile, outdir;
+    std::string infile, outdir, snapshot_dir;
+    std::vector<std::string> inputs;
     dump_format_t outformat = dump_format_t::unknown;
 
     if (vm.count("input"))
-        infile = vm["input"].as<string>();
+        inputs = vm["input"].as<std::vector<string>>();
+
+    if (vm.count("manifest"))
+    {
+        try
+        {
+            read_manifest(vm["manifest"].as<string>(), inputs);
+        }
+        catch (const std::exception& e)
+        {
+            cerr << e.what() << endl;
+            return false;
+        }
+    }
+
+    bool batch_mode = inputs.size() > 1 || vm.count("manifest");
+
+    if (batch_mode && !create_filter)
+    {
+        cerr << "Processing multiple input files is not supported." << endl;
+        return false;
+    }
+
+    if (inputs.size() == 1)
+        infile = inputs[0];
 
     if (vm.count("output"))
         outdir = vm["output"].as<string>();
 
+    if (vm.count("snapshot-dir"))
+        snapshot_dir = vm["snapshot-dir"].as<string>();
+
     if (vm.count("output-format"))
     {
         std::string outformat_s = vm["output-format"].as<string>();
         outformat = to_dump_format_enum(outformat_s.data(), outformat_s.size());
     }
 
-    if (vm.count("row-size"))
-        fact.set_default_row_size(vm["row-size"].as<spreadsheet::row_t>());
-
     std::string error_policy_s = vm["error-policy"].as<std::string>();
     spreadsheet::formula_error_policy_t error_policy =
         spreadsheet::to_formula_error_policy(error_policy_s.data(), error_policy_s.size());
@@ -191,14 +671,84 @@ bool parse_import_filter_args(
         return false;
     }
 
-    fact.set_formula_error_policy(error_policy);
+    spreadsheet::document_config doc_config = doc.get_config();
 
-    if (infile.empty())
+    if (vm.count("spill-threshold"))
+    {
+        doc_config.spill_threshold = vm["spill-threshold"].as<size_t>() * 1024 * 1024;
+        if (vm.count("spill-dir"))
+            doc_config.spill_directory = vm["spill-dir"].as<string>();
+    }
+
+    if (vm.count("csv-separator"))
+    {
+        std::string s = vm["csv-separator"].as<string>();
+        if (s.size() != 1)
+        {
+            cerr << "The CSV separator must be a single character." << endl;
+            return false;
+        }
+
+        doc_config.csv_separator = s[0];
+    }
+
+    if (vm.count("csv-quote"))
+    {
+        std::string s = vm["csv-quote"].as<string>();
+        if (s.size() != 1)
+        {
+            cerr << "The CSV quote must be a single character." << endl;
+            return false;
+        }
+
+        doc_config.csv_quote = s[0];
+    }
+
+    try
+    {
+        doc.set_config(doc_config);
+    }
+    catch (const std::exception& e)
+    {
+        cerr << e.what() << endl;
+        return false;
+    }
+
+    spreadsheet::row_t row_size = vm.count("row-size") ? vm["row-size"].as<spreadsheet::row_t>() : 0;
+
+    // This gets called from the worker threads in batch mode.
+    auto setup_factory = [&](spreadsheet::import_factory& f)
+    {
+        if (row_size)
+            f.set_default_row_size(row_size);
+
+        f.set_formula_error_policy(error_policy);
+        f.set_recalc_formula_cells(recalc_formula_cells);
+        f.set_deduplicate_styles(dedup_styles);
+    };
+
+    setup_factory(fact);
+
+    if (inputs.empty())
     {
         cerr << err_no_input_file << endl;
         return false;
     }
 
+    std::string trace_path;
+    if (vm.count("trace"))
+    {
+        if (!trace::is_available())
+        {
+            cerr << "Tracing is not available in this build." << endl;
+            return false;
+        }
+
+        trace_path = vm["trace"].as<string>();
+    }
+
+    trace_recorder tracer(trace_path);
+
     config opt = app.get_config();
     opt.debug = debug;
 
@@ -207,12 +757,72 @@ bool parse_import_filter_args(
 
     app.set_config(opt);
 
-    fact.set_recalc_formula_cells(recalc_formula_cells);
+    if (print_stats)
+        fact.set_stats(&app.get_stats());
+
+    // Let the handler take over the processing of the input file, but only
+    // when there is just one.
+    if (!batch_mode && args_handler && args_handler->handle_input(infile, vm))
+        return true;
+
+    // Import settings that affect the imported content, to key the snapshots
+    // with.  The recalc option is not one of them since the loaded snapshot
+    // gets re-calculated separately.
+    std::ostringstream settings;
+    settings << "error-policy=" << error_policy_s << ";dedup-styles=" << dedup_styles
+        << ";row-size=" << (vm.count("row-size") ? vm["row-size"].as<spreadsheet::row_t>() : 0);
+
+    if (opt.input_format == format_t::csv)
+    {
+        settings << ";header-row-size=" << opt.csv.header_row_size
+            << ";split=" << opt.csv.split_to_multiple_sheets;
+    }
+
+    if (batch_mode)
+    {
+        if (vm.count("dump-check"))
+            outformat = dump_format_t::check;
+
+        if (outformat == dump_format_t::unknown)
+        {
+            std::cerr << "You must specify one of the supported output formats." << endl;
+            return false;
+        }
+
+        if (outdir.empty())
+        {
+            std::cerr << "You must specify the output directory in batch mode." << endl;
+            return false;
+        }
+
+        batch_params params;
+        params.inputs = std::move(inputs);
+        params.outdir = outdir;
+        params.outformat = outformat;
+        params.jobs = vm.count("jobs") ? vm["jobs"].as<size_t>() : std::thread::hardware_concurrency();
+        params.jobs = std::max<size_t>(params.jobs, 1);
+        params.memory_budget = vm.count("memory-budget") ? vm["memory-budget"].as<size_t>() : 0;
+        params.snapshot_dir = snapshot_dir;
+        params.settings = settings.str();
+        params.recalc = recalc_formula_cells;
+        params.print_stats = print_stats;
+        params.opt = opt;
+        params.sheet_size = doc.get_sheet_size();
+        params.doc_config = doc.get_config();
+
+        return run_batch(params, create_filter, setup_factory);
+    }
 
     if (vm.count("dump-check"))
     {
         // 'outdir' is used as the output file path in this mode.
-        return handle_dump_check(app, doc, infile, outdir);
+        if (!handle_dump_check(app, doc, infile, outdir, snapshot_dir, settings.str(), recalc_formula_cells))
+            return false;
+
+        if (print_stats)
+            app.get_stats().dump(cerr);
+
+        return true;
     }
 
     if (outformat == dump_format_t::unknown)
@@ -223,7 +833,11 @@ bool parse_import_filter_args(
 
     try
     {
-        app.read_file(infile);
+        import_file(app, doc, infile, snapshot_dir, settings.str(), recalc_formula_cells);
+
+        if (print_stats)
+            app.get_stats().dump(cerr);
+
         doc.dump(outformat, outdir);
     }
     catch (const std::exception& e)
@@ -10,6 +10,9 @@
 
 #include <boost/program_options.hpp>
 
+#include <functional>
+#include <memory>
+
 namespace orcus {
 
 struct config;
@@ -17,13 +20,13 @@ struct config;
 namespace spreadsheet {
 
 class import_factory;
+class document;
 
 }
 
 namespace iface {
 
 class import_filter;
-class document_dumper;
 
 }
 
@@ -38,12 +41,41 @@ public:
     virtual void add_options(boost::program_options::options_description& desc) = 0;
     virtual void map_to_config(
         config& opt, const boost::program_options::variables_map& vm) = 0;
+
+    /**
+     * Optionally process the input file in place of the regular import and
+     * dump.
+     *
+     * @return true if the input file has been handled by this call, in which
+     *         case no import takes place.
+     */
+    virtual bool handle_input(
+        const std::string& infile, const boost::program_options::variables_map& vm);
 };
 
+/**
+ * Function that creates a new instance of the import filter for the passed
+ * factory.  It's used to import multiple input files in parallel in batch
+ * mode, where each input file gets its own document, factory and filter.
+ */
+using import_filter_creator =
+    std::function<std::unique_ptr<iface::import_filter>(spreadsheet::import_factory&)>;
+
+/**
+ * Parse the command-line arguments and process the input file(s) accordingly.
+ *
+ * @param create_filter function to create a new filter instance with.  The
+ *                      batch mode is only available when it's given.
+ *
+ * @return true if the input file(s) have been processed successfully, or the
+ *         help has been printed, false otherwise.  The caller should exit
+ *         with EXIT_FAILURE when it's false.
+ */
 bool parse_import_filter_args(
     int argc, char** argv, spreadsheet::import_factory& fact,
-    iface::import_filter& app, iface::document_dumper& doc,
-    extra_args_handler* args_handler = nullptr);
+    iface::import_filter& app, spreadsheet::document& doc,
+    extra_args_handler* args_handler = nullptr,
+    const import_filter_creator& create_filter = import_filter_creator());
 
 std::string gen_help_output_format();
 
@@ -20,7 +20,12 @@ int main(int argc, char** argv)
     spreadsheet::import_factory fact(doc);
     orcus_gnumeric app(&fact);
 
-    if (parse_import_filter_args(argc, argv, fact, app, doc))
+    auto create_filter = [](spreadsheet::import_factory& f)
+    {
+        return std::make_unique<orcus_gnumeric>(&f);
+    };
+
+    if (!parse_import_filter_args(argc, argv, fact, app, doc, nullptr, create_filter))
         return EXIT_FAILURE;
 
     return EXIT_SUCCESS;
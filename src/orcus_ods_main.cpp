@@ -8,6 +8,7 @@
 #include "orcus/orcus_ods.hpp"
 #include "orcus/spreadsheet/document.hpp"
 #include "orcus/spreadsheet/factory.hpp"
+#include "orcus/config.hpp"
 
 #include "orcus_filter_global.hpp"
 
@@ -15,6 +16,30 @@
 
 using namespace std;
 using namespace orcus;
+namespace po = boost::program_options;
+
+class ods_args_handler : public extra_args_handler
+{
+    constexpr static const char* help_threads =
+        "Specify the number of threads to parse the sheets with.  With more than "
+        "one thread, the sheets in the content part get located by a quick scan "
+        "first, then get parsed in parallel.";
+
+public:
+    virtual ~ods_args_handler() override {}
+
+    virtual void add_options(po::options_description& desc) override
+    {
+        desc.add_options()
+            ("threads,t", po::value<size_t>(), help_threads);
+    }
+
+    virtual void map_to_config(config& opt, const po::variables_map& vm) override
+    {
+        if (vm.count("threads"))
+            opt.ods.thread_count = vm["threads"].as<size_t>();
+    }
+};
 
 int main(int argc, char** argv)
 {
@@ -22,8 +47,14 @@ int main(int argc, char** argv)
     spreadsheet::document doc{ss};
     spreadsheet::import_factory fact(doc);
     orcus_ods app(&fact);
+    ods_args_handler hdl;
+
+    auto create_filter = [](spreadsheet::import_factory& f)
+    {
+        return std::make_unique<orcus_ods>(&f);
+    };
 
-    if (parse_import_filter_args(argc, argv, fact, app, doc))
+    if (!parse_import_filter_args(argc, argv, fact, app, doc, &hdl, create_filter))
         return EXIT_FAILURE;
 
     return EXIT_SUCCESS;
@@ -11,11 +11,15 @@
 #include "orcus/pstring.hpp"
 #include "orcus/global.hpp"
 #include "orcus/stream.hpp"
+#include "orcus/import_stats.hpp"
+#include "orcus/exception.hpp"
 #include "orcus/spreadsheet/factory.hpp"
 #include "orcus/spreadsheet/document.hpp"
 #include "orcus/spreadsheet/sheet.hpp"
+#include "orcus/spreadsheet/config.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -176,6 +180,166 @@ void test_csv_import_split_sheet()
     test::verify_content(__FILE__, __LINE__, control.str(), check);
 }
 
+void import_csv_stream(spreadsheet::document& doc, const config& conf, const std::string& stream)
+{
+    doc.clear();
+    spreadsheet::import_factory factory(doc);
+    orcus_csv app(&factory);
+    app.set_config(conf);
+    app.read_stream(stream.data(), stream.size());
+}
+
+void test_csv_import_scope()
+{
+    std::cout << "checking the import scope..." << std::endl;
+
+    const std::string stream =
+        "1,2,3,4\n"
+        "5,6,7,8\n"
+        "9,10,11,12\n"
+        "13,14,15,16\n";
+
+    spreadsheet::range_size_t ss{1048576, 16384};
+    spreadsheet::document doc{ss};
+
+    config conf(format_t::csv);
+    conf.csv.header_row_size = 0;
+
+    // Restrict the import to a range of rows and columns.
+    conf.scope.first_row = 1;
+    conf.scope.last_row = 2;
+    conf.scope.first_column = 1;
+    conf.scope.last_column = 2;
+
+    import_csv_stream(doc, conf, stream);
+
+    const char* expected =
+        "data/1/1:numeric:6\n"
+        "data/1/2:numeric:7\n"
+        "data/2/1:numeric:10\n"
+        "data/2/2:numeric:11\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, test::get_content_check(doc));
+
+    // Restrict the import to a set of columns.
+    conf.scope = config::import_scope();
+    conf.scope.columns = { 0, 3 };
+
+    import_csv_stream(doc, conf, stream);
+
+    expected =
+        "data/0/0:numeric:1\n"
+        "data/0/3:numeric:4\n"
+        "data/1/0:numeric:5\n"
+        "data/1/3:numeric:8\n"
+        "data/2/0:numeric:9\n"
+        "data/2/3:numeric:12\n"
+        "data/3/0:numeric:13\n"
+        "data/3/3:numeric:16\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, test::get_content_check(doc));
+
+    // Split the content into two sheets, and only import the second one.
+    conf.scope = config::import_scope();
+    conf.scope.sheet_names = { "data_1" };
+    conf.csv.split_to_multiple_sheets = true;
+
+    // Set the row size to 2 to make sure the split occurs.
+    spreadsheet::range_size_t ss_split{2, 4};
+    spreadsheet::document doc_split{ss_split};
+    import_csv_stream(doc_split, conf, stream);
+
+    assert(doc_split.get_sheet_count() == 2);
+
+    expected =
+        "data_1/0/0:numeric:9\n"
+        "data_1/0/1:numeric:10\n"
+        "data_1/0/2:numeric:11\n"
+        "data_1/0/3:numeric:12\n"
+        "data_1/1/0:numeric:13\n"
+        "data_1/1/1:numeric:14\n"
+        "data_1/1/2:numeric:15\n"
+        "data_1/1/3:numeric:16\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, test::get_content_check(doc_split));
+}
+
+void test_csv_import_stats()
+{
+    const char* content =
+        "A,1\n"
+        "B,2\n"
+        "A,x\n";
+
+    spreadsheet::range_size_t ss{1048576, 16384};
+    spreadsheet::document doc{ss};
+    spreadsheet::import_factory factory(doc);
+    orcus_csv app(&factory);
+    factory.set_stats(&app.get_stats());
+    app.read_stream(content, std::strlen(content));
+
+    // The values get counted by the type the sheet detected them as.
+    const import_stats& stats = app.get_stats();
+    assert(stats.cells.numeric == 2);
+    assert(stats.cells.string == 4);
+    assert(stats.strings.interned == 3);
+    assert(stats.strings.deduplicated == 1);
+}
+
+void test_csv_dump_custom_chars()
+{
+    std::cout << "checking the csv dump with custom separator and quote..." << std::endl;
+
+    const std::string stream =
+        "plain,\"a;b\",\"x,y\"\n"
+        "'q',\"say \"\"hi\"\"\",it's\n"
+        "1,2,3\n";
+
+    spreadsheet::range_size_t ss{1048576, 16384};
+    spreadsheet::document doc{ss};
+
+    config conf(format_t::csv);
+    conf.csv.header_row_size = 0;
+    import_csv_stream(doc, conf, stream);
+
+    // Non-default separator.
+    spreadsheet::document_config doc_config = doc.get_config();
+    doc_config.csv_separator = ';';
+    doc.set_config(doc_config);
+
+    std::string expected =
+        "plain;\"a;b\";x,y\n"
+        "'q';\"say \"\"hi\"\"\";it's\n"
+        "1;2;3";
+
+    assert(test::get_content_as_csv(doc, 0) == expected);
+
+    // Non-default quote, which gets doubled within the fields.
+    doc_config.csv_separator = ',';
+    doc_config.csv_quote = '\'';
+    doc.set_config(doc_config);
+
+    expected =
+        "plain,a;b,'x,y'\n"
+        "'''q''',say \"hi\",'it''s'\n"
+        "1,2,3";
+
+    assert(test::get_content_as_csv(doc, 0) == expected);
+
+    // The separator and quote characters must differ.
+    doc_config.csv_separator = '\'';
+
+    try
+    {
+        doc.set_config(doc_config);
+        assert(!"exception was not thrown");
+    }
+    catch (const invalid_arg_error&)
+    {
+        // expected.
+    }
+}
+
 }
 
 int main()
@@ -184,6 +348,9 @@ int main()
     {
         test_csv_import();
         test_csv_import_split_sheet();
+        test_csv_import_scope();
+        test_csv_import_stats();
+        test_csv_dump_custom_chars();
     }
     catch (const std::exception& e)
     {
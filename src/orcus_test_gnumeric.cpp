@@ -8,6 +8,7 @@
 #include "orcus_test_global.hpp"
 #include "orcus/orcus_gnumeric.hpp"
 #include "orcus/stream.hpp"
+#include "orcus/import_stats.hpp"
 #include "orcus/spreadsheet/factory.hpp"
 #include "orcus/spreadsheet/document.hpp"
 
@@ -57,11 +58,34 @@ void test_gnumeric_import()
     }
 }
 
+void test_gnumeric_stats()
+{
+    // The same content imported from ods must give the same counts.
+    std::string path(SRCDIR"/test/gnumeric/raw-values-1/input.gnumeric");
+
+    spreadsheet::range_size_t ss{1048576, 16384};
+    spreadsheet::document doc{ss};
+    spreadsheet::import_factory factory(doc);
+    orcus_gnumeric app(&factory);
+    factory.set_stats(&app.get_stats());
+    app.read_file(path.c_str());
+
+    const import_stats& stats = app.get_stats();
+    assert(stats.cells.numeric == 12);
+    assert(stats.cells.string == 13);
+    assert(stats.cells.boolean == 0);
+    assert(stats.cells.date_time == 0);
+    assert(stats.cells.formula == 0);
+    assert(stats.strings.interned == 13);
+    assert(stats.strings.deduplicated == 0);
+}
+
 }
 
 int main()
 {
     test_gnumeric_import();
+    test_gnumeric_stats();
 
     return EXIT_SUCCESS;
 }
@@ -9,6 +9,9 @@
 #include "orcus/pstring.hpp"
 #include "orcus/global.hpp"
 #include "orcus/stream.hpp"
+#include "orcus/config.hpp"
+#include "orcus/import_stats.hpp"
+#include "orcus/zip_archive_writer.hpp"
 #include "orcus/spreadsheet/factory.hpp"
 #include "orcus/spreadsheet/document.hpp"
 #include "orcus/spreadsheet/sheet.hpp"
@@ -17,6 +20,7 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -76,6 +80,46 @@ void test_ods_import_cell_values()
     }
 }
 
+void test_ods_import_cell_values_threaded()
+{
+    // Parse the sheets in parallel.  The results must be identical to those
+    // of a single pass.
+    for (const char* dir : dirs)
+    {
+        string path(dir);
+        cout << path << " (threaded)" << endl;
+
+        // Read the input.ods document.
+        path.append("input.ods");
+        spreadsheet::range_size_t ss{1048576, 16384};
+        spreadsheet::document doc{ss};
+        spreadsheet::import_factory factory(doc);
+        orcus_ods app(&factory);
+        config conf = app.get_config();
+        conf.ods.thread_count = 4;
+        app.set_config(conf);
+        app.read_file(path.c_str());
+        doc.recalc_formula_cells();
+
+        // Dump the content of the model.
+        ostringstream os;
+        doc.dump_check(os);
+        string check = os.str();
+
+        // Check that against known control.
+        path = dir;
+        path.append("check.txt");
+        file_content control(path.data());
+
+        assert(!check.empty());
+        assert(!control.empty());
+
+        pstring s1(&check[0], check.size());
+        pstring s2 = control.str();
+        assert(s1.trim() == s2.trim());
+    }
+}
+
 void test_ods_import_column_widths_row_heights()
 {
     const char* filepath = SRCDIR"/test/ods/column-width-row-height/input.ods";
@@ -245,13 +289,155 @@ void test_ods_import_formatted_text()
     }
 }
 
+/**
+ * Pack the content.xml stream of a document into a zip archive.
+ */
+string create_ods_stream(const char* content_xml)
+{
+    ostringstream os;
+    zip_archive_writer writer(os);
+    writer.add_file_entry("content.xml", content_xml, strlen(content_xml));
+    writer.close();
+    return os.str();
+}
+
+string import_ods_stream(const config& conf, const string& stream)
+{
+    spreadsheet::range_size_t ss{1048576, 16384};
+    document doc{ss};
+    import_factory factory(doc);
+    orcus_ods app(&factory);
+    app.set_config(conf);
+    app.read_stream(stream.data(), stream.size());
+
+    ostringstream os;
+    doc.dump_check(os);
+    return os.str();
+}
+
+void test_ods_import_scope()
+{
+    cout << "checking the import scope..." << endl;
+
+    const char* content_xml =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<office:document-content"
+        " xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+        " xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\""
+        " xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\""
+        " office:version=\"1.2\">"
+        "<office:body><office:spreadsheet>"
+        "<table:table table:name=\"Sheet1\">"
+        "<table:table-row>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"1\"><text:p>1</text:p></table:table-cell>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"2\"><text:p>2</text:p></table:table-cell>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"3\"><text:p>3</text:p></table:table-cell>"
+        "</table:table-row>"
+        "<table:table-row>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"4\"><text:p>4</text:p></table:table-cell>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"5\"><text:p>5</text:p></table:table-cell>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"6\"><text:p>6</text:p></table:table-cell>"
+        "</table:table-row>"
+        "<table:table-row>"
+        "<table:table-cell table:number-columns-repeated=\"3\" office:value-type=\"float\" office:value=\"7\"><text:p>7</text:p></table:table-cell>"
+        "</table:table-row>"
+        "</table:table>"
+        "<table:table table:name=\"Sheet2\">"
+        "<table:table-row>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"10\"><text:p>10</text:p></table:table-cell>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"11\"><text:p>11</text:p></table:table-cell>"
+        "</table:table-row>"
+        "<table:table-row>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"12\"><text:p>12</text:p></table:table-cell>"
+        "<table:table-cell office:value-type=\"float\" office:value=\"13\"><text:p>13</text:p></table:table-cell>"
+        "</table:table-row>"
+        "</table:table>"
+        "</office:spreadsheet></office:body>"
+        "</office:document-content>";
+
+    const string stream = create_ods_stream(content_xml);
+
+    config conf(format_t::ods);
+
+    // Only import the second sheet.
+    conf.scope.sheet_names = { "Sheet2" };
+
+    string check = import_ods_stream(conf, stream);
+    const char* expected =
+        "Sheet2/0/0:numeric:10\n"
+        "Sheet2/0/1:numeric:11\n"
+        "Sheet2/1/0:numeric:12\n"
+        "Sheet2/1/1:numeric:13\n";
+
+    assert(pstring(check).trim() == pstring(expected).trim());
+
+    // Restrict the import to a range of rows and columns on all sheets.
+    conf.scope = config::import_scope();
+    conf.scope.first_row = 1;
+    conf.scope.last_row = 2;
+    conf.scope.first_column = 1;
+
+    check = import_ods_stream(conf, stream);
+    expected =
+        "Sheet1/1/1:numeric:5\n"
+        "Sheet1/1/2:numeric:6\n"
+        "Sheet1/2/1:numeric:7\n"
+        "Sheet1/2/2:numeric:7\n"
+        "Sheet2/1/1:numeric:13\n";
+
+    assert(pstring(check).trim() == pstring(expected).trim());
+
+    // Restrict the import to a set of columns.  The repeated cell is only
+    // partially in scope.
+    conf.scope = config::import_scope();
+    conf.scope.columns = { 0, 2 };
+
+    check = import_ods_stream(conf, stream);
+    expected =
+        "Sheet1/0/0:numeric:1\n"
+        "Sheet1/0/2:numeric:3\n"
+        "Sheet1/1/0:numeric:4\n"
+        "Sheet1/1/2:numeric:6\n"
+        "Sheet1/2/0:numeric:7\n"
+        "Sheet1/2/2:numeric:7\n"
+        "Sheet2/0/0:numeric:10\n"
+        "Sheet2/1/0:numeric:12\n";
+
+    assert(pstring(check).trim() == pstring(expected).trim());
+}
+
+void test_ods_import_stats()
+{
+    // The same content imported from gnumeric must give the same counts.
+    std::string path(SRCDIR"/test/ods/raw-values-1/input.ods");
+
+    spreadsheet::range_size_t ss{1048576, 16384};
+    document doc{ss};
+    import_factory factory(doc);
+    orcus_ods app(&factory);
+    factory.set_stats(&app.get_stats());
+    app.read_file(path.c_str());
+
+    const import_stats& stats = app.get_stats();
+    assert(stats.cells.numeric == 12);
+    assert(stats.cells.string == 13);
+    assert(stats.cells.boolean == 0);
+    assert(stats.cells.date_time == 0);
+    assert(stats.cells.formula == 0);
+    assert(stats.strings.interned == 13);
+    assert(stats.strings.deduplicated == 0);
+}
+
 }
 
 int main()
 {
     test_ods_import_cell_values();
+    test_ods_import_cell_values_threaded();
     test_ods_import_column_widths_row_heights();
     test_ods_import_formatted_text();
+    test_ods_import_scope();
+    test_ods_import_stats();
     return EXIT_SUCCESS;
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -12,11 +12,14 @@
 #include "orcus/config.hpp"
 #include "orcus/spreadsheet/factory.hpp"
 #include "orcus/spreadsheet/document.hpp"
+#include "orcus/spreadsheet/config.hpp"
 #include "orcus/spreadsheet/view.hpp"
 #include "orcus/spreadsheet/sheet.hpp"
 #include "orcus/spreadsheet/auto_filter.hpp"
 #include "orcus/spreadsheet/pivot.hpp"
 #include "orcus/spreadsheet/styles.hpp"
+#include "orcus/import_stats.hpp"
+#include "orcus/exception.hpp"
 
 #include <cstdlib>
 #include <cassert>
@@ -534,6 +537,60 @@ void test_xlsx_cell_borders_single_cells()
     }
 }
 
+void test_xlsx_dedup_styles()
+{
+    pstring path(SRCDIR"/test/xlsx/borders/single-cells.xlsx");
+    std::unique_ptr<spreadsheet::document> doc = load_doc(path);
+
+    spreadsheet::range_size_t ss{1048576, 16384};
+    spreadsheet::document doc_dedup(ss);
+    spreadsheet::import_factory factory(doc_dedup);
+    factory.set_deduplicate_styles(true);
+    import_stats stats;
+    factory.set_stats(&stats);
+    orcus_xlsx app(&factory);
+    app.set_config(test_config);
+    app.read_file(path.str());
+
+    const spreadsheet::styles& styles = doc->get_styles();
+    const spreadsheet::styles& styles_dedup = doc_dedup.get_styles();
+
+    assert(styles_dedup.get_cell_formats_count() <= styles.get_cell_formats_count());
+    assert(styles_dedup.get_border_count() <= styles.get_border_count());
+    assert(styles_dedup.get_font_count() <= styles.get_font_count());
+    assert(stats.style_entries.stored > 0);
+
+    const spreadsheet::sheet* sh = doc->get_sheet(0);
+    const spreadsheet::sheet* sh_dedup = doc_dedup.get_sheet(0);
+    assert(sh && sh_dedup);
+
+    // Every cell must resolve to the same format attributes either way.
+    for (spreadsheet::row_t row = 0; row < 15; ++row)
+    {
+        for (spreadsheet::col_t col = 0; col < 5; ++col)
+        {
+            const spreadsheet::cell_format_t* cf = styles.get_cell_format(sh->get_cell_format(row, col));
+            const spreadsheet::cell_format_t* cf_dedup = styles_dedup.get_cell_format(sh_dedup->get_cell_format(row, col));
+            assert(cf && cf_dedup);
+            assert(cf->apply_border == cf_dedup->apply_border);
+
+            const spreadsheet::border_t* border = styles.get_border(cf->border);
+            const spreadsheet::border_t* border_dedup = styles_dedup.get_border(cf_dedup->border);
+            assert(border && border_dedup);
+            assert(border->top.style == border_dedup->top.style);
+            assert(border->bottom.style == border_dedup->bottom.style);
+            assert(border->left.style == border_dedup->left.style);
+            assert(border->right.style == border_dedup->right.style);
+
+            const spreadsheet::font_t* font = styles.get_font(cf->font);
+            const spreadsheet::font_t* font_dedup = styles_dedup.get_font(cf_dedup->font);
+            assert(font && font_dedup);
+            assert(font->name == font_dedup->name);
+            assert(font->size == font_dedup->size);
+        }
+    }
+}
+
 void test_xlsx_cell_borders_directions()
 {
     pstring path(SRCDIR"/test/xlsx/borders/directions.xlsx");
@@ -1632,6 +1689,209 @@ void test_xlsx_doc_structure_unordered_sheet_positions()
     }
 }
 
+/**
+ * Save each imported document to a snapshot, load it back into a new
+ * document, and check that the loaded content is identical to that of the
+ * original.
+ */
+void test_xlsx_snapshot()
+{
+    fs::path snapshot_path = fs::temp_directory_path() / fs::unique_path("orcus-%%%%-%%%%.snapshot");
+
+    auto run_check = [&snapshot_path](const fs::path& dir, bool recalc)
+    {
+        fs::path filepath = dir / "input.xlsx";
+        auto src = load_doc(filepath.string(), recalc);
+        src->save_snapshot(snapshot_path.string());
+
+        document doc{{1048576, 16384}};
+        doc.load_snapshot(snapshot_path.string());
+
+        ostringstream os;
+        src->dump_check(os);
+        string expected = os.str();
+
+        os.str(string());
+        doc.dump_check(os);
+        string check = os.str();
+
+        assert(!check.empty());
+        assert(check == expected);
+    };
+
+    for (const fs::path& dir : dirs_recalc)
+        run_check(dir, true);
+
+    // Cached formula results must survive the round trip.
+    for (const fs::path& dir : dirs_non_recalc)
+        run_check(dir, false);
+
+    // Tables are not part of the check output.
+    auto src = load_doc(SRCDIR"/test/xlsx/table/table-1.xlsx");
+    src->save_snapshot(snapshot_path.string());
+
+    document doc{{1048576, 16384}};
+    doc.load_snapshot(snapshot_path.string());
+
+    const table_t* p = doc.get_table("Table1");
+    assert(p);
+    assert(p->display_name == "Table1");
+    assert(p->totals_row_count == 1);
+    assert(p->range == src->get_table("Table1")->range);
+    assert(p->columns.size() == 2);
+    assert(p->columns[0].totals_row_label == "Total");
+    assert(p->columns[1].totals_row_function == totals_row_function_t::sum);
+    assert(p->filter.columns.size() == 1);
+    assert(p->filter.columns.begin()->second.match_values.count("E") > 0);
+    assert(p->style.name == "TableStyleLight9");
+    assert(p->style.show_row_stripes);
+
+    // A snapshot tied to a source only loads for that source.
+    std::string digest(64, 'a');
+    src->save_snapshot(snapshot_path.string(), 100, digest);
+    doc.load_snapshot(snapshot_path.string(), 100, digest);
+    doc.load_snapshot(snapshot_path.string());
+
+    std::vector<std::pair<uint64_t, std::string>> other_sources = {
+        { 101, digest },
+        { 100, std::string(64, 'b') },
+    };
+
+    for (const auto& source : other_sources)
+    {
+        try
+        {
+            doc.load_snapshot(snapshot_path.string(), source.first, source.second);
+            assert(!"exception was expected");
+        }
+        catch (const general_error&)
+        {
+            // expected.
+        }
+    }
+
+    assert(doc.get_table("Table1"));
+
+    // A truncated snapshot fails to load, and leaves the document as it was.
+    fs::resize_file(snapshot_path, fs::file_size(snapshot_path) / 2);
+
+    ostringstream os;
+    doc.dump_check(os);
+    string expected = os.str();
+
+    try
+    {
+        doc.load_snapshot(snapshot_path.string());
+        assert(!"exception was expected");
+    }
+    catch (const std::exception&)
+    {
+        // expected.
+    }
+
+    os.str(string());
+    doc.dump_check(os);
+    assert(os.str() == expected);
+    assert(doc.get_table("Table1"));
+
+    fs::remove(snapshot_path);
+}
+
+/**
+ * Import each document with the cell values allowed to get spilled to disk,
+ * make its sheet spill by accessing another one, and check that the content
+ * read back is identical to that of the document imported without spilling.
+ */
+void test_xlsx_spill()
+{
+    auto run_check = [](const fs::path& dir, bool recalc)
+    {
+        fs::path filepath = dir / "input.xlsx";
+        auto src = load_doc(filepath.string(), recalc);
+
+        document_config cfg;
+        cfg.spill_threshold = 1;
+        cfg.spill_directory = fs::temp_directory_path().string();
+
+        document doc{{1048576, 16384}};
+        doc.set_config(cfg);
+        import_factory factory(doc);
+        orcus_xlsx app(&factory);
+        app.set_config(test_config);
+        app.read_file(filepath.string());
+        if (recalc)
+            doc.recalc_formula_cells();
+
+        // Accessing the new sheet spills the cell values of all other sheets.
+        sheet* sh = doc.append_sheet("Spill");
+        assert(sh);
+        doc.page_in_sheet(sh->get_index());
+
+        ostringstream os;
+        src->dump_check(os);
+        string expected = os.str();
+
+        os.str(string());
+        doc.dump_check(os);
+        string check = os.str();
+
+        assert(!check.empty());
+        assert(check == expected);
+    };
+
+    for (const fs::path& dir : dirs_recalc)
+        run_check(dir, true);
+
+    // Cached formula results of all types must survive the spilling.
+    for (const fs::path& dir : dirs_non_recalc)
+        run_check(dir, false);
+}
+
+/**
+ * Export each imported document to a new xlsx file, import it back, and
+ * check that the content is identical to that of the original.  Named
+ * expressions are not exported yet, hence excluded.
+ */
+void test_xlsx_export()
+{
+    fs::path export_path = fs::temp_directory_path() / fs::unique_path("orcus-%%%%-%%%%.xlsx");
+
+    std::vector<fs::path> dirs = {
+        SRCDIR"/test/xlsx/raw-values-1",
+        SRCDIR"/test/xlsx/boolean-values",
+        SRCDIR"/test/xlsx/empty-shared-strings",
+        SRCDIR"/test/xlsx/formula-array-1",
+        SRCDIR"/test/xlsx/formula-cells",
+        SRCDIR"/test/xlsx/formula-shared",
+        SRCDIR"/test/xlsx/formula-with-string-results",
+    };
+
+    for (const fs::path& dir : dirs)
+    {
+        for (size_t thread_count : {1, 4})
+        {
+            fs::path filepath = dir / "input.xlsx";
+            auto src = load_doc(filepath.string(), false);
+            src->save_xlsx(export_path.string(), thread_count);
+
+            auto doc = load_doc(export_path.string(), false);
+
+            ostringstream os;
+            src->dump_check(os);
+            string expected = os.str();
+
+            os.str(string());
+            doc->dump_check(os);
+            string check = os.str();
+
+            assert(!check.empty());
+            assert(check == expected);
+        }
+    }
+
+    fs::remove(export_path);
+}
+
 }
 
 int main()
@@ -1650,7 +1910,11 @@ int main()
     test_xlsx_cell_borders_single_cells();
     test_xlsx_cell_borders_directions();
     test_xlsx_cell_borders_colors();
+    test_xlsx_dedup_styles();
     test_xlsx_hidden_rows_columns();
+    test_xlsx_snapshot();
+    test_xlsx_spill();
+    test_xlsx_export();
 
     // pivot table
     test_xlsx_pivot_two_pivot_caches();
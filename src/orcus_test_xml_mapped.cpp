@@ -24,6 +24,7 @@
 #include <sstream>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 
 #include <boost/filesystem.hpp>
 
@@ -227,6 +228,60 @@ void test_mapped_xml_import_no_map_definition()
     }
 }
 
+void test_mapped_xml_import_chunked()
+{
+    test::stack_printer __stack_printer__("::test_mapped_xml_import_chunked");
+
+    const std::vector<fs::path> tests = {
+        test_base_dir / "attribute-basic",
+        test_base_dir / "attribute-namespace",
+        test_base_dir / "content-basic",
+        test_base_dir / "content-namespace",
+        test_base_dir / "custom-labels",
+        test_base_dir / "fuel-economy",
+        test_base_dir / "nested-repeats",
+    };
+
+    // Chunk sizes small enough to split every token in the source document.
+    const std::vector<size_t> chunk_sizes = { 1, 7, 64 };
+
+    for (const fs::path& base_dir : tests)
+    {
+        fs::path data_file = base_dir / "input.xml";
+        fs::path map_file = base_dir / "map.xml";
+        fs::path check_file = base_dir / "check.txt";
+
+        cout << "reading " << data_file.string() << " in chunks" << endl;
+
+        file_content content(data_file.string().data());
+        file_content map_content(map_file.string().data());
+        file_content expected(check_file.string().data());
+
+        for (size_t chunk_size : chunk_sizes)
+        {
+            spreadsheet::range_size_t ss{1048576, 16384};
+            spreadsheet::document doc{ss};
+            spreadsheet::import_factory import_fact(doc);
+
+            xmlns_repository repo;
+            orcus_xml app(repo, &import_fact, nullptr);
+            app.read_map_definition(map_content.data(), map_content.size());
+
+            for (size_t pos = 0; pos < content.size(); pos += chunk_size)
+            {
+                // Pass each chunk in a separate buffer to make sure that
+                // nothing refers to a previous chunk.
+                std::string chunk(content.data() + pos, std::min(chunk_size, content.size() - pos));
+                app.feed_stream(chunk.data(), chunk.size());
+            }
+
+            app.finish_stream();
+
+            test::verify_content(__FILE__, __LINE__, doc, expected.str());
+        }
+    }
+}
+
 void test_invalid_map_definition()
 {
     test::stack_printer __stack_printer__("::test_invalid_map_definition");
@@ -279,6 +334,7 @@ int main()
 {
     test_mapped_xml_import();
     test_mapped_xml_import_no_map_definition();
+    test_mapped_xml_import_chunked();
     test_invalid_map_definition();
 
     return EXIT_SUCCESS;
@@ -6,6 +6,7 @@
  */
 
 #include "orcus/orcus_xlsx.hpp"
+#include "orcus/config.hpp"
 #include "orcus/spreadsheet/factory.hpp"
 #include "orcus/spreadsheet/document.hpp"
 #include "orcus/spreadsheet/view.hpp"
@@ -15,6 +16,45 @@
 #include <iostream>
 
 using namespace orcus;
+namespace po = boost::program_options;
+
+class xlsx_args_handler : public extra_args_handler
+{
+    constexpr static const char* help_metadata =
+        "Only print the workbook metadata i.e. sheet names, used ranges, "
+        "defined names and part sizes, without importing the content.";
+
+    constexpr static const char* help_prefetch_size =
+        "Specify the maximum amount of memory in MiB to hold the parts inflated "
+        "ahead of time while the current part is being parsed.  Set it to 0 to "
+        "inflate each part only when it gets parsed.";
+
+public:
+    virtual ~xlsx_args_handler() override {}
+
+    virtual void add_options(po::options_description& desc) override
+    {
+        desc.add_options()
+            ("metadata", help_metadata)
+            ("prefetch-size", po::value<size_t>(), help_prefetch_size);
+    }
+
+    virtual void map_to_config(config& opt, const po::variables_map& vm) override
+    {
+        if (vm.count("prefetch-size"))
+            opt.xlsx.prefetch_buffer_size = vm["prefetch-size"].as<size_t>() * 1024 * 1024;
+    }
+
+    virtual bool handle_input(const std::string& infile, const po::variables_map& vm) override
+    {
+        if (!vm.count("metadata"))
+            return false;
+
+        xlsx_workbook_metadata data = orcus_xlsx::read_metadata(infile);
+        data.dump(std::cout);
+        return true;
+    }
+};
 
 int main(int argc, char** argv)
 {
@@ -25,8 +65,14 @@ int main(int argc, char** argv)
         spreadsheet::view view(doc);
         spreadsheet::import_factory fact(doc, view);
         orcus_xlsx app(&fact);
+        xlsx_args_handler hdl;
+
+        auto create_filter = [](spreadsheet::import_factory& f)
+        {
+            return std::make_unique<orcus_xlsx>(&f);
+        };
 
-        if (parse_import_filter_args(argc, argv, fact, app, doc))
+        if (!parse_import_filter_args(argc, argv, fact, app, doc, &hdl, create_filter))
             return EXIT_FAILURE;
     }
     catch (const std::exception& e)
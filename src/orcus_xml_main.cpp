@@ -14,6 +14,7 @@
 #include "orcus/stream.hpp"
 #include "orcus/global.hpp"
 #include "orcus/sax_parser_base.hpp"
+#include "orcus/exception.hpp"
 
 #include "orcus_filter_global.hpp"
 #include "cli_global.hpp"
@@ -22,6 +23,7 @@
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 #include <mdds/sorted_string_map.hpp>
@@ -133,6 +135,29 @@ bool parse_and_dump_structure(const file_content& content, const std::string& ou
     return true;
 }
 
+/**
+ * Read the source document in chunks of the specified size, so that the
+ * whole document never needs to reside in memory.
+ */
+void read_stream_in_chunks(orcus_xml& app, const std::string& filepath, size_t chunk_size)
+{
+    ifstream file(filepath, ios::in | ios::binary);
+    if (!file)
+        throw general_error("failed to open the input file: " + filepath);
+
+    std::vector<char> buf(chunk_size);
+
+    while (file)
+    {
+        file.read(buf.data(), buf.size());
+        std::streamsize n = file.gcount();
+        if (n > 0)
+            app.feed_stream(buf.data(), n);
+    }
+
+    app.finish_stream();
+}
+
 void dump_document_structure(const file_content& content, output_stream& os)
 {
     xmlns_repository repo;
@@ -154,6 +179,9 @@ int main(int argc, char** argv)
         ("map,m", po::value<std::string>(), build_map_help_text().data())
         ("output,o", po::value<std::string>(), build_output_help_text().data())
         ("output-format,f", po::value<string>(), gen_help_output_format().data())
+        ("chunk-size", po::value<size_t>(),
+         "Read the input file in chunks of the specified size in bytes, instead of "
+         "reading it all at once. This is only used in the map mode with a map file.")
     ;
 
     po::options_description hidden("");
@@ -280,7 +308,12 @@ int main(int argc, char** argv)
             app.read_map_definition(map_content.data(), map_content.size());
         }
 
-        app.read_stream(content.data(), content.size());
+        size_t chunk_size = vm.count("chunk-size") ? vm["chunk-size"].as<size_t>() : 0;
+
+        if (chunk_size && mode == output_mode::type::map && !map_path.empty())
+            read_stream_in_chunks(app, input_path.string(), chunk_size);
+        else
+            app.read_stream(content.data(), content.size());
 
         switch (mode)
         {
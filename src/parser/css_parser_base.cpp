@@ -8,6 +8,7 @@
 #include "orcus/css_parser_base.hpp"
 #include "orcus/parser_global.hpp"
 #include "orcus/global.hpp"
+#include "numeric_parser.hpp"
 
 #include <cstring>
 #include <cassert>
@@ -97,7 +98,7 @@ double parser_base::parse_percent()
 
 double parser_base::parse_double_or_throw()
 {
-    double v = parse_double();
+    double v = parse_double<detail::numeric_parser_policy<detail::generic_parser_trait>>();
     if (std::isnan(v))
         throw css::parse_error("parse_double: failed to parse double precision value.");
     return v;
@@ -17,18 +17,7 @@ namespace orcus { namespace json {
 
 namespace {
 
-double parse_numeric_json(const char*& p, size_t max_length)
-{
-    using numeric_parser_type = detail::numeric_parser<detail::json_parser_trait>;
-
-    const char* p_end = p + max_length;
-
-    numeric_parser_type parser(p, p_end);
-    double v = parser.parse();
-    if (!std::isnan(v))
-        p = parser.get_char_position();
-    return v;
-};
+using numeric_policy_type = detail::numeric_parser_policy<detail::json_parser_trait>;
 
 } // anonymous namespace
 
@@ -55,8 +44,6 @@ struct parser_base::impl
 parser_base::parser_base(const char* p, size_t n) :
     ::orcus::parser_base(p, n, false), mp_impl(std::make_unique<impl>())
 {
-
-    set_numeric_parser(parse_numeric_json);
 }
 
 parser_base::~parser_base() {}
@@ -92,7 +79,7 @@ void parser_base::parse_null()
 
 double parser_base::parse_double_or_throw()
 {
-    double v = parse_double();
+    double v = parse_double<numeric_policy_type>();
     if (std::isnan(v))
         throw parse_error("parse_double_or_throw: failed to parse double precision value.", offset());
     return v;
@@ -83,10 +83,19 @@ std::string parse_error::build_message(
 parser_base::parser_base(const char* p, size_t n, bool transient_stream) :
     mp_begin(p), mp_char(p), mp_end(p+n),
     m_transient_stream(transient_stream),
+    m_offset_base(0),
     m_func_parse_numeric(parse_numeric)
 {
 }
 
+void parser_base::reset_stream(const char* p, size_t n, std::ptrdiff_t offset)
+{
+    mp_begin = p;
+    mp_char = p;
+    mp_end = p + n;
+    m_offset_base = offset;
+}
+
 void parser_base::prev(size_t dec)
 {
     mp_char -= dec;
@@ -250,7 +259,7 @@ size_t parser_base::remaining_size() const
 
 std::ptrdiff_t parser_base::offset() const
 {
-    return std::distance(mp_begin, mp_char);
+    return m_offset_base + std::distance(mp_begin, mp_char);
 }
 
 }
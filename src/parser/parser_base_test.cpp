@@ -8,6 +8,9 @@
 #include "test_global.hpp"
 #include "orcus/parser_base.hpp"
 #include "orcus/global.hpp"
+#include "numeric_parser.hpp"
+
+#include <cmath>
 
 using namespace std;
 using namespace orcus;
@@ -65,9 +68,60 @@ void test_skip_space_and_control()
     }
 }
 
+void test_parse_double()
+{
+    class _test_type : public orcus::parser_base
+    {
+    public:
+        _test_type(const char* p, size_t n) : orcus::parser_base(p, n, false) {}
+
+        double parse_runtime()
+        {
+            return parse_double();
+        }
+
+        double parse_json()
+        {
+            return parse_double<detail::numeric_parser_policy<detail::json_parser_trait>>();
+        }
+
+        char get_char() const
+        {
+            return *mp_char;
+        }
+    };
+
+    {
+        // Both should parse it the same way.
+        std::string s = "-1.5e2,";
+
+        _test_type test(s.data(), s.size());
+        assert(test.parse_runtime() == -150.0);
+        assert(test.get_char() == ',');
+
+        _test_type test2(s.data(), s.size());
+        assert(test2.parse_json() == -150.0);
+        assert(test2.get_char() == ',');
+    }
+
+    {
+        // Leading zeros are only allowed by the generic numeric parser.
+        std::string s = "012]";
+
+        _test_type test(s.data(), s.size());
+        assert(test.parse_runtime() == 12.0);
+        assert(test.get_char() == ']');
+
+        _test_type test2(s.data(), s.size());
+        assert(std::isnan(test2.parse_json()));
+        assert(test2.get_char() == '0'); // position should not move.
+    }
+}
+
 int main()
 {
     test_skip_space_and_control();
+    test_parse_double();
 
     return EXIT_SUCCESS;
 }
@@ -75,15 +75,7 @@ void write_to(std::ostringstream& os, const char* p, size_t n)
 
 double parse_numeric(const char*& p, size_t max_length)
 {
-    using numeric_parser_type = detail::numeric_parser<detail::generic_parser_trait>;
-
-    const char* p_end = p + max_length;
-
-    numeric_parser_type parser(p, p_end);
-    double v = parser.parse();
-    if (!std::isnan(v))
-        p = parser.get_char_position();
-    return v;
+    return detail::numeric_parser_policy<detail::generic_parser_trait>::parse(p, max_length);
 }
 
 long parse_integer(const char*& p, size_t max_length)
@@ -8,6 +8,9 @@
 #include <orcus/sax_ns_parser.hpp>
 #include <orcus/xml_namespace.hpp>
 
+#include <algorithm>
+#include <string>
+
 void test_handler()
 {
     const char* test_code = "<?xml version=\"1.0\"?><root/>";
@@ -67,10 +70,59 @@ void test_default_attr_ns()
     parser.parse();
 }
 
+void test_push_parser_ns_alias()
+{
+    struct _handler : public orcus::sax_ns_handler
+    {
+        size_t count = 0;
+
+        void start_element(const orcus::sax_ns_parser_element& elem)
+        {
+            // The alias declared in the root element must stay resolvable
+            // after the chunks containing the root element are gone.
+            if (elem.name == "child")
+            {
+                assert(elem.ns && std::string(elem.ns) == "test:foo");
+                ++count;
+            }
+        }
+
+        void attribute(const orcus::pstring& /*name*/, const orcus::pstring& /*val*/) {}
+        void attribute(const orcus::sax_ns_parser_attribute& /*attr*/) {}
+    };
+
+    const char* test_code =
+        "<?xml version=\"1.0\"?>"
+        "<foo:root xmlns:foo='test:foo'><foo:child/><foo:child>text</foo:child></foo:root>";
+    size_t len = strlen(test_code);
+
+    for (size_t chunk_size = 1; chunk_size <= len; ++chunk_size)
+    {
+        orcus::xmlns_repository repo;
+        orcus::xmlns_context cxt = repo.create_context();
+
+        _handler hdl;
+        orcus::sax_ns_push_parser<_handler> parser(cxt, hdl);
+
+        // Pass each chunk via a temporary buffer that gets overwritten.
+        std::string buf;
+        for (size_t pos = 0; pos < len; pos += chunk_size)
+        {
+            buf.assign(test_code + pos, std::min(chunk_size, len - pos));
+            parser.feed(buf.data(), buf.size());
+            buf.assign(buf.size(), 'x');
+        }
+
+        parser.finish();
+        assert(hdl.count == 2);
+    }
+}
+
 int main()
 {
     test_handler();
     test_default_attr_ns();
+    test_push_parser_ns_alias();
 
     return EXIT_SUCCESS;
 }
@@ -56,57 +56,241 @@ char decode_xml_encoded_char(const char* p, size_t n)
     return '\0';
 }
 
-std::string decode_xml_unicode_char(const char* p, size_t n)
+size_t decode_xml_unicode_char(const char* p, size_t n, char* out)
 {
-    if (*p == '#' && n >= 2)
-    {
-        uint32_t point = 0;
-        if (p[1] == 'x')
-        {
-            if (n == 2)
-                throw orcus::xml_structure_error(
-                    "invalid number of characters for hexadecimal unicode reference");
+    if (*p != '#' || n < 2)
+        return 0;
 
-            point = std::stoi(std::string(p + 2, n - 2), nullptr, 16);
-        }
-        else
-            point = std::stoi(std::string(p + 1, n - 1), nullptr, 10);
+    const char* p_end = p + n;
+    uint32_t point = 0;
 
-        if (point < 0x80)
-        {
-            // is it really necessary to do the bit manipulation here?
-            std::string s(1, static_cast<char>(point & 0x7F));
-            return s;
-        }
-        else if (point < 0x0800)
-        {
-            std::string s(1, static_cast<char>((point >> 6 & 0x1F) | 0xC0));
-            s += static_cast<char>((point & 0x3F) | 0x80);
-            return s;
-        }
-        else if (point < 0x010000)
+    if (p[1] == 'x')
+    {
+        if (n == 2)
+            throw orcus::xml_structure_error(
+                "invalid number of characters for hexadecimal unicode reference");
+
+        for (p += 2; p != p_end; ++p)
         {
-            std::string s(1, static_cast<char>((point >> 12 & 0x0F) | 0xE0));
-            s += static_cast<char>((point >> 6 & 0x3F) | 0x80);
-            s += static_cast<char>((point & 0x3F) | 0x80);
-            return s;
+            char c = *p;
+            uint32_t digit = 0;
+            if ('0' <= c && c <= '9')
+                digit = c - '0';
+            else if ('a' <= c && c <= 'f')
+                digit = c - 'a' + 10;
+            else if ('A' <= c && c <= 'F')
+                digit = c - 'A' + 10;
+            else
+                return 0;
+
+            point = point * 16 + digit;
+            if (point >= 0x110000)
+                // not representable in utf-8.
+                return 0;
         }
-        else if (point < 0x110000)
+    }
+    else
+    {
+        for (++p; p != p_end; ++p)
         {
-            std::string s(1, static_cast<char>((point >> 18 & 0x07) | 0xF0));
-            s += static_cast<char>((point >> 12 & 0x3F) | 0x80);
-            s += static_cast<char>((point >> 6 & 0x3F) | 0x80);
-            s += static_cast<char>((point & 0x3F) | 0x80);
-            return s;
+            char c = *p;
+            if (c < '0' || '9' < c)
+                return 0;
+
+            point = point * 10 + (c - '0');
+            if (point >= 0x110000)
+                // not representable in utf-8.
+                return 0;
         }
-        else
+    }
+
+    if (point < 0x80)
+    {
+        out[0] = static_cast<char>(point & 0x7F);
+        return 1;
+    }
+
+    if (point < 0x0800)
+    {
+        out[0] = static_cast<char>((point >> 6 & 0x1F) | 0xC0);
+        out[1] = static_cast<char>((point & 0x3F) | 0x80);
+        return 2;
+    }
+
+    if (point < 0x010000)
+    {
+        out[0] = static_cast<char>((point >> 12 & 0x0F) | 0xE0);
+        out[1] = static_cast<char>((point >> 6 & 0x3F) | 0x80);
+        out[2] = static_cast<char>((point & 0x3F) | 0x80);
+        return 3;
+    }
+
+    out[0] = static_cast<char>((point >> 18 & 0x07) | 0xF0);
+    out[1] = static_cast<char>((point >> 12 & 0x3F) | 0x80);
+    out[2] = static_cast<char>((point >> 6 & 0x3F) | 0x80);
+    out[3] = static_cast<char>((point & 0x3F) | 0x80);
+    return 4;
+}
+
+std::string decode_xml_unicode_char(const char* p, size_t n)
+{
+    char buf[4];
+    size_t len = decode_xml_unicode_char(p, n, buf);
+    return std::string(buf, len);
+}
+
+push_scanner::push_scanner() :
+    m_type(token_type::none), m_token_begin(0), m_pos(0), m_quote(0) {}
+
+size_t push_scanner::scan(const char* p, size_t n)
+{
+    while (true)
+    {
+        switch (m_type)
         {
-            // should not happen as that is not represented by utf-8
-            assert(false);
+            case token_type::none:
+            {
+                if (m_pos >= n)
+                    return m_token_begin;
+
+                m_token_begin = m_pos;
+                m_type = p[m_pos] == '<' ? token_type::markup : token_type::text;
+                break;
+            }
+            case token_type::text:
+            {
+                // A text run ends at the next '<', which starts the next token.
+                const void* found = std::memchr(p+m_pos, '<', n-m_pos);
+                if (!found)
+                {
+                    m_pos = n;
+                    return m_token_begin;
+                }
+
+                m_pos = static_cast<const char*>(found) - p;
+                m_token_begin = m_pos;
+                m_type = token_type::none;
+                break;
+            }
+            case token_type::markup:
+            {
+                // Determine the type of markup from its leading characters.
+                const char* t = p + m_token_begin;
+                size_t avail = n - m_token_begin;
+                if (avail < 2)
+                    return m_token_begin;
+
+                m_quote = 0;
+
+                if (t[1] != '!')
+                {
+                    // Element, closing element or declaration.
+                    m_type = token_type::tag;
+                    m_pos = m_token_begin + 1;
+                    break;
+                }
+
+                if (avail < 4)
+                    return m_token_begin;
+
+                if (t[2] == '-' && t[3] == '-')
+                {
+                    m_type = token_type::comment;
+                    m_pos = m_token_begin + 4;
+                    break;
+                }
+
+                if (t[2] == '[')
+                {
+                    // Length of '<![CDATA['.
+                    if (avail < 9)
+                        return m_token_begin;
+
+                    m_type = token_type::cdata;
+                    m_pos = m_token_begin + 9;
+                    break;
+                }
+
+                // DOCTYPE.
+                m_type = token_type::tag;
+                m_pos = m_token_begin + 2;
+                break;
+            }
+            case token_type::tag:
+            {
+                // Find the closing '>' that is not inside a quoted value.
+                for (; m_pos < n; ++m_pos)
+                {
+                    char c = p[m_pos];
+                    if (m_quote)
+                    {
+                        if (c == m_quote)
+                            m_quote = 0;
+                    }
+                    else if (c == '"' || c == '\'')
+                        m_quote = c;
+                    else if (c == '>')
+                        break;
+                }
+
+                if (m_pos == n)
+                    return m_token_begin;
+
+                m_token_begin = ++m_pos;
+                m_type = token_type::none;
+                break;
+            }
+            case token_type::comment:
+            {
+                // A comment ends at the first '--', which must be followed
+                // by '>'.
+                for (; m_pos + 1 < n; ++m_pos)
+                {
+                    if (p[m_pos] == '-' && p[m_pos+1] == '-')
+                        break;
+                }
+
+                if (m_pos + 2 >= n)
+                    return m_token_begin;
+
+                m_pos += 3;
+                m_token_begin = m_pos;
+                m_type = token_type::none;
+                break;
+            }
+            case token_type::cdata:
+            {
+                for (; m_pos + 2 < n; ++m_pos)
+                {
+                    if (p[m_pos] == ']' && p[m_pos+1] == ']' && p[m_pos+2] == '>')
+                        break;
+                }
+
+                if (m_pos + 2 >= n)
+                    return m_token_begin;
+
+                m_pos += 3;
+                m_token_begin = m_pos;
+                m_type = token_type::none;
+                break;
+            }
         }
     }
+}
 
-    return std::string();
+void push_scanner::consume(size_t n)
+{
+    assert(n <= m_token_begin);
+    m_token_begin -= n;
+    m_pos -= n;
+}
+
+void push_scanner::reset()
+{
+    m_type = token_type::none;
+    m_token_begin = 0;
+    m_pos = 0;
+    m_quote = 0;
 }
 
 struct parser_base::impl
@@ -142,7 +326,7 @@ void parser_base::comment()
 {
     // Parse until we reach '-->'.
     size_t len = remains();
-    assert(len > 3);
+    assert(len >= 3);
     char c = cur_char();
     size_t i = 0;
     bool hyphen = false;
@@ -211,55 +395,80 @@ void parser_base::expects_next(const char* p, size_t n)
     }
 }
 
+void parser_base::skip_to_either(char c1, char c2)
+{
+#if defined(__ORCUS_CPU_FEATURES) && defined(__SSE4_2__)
+    const __m128i v_c1 = _mm_set1_epi8(c1);
+    const __m128i v_c2 = _mm_set1_epi8(c2);
+
+    for (; mp_end - mp_char >= 16; mp_char += 16)
+    {
+        __m128i char_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mp_char));
+        __m128i results = _mm_or_si128(
+            _mm_cmpeq_epi8(char_block, v_c1), _mm_cmpeq_epi8(char_block, v_c2));
+        int r = _mm_movemask_epi8(results);
+        if (r)
+        {
+            mp_char += __builtin_ctz(r);
+            return;
+        }
+    }
+#endif
+
+    // Scan the remaining tail (or everything when no CPU features are in
+    // use) one character at a time.
+    for (; mp_char != mp_end; ++mp_char)
+    {
+        if (*mp_char == c1 || *mp_char == c2)
+            return;
+    }
+}
+
 void parser_base::parse_encoded_char(cell_buffer& buf)
 {
     assert(cur_char() == '&');
     next();
     const char* p0 = mp_char;
-    for (; has_char(); next())
+    const char* p_end = static_cast<const char*>(std::memchr(mp_char, ';', available_size()));
+    if (!p_end)
     {
-        if (cur_char() != ';')
-            continue;
+        mp_char = mp_end;
+        throw malformed_xml_error(
+            "error parsing encoded character: terminating character is not found.", offset());
+    }
 
-        size_t n = mp_char - p0;
-        if (!n)
-            throw malformed_xml_error("empty encoded character.", offset());
+    mp_char = p_end;
+    size_t n = mp_char - p0;
+    if (!n)
+        throw malformed_xml_error("empty encoded character.", offset());
 
 #if ORCUS_DEBUG_SAX_PARSER
-        cout << "sax_parser::parse_encoded_char: raw='" << std::string(p0, n) << "'" << endl;
+    cout << "sax_parser::parse_encoded_char: raw='" << std::string(p0, n) << "'" << endl;
 #endif
 
-        char c = decode_xml_encoded_char(p0, n);
-        if (c)
-            buf.append(&c, 1);
-        else
-        {
-            std::string utf8 = decode_xml_unicode_char(p0, n);
-
-            if (!utf8.empty())
-            {
-                buf.append(utf8.data(), utf8.size());
-                c = '1'; // just to avoid hitting the !c case below
-            }
-        }
-
-        // Move to the character past ';' before returning to the parent call.
-        next();
+    // Move to the character past ';' before returning to the parent call.
+    next();
 
-        if (!c)
-        {
-#if ORCUS_DEBUG_SAX_PARSER
-            cout << "sax_parser::parse_encoded_char: not a known encoding name. Use the original." << endl;
-#endif
-            // Unexpected encoding name. Use the original text.
-            buf.append(p0, mp_char-p0);
-        }
+    char c = decode_xml_encoded_char(p0, n);
+    if (c)
+    {
+        buf.append(&c, 1);
+        return;
+    }
 
+    char utf8[4];
+    size_t utf8_len = decode_xml_unicode_char(p0, n, utf8);
+    if (utf8_len)
+    {
+        buf.append(utf8, utf8_len);
         return;
     }
 
-    throw malformed_xml_error(
-        "error parsing encoded character: terminating character is not found.", offset());
+#if ORCUS_DEBUG_SAX_PARSER
+    cout << "sax_parser::parse_encoded_char: not a known encoding name. Use the original." << endl;
+#endif
+    // Unexpected encoding name. Use the original text.
+    buf.append(p0, mp_char-p0);
 }
 
 void parser_base::value_with_encoded_char(cell_buffer& buf, pstring& str, char quote_char)
@@ -267,29 +476,20 @@ void parser_base::value_with_encoded_char(cell_buffer& buf, pstring& str, char q
     assert(cur_char() == '&');
     parse_encoded_char(buf);
 
-    const char* p0 = mp_char;
-
     while (has_char())
     {
-        if (cur_char() == '&')
-        {
-            if (mp_char > p0)
-                buf.append(p0, mp_char-p0);
-
-            parse_encoded_char(buf);
-            p0 = mp_char;
-        }
+        // Copy the span up to the next encoded character in one go.
+        const char* p0 = mp_char;
+        skip_to_either(quote_char, '&');
+        if (mp_char > p0)
+            buf.append(p0, mp_char-p0);
 
-        if (cur_char() == quote_char)
+        if (!has_char() || cur_char() == quote_char)
             break;
 
-        if (cur_char() != '&')
-            next();
+        parse_encoded_char(buf);
     }
 
-    if (mp_char > p0)
-        buf.append(p0, mp_char-p0);
-
     if (!buf.empty())
         str = pstring(buf.get(), buf.size());
 
@@ -306,20 +506,21 @@ bool parser_base::value(pstring& str, bool decode)
 
     char quote_char = c;
 
-    c = next_char_checked();
+    next_check();
 
     const char* p0 = mp_char;
-    for (; c != quote_char; c = next_char_checked())
+    skip_to_either(quote_char, decode ? '&' : quote_char);
+    if (!has_char())
+        throw malformed_xml_error("xml stream ended prematurely.", offset());
+
+    if (cur_char() == '&')
     {
-        if (decode && c == '&')
-        {
-            // This value contains one or more encoded characters.
-            cell_buffer& buf = get_cell_buffer();
-            buf.reset();
-            buf.append(p0, mp_char-p0);
-            value_with_encoded_char(buf, str, quote_char);
-            return true;
-        }
+        // This value contains one or more encoded characters.
+        cell_buffer& buf = get_cell_buffer();
+        buf.reset();
+        buf.append(p0, mp_char-p0);
+        value_with_encoded_char(buf, str, quote_char);
+        return true;
     }
 
     str = pstring(p0, mp_char-p0);
@@ -420,28 +621,19 @@ void parser_base::characters_with_encoded_char(cell_buffer& buf)
     assert(cur_char() == '&');
     parse_encoded_char(buf);
 
-    const char* p0 = mp_char;
-
     while (has_char())
     {
-        if (cur_char() == '&')
-        {
-            if (mp_char > p0)
-                buf.append(p0, mp_char-p0);
-
-            parse_encoded_char(buf);
-            p0 = mp_char;
-        }
+        // Copy the span up to the next encoded character in one go.
+        const char* p0 = mp_char;
+        skip_to_either('<', '&');
+        if (mp_char > p0)
+            buf.append(p0, mp_char-p0);
 
-        if (cur_char() == '<')
+        if (!has_char() || cur_char() == '<')
             break;
 
-        if (cur_char() != '&')
-            next();
+        parse_encoded_char(buf);
     }
-
-    if (mp_char > p0)
-        buf.append(p0, mp_char-p0);
 }
 
 }}
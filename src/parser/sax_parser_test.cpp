@@ -8,6 +8,9 @@
 #include "test_global.hpp"
 #include "orcus/sax_parser.hpp"
 
+#include <algorithm>
+#include <sstream>
+
 using namespace std;
 
 void test_handler()
@@ -115,12 +118,202 @@ void test_attr_with_encoded_chars_single_quotes()
     parser.parse();
 }
 
+void test_decode_xml_unicode_char()
+{
+    struct test_case
+    {
+        const char* encoded;
+        const char* decoded;
+    };
+
+    const test_case tcs[] = {
+        { "#10", "\n" },
+        { "#x41", "A" },
+        { "#xA9", "\xC2\xA9" },
+        { "#x20A9", "\xE2\x82\xA9" },
+        { "#8361", "\xE2\x82\xA9" },
+        { "#x1F600", "\xF0\x9F\x98\x80" },
+        { "#x110000", "" }, // out of the unicode range
+        { "#12a", "" },
+        { "#xZZ", "" },
+        { "amp", "" },
+    };
+
+    for (const test_case& tc : tcs)
+    {
+        char buf[4];
+        size_t n = orcus::sax::decode_xml_unicode_char(tc.encoded, strlen(tc.encoded), buf);
+        assert(std::string(buf, n) == tc.decoded);
+        assert(orcus::sax::decode_xml_unicode_char(tc.encoded, strlen(tc.encoded)) == tc.decoded);
+    }
+}
+
+void test_encoded_chars()
+{
+    struct _handler : public orcus::sax_handler
+    {
+        std::string chars;
+        std::string attr_value;
+
+        void characters(const orcus::pstring& val, bool /*transient*/)
+        {
+            chars += val.str();
+        }
+
+        void attribute(const orcus::sax::parser_attribute& attr)
+        {
+            if (attr.name == "attr")
+                attr_value = attr.value.str();
+        }
+    };
+
+    // Use spans longer than 16 characters between the encoded characters.
+    const char* content =
+        "<root attr=\"a long attribute value &amp;&amp; another long span &#10;&quot;end\">"
+        "a long run of text without encoded characters &lt;tag&gt;&#x20A9;&#10;"
+        "another long run of text &amp; more &;end"
+        "</root>";
+
+    _handler hdl;
+    orcus::sax_parser<_handler> parser(content, strlen(content), hdl);
+
+    try
+    {
+        parser.parse();
+        assert(!"exception was expected for the empty encoded character");
+    }
+    catch (const orcus::sax::malformed_xml_error&) {}
+
+    assert(hdl.attr_value == "a long attribute value && another long span \n\"end");
+
+    content =
+        "<root>"
+        "a long run of text without encoded characters &lt;tag&gt;&#x20A9;&#10;"
+        "another long run of text &amp; more&apos;"
+        "</root>";
+
+    _handler hdl2;
+    orcus::sax_parser<_handler> parser2(content, strlen(content), hdl2);
+    parser2.parse();
+
+    assert(hdl2.chars ==
+        "a long run of text without encoded characters <tag>\xE2\x82\xA9\n"
+        "another long run of text & more'");
+}
+
+/**
+ * Handler that records all callbacks in a string, for comparing the output
+ * of different parsers.
+ */
+struct recording_handler : public orcus::sax_handler
+{
+    std::ostringstream os;
+
+    void doctype(const orcus::sax::doctype_declaration& dtd)
+    {
+        os << "doctype: " << dtd.root_element << "," << dtd.fpi << "," << dtd.uri << endl;
+    }
+
+    void start_declaration(const orcus::pstring& decl)
+    {
+        os << "start_declaration: " << decl << endl;
+    }
+
+    void end_declaration(const orcus::pstring& decl)
+    {
+        os << "end_declaration: " << decl << endl;
+    }
+
+    void start_element(const orcus::sax::parser_element& elem)
+    {
+        os << "start_element: " << elem.ns << ":" << elem.name << " (" << elem.begin_pos << "-" << elem.end_pos << ")" << endl;
+    }
+
+    void end_element(const orcus::sax::parser_element& elem)
+    {
+        os << "end_element: " << elem.ns << ":" << elem.name << " (" << elem.begin_pos << "-" << elem.end_pos << ")" << endl;
+    }
+
+    void characters(const orcus::pstring& val, bool /*transient*/)
+    {
+        os << "characters: '" << val << "'" << endl;
+    }
+
+    void attribute(const orcus::sax::parser_attribute& attr)
+    {
+        os << "attribute: " << attr.ns << ":" << attr.name << "='" << attr.value << "'" << endl;
+    }
+};
+
+void test_push_parser()
+{
+    const char* content =
+        "  <?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Strict//EN\" \"http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd\">\n"
+        "<!-- comment with <tags> and - hyphens -->\n"
+        "<root xmlns:a=\"http://example.com/a\" attr='a > b' attr2=\"&quot;&lt;quoted&gt;&quot;\">\n"
+        "    <a:child attr=\"value\"/>\n"
+        "    text with &amp; encoded &#x20A9; chars\n"
+        "    <![CDATA[cdata with <tags> and ]] brackets]]>\n"
+        "    <!-- another comment -->"
+        "    <child>some text</child>\n"
+        "</root>\n"
+        "trailing content that is ignored"
+    ;
+
+    size_t len = strlen(content);
+
+    recording_handler expected;
+    orcus::sax_parser<recording_handler> parser(content, len, expected);
+    parser.parse();
+
+    for (size_t chunk_size : { 1, 2, 3, 5, 7, 16, 64, 1024 })
+    {
+        recording_handler hdl;
+        orcus::sax_push_parser<recording_handler> push_parser(hdl);
+
+        for (size_t pos = 0; pos < len; pos += chunk_size)
+            push_parser.feed(content + pos, std::min(chunk_size, len - pos));
+
+        push_parser.finish();
+
+        assert(hdl.os.str() == expected.os.str());
+    }
+}
+
+void test_push_parser_transient()
+{
+    struct _handler : public orcus::sax_handler
+    {
+        void characters(const orcus::pstring& /*val*/, bool transient)
+        {
+            assert(transient);
+        }
+
+        void attribute(const orcus::sax::parser_attribute& attr)
+        {
+            assert(attr.transient);
+        }
+    };
+
+    const char* content = "<root attr1=\"non-transient\">non-transient</root>";
+
+    _handler hdl;
+    orcus::sax_push_parser<_handler> parser(hdl);
+    parser.feed(content, strlen(content));
+    parser.finish();
+}
+
 int main()
 {
     test_handler();
     test_transient_stream();
     test_attr_equal_with_whitespace();
     test_attr_with_encoded_chars_single_quotes();
+    test_decode_xml_unicode_char();
+    test_encoded_chars();
+    test_push_parser();
+    test_push_parser_transient();
 
     return EXIT_SUCCESS;
 }
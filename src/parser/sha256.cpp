@@ -0,0 +1,141 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/detail/sha256.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace orcus { namespace detail {
+
+namespace {
+
+const uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+uint32_t rotate_right(uint32_t v, int n)
+{
+    return (v >> n) | (v << (32 - n));
+}
+
+}
+
+sha256::sha256() :
+    m_state{
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+    m_length(0), m_block_size(0) {}
+
+void sha256::process_block(const unsigned char* p)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i, p += 4)
+        w[i] = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+
+    for (int i = 16; i < 64; ++i)
+    {
+        uint32_t s0 = rotate_right(w[i-15], 7) ^ rotate_right(w[i-15], 18) ^ (w[i-15] >> 3);
+        uint32_t s1 = rotate_right(w[i-2], 17) ^ rotate_right(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+
+    uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+
+    for (int i = 0; i < 64; ++i)
+    {
+        uint32_t s1 = rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + ch + round_constants[i] + w[i];
+        uint32_t s0 = rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
+
+void sha256::update(const char* p, size_t n)
+{
+    const unsigned char* up = reinterpret_cast<const unsigned char*>(p);
+    m_length += n;
+
+    if (m_block_size)
+    {
+        // Complete the block left over from the previous call first.
+        size_t len = std::min(n, sizeof(m_block) - m_block_size);
+        std::memcpy(m_block + m_block_size, up, len);
+        m_block_size += len;
+        up += len;
+        n -= len;
+
+        if (m_block_size < sizeof(m_block))
+            return;
+
+        process_block(m_block);
+        m_block_size = 0;
+    }
+
+    for (; n >= sizeof(m_block); up += sizeof(m_block), n -= sizeof(m_block))
+        process_block(up);
+
+    std::memcpy(m_block, up, n);
+    m_block_size = n;
+}
+
+std::string sha256::hex_digest()
+{
+    uint64_t bits = m_length * 8;
+
+    // Pad with a single 1 bit followed by zeros, leaving room for the
+    // message length at the end of the last block.
+    unsigned char pad[72] = { 0x80 };
+    size_t pad_size = (m_block_size < 56 ? 56 : 120) - m_block_size;
+    for (int i = 0; i < 8; ++i)
+        pad[pad_size + i] = static_cast<unsigned char>(bits >> (56 - i * 8));
+
+    update(reinterpret_cast<const char*>(pad), pad_size + 8);
+
+    static const char* digits = "0123456789abcdef";
+    std::string s;
+    s.reserve(64);
+    for (uint32_t v : m_state)
+    {
+        for (int shift = 28; shift >= 0; shift -= 4)
+            s.push_back(digits[(v >> shift) & 0xF]);
+    }
+
+    return s;
+}
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,69 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/detail/sha256.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using orcus::detail::sha256;
+
+namespace {
+
+std::string digest(const char* p)
+{
+    sha256 hash;
+    hash.update(p, std::strlen(p));
+    return hash.hex_digest();
+}
+
+void test_known_digests()
+{
+    assert(digest("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assert(digest("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    // 56 bytes, which makes the padding spill over into another block.
+    assert(digest("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+void test_pieces()
+{
+    // One million 'a's fed in pieces that straddle the block boundaries.
+    std::string s(1000000, 'a');
+    sha256 hash;
+    size_t pos = 0;
+    for (size_t n = 1; pos < s.size(); n = n % 97 + 1)
+    {
+        n = std::min(n, s.size() - pos);
+        hash.update(s.data() + pos, n);
+        pos += n;
+    }
+
+    assert(hash.hex_digest() == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    // The same content in one piece.
+    sha256 hash2;
+    hash2.update(s.data(), s.size());
+    assert(hash2.hex_digest() == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+}
+
+int main()
+{
+    test_known_digests();
+    test_pieces();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
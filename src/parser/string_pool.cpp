@@ -10,6 +10,7 @@
 #include "orcus/global.hpp"
 #include "orcus/pstring.hpp"
 #include "orcus/exception.hpp"
+#include "orcus/detail/trace.hpp"
 
 #include <iostream>
 #include <unordered_set>
@@ -55,6 +56,8 @@ std::pair<pstring, bool> string_pool::intern(const char* str)
 
 std::pair<pstring, bool> string_pool::intern(const char* str, size_t n)
 {
+    ORCUS_TRACE_SPAN("string", "string_pool::intern");
+
     if (!n)
         return std::pair<pstring, bool>(pstring(), false);
 
@@ -126,6 +129,11 @@ size_t string_pool::size() const
     return mp_impl->m_set.size();
 }
 
+void string_pool::reserve(size_t n)
+{
+    mp_impl->m_set.reserve(n);
+}
+
 void string_pool::swap(string_pool& other)
 {
     std::swap(mp_impl, other.mp_impl);
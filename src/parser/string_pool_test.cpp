@@ -101,10 +101,29 @@ void test_merge()
     assert(entries.size() == pool1.size());
 }
 
+void test_reserve()
+{
+    string_pool pool;
+    pool.reserve(100);
+    assert(pool.size() == 0);
+
+    pstring v1 = pool.intern("A").first;
+    pool.intern("B");
+
+    // Reserving less than what is already stored should be harmless.
+    pool.reserve(1);
+    assert(pool.size() == 2);
+
+    auto r = pool.intern("A");
+    assert(!r.second);
+    assert(r.first.get() == v1.get());
+}
+
 int main()
 {
     test_basic();
     test_merge();
+    test_reserve();
 
     return EXIT_SUCCESS;
 }
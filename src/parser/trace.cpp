@@ -0,0 +1,412 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/trace.hpp"
+#include "orcus/detail/trace.hpp"
+#include "orcus/json_global.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace orcus { namespace trace {
+
+namespace {
+
+/** Number of spans each thread can hold.  It must be a power of 2. */
+constexpr uint64_t ring_capacity = 1 << 16;
+
+std::atomic<bool> recording(false);
+
+uint64_t now()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::chrono::nanoseconds d = std::chrono::steady_clock::now() - epoch;
+    return d.count();
+}
+
+/**
+ * The fields are atomic only so that a reader can copy a slot while its
+ * owning thread overwrites it.  A torn copy gets detected and discarded by
+ * the reader.
+ */
+struct span_slot
+{
+    std::atomic<size_t> thread_id;
+    std::atomic<const char*> category;
+    std::atomic<const char*> name;
+    std::atomic<const char*> detail;
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> duration;
+};
+
+struct span
+{
+    size_t thread_id;
+    const char* category;
+    const char* name;
+    const char* detail;
+    uint64_t start;
+    uint64_t duration;
+};
+
+/**
+ * Ring buffer of the spans of one thread.  Only the owning thread writes to
+ * it, and any thread may read from it without locking.  Each span records
+ * the id of the thread that owned the ring at the time, since the ring may
+ * have been handed over from a finished thread.
+ */
+class span_ring
+{
+    size_t m_thread_id;
+    std::unique_ptr<span_slot[]> m_slots;
+
+    /** Total number of spans ever pushed. */
+    std::atomic<uint64_t> m_head;
+
+    /** Position of the first span not discarded by clear(). */
+    std::atomic<uint64_t> m_begin;
+
+    /**
+     * Get the position of the oldest span that can be read safely.  The
+     * slot the next span goes into may be overwritten at any moment, so a
+     * full ring holds one span less than its capacity.
+     */
+    static uint64_t get_oldest(uint64_t head)
+    {
+        return head >= ring_capacity ? head - ring_capacity + 1 : 0;
+    }
+
+    uint64_t get_first(uint64_t head) const
+    {
+        return std::max(get_oldest(head), m_begin.load(std::memory_order_acquire));
+    }
+
+public:
+    span_ring(size_t thread_id) :
+        m_thread_id(thread_id), m_slots(new span_slot[ring_capacity]), m_head(0), m_begin(0) {}
+
+    /**
+     * Set the id of the thread taking the ring over.  It must be called
+     * before the thread pushes its first span.
+     */
+    void set_thread_id(size_t thread_id)
+    {
+        m_thread_id = thread_id;
+    }
+
+    void push(const char* category, const char* name, const char* detail, uint64_t start, uint64_t duration)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+
+        // Let a reader that sees any of the stores below also see the
+        // previous head, so that it knows the slot may be overwritten.
+        std::atomic_thread_fence(std::memory_order_release);
+
+        span_slot& slot = m_slots[head & (ring_capacity - 1)];
+        slot.thread_id.store(m_thread_id, std::memory_order_relaxed);
+        slot.category.store(category, std::memory_order_relaxed);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.detail.store(detail, std::memory_order_relaxed);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.duration.store(duration, std::memory_order_relaxed);
+
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    void clear()
+    {
+        m_begin.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t size() const
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        return head - get_first(head);
+    }
+
+    void copy(std::vector<span>& spans) const
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t first = get_first(head);
+
+        std::vector<span> copied;
+        copied.reserve(head - first);
+
+        for (uint64_t i = first; i < head; ++i)
+        {
+            const span_slot& slot = m_slots[i & (ring_capacity - 1)];
+            copied.push_back({
+                slot.thread_id.load(std::memory_order_relaxed),
+                slot.category.load(std::memory_order_relaxed),
+                slot.name.load(std::memory_order_relaxed),
+                slot.detail.load(std::memory_order_relaxed),
+                slot.start.load(std::memory_order_relaxed),
+                slot.duration.load(std::memory_order_relaxed)
+            });
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // The owning thread may have overwritten the oldest spans while they
+        // were being copied.
+        uint64_t valid = get_oldest(m_head.load(std::memory_order_relaxed));
+        size_t skip = valid > first ? std::min<uint64_t>(valid - first, copied.size()) : 0;
+
+        spans.insert(spans.end(), copied.begin() + skip, copied.end());
+    }
+};
+
+/**
+ * Owns the rings of all threads that have ever recorded a span.  The rings
+ * outlive their threads so that the spans of the worker threads can be
+ * written after they finish.  The ring of a finished thread gets handed
+ * over to the next new thread though, so that the number of rings stays
+ * bounded by the number of threads recording at the same time.  The spans
+ * of the finished thread remain in the ring until they get overwritten, and
+ * keep the id of the finished thread.
+ */
+struct ring_registry
+{
+    std::mutex mtx;
+    std::vector<std::unique_ptr<span_ring>> rings;
+
+    /** Rings whose threads have finished. */
+    std::vector<span_ring*> free_rings;
+
+    /** Id to give to the next thread acquiring a ring. */
+    size_t next_thread_id = 1;
+
+    static ring_registry& get()
+    {
+        static ring_registry registry;
+        return registry;
+    }
+
+    span_ring* acquire()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        size_t thread_id = next_thread_id++;
+
+        if (!free_rings.empty())
+        {
+            span_ring* p = free_rings.back();
+            free_rings.pop_back();
+            p->set_thread_id(thread_id);
+            return p;
+        }
+
+        rings.push_back(std::make_unique<span_ring>(thread_id));
+        return rings.back().get();
+    }
+
+    void release(span_ring* p)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        free_rings.push_back(p);
+    }
+};
+
+/**
+ * Returns the ring of its thread to the registry when the thread finishes.
+ */
+class thread_ring_owner
+{
+    ring_registry& m_registry;
+    span_ring* mp_ring;
+
+public:
+    thread_ring_owner() :
+        m_registry(ring_registry::get()), mp_ring(m_registry.acquire()) {}
+
+    ~thread_ring_owner()
+    {
+        m_registry.release(mp_ring);
+    }
+
+    span_ring& get()
+    {
+        return *mp_ring;
+    }
+};
+
+span_ring& get_thread_ring()
+{
+    thread_local thread_ring_owner owner;
+    return owner.get();
+}
+
+std::string demangle(const char* name)
+{
+#ifdef __GNUG__
+    int status = 0;
+    char* p = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (p)
+    {
+        std::string s = p;
+        std::free(p);
+        return s;
+    }
+#endif
+    return name;
+}
+
+void write_timestamp(std::ostream& os, uint64_t ns)
+{
+    // Chrome trace timestamps are in microseconds.
+    os << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000;
+}
+
+}
+
+bool is_available()
+{
+#ifdef __ORCUS_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void start()
+{
+    // Fix the epoch before the first span.
+    now();
+    recording.store(true, std::memory_order_release);
+}
+
+void stop()
+{
+    recording.store(false, std::memory_order_release);
+}
+
+bool is_recording()
+{
+    return recording.load(std::memory_order_acquire);
+}
+
+void clear()
+{
+    ring_registry& registry = ring_registry::get();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+
+    for (std::unique_ptr<span_ring>& ring : registry.rings)
+        ring->clear();
+}
+
+size_t get_span_count()
+{
+    ring_registry& registry = ring_registry::get();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+
+    size_t n = 0;
+    for (const std::unique_ptr<span_ring>& ring : registry.rings)
+        n += ring->size();
+
+    return n;
+}
+
+void write_chrome_trace(std::ostream& os)
+{
+    ring_registry& registry = ring_registry::get();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+
+    // Qualified span names keyed by the span's name and detail.  Both are
+    // expected to be static strings, so their addresses identify them.
+    std::unordered_map<std::string, std::string> names;
+    std::unordered_set<size_t> thread_ids;
+    std::vector<span> spans;
+    char fill = os.fill();
+
+    os << "{\"traceEvents\":[";
+    bool first = true;
+
+    for (const std::unique_ptr<span_ring>& ring : registry.rings)
+    {
+        spans.clear();
+        ring->copy(spans);
+
+        for (const span& sp : spans)
+        {
+            size_t tid = sp.thread_id;
+
+            if (!first)
+                os << ',';
+            first = false;
+
+            // Name each thread once, before its first span.
+            if (thread_ids.insert(tid).second)
+                os << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                    << ",\"args\":{\"name\":\"thread " << tid << "\"}},";
+
+            std::string key(reinterpret_cast<const char*>(&sp.name), sizeof(sp.name));
+            key.append(reinterpret_cast<const char*>(&sp.detail), sizeof(sp.detail));
+
+            auto it = names.find(key);
+            if (it == names.end())
+            {
+                std::string name = sp.name;
+                if (sp.detail)
+                    name = demangle(sp.detail) + "::" + name;
+
+                it = names.emplace(std::move(key), json::escape_string(name)).first;
+            }
+
+            os << "\n{\"name\":\"" << it->second
+                << "\",\"cat\":\"" << json::escape_string(sp.category)
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+            write_timestamp(os, sp.start);
+            os << ",\"dur\":";
+            write_timestamp(os, sp.duration);
+            os << '}';
+        }
+    }
+
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    os.fill(fill);
+}
+
+}}
+
+namespace orcus { namespace detail { namespace trace {
+
+scoped_span::scoped_span(const char* category, const char* name, const char* detail) :
+    mp_category(category), mp_name(nullptr), mp_detail(detail), m_start(0)
+{
+    if (!orcus::trace::recording.load(std::memory_order_relaxed))
+        return;
+
+    mp_name = name;
+    m_start = orcus::trace::now();
+}
+
+scoped_span::~scoped_span()
+{
+    if (!mp_name)
+        return;
+
+    uint64_t end = orcus::trace::now();
+    orcus::trace::get_thread_ring().push(mp_category, mp_name, mp_detail, m_start, end - m_start);
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,270 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/trace.hpp"
+#include "orcus/detail/trace.hpp"
+#include "orcus/json_parser.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+using namespace orcus;
+using orcus::detail::trace::scoped_span;
+
+namespace {
+
+struct some_context
+{
+    virtual ~some_context() {}
+};
+
+/**
+ * Collects the values of the "name" and "tid" keys of the trace events.
+ */
+class trace_handler : public json_handler
+{
+    std::string m_key;
+    std::string m_name;
+
+public:
+    std::vector<std::string> names;
+    std::set<double> tids;
+    std::map<std::string, std::set<double>> name_tids;
+
+    void object_key(const char* p, size_t len, bool /*transient*/)
+    {
+        m_key.assign(p, len);
+    }
+
+    void string(const char* p, size_t len, bool /*transient*/)
+    {
+        if (m_key == "name")
+        {
+            names.emplace_back(p, len);
+            m_name = names.back();
+        }
+        m_key.clear();
+    }
+
+    void number(double val)
+    {
+        if (m_key == "tid")
+        {
+            tids.insert(val);
+            name_tids[m_name].insert(val);
+        }
+        m_key.clear();
+    }
+};
+
+trace_handler parse_trace()
+{
+    std::ostringstream os;
+    trace::write_chrome_trace(os);
+    std::string s = os.str();
+
+    trace_handler hdl;
+    json_parser<trace_handler> parser(s.data(), s.size(), hdl);
+    parser.parse();
+    return hdl;
+}
+
+size_t count_name(const trace_handler& hdl, const std::string& name)
+{
+    size_t n = 0;
+    for (const std::string& s : hdl.names)
+    {
+        if (s == name)
+            ++n;
+    }
+    return n;
+}
+
+void test_recording()
+{
+    trace::clear();
+    assert(!trace::is_recording());
+
+    {
+        scoped_span span("test", "not-recorded");
+    }
+
+    assert(trace::get_span_count() == 0);
+
+    trace::start();
+    assert(trace::is_recording());
+
+    {
+        scoped_span outer("test", "outer");
+        for (int i = 0; i < 3; ++i)
+            scoped_span inner("test", "inner");
+    }
+
+    trace::stop();
+
+    {
+        scoped_span span("test", "not-recorded");
+    }
+
+    assert(trace::get_span_count() == 4);
+
+    trace_handler hdl = parse_trace();
+    assert(count_name(hdl, "outer") == 1);
+    assert(count_name(hdl, "inner") == 3);
+    assert(count_name(hdl, "not-recorded") == 0);
+
+    trace::clear();
+    assert(trace::get_span_count() == 0);
+}
+
+void test_detail()
+{
+    trace::clear();
+    trace::start();
+
+    some_context cxt;
+
+    {
+        scoped_span span("test", "start_element", typeid(cxt).name());
+    }
+
+    trace::stop();
+
+    trace_handler hdl = parse_trace();
+
+#ifdef __GNUG__
+    assert(count_name(hdl, "(anonymous namespace)::some_context::start_element") == 1);
+#else
+    assert(hdl.names.size() == 2); // thread name and the span
+#endif
+
+    trace::clear();
+}
+
+void test_overwrite()
+{
+    trace::clear();
+    trace::start();
+
+    const size_t n = 100000;
+    for (size_t i = 0; i < n; ++i)
+        scoped_span span("test", "span");
+
+    {
+        scoped_span span("test", "last");
+    }
+
+    trace::stop();
+
+    // Only the latest spans are kept.
+    size_t count = trace::get_span_count();
+    assert(0 < count && count < n);
+
+    trace_handler hdl = parse_trace();
+    assert(count_name(hdl, "span") == count - 1);
+    assert(count_name(hdl, "last") == 1);
+
+    trace::clear();
+}
+
+void test_threads()
+{
+    trace::clear();
+    trace::start();
+
+    const int n_threads = 4;
+    std::atomic<int> started(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n_threads; ++i)
+    {
+        threads.emplace_back([&started]()
+        {
+            for (int j = 0; j < 100; ++j)
+                scoped_span span("test", "worker");
+
+            // Keep all worker threads alive until each has recorded its
+            // spans, so that none of them takes over the ring of another.
+            ++started;
+            while (started.load() < n_threads)
+                std::this_thread::yield();
+        });
+    }
+
+    // Write the trace while the worker threads are recording.
+    std::ostringstream os;
+    trace::write_chrome_trace(os);
+
+    for (std::thread& t : threads)
+        t.join();
+
+    trace::stop();
+
+    trace_handler hdl = parse_trace();
+    assert(count_name(hdl, "worker") == 400);
+
+    // Each worker thread has its own id.
+    assert(hdl.name_tids["worker"].size() == size_t(n_threads));
+
+    trace::clear();
+}
+
+void test_ring_recycling()
+{
+    trace::clear();
+    trace::start();
+
+    {
+        std::thread t([]() { scoped_span span("test", "first"); });
+        t.join();
+    }
+
+    // A new thread reuses the ring of the finished one, rather than
+    // allocating a new ring every time.  Each thread still gets its own id.
+    for (int i = 0; i < 10; ++i)
+    {
+        std::thread t([]() { scoped_span span("test", "next"); });
+        t.join();
+    }
+
+    trace::stop();
+
+    trace_handler hdl = parse_trace();
+    assert(count_name(hdl, "first") == 1);
+    assert(count_name(hdl, "next") == 10);
+    assert(hdl.name_tids["first"].size() == 1);
+    assert(hdl.name_tids["next"].size() == 10);
+    assert(!hdl.name_tids["next"].count(*hdl.name_tids["first"].begin()));
+
+    trace::clear();
+}
+
+}
+
+int main()
+{
+    std::cout << "tracing compiled in: " << trace::is_available() << std::endl;
+
+    test_recording();
+    test_detail();
+    test_overwrite();
+    test_threads();
+    test_ring_recycling();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -243,6 +243,7 @@ const std::vector<map_type::entry> entries =
     { ORCUS_ASCII("html"),  dump_format_t::html  },
     { ORCUS_ASCII("json"),  dump_format_t::json  },
     { ORCUS_ASCII("none"),  dump_format_t::none  },
+    { ORCUS_ASCII("xlsx"),  dump_format_t::xlsx  },
     { ORCUS_ASCII("xml"),   dump_format_t::xml   },
 };
 
@@ -15,6 +15,7 @@
 #include <limits>
 #include <sstream>
 #include <algorithm>
+#include <iterator>
 #include <cassert>
 
 #define ORCUS_DEBUG_XML_NAMESPACE 0
@@ -28,29 +29,6 @@ using namespace std;
 
 namespace orcus {
 
-namespace {
-
-#if ORCUS_DEBUG_XML_NAMESPACE
-template<typename _MapType>
-void print_map_keys(const _MapType& map_store)
-{
-    cout << "keys: (";
-    bool first = true;
-    typename _MapType::const_iterator it = map_store.begin(), it_end = map_store.end();
-    for (; it != it_end; ++it)
-    {
-        if (first)
-            first = false;
-        else
-            cout << " ";
-        cout << "'" << it->first << "'";
-    }
-    cout << ")";
-};
-#endif
-
-}
-
 typedef std::unordered_map<pstring, size_t, pstring::hash> strid_map_type;
 
 struct xmlns_repository::impl
@@ -171,21 +149,81 @@ size_t xmlns_repository::get_index(xmlns_id_t ns_id) const
 }
 
 typedef std::vector<xmlns_id_t> xmlns_list_type;
-typedef std::unordered_map<pstring, xmlns_list_type, pstring::hash> alias_map_type;
+
+namespace {
+
+/**
+ * Single alias-to-namespace binding in the namespace stack.  The alias
+ * string is always interned in the context's own alias store.
+ */
+struct alias_entry
+{
+    pstring alias;
+    xmlns_id_t ns;
+
+    alias_entry(const pstring& _alias, xmlns_id_t _ns) : alias(_alias), ns(_ns) {}
+};
+
+typedef std::vector<alias_entry> alias_stack_type;
+
+}
 
 struct xmlns_context::impl
 {
     xmlns_repository* repo = nullptr;
     xmlns_list_type m_all_ns; /// all namespaces ever used in this context.
     xmlns_list_type m_default;
-    alias_map_type m_map;
+
+    /**
+     * Bindings of all non-default aliases currently in scope, in the order
+     * of their declarations.  A document rarely has more than a handful of
+     * aliases in scope at any given time, so scanning this from the top is
+     * cheaper than a hash lookup.
+     */
+    alias_stack_type m_aliases;
+
+    /**
+     * All distinct aliases ever pushed to this context.  The alias strings
+     * in m_aliases point to the strings stored in m_alias_pool.
+     */
+    std::vector<pstring> m_alias_names;
+    string_pool m_alias_pool;
 
     bool m_trim_all_ns = true;
 
     impl() {}
     impl(xmlns_repository& _repo) : repo(&_repo) {}
     impl(const impl& r) :
-        repo(r.repo), m_all_ns(r.m_all_ns), m_default(r.m_default), m_map(r.m_map), m_trim_all_ns(r.m_trim_all_ns) {}
+        repo(r.repo), m_all_ns(r.m_all_ns), m_default(r.m_default), m_trim_all_ns(r.m_trim_all_ns)
+    {
+        m_aliases.reserve(r.m_aliases.size());
+        for (const alias_entry& e : r.m_aliases)
+            m_aliases.emplace_back(intern_alias(e.alias), e.ns);
+    }
+
+    pstring intern_alias(const pstring& key)
+    {
+        for (const pstring& name : m_alias_names)
+        {
+            if (name == key)
+                return name;
+        }
+
+        pstring name = m_alias_pool.intern(key).first;
+        m_alias_names.push_back(name);
+        return name;
+    }
+
+    const alias_entry* find(const pstring& key) const
+    {
+        for (auto it = m_aliases.rbegin(), ite = m_aliases.rend(); it != ite; ++it)
+        {
+            if (it->alias == key)
+                return &*it;
+        }
+
+        return nullptr;
+    }
 };
 
 xmlns_context::xmlns_context() : mp_impl(std::make_unique<impl>()) {}
@@ -232,29 +270,9 @@ xmlns_id_t xmlns_context::push(const pstring& key, const pstring& uri)
         return mp_impl->m_default.back();
     }
 
-    // See if this key already exists.
-    alias_map_type::iterator it = mp_impl->m_map.find(key);
-    if (it == mp_impl->m_map.end())
-    {
-        // This is the first time this key is used.
-        xmlns_list_type nslist;
-        nslist.push_back(uri_interned.get());
-        mp_impl->m_all_ns.push_back(uri_interned.get());
-        std::pair<alias_map_type::iterator,bool> r =
-            mp_impl->m_map.insert(alias_map_type::value_type(key, nslist));
-
-        if (!r.second)
-            // insertion failed.
-            throw general_error("Failed to insert new namespace.");
-
-        return nslist.back();
-    }
-
-    // The key already exists.
-    xmlns_list_type& nslist = it->second;
-    nslist.push_back(uri_interned.get());
+    mp_impl->m_aliases.emplace_back(mp_impl->intern_alias(key), uri_interned.get());
     mp_impl->m_all_ns.push_back(uri_interned.get());
-    return nslist.back();
+    return mp_impl->m_aliases.back().ns;
 }
 
 void xmlns_context::pop(const pstring& key)
@@ -272,32 +290,33 @@ void xmlns_context::pop(const pstring& key)
         return;
     }
 
-    // See if this key really exists.
-    alias_map_type::iterator it = mp_impl->m_map.find(key);
-    if (it == mp_impl->m_map.end())
-        throw general_error("failed to find the key.");
-
-    xmlns_list_type& nslist = it->second;
-    if (nslist.empty())
-        throw general_error("namespace stack for this key is empty.");
+    // Remove the most recent binding of this key.  It is normally at or
+    // near the top of the stack.
+    alias_stack_type& aliases = mp_impl->m_aliases;
+    for (auto it = aliases.rbegin(), ite = aliases.rend(); it != ite; ++it)
+    {
+        if (it->alias == key)
+        {
+            aliases.erase(std::next(it).base());
+            return;
+        }
+    }
 
-    nslist.pop_back();
+    throw general_error("failed to find the key.");
 }
 
 xmlns_id_t xmlns_context::get(const pstring& key) const
 {
 #if ORCUS_DEBUG_XML_NAMESPACE
     cout << "xmlns_context::get: alias='" << key << "', default ns stack size="
-        << mp_impl->m_default.size() << ", non-default alias count=" << mp_impl->m_map.size();
-    cout << ", ";
-    print_map_keys(mp_impl->m_map);
+        << mp_impl->m_default.size() << ", non-default alias stack size=" << mp_impl->m_aliases.size();
     cout << endl;
 #endif
     if (key.empty())
         return mp_impl->m_default.empty() ? XMLNS_UNKNOWN_ID : mp_impl->m_default.back();
 
-    alias_map_type::const_iterator it = mp_impl->m_map.find(key);
-    if (it == mp_impl->m_map.end())
+    const alias_entry* entry = mp_impl->find(key);
+    if (!entry)
     {
 #if ORCUS_DEBUG_XML_NAMESPACE
         cout << "xmlns_context::get: alias not in this context" << endl;
@@ -305,10 +324,7 @@ xmlns_id_t xmlns_context::get(const pstring& key) const
         return XMLNS_UNKNOWN_ID;
     }
 
-#if ORCUS_DEBUG_XML_NAMESPACE
-    cout << "xmlns_context::get: alias stack size=" << it->second.size() << endl;
-#endif
-    return it->second.empty() ? XMLNS_UNKNOWN_ID : it->second.back();
+    return entry->ns;
 }
 
 size_t xmlns_context::get_index(xmlns_id_t ns_id) const
@@ -329,15 +345,15 @@ string xmlns_context::get_short_name(xmlns_id_t ns_id) const
 
 pstring xmlns_context::get_alias(xmlns_id_t ns_id) const
 {
-    alias_map_type::const_iterator it = mp_impl->m_map.begin(), it_end = mp_impl->m_map.end();
-    for (; it != it_end; ++it)
+    const alias_stack_type& aliases = mp_impl->m_aliases;
+    for (auto it = aliases.rbegin(), ite = aliases.rend(); it != ite; ++it)
     {
-        const xmlns_list_type& lst = it->second;
-        if (lst.empty())
+        if (it->ns != ns_id)
             continue;
 
-        if (lst.back() == ns_id)
-            return it->first;
+        // Make sure this binding is not shadowed by a more recent one.
+        if (mp_impl->find(it->alias) == &*it)
+            return it->alias;
     }
 
     return pstring();
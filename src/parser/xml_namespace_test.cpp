@@ -10,6 +10,7 @@
 #include "orcus/pstring.hpp"
 
 #include <cstdlib>
+#include <string>
 #include <vector>
 #include <algorithm>
 
@@ -193,6 +194,58 @@ void test_ns_context()
     assert(id1 == id2);
 }
 
+void test_nested_aliases()
+{
+    xmlns_repository repo;
+    xmlns_context cxt = repo.create_context();
+
+    // Push the keys from a transient buffer to make sure the context does
+    // not hold on to the key strings passed by the caller.
+    std::string buf = "a";
+    xmlns_id_t ns1 = cxt.push(buf, "ns:1");
+    buf = "b";
+    xmlns_id_t ns2 = cxt.push(buf, "ns:2");
+    buf = "a";
+    xmlns_id_t ns3 = cxt.push(buf, "ns:3"); // shadows the first "a".
+    buf = "x";
+
+    assert(cxt.get("a") == ns3);
+    assert(cxt.get("b") == ns2);
+    assert(cxt.get("c") == XMLNS_UNKNOWN_ID);
+
+    // "ns:1" is only reachable via a shadowed alias.
+    assert(cxt.get_alias(ns1).empty());
+    assert(cxt.get_alias(ns2) == "b");
+    assert(cxt.get_alias(ns3) == "a");
+
+    xmlns_context cxt2 = cxt; // copy ctor
+    assert(cxt2.get("a") == ns3);
+
+    // Popping the keys out of order only affects the binding of each key.
+    cxt.pop("b");
+    assert(cxt.get("b") == XMLNS_UNKNOWN_ID);
+    assert(cxt.get("a") == ns3);
+    cxt.pop("a");
+    assert(cxt.get("a") == ns1);
+    assert(cxt.get_alias(ns1) == "a");
+    cxt.pop("a");
+    assert(cxt.get("a") == XMLNS_UNKNOWN_ID);
+
+    try
+    {
+        cxt.pop("a");
+        assert(!"exception was supposed to be thrown due to empty stack.");
+    }
+    catch (const std::exception&)
+    {
+        // expected
+    }
+
+    // The copy is not affected.
+    assert(cxt2.get("a") == ns3);
+    assert(cxt2.get("b") == ns2);
+}
+
 } // anonymous namespace
 
 int main()
@@ -202,6 +255,7 @@ int main()
     test_predefined_ns();
     test_xml_name_t();
     test_ns_context();
+    test_nested_aliases();
 
     return EXIT_SUCCESS;
 }
@@ -19,10 +19,14 @@ namespace {
 struct _elem
 {
     xml_name_t name;
+    std::string name_buf; // copy of the name in transient mode.
     std::vector<pstring> ns_aliases;
     bool open;
 
     _elem(const xml_name_t& _name) : name(_name), open(true) {}
+
+    _elem(xmlns_id_t ns, const pstring& _name) :
+        name(ns, pstring()), name_buf(_name.data(), _name.size()), open(true) {}
 };
 
 struct _attr
@@ -30,10 +34,33 @@ struct _attr
     xml_name_t name;
     pstring value;
 
+    // copies of the name and value in transient mode.
+    bool transient;
+    std::string name_buf;
+    std::string value_buf;
+
     _attr(const xml_name_t& _name, const pstring& _value) :
         name(_name),
-        value(_value)
+        value(_value),
+        transient(false)
     {}
+
+    _attr(const xml_name_t& _name, const pstring& _value, bool /*transient*/) :
+        name(_name.ns, pstring()),
+        transient(true),
+        name_buf(_name.name.data(), _name.name.size()),
+        value_buf(_value.data(), _value.size())
+    {}
+
+    xml_name_t get_name() const
+    {
+        return transient ? xml_name_t(name.ns, name_buf) : name;
+    }
+
+    pstring get_value() const
+    {
+        return transient ? pstring(value_buf) : value;
+    }
 };
 
 void write_content_encoded(const pstring& content, std::ostream& os)
@@ -131,17 +158,21 @@ struct xml_writer::impl
 {
     xmlns_repository& ns_repo;
     std::ostream& os;
+    const string_mode mode;
     std::vector<_elem> elem_stack;
     std::vector<pstring> ns_decls;
     std::vector<_attr> attrs;
 
+    std::string popped_name; // name of the last popped element in transient mode.
+
     string_pool str_pool;
     xmlns_repository repo;
     xmlns_context cxt;
 
-    impl(xmlns_repository& _ns_repo, std::ostream& _os) :
+    impl(xmlns_repository& _ns_repo, std::ostream& _os, string_mode _mode) :
         ns_repo(_ns_repo),
         os(_os),
+        mode(_mode),
         cxt(ns_repo.create_context())
     {}
 
@@ -167,7 +198,10 @@ struct xml_writer::impl
 };
 
 xml_writer::xml_writer(xmlns_repository& ns_repo, std::ostream& os) :
-    mp_impl(std::make_unique<impl>(ns_repo, os))
+    xml_writer(ns_repo, os, string_mode::intern) {}
+
+xml_writer::xml_writer(xmlns_repository& ns_repo, std::ostream& os, string_mode mode) :
+    mp_impl(std::make_unique<impl>(ns_repo, os, mode))
 {
     os << "<?xml version=\"1.0\"?>";
 }
@@ -175,7 +209,7 @@ xml_writer::xml_writer(xmlns_repository& ns_repo, std::ostream& os) :
 xml_writer::xml_writer(xml_writer&& other) :
     mp_impl(std::move(other.mp_impl))
 {
-    other.mp_impl = std::make_unique<impl>(mp_impl->ns_repo, mp_impl->os);
+    other.mp_impl = std::make_unique<impl>(mp_impl->ns_repo, mp_impl->os, mp_impl->mode);
 }
 
 xml_writer& xml_writer::operator= (xml_writer&& other)
@@ -211,10 +245,9 @@ void xml_writer::push_element(const xml_name_t& _name)
     close_current_element();
 
     auto& os = mp_impl->os;
-    xml_name_t name = mp_impl->intern(_name);
 
     os << '<';
-    mp_impl->print(name);
+    mp_impl->print(_name);
 
     for (const pstring& alias : mp_impl->ns_decls)
     {
@@ -229,15 +262,19 @@ void xml_writer::push_element(const xml_name_t& _name)
     for (const _attr& attr : mp_impl->attrs)
     {
         os << ' ';
-        mp_impl->print(attr.name);
+        mp_impl->print(attr.get_name());
         os << "=\"";
-        os << attr.value << '"';
+        write_content_encoded(attr.get_value(), os);
+        os << '"';
     }
 
     mp_impl->attrs.clear();
     mp_impl->ns_decls.clear();
 
-    mp_impl->elem_stack.emplace_back(name);
+    if (mp_impl->mode == string_mode::transient)
+        mp_impl->elem_stack.emplace_back(_name.ns, _name.name);
+    else
+        mp_impl->elem_stack.emplace_back(mp_impl->intern(_name));
 }
 
 xmlns_id_t xml_writer::add_namespace(const pstring& alias, const pstring& value)
@@ -250,7 +287,10 @@ xmlns_id_t xml_writer::add_namespace(const pstring& alias, const pstring& value)
 
 void xml_writer::add_attribute(const xml_name_t& name, const pstring& value)
 {
-    mp_impl->attrs.emplace_back(mp_impl->intern(name), mp_impl->intern(value));
+    if (mp_impl->mode == string_mode::transient)
+        mp_impl->attrs.emplace_back(name, value, true);
+    else
+        mp_impl->attrs.emplace_back(mp_impl->intern(name), mp_impl->intern(value));
 }
 
 void xml_writer::add_content(const pstring& content)
@@ -264,7 +304,13 @@ xml_name_t xml_writer::pop_element()
     auto& os = mp_impl->os;
 
     const _elem& elem = mp_impl->elem_stack.back();
-    auto name = elem.name;
+    xml_name_t name = elem.name;
+
+    if (mp_impl->mode == string_mode::transient)
+    {
+        mp_impl->popped_name = elem.name_buf;
+        name.name = mp_impl->popped_name;
+    }
 
     if (elem.open)
     {
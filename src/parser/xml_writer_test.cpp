@@ -95,10 +95,66 @@ void test_move()
     }
 }
 
+void test_attribute_encoding()
+{
+    xmlns_repository repo;
+    std::ostringstream os;
+
+    {
+        xml_writer writer(repo, os);
+        writer.add_attribute({nullptr, "name"}, "Tom & \"Jerry\"");
+        writer.push_element({nullptr, "root"});
+    }
+
+    std::string stream = os.str();
+    assert(stream == "<?xml version=\"1.0\"?><root name=\"Tom &amp; &quot;Jerry&quot;\"/>");
+}
+
+void test_transient_strings()
+{
+    xmlns_repository repo;
+    std::ostringstream os;
+
+    {
+        xml_writer writer(repo, os, xml_writer::string_mode::transient);
+
+        // Reuse the same buffers for all the names and values, to make sure
+        // the writer doesn't hold on to them.
+        std::string name = "root";
+        std::string value = "1";
+        writer.push_element({nullptr, name});
+
+        for (int i = 0; i < 3; ++i)
+        {
+            name = "child";
+            value = std::to_string(i);
+            writer.add_attribute({nullptr, name}, value);
+            name = "c";
+            writer.push_element({nullptr, name});
+            name = "garbage";
+            value = "garbage";
+            writer.add_content("text");
+            xml_name_t popped = writer.pop_element();
+            assert(popped.name == "c");
+        }
+
+        xml_name_t popped = writer.pop_element();
+        assert(popped.name == "root");
+    }
+
+    std::string stream = os.str();
+    assert(stream ==
+        "<?xml version=\"1.0\"?><root>"
+        "<c child=\"0\">text</c><c child=\"1\">text</c><c child=\"2\">text</c>"
+        "</root>");
+}
+
 int main()
 {
     test_encoded_content();
     test_move();
+    test_attribute_encoding();
+    test_transient_strings();
 
     return EXIT_SUCCESS;
 }
@@ -8,6 +8,7 @@
 #include "orcus/zip_archive.hpp"
 #include "orcus/zip_archive_stream.hpp"
 #include "orcus/string_pool.hpp"
+#include "orcus/detail/trace.hpp"
 
 #include <cstdio>
 #include <cstdlib>
@@ -20,10 +21,18 @@
 #endif
 #include <cstdio>
 #include <sstream>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 
 #include <zlib.h>
 #include <zconf.h>
 
+#ifdef __ORCUS_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
 #define ORCUS_DEBUG_ZIP_ARCHIVE 0
 
 using namespace std;
@@ -45,6 +54,9 @@ const char* zip_error::what() const throw()
     return m_msg.c_str();
 }
 
+zip_file_entry_stat::zip_file_entry_stat() :
+    size_compressed(0), size_uncompressed(0), compressed(false) {}
+
 namespace {
 
 struct zip_file_param
@@ -75,43 +87,249 @@ struct zip_file_param
     uint32_t crc32;
 };
 
-class zip_inflater
+/**
+ * Inflates a whole deflate stream whose uncompressed size is known in
+ * advance, directly into its destination buffer.
+ */
+class inflate_backend
+{
+public:
+    virtual ~inflate_backend() {}
+
+    /**
+     * Inflate the compressed stream.  It throws zip_error when the stream is
+     * corrupt, or when its uncompressed size differs from the size of the
+     * destination buffer.
+     */
+    virtual void inflate(
+        const unsigned char* src, size_t src_size, unsigned char* dest, size_t dest_size) = 0;
+};
+
+class zlib_inflate_backend : public inflate_backend
+{
+    struct stream_guard
+    {
+        z_stream& cxt;
+        stream_guard(z_stream& _cxt) : cxt(_cxt) {}
+        ~stream_guard() { inflateEnd(&cxt); }
+    };
+
+public:
+    virtual void inflate(
+        const unsigned char* src, size_t src_size, unsigned char* dest, size_t dest_size) override
+    {
+        // z_stream counts the bytes in uInt, which may be narrower than
+        // size_t.  Feed larger buffers in multiple segments.
+        constexpr size_t max_segment = std::numeric_limits<uInt>::max();
+
+        z_stream cxt;
+        cxt.zalloc = 0;
+        cxt.zfree = 0;
+        cxt.opaque = 0;
+        cxt.next_in = const_cast<Bytef*>(src);
+        cxt.avail_in = 0;
+        cxt.next_out = static_cast<Bytef*>(dest);
+        cxt.avail_out = 0;
+
+        if (inflateInit2(&cxt, -MAX_WBITS) != Z_OK)
+            throw zip_error("failed to initialize the inflater.");
+
+        stream_guard guard(cxt);
+
+        size_t in_left = src_size;
+        size_t out_left = dest_size;
+
+        while (true)
+        {
+            if (!cxt.avail_in && in_left)
+            {
+                cxt.avail_in = std::min(in_left, max_segment);
+                in_left -= cxt.avail_in;
+            }
+
+            if (!cxt.avail_out && out_left)
+            {
+                cxt.avail_out = std::min(out_left, max_segment);
+                out_left -= cxt.avail_out;
+            }
+
+            // With the whole stream and the whole output buffer given in one
+            // call, Z_FINISH lets zlib skip maintaining its sliding window.
+            int flush = (in_left || out_left) ? Z_NO_FLUSH : Z_FINISH;
+            int err = ::inflate(&cxt, flush);
+
+            if (err == Z_STREAM_END)
+                break;
+
+            if (err == Z_BUF_ERROR)
+            {
+                if ((!cxt.avail_in && !in_left) || (!cxt.avail_out && !out_left))
+                    // No more input to feed, or no more room for the output.
+                    throw zip_error("inflated size differs from the recorded size.");
+
+                continue;
+            }
+
+            if (err != Z_OK)
+                throw zip_error("error during inflate.");
+        }
+
+        if (cxt.avail_out || out_left)
+            throw zip_error("inflated size differs from the recorded size.");
+    }
+};
+
+#ifdef __ORCUS_LIBDEFLATE
+
+/**
+ * Uses libdeflate which decompresses a whole buffer at a time, and is
+ * considerably faster than zlib when the uncompressed size is known.
+ */
+class libdeflate_inflate_backend : public inflate_backend
+{
+    libdeflate_decompressor* mp_cxt;
+
+public:
+    libdeflate_inflate_backend() : mp_cxt(libdeflate_alloc_decompressor())
+    {
+        if (!mp_cxt)
+            throw zip_error("failed to initialize the inflater.");
+    }
+
+    virtual ~libdeflate_inflate_backend() override
+    {
+        libdeflate_free_decompressor(mp_cxt);
+    }
+
+    virtual void inflate(
+        const unsigned char* src, size_t src_size, unsigned char* dest, size_t dest_size) override
+    {
+        // Passing null as the actual output size requires the output to fill
+        // the buffer exactly.
+        libdeflate_result res = libdeflate_deflate_decompress(
+            mp_cxt, src, src_size, dest, dest_size, nullptr);
+
+        switch (res)
+        {
+            case LIBDEFLATE_SUCCESS:
+                break;
+            case LIBDEFLATE_BAD_DATA:
+                throw zip_error("error during inflate.");
+            default:
+                throw zip_error("inflated size differs from the recorded size.");
+        }
+    }
+};
+
+#endif
+
+bool is_backend_available(zip_inflate_backend_t backend)
+{
+    switch (backend)
+    {
+        case zip_inflate_backend_t::automatic:
+        case zip_inflate_backend_t::zlib:
+            return true;
+        case zip_inflate_backend_t::libdeflate:
+#ifdef __ORCUS_LIBDEFLATE
+            return true;
+#else
+            return false;
+#endif
+    }
+
+    return false;
+}
+
+std::unique_ptr<inflate_backend> create_inflate_backend(zip_inflate_backend_t backend)
+{
+    switch (backend)
+    {
+#ifdef __ORCUS_LIBDEFLATE
+        case zip_inflate_backend_t::automatic:
+        case zip_inflate_backend_t::libdeflate:
+            return std::make_unique<libdeflate_inflate_backend>();
+#else
+        case zip_inflate_backend_t::automatic:
+#endif
+        case zip_inflate_backend_t::zlib:
+            return std::make_unique<zlib_inflate_backend>();
+        default:
+            ;
+    }
+
+    throw zip_error("inflate backend is not available.");
+}
+
+/**
+ * Inflate a compressed stream incrementally, one chunk of input at a time,
+ * into a fixed-size output buffer.
+ */
+class zip_chunk_inflater
 {
     z_stream m_zlib_cxt;
+    bool m_initialized;
+    bool m_stream_end;
 
-    zip_inflater(); // disabled
 public:
-    zip_inflater(vector<unsigned char>& raw_buf, vector<unsigned char>& dest_buf, const zip_file_param& param)
+    zip_chunk_inflater(unsigned char* dest, size_t dest_size) :
+        m_initialized(false), m_stream_end(false)
     {
         m_zlib_cxt.total_out = 0;
         m_zlib_cxt.zalloc = 0;
         m_zlib_cxt.zfree = 0;
         m_zlib_cxt.opaque = 0;
-        m_zlib_cxt.next_in = static_cast<Bytef*>(&raw_buf[0]);
-        m_zlib_cxt.avail_in = param.size_compressed;
+        m_zlib_cxt.next_in = nullptr;
+        m_zlib_cxt.avail_in = 0;
 
-        m_zlib_cxt.next_out = static_cast<Bytef*>(&dest_buf[0]);
-        m_zlib_cxt.avail_out = param.size_uncompressed;
+        m_zlib_cxt.next_out = static_cast<Bytef*>(dest);
+        m_zlib_cxt.avail_out = dest_size;
     }
 
-    ~zip_inflater()
+    ~zip_chunk_inflater()
     {
-        inflateEnd(&m_zlib_cxt);
+        if (m_initialized)
+            inflateEnd(&m_zlib_cxt);
     }
 
     bool init()
     {
-        int err = inflateInit2(&m_zlib_cxt, -MAX_WBITS);
-        return err == Z_OK;
+        m_initialized = inflateInit2(&m_zlib_cxt, -MAX_WBITS) == Z_OK;
+        return m_initialized;
     }
 
-    bool inflate()
+    /**
+     * Feed a chunk of compressed data, and inflate it until either the chunk
+     * is fully consumed, the output buffer is full, or the end of the
+     * compressed stream is reached.
+     */
+    void inflate(unsigned char* src, size_t src_size)
     {
-        int err = ::inflate(&m_zlib_cxt, Z_SYNC_FLUSH);
-        if (err >= 0 && m_zlib_cxt.msg)
-            return false;
+        m_zlib_cxt.next_in = static_cast<Bytef*>(src);
+        m_zlib_cxt.avail_in = src_size;
 
-        return true;
+        while (m_zlib_cxt.avail_in && m_zlib_cxt.avail_out)
+        {
+            int err = ::inflate(&m_zlib_cxt, Z_SYNC_FLUSH);
+            if (err == Z_STREAM_END)
+            {
+                m_stream_end = true;
+                break;
+            }
+
+            if (err != Z_OK)
+                throw zip_error("error during inflate.");
+        }
+    }
+
+    bool done() const
+    {
+        return m_stream_end || !m_zlib_cxt.avail_out;
+    }
+
+    size_t avail_out() const
+    {
+        return m_zlib_cxt.avail_out;
     }
 };
 
@@ -173,6 +391,13 @@ public:
         return ret;
     }
 
+    uint64_t read_8bytes()
+    {
+        uint64_t lower = read_4bytes();
+        uint64_t upper = read_4bytes();
+        return lower | (upper << 32);
+    }
+
     uint16_t read_2bytes()
     {
         m_stream->seek(m_pos+m_pos_internal);
@@ -198,15 +423,33 @@ public:
 struct central_dir_end
 {
     uint32_t magic_number;
-    uint16_t this_disk_id;
-    uint16_t central_dir_disk_id;
-    uint16_t num_central_dir_records_local;
-    uint16_t num_celtral_dir_records_total;
-    uint32_t size_central_dir;
+    uint32_t this_disk_id;
+    uint32_t central_dir_disk_id;
+    size_t num_central_dir_records_local;
+    size_t num_central_dir_records_total;
+    size_t size_central_dir;
     size_t central_dir_pos;
     uint16_t comment_length;
 };
 
+/**
+ * Values in the 32-bit (or 16-bit) fields which indicate that the actual
+ * values are stored in the ZIP64 extension.
+ */
+constexpr uint32_t zip64_placeholder_32 = 0xFFFFFFFF;
+constexpr uint16_t zip64_placeholder_16 = 0xFFFF;
+
+/**
+ * Header ID of the ZIP64 extended information extra field.
+ */
+constexpr uint16_t zip64_extra_field_id = 0x0001;
+
+/**
+ * Size of a central directory file header with an empty file name, extra
+ * field and file comment.
+ */
+constexpr size_t central_dir_record_min_size = 46;
+
 } // anonymous namespace
 
 class zip_archive_impl
@@ -218,6 +461,8 @@ class zip_archive_impl
     zip_archive_stream* m_stream;
     off_t m_stream_size;
     size_t m_central_dir_pos;
+    size_t m_num_central_dir_records;
+    zip_inflate_backend_t m_inflate_backend;
 
     zip_stream_parser m_central_dir_end;
 
@@ -228,6 +473,8 @@ public:
     zip_archive_impl(zip_archive_stream* stream);
     ~zip_archive_impl();
 
+    void set_inflate_backend(zip_inflate_backend_t backend);
+
     void load();
     void dump_file_entry(size_t pos) const;
     void dump_file_entry(const char* entry_name) const;
@@ -238,10 +485,30 @@ public:
         return m_file_params.size();
     }
 
+    zip_file_entry_stat get_file_entry_stat(size_t pos) const;
+
     bool read_file_entry(const pstring& entry_name, vector<unsigned char>& buf) const;
 
+    bool read_file_entry(const pstring& entry_name, zip_file_entry_buffer& buf) const;
+
+    bool read_file_entry_head(const pstring& entry_name, vector<unsigned char>& buf, size_t max_size) const;
+
 private:
 
+    const zip_file_param* find_file_param(const pstring& entry_name) const;
+
+    /**
+     * Skip the local file header of a file entry, and return the position
+     * of its data stream which immediately follows the header.
+     */
+    size_t get_data_stream_pos(const zip_file_param& param) const;
+
+    /**
+     * Read the data stream of a file entry into a buffer whose size equals
+     * the uncompressed size of the entry.
+     */
+    void read_file_entry_data(const zip_file_param& param, unsigned char* dest) const;
+
     /**
      * Find the central directory of a zip file, located toward the end before
      * the global comment, and starts with the byte sequence of 0x504b0506.
@@ -249,11 +516,26 @@ private:
     size_t seek_central_dir();
 
     void read_central_dir_end();
+
+    /**
+     * Read the ZIP64 end of central directory record if the archive has
+     * one, and overwrite the values read from the regular end of central
+     * directory record.
+     */
+    void read_zip64_central_dir_end(central_dir_end& content);
+
+    /**
+     * Read the ZIP64 extended information extra field of a central directory
+     * file header, and overwrite the values that are only stored there.
+     */
+    void read_zip64_extra_field(zip_stream_parser& central_dir, zip_file_param& param);
+
     void read_file_entries();
 };
 
 zip_archive_impl::zip_archive_impl(zip_archive_stream* stream) :
-    m_stream(stream), m_stream_size(0), m_central_dir_pos(0)
+    m_stream(stream), m_stream_size(0), m_central_dir_pos(0), m_num_central_dir_records(0),
+    m_inflate_backend(zip_inflate_backend_t::automatic)
 {
     if (!m_stream)
         throw zip_error("null stream is not allowed.");
@@ -265,6 +547,14 @@ zip_archive_impl::~zip_archive_impl()
 {
 }
 
+void zip_archive_impl::set_inflate_backend(zip_inflate_backend_t backend)
+{
+    if (!is_backend_available(backend))
+        throw zip_error("inflate backend is not available.");
+
+    m_inflate_backend = backend;
+}
+
 void zip_archive_impl::load()
 {
     size_t central_dir_end_pos = seek_central_dir();
@@ -283,6 +573,7 @@ void zip_archive_impl::load()
 void zip_archive_impl::read_file_entries()
 {
     m_file_params.clear();
+    m_file_params.reserve(m_num_central_dir_records);
 
     zip_stream_parser central_dir(m_stream, m_central_dir_pos);
     uint32_t magic_num = central_dir.read_4bytes();
@@ -314,8 +605,7 @@ void zip_archive_impl::read_file_entries()
             param.filename = central_dir.read_string(param.filename_length, m_pool);
 
         if (param.extra_field_length)
-            // Ignore extra field for now.
-            central_dir.skip_bytes(param.extra_field_length);
+            read_zip64_extra_field(central_dir, param);
 
         if (param.comment_length)
             // Ignore file comment for now.
@@ -432,22 +722,37 @@ pstring zip_archive_impl::get_file_entry_name(size_t pos) const
     return m_file_params[pos].filename;
 }
 
-bool zip_archive_impl::read_file_entry(const pstring& entry_name, vector<unsigned char>& buf) const
+zip_file_entry_stat zip_archive_impl::get_file_entry_stat(size_t pos) const
 {
-    pstring name(entry_name);
-    filename_map_type::const_iterator it = m_filenames.find(name);
+    if (pos >= m_file_params.size())
+        throw zip_error("file entry index is out of bound.");
+
+    const zip_file_param& param = m_file_params[pos];
+
+    zip_file_entry_stat stat;
+    stat.size_compressed = param.size_compressed;
+    stat.size_uncompressed = param.size_uncompressed;
+    stat.compressed = param.compress_method != zip_file_param::stored;
+    return stat;
+}
+
+const zip_file_param* zip_archive_impl::find_file_param(const pstring& entry_name) const
+{
+    filename_map_type::const_iterator it = m_filenames.find(entry_name);
     if (it == m_filenames.end())
         // entry name not found.
-        return false;
+        return nullptr;
 
     size_t index = it->second;
     if (index >= m_file_params.size())
         // entry index is out of bound.
-        return false;
+        return nullptr;
 
-    const zip_file_param& param = m_file_params[index];
+    return &m_file_params[index];
+}
 
-    // Skip the file header section.
+size_t zip_archive_impl::get_data_stream_pos(const zip_file_param& param) const
+{
     zip_stream_parser file_header(m_stream, param.offset_file_header);
     file_header.skip_bytes(4);
     file_header.skip_bytes(2);
@@ -463,29 +768,146 @@ bool zip_archive_impl::read_file_entry(const pstring& entry_name, vector<unsigne
     file_header.skip_bytes(filename_len);
     file_header.skip_bytes(extra_field_len);
 
-    // Data section is immediately followed by the header section.
-    m_stream->seek(file_header.tell());
+    return file_header.tell();
+}
 
-    vector<unsigned char> raw_buf(param.size_compressed+1, 0);
-    m_stream->read(&raw_buf[0], param.size_compressed);
+void zip_archive_impl::read_file_entry_data(const zip_file_param& param, unsigned char* dest) const
+{
+    // Data section is immediately followed by the header section.
+    m_stream->seek(get_data_stream_pos(param));
 
     switch (param.compress_method)
     {
         case zip_file_param::stored:
+        {
             // Not compressed at all.
+            if (param.size_compressed != param.size_uncompressed)
+                throw zip_error("stored file entry has inconsistent sizes.");
+
+            m_stream->read(dest, param.size_uncompressed);
+            break;
+        }
+        case zip_file_param::deflated:
+        {
+            // deflate compression.  Neither buffer needs initializing as both
+            // get overwritten in full.
+            std::unique_ptr<unsigned char[]> raw_buf(new unsigned char[param.size_compressed]);
+            m_stream->read(raw_buf.get(), param.size_compressed);
+
+            std::unique_ptr<inflate_backend> inflater = create_inflate_backend(m_inflate_backend);
+            inflater->inflate(raw_buf.get(), param.size_compressed, dest, param.size_uncompressed);
+            break;
+        }
+        default:
+            throw zip_error("unsupported compression method.");
+    }
+}
+
+bool zip_archive_impl::read_file_entry(const pstring& entry_name, vector<unsigned char>& buf) const
+{
+    const zip_file_param* p = find_file_param(entry_name);
+    if (!p)
+        return false;
+
+    const zip_file_param& param = *p;
+
+    switch (param.compress_method)
+    {
+        case zip_file_param::stored:
+        case zip_file_param::deflated:
+        {
+            vector<unsigned char> dest(param.size_uncompressed+1); // null-terminated
+            read_file_entry_data(param, dest.data());
+            buf.swap(dest);
+            return true;
+        }
+        default:
+            ;
+    }
+
+    return false;
+}
+
+bool zip_archive_impl::read_file_entry(const pstring& entry_name, zip_file_entry_buffer& buf) const
+{
+    const zip_file_param* p = find_file_param(entry_name);
+    if (!p)
+        return false;
+
+    const zip_file_param& param = *p;
+
+    switch (param.compress_method)
+    {
+        case zip_file_param::stored:
+        case zip_file_param::deflated:
+        {
+            zip_file_entry_buffer dest;
+            dest.allocate(param.size_uncompressed);
+            read_file_entry_data(param, dest.data());
+            buf = std::move(dest);
+            return true;
+        }
+        default:
+            ;
+    }
+
+    return false;
+}
+
+bool zip_archive_impl::read_file_entry_head(
+    const pstring& entry_name, vector<unsigned char>& buf, size_t max_size) const
+{
+    // Size of each chunk of compressed data to read from the stream at a time.
+    constexpr size_t chunk_size = 16 * 1024;
+
+    const zip_file_param* p = find_file_param(entry_name);
+    if (!p)
+        return false;
+
+    const zip_file_param& param = *p;
+    size_t data_pos = get_data_stream_pos(param);
+    size_t size_out = std::min(max_size, param.size_uncompressed);
+
+    switch (param.compress_method)
+    {
+        case zip_file_param::stored:
+        {
+            // Not compressed.  Read only the requested leading segment.
+            vector<unsigned char> raw_buf(size_out);
+            if (size_out)
+            {
+                m_stream->seek(data_pos);
+                m_stream->read(&raw_buf[0], size_out);
+            }
             buf.swap(raw_buf);
             return true;
+        }
         case zip_file_param::deflated:
         {
-            // deflate compression
-            vector<unsigned char> zip_buf(param.size_uncompressed+1, 0); // null-terminated
-            zip_inflater inflater(raw_buf, zip_buf, param);
+            vector<unsigned char> zip_buf(size_out);
+            if (!size_out)
+            {
+                buf.swap(zip_buf);
+                return true;
+            }
+
+            zip_chunk_inflater inflater(&zip_buf[0], zip_buf.size());
             if (!inflater.init())
                 break;
 
-            if (!inflater.inflate())
-                throw zip_error("error during inflate.");
+            vector<unsigned char> raw_buf(std::min(chunk_size, param.size_compressed));
+            size_t read_size = 0;
 
+            while (!inflater.done() && read_size < param.size_compressed)
+            {
+                size_t n = std::min(raw_buf.size(), param.size_compressed - read_size);
+                m_stream->seek(data_pos + read_size);
+                m_stream->read(&raw_buf[0], n);
+                read_size += n;
+                inflater.inflate(&raw_buf[0], n);
+            }
+
+            zip_buf.resize(size_out - inflater.avail_out());
             buf.swap(zip_buf);
             return true;
         }
@@ -557,20 +979,31 @@ void zip_archive_impl::read_central_dir_end()
     content.this_disk_id = m_central_dir_end.read_2bytes();
     content.central_dir_disk_id = m_central_dir_end.read_2bytes();
     content.num_central_dir_records_local = m_central_dir_end.read_2bytes();
-    content.num_celtral_dir_records_total = m_central_dir_end.read_2bytes();
+    content.num_central_dir_records_total = m_central_dir_end.read_2bytes();
     content.size_central_dir = m_central_dir_end.read_4bytes();
     content.central_dir_pos = m_central_dir_end.read_4bytes();
-    m_central_dir_pos = content.central_dir_pos;
-
     content.comment_length = m_central_dir_end.read_2bytes();
 
+    read_zip64_central_dir_end(content);
+
+    // Both values may come from the 8-byte fields of the ZIP64 record.
+    // Make sure they are plausible before anything gets allocated from them.
+    if (content.size_central_dir > size_t(m_stream->size()))
+        throw zip_error("size of the central directory exceeds the size of the stream.");
+
+    if (content.num_central_dir_records_total > content.size_central_dir / central_dir_record_min_size)
+        throw zip_error("number of central directory records exceeds the size of the central directory.");
+
+    m_central_dir_pos = content.central_dir_pos;
+    m_num_central_dir_records = content.num_central_dir_records_total;
+
 #if ORCUS_DEBUG_ZIP_ARCHIVE
     cout << "-- central directory content" << endl;
     printf("  magic number: 0x%8.8x\n", content.magic_number);
     cout << "  number of this disk: " << content.this_disk_id << endl;
     cout << "  disk where central directory starts: " << content.central_dir_disk_id << endl;
     cout << "  number of central directory records on this disk: " << content.num_central_dir_records_local << endl;
-    cout << "  total number of central directory records: " << content.num_celtral_dir_records_total << endl;
+    cout << "  total number of central directory records: " << content.num_central_dir_records_total << endl;
     cout << "  size of central directory: " << content.size_central_dir << endl;
     cout << "  offset of start of central directory, relative to start of archive: " << content.central_dir_pos << endl;
     cout << "  comment length: " << content.comment_length << endl;
@@ -578,6 +1011,129 @@ void zip_archive_impl::read_central_dir_end()
 #endif
 }
 
+void zip_archive_impl::read_zip64_central_dir_end(central_dir_end& content)
+{
+    // The ZIP64 end of central directory locator, if any, immediately
+    // precedes the regular end of central directory record.
+    constexpr size_t locator_size = 20;
+
+    size_t central_dir_end_pos = m_central_dir_end.tell() - 22;
+    if (central_dir_end_pos < locator_size)
+        return;
+
+    zip_stream_parser locator(m_stream, central_dir_end_pos - locator_size);
+    if (locator.read_4bytes() != 0x07064b50)
+        return;
+
+    locator.skip_bytes(4); // disk where the ZIP64 end of central directory starts
+    size_t record_pos = locator.read_8bytes();
+
+    if (record_pos >= central_dir_end_pos - locator_size)
+        throw zip_error("invalid position of the zip64 end of central directory record.");
+
+    zip_stream_parser record(m_stream, record_pos);
+    if (record.read_4bytes() != 0x06064b50)
+        throw zip_error("zip64 end of central directory record not found.");
+
+    record.skip_bytes(8); // size of this record
+    record.skip_bytes(2); // version made by
+    record.skip_bytes(2); // version needed to extract
+    content.this_disk_id = record.read_4bytes();
+    content.central_dir_disk_id = record.read_4bytes();
+    content.num_central_dir_records_local = record.read_8bytes();
+    content.num_central_dir_records_total = record.read_8bytes();
+    content.size_central_dir = record.read_8bytes();
+    content.central_dir_pos = record.read_8bytes();
+
+    if (content.central_dir_pos >= record_pos)
+        throw zip_error("invalid position of the central directory.");
+}
+
+void zip_archive_impl::read_zip64_extra_field(zip_stream_parser& central_dir, zip_file_param& param)
+{
+    size_t end_pos = central_dir.tell() + param.extra_field_length;
+
+    while (central_dir.tell() + 4 <= end_pos)
+    {
+        uint16_t header_id = central_dir.read_2bytes();
+        uint16_t data_size = central_dir.read_2bytes();
+        size_t data_end_pos = central_dir.tell() + data_size;
+
+        if (data_end_pos > end_pos)
+            // Malformed block.  Skip the rest of the extra field, as if it
+            // contained no blocks.
+            break;
+
+        if (header_id == zip64_extra_field_id)
+        {
+            // Only the values whose regular fields are set to the
+            // placeholder are present, always in this order.  A value that
+            // doesn't fit in the block is left as the placeholder.
+            auto read_value = [&](size_t& value, size_t placeholder)
+            {
+                if (value != placeholder || central_dir.tell() + 8 > data_end_pos)
+                    return;
+
+                value = central_dir.read_8bytes();
+            };
+
+            read_value(param.size_uncompressed, zip64_placeholder_32);
+            read_value(param.size_compressed, zip64_placeholder_32);
+            read_value(param.offset_file_header, zip64_placeholder_32);
+
+            if (param.disk_id_where_file_starts == zip64_placeholder_16 && central_dir.tell() + 4 <= data_end_pos)
+                central_dir.read_4bytes(); // orcus doesn't support multi-disk archives.
+        }
+
+        central_dir.skip_bytes(data_end_pos - central_dir.tell());
+    }
+
+    // Skip whatever remains, which is too short to form a block.
+    central_dir.skip_bytes(end_pos - central_dir.tell());
+}
+
+zip_file_entry_buffer::zip_file_entry_buffer() : m_size(0) {}
+
+zip_file_entry_buffer::zip_file_entry_buffer(zip_file_entry_buffer&& other) :
+    m_data(std::move(other.m_data)), m_size(other.m_size)
+{
+    other.m_size = 0;
+}
+
+zip_file_entry_buffer::~zip_file_entry_buffer() {}
+
+zip_file_entry_buffer& zip_file_entry_buffer::operator= (zip_file_entry_buffer&& other)
+{
+    m_data = std::move(other.m_data);
+    m_size = other.m_size;
+    other.m_size = 0;
+    return *this;
+}
+
+void zip_file_entry_buffer::allocate(size_t size)
+{
+    m_data.reset(new unsigned char[size+1]);
+    m_data[size] = '\0';
+    m_size = size;
+}
+
+void zip_file_entry_buffer::truncate(size_t size)
+{
+    if (size > m_size)
+        throw std::out_of_range("new size exceeds the current size.");
+
+    if (m_data)
+        m_data[size] = '\0';
+
+    m_size = size;
+}
+
+void zip_file_entry_buffer::clear()
+{
+    m_data.reset();
+    m_size = 0;
+}
+
 zip_archive::zip_archive(zip_archive_stream* stream) :
     mp_impl(new zip_archive_impl(stream))
 {
@@ -588,6 +1144,16 @@ zip_archive::~zip_archive()
     delete mp_impl;
 }
 
+bool zip_archive::is_inflate_backend_available(zip_inflate_backend_t backend)
+{
+    return is_backend_available(backend);
+}
+
+void zip_archive::set_inflate_backend(zip_inflate_backend_t backend)
+{
+    mp_impl->set_inflate_backend(backend);
+}
+
 void zip_archive::load()
 {
     mp_impl->load();
@@ -613,10 +1179,28 @@ size_t zip_archive::get_file_entry_count() const
     return mp_impl->get_file_entry_count();
 }
 
+zip_file_entry_stat zip_archive::get_file_entry_stat(size_t index) const
+{
+    return mp_impl->get_file_entry_stat(index);
+}
+
 bool zip_archive::read_file_entry(const pstring& entry_name, vector<unsigned char>& buf) const
 {
+    ORCUS_TRACE_SPAN("zip", "zip_archive::read_file_entry");
     return mp_impl->read_file_entry(entry_name, buf);
 }
 
+bool zip_archive::read_file_entry(const pstring& entry_name, zip_file_entry_buffer& buf) const
+{
+    ORCUS_TRACE_SPAN("zip", "zip_archive::read_file_entry");
+    return mp_impl->read_file_entry(entry_name, buf);
+}
+
+bool zip_archive::read_file_entry_head(
+    const pstring& entry_name, vector<unsigned char>& buf, size_t max_size) const
+{
+    return mp_impl->read_file_entry_head(entry_name, buf, max_size);
+}
+
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
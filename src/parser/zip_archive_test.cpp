@@ -7,10 +7,14 @@
 
 #include "test_global.hpp"
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <string>
 #include <vector>
 
 #include "orcus/zip_archive_stream.hpp"
+#include "orcus/zip_archive.hpp"
+#include "orcus/pstring.hpp"
 
 #define ASSERT_THROW(expr) \
 try \
@@ -58,9 +62,381 @@ void test_zip_archive_stream_blob()
     test_zip_archive_stream(&strm, data, sizeof(data));
 }
 
+/**
+ * Small zip archive containing a stored 'mimetype' entry and a deflated
+ * 'content.xml' entry.
+ */
+const unsigned char zip_data[] = {
+    0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x00, 0x85, 0x6c,
+    0x39, 0x8a, 0x2e, 0x00, 0x00, 0x00, 0x2e, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x6d, 0x69,
+    0x6d, 0x65, 0x74, 0x79, 0x70, 0x65, 0x61, 0x70, 0x70, 0x6c, 0x69, 0x63, 0x61, 0x74, 0x69, 0x6f,
+    0x6e, 0x2f, 0x76, 0x6e, 0x64, 0x2e, 0x6f, 0x61, 0x73, 0x69, 0x73, 0x2e, 0x6f, 0x70, 0x65, 0x6e,
+    0x64, 0x6f, 0x63, 0x75, 0x6d, 0x65, 0x6e, 0x74, 0x2e, 0x73, 0x70, 0x72, 0x65, 0x61, 0x64, 0x73,
+    0x68, 0x65, 0x65, 0x74, 0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x57, 0x48,
+    0x52, 0x5d, 0x7e, 0xdf, 0x4f, 0xd3, 0x65, 0x01, 0x00, 0x00, 0x9f, 0x06, 0x00, 0x00, 0x0b, 0x00,
+    0x00, 0x00, 0x63, 0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 0x2e, 0x78, 0x6d, 0x6c, 0x6d, 0x95, 0xed,
+    0x4a, 0x03, 0x41, 0x0c, 0x45, 0x5f, 0xa5, 0xf4, 0x01, 0xec, 0xe4, 0x63, 0x66, 0x76, 0x60, 0xdd,
+    0x3e, 0x4c, 0x29, 0x28, 0xa8, 0x85, 0x56, 0xd4, 0xc7, 0xb7, 0x6c, 0x52, 0x41, 0xf6, 0xfc, 0xdd,
+    0x4b, 0x9a, 0xe4, 0xcc, 0xbd, 0xe9, 0x7c, 0xfc, 0x79, 0x7f, 0xdb, 0x7d, 0x9d, 0xaf, 0xb7, 0xd7,
+    0xcb, 0xc7, 0xf3, 0x5e, 0x9e, 0xca, 0xfe, 0xb8, 0xcc, 0xb7, 0x97, 0xf3, 0xf9, 0x73, 0x99, 0xaf,
+    0x97, 0xef, 0xdd, 0xf5, 0xfe, 0x71, 0xbf, 0xcc, 0xa7, 0x45, 0xe6, 0xc3, 0x69, 0x99, 0x0f, 0xf7,
+    0x6f, 0x7f, 0x82, 0xae, 0x82, 0x6f, 0x05, 0x5b, 0x85, 0xb1, 0x15, 0x3c, 0x7e, 0xaa, 0x6d, 0x95,
+    0xba, 0x2a, 0x5a, 0xb7, 0x4a, 0x5b, 0x15, 0x83, 0x9a, 0x1e, 0xfd, 0xa1, 0xcf, 0xb4, 0x2a, 0x0d,
+    0x46, 0x1b, 0xab, 0x32, 0xc1, 0x36, 0x52, 0x62, 0xb8, 0x52, 0x40, 0x4b, 0x06, 0x4a, 0x75, 0x81,
+    0x41, 0x1c, 0xba, 0x89, 0xe5, 0xc2, 0x30, 0xa3, 0x24, 0x8c, 0x01, 0x9b, 0x49, 0xe2, 0x20, 0x1e,
+    0xd2, 0x12, 0x15, 0xd5, 0x05, 0x12, 0x9d, 0xa8, 0x5f, 0x40, 0x31, 0xa5, 0x39, 0x47, 0x42, 0xa6,
+    0x57, 0x0e, 0x2e, 0x4e, 0x5c, 0x34, 0xb8, 0xb8, 0x53, 0x5d, 0xda, 0x63, 0x82, 0x7e, 0x1a, 0x5c,
+    0xaa, 0xc2, 0x9c, 0x1a, 0x5c, 0x6a, 0x87, 0xfd, 0x34, 0xb8, 0x34, 0xe2, 0xa2, 0xc1, 0xa5, 0x61,
+    0x5d, 0x70, 0xe9, 0xd8, 0x2f, 0xb8, 0x74, 0x9c, 0x33, 0xed, 0x42, 0xfb, 0x59, 0x70, 0x19, 0xc4,
+    0xc5, 0x82, 0xcb, 0x20, 0x9e, 0x96, 0x7e, 0x29, 0xf4, 0x10, 0x96, 0x86, 0x29, 0xf4, 0x82, 0x96,
+    0x8e, 0x11, 0x7a, 0x7a, 0xab, 0x69, 0x51, 0x62, 0x63, 0x2d, 0x45, 0x32, 0x9b, 0x05, 0x1c, 0x31,
+    0x72, 0xa9, 0x4d, 0x0f, 0x77, 0xd3, 0xb4, 0x81, 0x47, 0x2a, 0xe5, 0xc2, 0x33, 0x4f, 0x8d, 0x00,
+    0x79, 0x06, 0xaa, 0x51, 0x12, 0x3d, 0x09, 0x75, 0x0a, 0xb0, 0x27, 0xa1, 0x89, 0x72, 0xef, 0x8f,
+    0x4c, 0xd1, 0xb9, 0xf0, 0x0c, 0x55, 0x21, 0x42, 0x9e, 0xa9, 0x12, 0x3a, 0x4e, 0x9e, 0xb1, 0xd2,
+    0x42, 0x3d, 0x83, 0x90, 0x5a, 0xa1, 0x69, 0x83, 0x90, 0x7a, 0x81, 0x3d, 0x6b, 0xc9, 0x24, 0x13,
+    0xa1, 0x1a, 0x84, 0xb4, 0x61, 0x65, 0x10, 0xd2, 0x4e, 0x3d, 0xab, 0xe5, 0x11, 0xa0, 0x69, 0x6b,
+    0x10, 0xd2, 0x81, 0x47, 0x38, 0x08, 0x19, 0x12, 0xaa, 0x79, 0x88, 0x85, 0xd8, 0xd6, 0xfe, 0x38,
+    0x2e, 0xd4, 0x33, 0x2f, 0x8f, 0xd1, 0x7b, 0xd6, 0x3c, 0x3d, 0xfe, 0xcf, 0x09, 0x87, 0xf8, 0x0b,
+    0xfa, 0x05, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x21, 0x00, 0x85, 0x6c, 0x39, 0x8a, 0x2e, 0x00, 0x00, 0x00, 0x2e, 0x00, 0x00, 0x00, 0x08, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x6d, 0x69, 0x6d, 0x65, 0x74, 0x79, 0x70, 0x65, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00,
+    0x00, 0x00, 0x08, 0x00, 0x57, 0x48, 0x52, 0x5d, 0x7e, 0xdf, 0x4f, 0xd3, 0x65, 0x01, 0x00, 0x00,
+    0x9f, 0x06, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x80, 0x01, 0x54, 0x00, 0x00, 0x00, 0x63, 0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 0x2e, 0x78, 0x6d,
+    0x6c, 0x50, 0x4b, 0x05, 0x06, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x02, 0x00, 0x6f, 0x00, 0x00,
+    0x00, 0xe2, 0x01, 0x00, 0x00, 0x00, 0x00,
+};
+
+void test_zip_archive_file_entry_head()
+{
+    zip_archive_stream_blob strm(zip_data, sizeof(zip_data));
+    zip_archive archive(&strm);
+    archive.load();
+
+    size_t n = archive.get_file_entry_count();
+    assert(n == 2);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        pstring name = archive.get_file_entry_name(i);
+        zip_file_entry_stat stat = archive.get_file_entry_stat(i);
+        assert(stat.compressed == (name == "content.xml"));
+
+        std::vector<unsigned char> full;
+        assert(archive.read_file_entry(name, full));
+        assert(full.size() >= stat.size_uncompressed);
+
+        // Leading segment must match the head of the full stream.
+        for (size_t max_size : { size_t(0), size_t(1), size_t(37), size_t(512), stat.size_uncompressed + 10 })
+        {
+            std::vector<unsigned char> head;
+            assert(archive.read_file_entry_head(name, head, max_size));
+            assert(head.size() == std::min(max_size, stat.size_uncompressed));
+            assert(equal(head.begin(), head.end(), full.begin()));
+        }
+    }
+
+    std::vector<unsigned char> head;
+    assert(archive.read_file_entry_head("mimetype", head, 11));
+    assert(pstring(reinterpret_cast<const char*>(head.data()), head.size()) == "application");
+
+    assert(!archive.read_file_entry_head("no-such-entry", head, 10));
+    ASSERT_THROW(archive.get_file_entry_stat(n));
+}
+
+void test_zip_archive_file_entry_buffer()
+{
+    zip_archive_stream_blob strm(zip_data, sizeof(zip_data));
+    zip_archive archive(&strm);
+    archive.load();
+
+    assert(zip_archive::is_inflate_backend_available(zip_inflate_backend_t::automatic));
+    assert(zip_archive::is_inflate_backend_available(zip_inflate_backend_t::zlib));
+
+    for (zip_inflate_backend_t backend : { zip_inflate_backend_t::automatic, zip_inflate_backend_t::zlib, zip_inflate_backend_t::libdeflate })
+    {
+        if (!zip_archive::is_inflate_backend_available(backend))
+        {
+            ASSERT_THROW(archive.set_inflate_backend(backend));
+            continue;
+        }
+
+        archive.set_inflate_backend(backend);
+
+        for (size_t i = 0; i < archive.get_file_entry_count(); ++i)
+        {
+            pstring name = archive.get_file_entry_name(i);
+            zip_file_entry_stat stat = archive.get_file_entry_stat(i);
+
+            // The vector variant includes the null terminator in its size.
+            std::vector<unsigned char> expected;
+            assert(archive.read_file_entry(name, expected));
+            assert(expected.size() == stat.size_uncompressed + 1);
+            assert(expected.back() == '\0');
+
+            zip_file_entry_buffer buf;
+            assert(archive.read_file_entry(name, buf));
+            assert(buf.size() == stat.size_uncompressed);
+            assert(buf.data()[buf.size()] == '\0');
+            assert(equal(buf.data(), buf.data() + buf.size(), expected.begin()));
+        }
+    }
+
+    zip_file_entry_buffer buf;
+    assert(!archive.read_file_entry("no-such-entry", buf));
+
+    buf.allocate(10);
+    assert(buf.size() == 10);
+    buf.truncate(4);
+    assert(buf.size() == 4);
+    assert(buf[4] == '\0');
+    ASSERT_THROW(buf.truncate(5));
+
+    zip_file_entry_buffer moved(std::move(buf));
+    assert(moved.size() == 4);
+    assert(buf.empty());
+
+    // Record a wrong uncompressed size for 'content.xml' in the central
+    // directory.  Inflating it must fail rather than return partial data.
+    std::vector<unsigned char> bad_data(zip_data, zip_data + sizeof(zip_data));
+    assert(bad_data[560] == 0x9f && bad_data[561] == 0x06);
+    bad_data[560] = 0xa0;
+
+    zip_archive_stream_blob bad_strm(bad_data.data(), bad_data.size());
+    zip_archive bad_archive(&bad_strm);
+    bad_archive.load();
+
+    std::vector<unsigned char> vec;
+    ASSERT_THROW(bad_archive.read_file_entry("content.xml", vec));
+    ASSERT_THROW(bad_archive.read_file_entry("content.xml", buf));
+    assert(bad_archive.read_file_entry("mimetype", buf));
+}
+
+/**
+ * Builds a zip archive in memory, one little-endian value at a time.
+ */
+class zip_builder
+{
+    std::vector<unsigned char> m_buf;
+
+public:
+    void add(uint64_t v, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i, v >>= 8)
+            m_buf.push_back(v & 0xFF);
+    }
+
+    void add(const std::string& s)
+    {
+        m_buf.insert(m_buf.end(), s.begin(), s.end());
+    }
+
+    size_t size() const { return m_buf.size(); }
+
+    const std::vector<unsigned char>& get() const { return m_buf; }
+};
+
+uint32_t calc_crc32(const std::string& s)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (unsigned char c : s)
+    {
+        crc ^= c;
+        for (int i = 0; i < 8; ++i)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+/**
+ * Archive whose sizes and offsets are only stored in the ZIP64 extensions,
+ * i.e. the ZIP64 extra fields of the central directory file headers and the
+ * ZIP64 end of central directory record.
+ */
+void test_zip_archive_zip64()
+{
+    struct entry
+    {
+        std::string name;
+        std::string content;
+        bool zip64;
+        size_t offset;
+    };
+
+    std::vector<entry> entries = {
+        { "zip64.txt", "Content whose sizes are in the ZIP64 extra field.", true, 0 },
+        { "regular.txt", "Content whose sizes are in the regular fields.", false, 0 },
+    };
+
+    zip_builder zb;
+
+    for (entry& e : entries)
+    {
+        e.offset = zb.size();
+
+        zb.add(0x04034b50, 4); // local file header signature
+        zb.add(45, 2); // version needed to extract
+        zb.add(0, 2); // general purpose bit flag
+        zb.add(0, 2); // compression method (stored)
+        zb.add(0, 2); // last modified time
+        zb.add(0x21, 2); // last modified date
+        zb.add(calc_crc32(e.content), 4);
+        zb.add(e.zip64 ? 0xFFFFFFFF : e.content.size(), 4); // compressed size
+        zb.add(e.zip64 ? 0xFFFFFFFF : e.content.size(), 4); // uncompressed size
+        zb.add(e.name.size(), 2);
+        zb.add(e.zip64 ? 20 : 0, 2); // extra field length
+        zb.add(e.name);
+
+        if (e.zip64)
+        {
+            zb.add(0x0001, 2);
+            zb.add(16, 2);
+            zb.add(e.content.size(), 8);
+            zb.add(e.content.size(), 8);
+        }
+
+        zb.add(e.content);
+    }
+
+    size_t central_dir_pos = zb.size();
+
+    for (const entry& e : entries)
+    {
+        zb.add(0x02014b50, 4); // central directory file header signature
+        zb.add(45, 2); // version made by
+        zb.add(45, 2); // version needed to extract
+        zb.add(0, 2); // general purpose bit flag
+        zb.add(0, 2); // compression method (stored)
+        zb.add(0, 2); // last modified time
+        zb.add(0x21, 2); // last modified date
+        zb.add(calc_crc32(e.content), 4);
+        zb.add(e.zip64 ? 0xFFFFFFFF : e.content.size(), 4); // compressed size
+        zb.add(e.zip64 ? 0xFFFFFFFF : e.content.size(), 4); // uncompressed size
+        zb.add(e.name.size(), 2);
+        zb.add(e.zip64 ? 9 + 28 : 0, 2); // extra field length
+        zb.add(0, 2); // file comment length
+        zb.add(0, 2); // disk number where file starts
+        zb.add(0, 2); // internal file attributes
+        zb.add(0, 4); // external file attributes
+        zb.add(e.zip64 ? 0xFFFFFFFF : e.offset, 4);
+        zb.add(e.name);
+
+        if (e.zip64)
+        {
+            // Unrelated extended timestamp block preceding the ZIP64 one.
+            zb.add(0x5455, 2);
+            zb.add(5, 2);
+            zb.add(1, 1);
+            zb.add(0, 4);
+
+            zb.add(0x0001, 2);
+            zb.add(24, 2);
+            zb.add(e.content.size(), 8);
+            zb.add(e.content.size(), 8);
+            zb.add(e.offset, 8);
+        }
+    }
+
+    size_t central_dir_size = zb.size() - central_dir_pos;
+    size_t zip64_end_pos = zb.size();
+
+    zb.add(0x06064b50, 4); // zip64 end of central directory signature
+    zb.add(44, 8); // size of the rest of this record
+    zb.add(45, 2); // version made by
+    zb.add(45, 2); // version needed to extract
+    zb.add(0, 4); // number of this disk
+    zb.add(0, 4); // disk where central directory starts
+    zb.add(entries.size(), 8);
+    zb.add(entries.size(), 8);
+    zb.add(central_dir_size, 8);
+    zb.add(central_dir_pos, 8);
+
+    zb.add(0x07064b50, 4); // zip64 end of central directory locator signature
+    zb.add(0, 4); // disk where zip64 end of central directory starts
+    zb.add(zip64_end_pos, 8);
+    zb.add(1, 4); // total number of disks
+
+    zb.add(0x06054b50, 4); // end of central directory signature
+    zb.add(0xFFFF, 2);
+    zb.add(0xFFFF, 2);
+    zb.add(0xFFFF, 2);
+    zb.add(0xFFFF, 2);
+    zb.add(0xFFFFFFFF, 4);
+    zb.add(0xFFFFFFFF, 4);
+    zb.add(0, 2); // comment length
+
+    const std::vector<unsigned char>& data = zb.get();
+    zip_archive_stream_blob strm(data.data(), data.size());
+    zip_archive archive(&strm);
+    archive.load();
+
+    assert(archive.get_file_entry_count() == entries.size());
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const entry& e = entries[i];
+        assert(archive.get_file_entry_name(i) == e.name);
+
+        zip_file_entry_stat stat = archive.get_file_entry_stat(i);
+        assert(stat.size_uncompressed == e.content.size());
+        assert(stat.size_compressed == e.content.size());
+        assert(!stat.compressed);
+
+        zip_file_entry_buffer buf;
+        assert(archive.read_file_entry(e.name, buf));
+        assert(std::string(reinterpret_cast<const char*>(buf.data()), buf.size()) == e.content);
+    }
+
+    {
+        // A malformed extra field block gets skipped along with the rest of
+        // the extra field.  The sizes of the entry are then unknown, but the
+        // other entries can still be read.
+        std::vector<unsigned char> bad_data = data;
+        size_t block_size_pos = central_dir_pos + 46 + entries[0].name.size() + 2;
+        assert(bad_data[block_size_pos] == 5 && bad_data[block_size_pos+1] == 0);
+        bad_data[block_size_pos] = 0xFF;
+
+        zip_archive_stream_blob bad_strm(bad_data.data(), bad_data.size());
+        zip_archive bad_archive(&bad_strm);
+        bad_archive.load();
+
+        assert(bad_archive.get_file_entry_count() == entries.size());
+        assert(bad_archive.get_file_entry_stat(0).size_uncompressed == 0xFFFFFFFF);
+
+        zip_file_entry_buffer buf;
+        assert(bad_archive.read_file_entry(entries[1].name, buf));
+        assert(std::string(reinterpret_cast<const char*>(buf.data()), buf.size()) == entries[1].content);
+    }
+
+    {
+        // Record a huge number of central directory records in the ZIP64
+        // end of central directory record.
+        std::vector<unsigned char> bad_data = data;
+        for (size_t i = 0; i < 16; ++i)
+            bad_data[zip64_end_pos + 24 + i] = 0x7F;
+
+        zip_archive_stream_blob bad_strm(bad_data.data(), bad_data.size());
+        zip_archive bad_archive(&bad_strm);
+
+        try
+        {
+            bad_archive.load();
+            assert(!"zip_error was expected");
+        }
+        catch (const zip_error&)
+        {
+            // expected.
+        }
+    }
+}
+
 int main()
 {
     test_zip_archive_stream_blob();
+    test_zip_archive_file_entry_head();
+    test_zip_archive_file_entry_buffer();
+    test_zip_archive_zip64();
 
     return EXIT_SUCCESS;
 }
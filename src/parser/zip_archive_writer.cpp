@@ -0,0 +1,343 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/zip_archive_writer.hpp"
+#include "orcus/zip_archive.hpp"
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+
+#include <zlib.h>
+
+namespace orcus {
+
+namespace {
+
+constexpr uint32_t sig_local_file_header = 0x04034b50;
+constexpr uint32_t sig_central_dir_header = 0x02014b50;
+constexpr uint32_t sig_end_central_dir = 0x06054b50;
+
+constexpr uint16_t version_needed = 20; // 2.0, for deflate.
+constexpr uint16_t flag_utf8_name = 0x0800;
+constexpr uint16_t method_deflated = 8;
+
+// Timestamps are fixed at 1980-01-01 00:00:00, the earliest date the zip
+// format can represent, so that the output only depends on the content.
+constexpr uint16_t dos_time = 0;
+constexpr uint16_t dos_date = (1 << 5) | 1;
+
+constexpr size_t buffer_size = 64 * 1024;
+
+/**
+ * Stream buffer that compresses the content written to it in chunks.
+ */
+class deflate_buffer : public std::streambuf
+{
+    z_stream m_zs;
+    std::vector<char> m_in;
+    std::string m_out;
+    uint32_t m_crc;
+    uint64_t m_size;
+    bool m_finished;
+
+    void deflate_chunk(const char* p, size_t n, int flush)
+    {
+        m_crc = crc32(m_crc, reinterpret_cast<const Bytef*>(p), n);
+        m_size += n;
+
+        m_zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(p));
+        m_zs.avail_in = n;
+
+        do
+        {
+            size_t pos = m_out.size();
+            m_out.resize(pos + buffer_size);
+            m_zs.next_out = reinterpret_cast<Bytef*>(&m_out[pos]);
+            m_zs.avail_out = buffer_size;
+
+            if (::deflate(&m_zs, flush) == Z_STREAM_ERROR)
+                throw zip_error("failed to deflate a file entry.");
+
+            m_out.resize(pos + buffer_size - m_zs.avail_out);
+        }
+        while (m_zs.avail_out == 0);
+    }
+
+    void deflate_pending(int flush)
+    {
+        deflate_chunk(pbase(), pptr() - pbase(), flush);
+        setp(m_in.data(), m_in.data() + m_in.size());
+    }
+
+protected:
+    virtual int_type overflow(int_type c) override
+    {
+        if (m_finished)
+            return traits_type::eof();
+
+        deflate_pending(Z_NO_FLUSH);
+
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+    }
+
+    virtual std::streamsize xsputn(const char* p, std::streamsize n) override
+    {
+        if (m_finished)
+            return 0;
+
+        if (n < epptr() - pptr())
+        {
+            std::memcpy(pptr(), p, n);
+            pbump(n);
+            return n;
+        }
+
+        // Large enough to bypass the buffer.
+        deflate_pending(Z_NO_FLUSH);
+        deflate_chunk(p, n, Z_NO_FLUSH);
+        return n;
+    }
+
+public:
+    deflate_buffer() : m_in(buffer_size), m_crc(crc32(0, nullptr, 0)), m_size(0), m_finished(false)
+    {
+        std::memset(&m_zs, 0, sizeof(m_zs));
+
+        // Raw deflate stream without the zlib header, as the zip format
+        // expects.
+        int err = deflateInit2(
+            &m_zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        if (err != Z_OK)
+            throw zip_error("failed to initialize the deflater.");
+
+        setp(m_in.data(), m_in.data() + m_in.size());
+    }
+
+    virtual ~deflate_buffer() override
+    {
+        deflateEnd(&m_zs);
+    }
+
+    void finish()
+    {
+        if (m_finished)
+            return;
+
+        deflate_pending(Z_FINISH);
+        m_finished = true;
+        setp(nullptr, nullptr);
+
+        std::vector<char>().swap(m_in);
+    }
+
+    const std::string& get_output() const { return m_out; }
+    uint32_t get_crc() const { return m_crc; }
+    uint64_t get_size() const { return m_size; }
+};
+
+void write_uint16(std::ostream& os, uint16_t v)
+{
+    char buf[2] = { char(v & 0xFF), char((v >> 8) & 0xFF) };
+    os.write(buf, 2);
+}
+
+void write_uint32(std::ostream& os, uint32_t v)
+{
+    char buf[4];
+    for (int i = 0; i < 4; ++i, v >>= 8)
+        buf[i] = char(v & 0xFF);
+    os.write(buf, 4);
+}
+
+uint32_t to_uint32(uint64_t v, const char* what)
+{
+    if (v > std::numeric_limits<uint32_t>::max())
+    {
+        std::ostringstream os;
+        os << what << " exceeds the limit of the zip format without the ZIP64 extension.";
+        throw zip_error(os.str());
+    }
+
+    return v;
+}
+
+struct entry_info
+{
+    std::string name;
+    uint32_t crc;
+    uint32_t size_compressed;
+    uint32_t size_uncompressed;
+    uint32_t offset;
+};
+
+}
+
+struct zip_entry_deflater::impl
+{
+    std::string name;
+    deflate_buffer buf;
+    std::ostream stream;
+
+    impl(std::string _name) : name(std::move(_name)), stream(&buf) {}
+};
+
+zip_entry_deflater::zip_entry_deflater(std::string name) :
+    mp_impl(std::make_unique<impl>(std::move(name))) {}
+
+zip_entry_deflater::zip_entry_deflater(zip_entry_deflater&& other) :
+    mp_impl(std::move(other.mp_impl)) {}
+
+zip_entry_deflater::~zip_entry_deflater() {}
+
+const std::string& zip_entry_deflater::get_name() const
+{
+    return mp_impl->name;
+}
+
+std::ostream& zip_entry_deflater::get_stream()
+{
+    return mp_impl->stream;
+}
+
+void zip_entry_deflater::finish()
+{
+    mp_impl->buf.finish();
+}
+
+struct zip_archive_writer::impl
+{
+    std::ostream& os;
+    uint64_t offset; // number of bytes written so far.
+    std::vector<entry_info> entries;
+    bool closed;
+
+    impl(std::ostream& _os) : os(_os), offset(0), closed(false) {}
+
+    void write_bytes(const char* p, size_t n)
+    {
+        os.write(p, n);
+        offset += n;
+    }
+
+    void write_entry(const std::string& name, const deflate_buffer& buf)
+    {
+        if (closed)
+            throw zip_error("cannot add a file entry to a closed archive.");
+
+        if (name.size() > std::numeric_limits<uint16_t>::max())
+            throw zip_error("file entry name is too long.");
+
+        entry_info entry;
+        entry.name = name;
+        entry.crc = buf.get_crc();
+        entry.size_compressed = to_uint32(buf.get_output().size(), "compressed size of a file entry");
+        entry.size_uncompressed = to_uint32(buf.get_size(), "size of a file entry");
+        entry.offset = to_uint32(offset, "offset of a file entry");
+
+        write_uint32(os, sig_local_file_header);
+        write_uint16(os, version_needed);
+        write_uint16(os, flag_utf8_name);
+        write_uint16(os, method_deflated);
+        write_uint16(os, dos_time);
+        write_uint16(os, dos_date);
+        write_uint32(os, entry.crc);
+        write_uint32(os, entry.size_compressed);
+        write_uint32(os, entry.size_uncompressed);
+        write_uint16(os, name.size());
+        write_uint16(os, 0); // extra field length
+        offset += 30;
+
+        write_bytes(name.data(), name.size());
+        write_bytes(buf.get_output().data(), buf.get_output().size());
+
+        entries.push_back(std::move(entry));
+    }
+};
+
+zip_archive_writer::zip_archive_writer(std::ostream& os) :
+    mp_impl(std::make_unique<impl>(os)) {}
+
+zip_archive_writer::~zip_archive_writer() {}
+
+void zip_archive_writer::add_file_entry(const std::string& name, const char* p, size_t n)
+{
+    deflate_buffer buf;
+    buf.sputn(p, n);
+    buf.finish();
+    mp_impl->write_entry(name, buf);
+}
+
+void zip_archive_writer::add_file_entry(zip_entry_deflater& entry)
+{
+    entry.finish();
+    mp_impl->write_entry(entry.mp_impl->name, entry.mp_impl->buf);
+}
+
+void zip_archive_writer::close()
+{
+    if (mp_impl->closed)
+        return;
+
+    std::ostream& os = mp_impl->os;
+    const std::vector<entry_info>& entries = mp_impl->entries;
+
+    if (entries.size() > std::numeric_limits<uint16_t>::max())
+        throw zip_error("number of file entries exceeds the limit of the zip format without the ZIP64 extension.");
+
+    uint32_t cd_offset = to_uint32(mp_impl->offset, "offset of the central directory");
+
+    for (const entry_info& entry : entries)
+    {
+        write_uint32(os, sig_central_dir_header);
+        write_uint16(os, version_needed); // version made by
+        write_uint16(os, version_needed);
+        write_uint16(os, flag_utf8_name);
+        write_uint16(os, method_deflated);
+        write_uint16(os, dos_time);
+        write_uint16(os, dos_date);
+        write_uint32(os, entry.crc);
+        write_uint32(os, entry.size_compressed);
+        write_uint32(os, entry.size_uncompressed);
+        write_uint16(os, entry.name.size());
+        write_uint16(os, 0); // extra field length
+        write_uint16(os, 0); // comment length
+        write_uint16(os, 0); // disk number
+        write_uint16(os, 0); // internal attributes
+        write_uint32(os, 0); // external attributes
+        write_uint32(os, entry.offset);
+        mp_impl->offset += 46;
+
+        mp_impl->write_bytes(entry.name.data(), entry.name.size());
+    }
+
+    uint32_t cd_size = to_uint32(mp_impl->offset - cd_offset, "size of the central directory");
+
+    write_uint32(os, sig_end_central_dir);
+    write_uint16(os, 0); // number of this disk
+    write_uint16(os, 0); // disk where the central directory starts
+    write_uint16(os, entries.size());
+    write_uint16(os, entries.size());
+    write_uint32(os, cd_size);
+    write_uint32(os, cd_offset);
+    write_uint16(os, 0); // comment length
+
+    os.flush();
+    mp_impl->closed = true;
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
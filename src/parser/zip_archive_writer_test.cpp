@@ -0,0 +1,124 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "test_global.hpp"
+#include "orcus/zip_archive_writer.hpp"
+#include "orcus/zip_archive_stream.hpp"
+#include "orcus/zip_archive.hpp"
+#include "orcus/pstring.hpp"
+
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+using namespace orcus;
+
+namespace {
+
+std::string read_entry(const zip_archive& archive, const char* name)
+{
+    std::vector<unsigned char> buf;
+    bool success = archive.read_file_entry(name, buf);
+    assert(success);
+
+    // The buffer is null-terminated.
+    assert(!buf.empty() && buf.back() == 0);
+    return std::string(buf.begin(), buf.end() - 1);
+}
+
+void test_write_read()
+{
+    // Large and repetitive enough to span many stream buffers, and to
+    // compress well.
+    std::string large;
+    for (int i = 0; i < 100000; ++i)
+        large += "<row r=\"" + std::to_string(i) + "\"/>";
+
+    std::ostringstream os;
+
+    {
+        zip_archive_writer writer(os);
+
+        std::string small = "My hovercraft is full of eels.";
+        writer.add_file_entry("small.txt", small.data(), small.size());
+
+        zip_entry_deflater entry("dir/large.xml");
+        std::ostream& entry_os = entry.get_stream();
+        for (int i = 0; i < 100000; ++i)
+            entry_os << "<row r=\"" << i << "\"/>";
+        writer.add_file_entry(entry);
+
+        writer.add_file_entry("empty", nullptr, 0);
+        writer.close();
+
+        // No more entries after closing.
+        try
+        {
+            writer.add_file_entry("late", nullptr, 0);
+            assert(!"exception was expected");
+        }
+        catch (const zip_error&) {}
+    }
+
+    std::string buf = os.str();
+    zip_archive_stream_blob stream(reinterpret_cast<const unsigned char*>(buf.data()), buf.size());
+    zip_archive archive(&stream);
+    archive.load();
+
+    assert(archive.get_file_entry_count() == 3);
+    assert(archive.get_file_entry_name(0) == "small.txt");
+    assert(archive.get_file_entry_name(1) == "dir/large.xml");
+    assert(archive.get_file_entry_name(2) == "empty");
+
+    assert(read_entry(archive, "small.txt") == "My hovercraft is full of eels.");
+    assert(read_entry(archive, "dir/large.xml") == large);
+    assert(read_entry(archive, "empty").empty());
+
+    zip_file_entry_stat stat = archive.get_file_entry_stat(1);
+    assert(stat.compressed);
+    assert(stat.size_uncompressed == large.size());
+    assert(stat.size_compressed < large.size() / 4);
+}
+
+void test_parallel_deflaters()
+{
+    // Deflaters are independent of the archive, and can be filled in any
+    // order before being added.
+    std::vector<zip_entry_deflater> entries;
+    for (int i = 0; i < 3; ++i)
+        entries.emplace_back("part" + std::to_string(i));
+
+    for (int i = 2; i >= 0; --i)
+        entries[i].get_stream() << "content of part " << i;
+
+    std::ostringstream os;
+    zip_archive_writer writer(os);
+    for (zip_entry_deflater& entry : entries)
+        writer.add_file_entry(entry);
+    writer.close();
+
+    std::string buf = os.str();
+    zip_archive_stream_blob stream(reinterpret_cast<const unsigned char*>(buf.data()), buf.size());
+    zip_archive archive(&stream);
+    archive.load();
+
+    assert(archive.get_file_entry_count() == 3);
+    assert(read_entry(archive, "part0") == "content of part 0");
+    assert(read_entry(archive, "part2") == "content of part 2");
+}
+
+}
+
+int main()
+{
+    test_write_read();
+    test_parallel_deflaters();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
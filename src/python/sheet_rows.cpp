@@ -69,6 +69,7 @@ PyObject* sheet_rows_iter(PyObject* self)
         sheet_range.last.column = range.last.column;
         sheet_range.last.row = range.last.row;
 
+        data->m_doc->page_in_sheet(data->m_sheet->get_index());
         data->m_range_iterator = data->m_doc->get_model_context().get_model_iterator(
             data->m_sheet->get_index(), ixion::rc_direction_t::horizontal, sheet_range);
     }
@@ -0,0 +1,228 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "cell_format_store.hpp"
+
+#include <algorithm>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+cell_format_store::const_iterator::const_iterator() :
+    mp_columns(nullptr), m_col_pos(0), m_run_pos(0), m_current() {}
+
+cell_format_store::const_iterator::const_iterator(const columns_type* columns, size_t col_pos) :
+    mp_columns(columns), m_col_pos(col_pos), m_run_pos(0), m_current()
+{
+    skip_empty_columns();
+    update_current();
+}
+
+void cell_format_store::const_iterator::skip_empty_columns()
+{
+    while (m_col_pos < mp_columns->size() && (*mp_columns)[m_col_pos].runs.empty())
+        ++m_col_pos;
+}
+
+void cell_format_store::const_iterator::update_current()
+{
+    if (m_col_pos >= mp_columns->size())
+        return;
+
+    const column& c = (*mp_columns)[m_col_pos];
+    const run& r = c.runs[m_run_pos];
+    m_current.column = c.col;
+    m_current.first_row = r.first;
+    m_current.last_row = r.last;
+    m_current.index = r.index;
+}
+
+cell_format_store::const_iterator& cell_format_store::const_iterator::operator++()
+{
+    if (++m_run_pos >= (*mp_columns)[m_col_pos].runs.size())
+    {
+        ++m_col_pos;
+        m_run_pos = 0;
+        skip_empty_columns();
+    }
+
+    update_current();
+    return *this;
+}
+
+cell_format_store::const_iterator cell_format_store::const_iterator::operator++(int)
+{
+    const_iterator ret = *this;
+    ++(*this);
+    return ret;
+}
+
+bool cell_format_store::const_iterator::operator==(const const_iterator& other) const
+{
+    return mp_columns == other.mp_columns && m_col_pos == other.m_col_pos && m_run_pos == other.m_run_pos;
+}
+
+bool cell_format_store::const_iterator::operator!=(const const_iterator& other) const
+{
+    return !operator==(other);
+}
+
+cell_format_store::cell_format_store() {}
+cell_format_store::~cell_format_store() {}
+
+cell_format_store::column& cell_format_store::get_or_create_column(col_t col)
+{
+    auto it = std::lower_bound(m_columns.begin(), m_columns.end(), col,
+        [](const column& c, col_t v) { return c.col < v; });
+
+    if (it == m_columns.end() || it->col != col)
+        it = m_columns.insert(it, column{col, std::vector<run>()});
+
+    return *it;
+}
+
+const cell_format_store::column* cell_format_store::get_column(col_t col) const
+{
+    auto it = std::lower_bound(m_columns.begin(), m_columns.end(), col,
+        [](const column& c, col_t v) { return c.col < v; });
+
+    if (it == m_columns.end() || it->col != col)
+        return nullptr;
+
+    return &*it;
+}
+
+void cell_format_store::set_column(column& c, row_t first, row_t last, size_t index)
+{
+    std::vector<run>& runs = c.runs;
+
+    if (runs.empty() || runs.back().last < first)
+    {
+        // Appending past the last run.  This is by far the most common case
+        // since importers normally set the formats in row order.
+        if (!index)
+            return;
+
+        run* back = runs.empty() ? nullptr : &runs.back();
+        if (back && back->last + 1 == first && back->index == index)
+            back->last = last;
+        else
+            runs.push_back(run{first, last, index});
+
+        return;
+    }
+
+    // First run that ends at or after the first row.
+    auto it = std::lower_bound(runs.begin(), runs.end(), first,
+        [](const run& r, row_t row) { return r.last < row; });
+
+    // First run that starts after the last row.
+    auto it_end = std::upper_bound(it, runs.end(), last,
+        [](row_t row, const run& r) { return row < r.first; });
+
+    // Runs to replace the overlapped runs with: the parts of the overlapped
+    // runs sticking out on either end, and the new run itself.
+    run pieces[3];
+    size_t n = 0;
+
+    if (it != it_end && it->first < first)
+        pieces[n++] = run{it->first, first - 1, it->index};
+
+    if (index)
+        pieces[n++] = run{first, last, index};
+
+    if (it != it_end)
+    {
+        const run& back = *std::prev(it_end);
+        if (back.last > last)
+            pieces[n++] = run{last + 1, back.last, back.index};
+    }
+
+    size_t pos = std::distance(runs.begin(), it);
+    it = runs.erase(it, it_end);
+    runs.insert(it, pieces, pieces + n);
+
+    // Merge adjacent runs of the same index around the modified part.
+    size_t i = pos ? pos : 1;
+    size_t end_pos = std::min(pos + n + 1, runs.size());
+    while (i < end_pos)
+    {
+        run& prev = runs[i-1];
+        const run& cur = runs[i];
+        if (prev.last + 1 == cur.first && prev.index == cur.index)
+        {
+            prev.last = cur.last;
+            runs.erase(runs.begin() + i);
+            --end_pos;
+        }
+        else
+            ++i;
+    }
+}
+
+void cell_format_store::set(row_t row_start, col_t col_start, row_t row_end, col_t col_end, size_t index)
+{
+    if (row_start > row_end || col_start > col_end)
+        return;
+
+    for (col_t col = col_start; col <= col_end; ++col)
+    {
+        if (!index && !get_column(col))
+            // Nothing to clear.
+            continue;
+
+        set_column(get_or_create_column(col), row_start, row_end, index);
+    }
+}
+
+size_t cell_format_store::get(row_t row, col_t col) const
+{
+    const column* c = get_column(col);
+    if (!c)
+        return 0;
+
+    // Last run that starts at or before the row.
+    auto it = std::upper_bound(c->runs.begin(), c->runs.end(), row,
+        [](row_t v, const run& r) { return v < r.first; });
+
+    if (it == c->runs.begin())
+        return 0;
+
+    --it;
+    return it->last >= row ? it->index : 0;
+}
+
+void cell_format_store::reserve(size_t n)
+{
+    m_columns.reserve(n);
+}
+
+size_t cell_format_store::run_count() const
+{
+    size_t n = 0;
+    for (const column& c : m_columns)
+        n += c.runs.size();
+    return n;
+}
+
+bool cell_format_store::empty() const
+{
+    return begin() == end();
+}
+
+cell_format_store::const_iterator cell_format_store::begin() const
+{
+    return const_iterator(&m_columns, 0);
+}
+
+cell_format_store::const_iterator cell_format_store::end() const
+{
+    return const_iterator(&m_columns, m_columns.size());
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
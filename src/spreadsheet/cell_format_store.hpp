@@ -0,0 +1,130 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_SPREADSHEET_CELL_FORMAT_STORE_HPP
+#define INCLUDED_ORCUS_SPREADSHEET_CELL_FORMAT_STORE_HPP
+
+#include "orcus/spreadsheet/types.hpp"
+
+#include <vector>
+#include <iterator>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+/**
+ * Stores the cell format indices of a sheet as runs of rows per column.
+ * Only the columns that have at least one formatted cell take up space,
+ * and each column only stores the runs of non-default format indices, with
+ * adjacent runs of the same index merged into one.  Cells not covered by
+ * any run have the default format index of 0.
+ */
+class cell_format_store
+{
+    struct run
+    {
+        row_t first;
+        row_t last;
+        size_t index;
+    };
+
+    struct column
+    {
+        col_t col;
+        std::vector<run> runs;
+    };
+
+    std::vector<column> m_columns; /// sorted by column index.
+
+    column& get_or_create_column(col_t col);
+    const column* get_column(col_t col) const;
+
+    static void set_column(column& c, row_t first, row_t last, size_t index);
+
+public:
+    /**
+     * Single run of one format index within a column.  Both the first and
+     * last rows are inclusive.
+     */
+    struct range
+    {
+        col_t column;
+        row_t first_row;
+        row_t last_row;
+        size_t index;
+    };
+
+    /**
+     * Iterates over all non-default runs in column-major order.
+     */
+    class const_iterator
+    {
+        friend class cell_format_store;
+
+        using columns_type = std::vector<column>;
+
+        const columns_type* mp_columns;
+        size_t m_col_pos;
+        size_t m_run_pos;
+        range m_current;
+
+        const_iterator(const columns_type* columns, size_t col_pos);
+
+        void skip_empty_columns();
+        void update_current();
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = range;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const range*;
+        using reference = const range&;
+
+        const_iterator();
+
+        const range& operator*() const { return m_current; }
+        const range* operator->() const { return &m_current; }
+
+        const_iterator& operator++();
+        const_iterator operator++(int);
+
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+    };
+
+    cell_format_store();
+    ~cell_format_store();
+
+    /**
+     * Assign a format index to a rectangular range of cells.  Both the
+     * start and end positions are inclusive.
+     */
+    void set(row_t row_start, col_t col_start, row_t row_end, col_t col_end, size_t index);
+
+    size_t get(row_t row, col_t col) const;
+
+    /**
+     * Reserve room for the specified number of columns with formatted
+     * cells.
+     */
+    void reserve(size_t n);
+
+    /**
+     * @return total number of runs stored.
+     */
+    size_t run_count() const;
+
+    bool empty() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+};
+
+}}}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,187 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "cell_format_store.hpp"
+
+#include <cstdlib>
+#include <cassert>
+#include <vector>
+#include <random>
+
+using namespace orcus::spreadsheet;
+using detail::cell_format_store;
+
+namespace {
+
+void test_single_cells()
+{
+    cell_format_store store;
+    assert(store.empty());
+    assert(store.get(0, 0) == 0);
+
+    // Typical xlsx import: one cell at a time in row order.
+    for (row_t row = 0; row < 10; ++row)
+    {
+        for (col_t col = 0; col < 3; ++col)
+            store.set(row, col, row, col, col + 1);
+    }
+
+    for (row_t row = 0; row < 10; ++row)
+    {
+        for (col_t col = 0; col < 3; ++col)
+            assert(store.get(row, col) == size_t(col + 1));
+    }
+
+    assert(store.get(10, 0) == 0);
+    assert(store.get(0, 3) == 0);
+
+    // Consecutive cells of the same format collapse into one run per column.
+    assert(store.run_count() == 3);
+}
+
+void test_overwrite()
+{
+    cell_format_store store;
+    store.set(0, 0, 99, 0, 1);
+    assert(store.run_count() == 1);
+
+    // Split the run in the middle.
+    store.set(40, 0, 49, 0, 2);
+    assert(store.run_count() == 3);
+    assert(store.get(39, 0) == 1);
+    assert(store.get(40, 0) == 2);
+    assert(store.get(49, 0) == 2);
+    assert(store.get(50, 0) == 1);
+
+    // Resetting to the default format removes the run.
+    store.set(40, 0, 49, 0, 0);
+    assert(store.run_count() == 2);
+    assert(store.get(45, 0) == 0);
+
+    // Filling the gap with the original format merges all three back.
+    store.set(40, 0, 49, 0, 1);
+    assert(store.run_count() == 1);
+    assert(store.get(45, 0) == 1);
+
+    // Range spanning over several existing runs.
+    store.set(10, 0, 19, 0, 3);
+    store.set(30, 0, 39, 0, 4);
+    store.set(15, 0, 34, 0, 5);
+    assert(store.get(14, 0) == 3);
+    assert(store.get(15, 0) == 5);
+    assert(store.get(34, 0) == 5);
+    assert(store.get(35, 0) == 4);
+    assert(store.get(40, 0) == 1);
+
+    store.set(0, 0, 99, 0, 0);
+    assert(store.empty());
+}
+
+void test_iterator()
+{
+    cell_format_store store;
+    store.set(5, 2, 6, 3, 7);
+    store.set(0, 1, 0, 1, 8);
+    store.set(3, 3, 3, 3, 9);
+
+    struct check
+    {
+        col_t column;
+        row_t first_row;
+        row_t last_row;
+        size_t index;
+    };
+
+    std::vector<check> expected = {
+        { 1, 0, 0, 8 },
+        { 2, 5, 6, 7 },
+        { 3, 3, 3, 9 },
+        { 3, 5, 6, 7 },
+    };
+
+    auto it = store.begin();
+    for (const check& c : expected)
+    {
+        assert(it != store.end());
+        assert(it->column == c.column);
+        assert(it->first_row == c.first_row);
+        assert(it->last_row == c.last_row);
+        assert(it->index == c.index);
+        ++it;
+    }
+
+    assert(it == store.end());
+
+    // Columns that have become empty are skipped.
+    store.set(0, 1, 0, 1, 0);
+    it = store.begin();
+    assert(it->column == 2);
+}
+
+void test_random()
+{
+    const row_t row_size = 64;
+    const col_t col_size = 8;
+
+    cell_format_store store;
+    std::vector<size_t> ref(row_size * col_size, 0);
+
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<row_t> row_dist(0, row_size - 1);
+    std::uniform_int_distribution<col_t> col_dist(0, col_size - 1);
+    std::uniform_int_distribution<size_t> index_dist(0, 3);
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        row_t r1 = row_dist(gen), r2 = row_dist(gen);
+        col_t c1 = col_dist(gen), c2 = col_dist(gen);
+        if (r1 > r2)
+            std::swap(r1, r2);
+        if (c1 > c2)
+            std::swap(c1, c2);
+
+        size_t index = index_dist(gen);
+        store.set(r1, c1, r2, c2, index);
+
+        for (col_t col = c1; col <= c2; ++col)
+            for (row_t row = r1; row <= r2; ++row)
+                ref[col * row_size + row] = index;
+
+        for (col_t col = 0; col < col_size; ++col)
+            for (row_t row = 0; row < row_size; ++row)
+                assert(store.get(row, col) == ref[col * row_size + row]);
+
+        // The runs must be sorted, non-overlapping, non-default, and no two
+        // adjacent runs may share the same index.
+        auto it = store.begin(), it_end = store.end();
+        for (auto prev = it_end; it != it_end; prev = it++)
+        {
+            assert(it->index != 0);
+            assert(it->first_row <= it->last_row);
+
+            if (prev != it_end && prev->column == it->column)
+            {
+                assert(prev->last_row < it->first_row);
+                assert(prev->last_row + 1 < it->first_row || prev->index != it->index);
+            }
+        }
+    }
+}
+
+}
+
+int main()
+{
+    test_single_cells();
+    test_overwrite();
+    test_iterator();
+    test_random();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -10,16 +10,24 @@
 namespace orcus { namespace spreadsheet {
 
 document_config::document_config() :
-    output_precision(-1) {}
+    output_precision(-1), spill_threshold(0), csv_separator(','), csv_quote('"') {}
 
 document_config::document_config(const document_config& r) :
-    output_precision(r.output_precision) {}
+    output_precision(r.output_precision),
+    spill_threshold(r.spill_threshold),
+    spill_directory(r.spill_directory),
+    csv_separator(r.csv_separator),
+    csv_quote(r.csv_quote) {}
 
 document_config::~document_config() {}
 
 document_config& document_config::operator= (const document_config& r)
 {
     output_precision = r.output_precision;
+    spill_threshold = r.spill_threshold;
+    spill_directory = r.spill_directory;
+    csv_separator = r.csv_separator;
+    csv_quote = r.csv_quote;
     return *this;
 }
 
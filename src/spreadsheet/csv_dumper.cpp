@@ -9,54 +9,164 @@
 #include "dumper_global.hpp"
 #include "orcus/spreadsheet/document.hpp"
 
+#include "orcus/global.hpp"
+
 #include <ixion/model_context.hpp>
-#include <ixion/formula_name_resolver.hpp>
-#include <ixion/formula_result.hpp>
-#include <mdds/multi_type_vector/collection.hpp>
 
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include <cstring>
+
+#ifdef __ORCUS_CPU_FEATURES
+#include <immintrin.h>
+#endif
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
 namespace {
 
-void dump_string(std::ostream& os, const std::string& s)
+/**
+ * Find the first character that requires the field to be quoted i.e. either
+ * the separator or the quote character.
+ *
+ * @return pointer to the first special character, or the end position if
+ *         none is found.
+ */
+const char* find_special_char(const char* p, const char* p_end, char sep, char quote)
+{
+#if defined(__ORCUS_CPU_FEATURES) && defined(__AVX2__)
+    const __m256i v_sep = _mm256_set1_epi8(sep);
+    const __m256i v_quote = _mm256_set1_epi8(quote);
+
+    for (; p_end - p >= 32; p += 32)
+    {
+        __m256i char_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i results = _mm256_or_si256(
+            _mm256_cmpeq_epi8(char_block, v_sep), _mm256_cmpeq_epi8(char_block, v_quote));
+        int r = _mm256_movemask_epi8(results);
+        if (r)
+            return p + _tzcnt_u32(r);
+    }
+#elif defined(__ORCUS_CPU_FEATURES) && defined(__SSE4_2__)
+    const __m128i v_sep = _mm_set1_epi8(sep);
+    const __m128i v_quote = _mm_set1_epi8(quote);
+
+    for (; p_end - p >= 16; p += 16)
+    {
+        __m128i char_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i results = _mm_or_si128(
+            _mm_cmpeq_epi8(char_block, v_sep), _mm_cmpeq_epi8(char_block, v_quote));
+        int r = _mm_movemask_epi8(results);
+        if (r)
+            return p + __builtin_ctz(r);
+    }
+#endif
+
+    // Scan the remaining tail (or everything when no CPU features are in
+    // use) one character at a time.
+    for (; p != p_end; ++p)
+    {
+        if (*p == sep || *p == quote)
+            return p;
+    }
+
+    return p_end;
+}
+
+class string_writer
 {
-    // Scan for any special characters that necessitate quoting.
-    bool outer_quotes = s.find_first_of(",\"") != std::string::npos;
+    output_buffer& m_buf;
+    const char m_sep;
+    const char m_quote;
 
-    if (outer_quotes)
-        os << '"';
+public:
+    string_writer(output_buffer& buf, char sep, char quote) :
+        m_buf(buf), m_sep(sep), m_quote(quote) {}
 
-    for (const char c : s)
+    void operator() (const std::string& s) const
     {
-        switch (c)
+        const char* p = s.data();
+        const char* p_end = p + s.size();
+
+        const char* p_special = find_special_char(p, p_end, m_sep, m_quote);
+
+        if (p_special == p_end)
+        {
+            // No quoting needed. Copy the whole string in one go.
+            m_buf.write(p, s.size());
+            return;
+        }
+
+        m_buf.write(m_quote);
+
+        // Copy the runs between the quote characters in bulk, and double
+        // each quote character.
+        while (p != p_end)
         {
-            case '"':
+            const char* p_quote = static_cast<const char*>(std::memchr(p, m_quote, p_end - p));
+            if (!p_quote)
             {
-                os << c << c;
+                m_buf.write(p, p_end - p);
                 break;
             }
-            default:
-                os << c;
+
+            ++p_quote; // include the quote itself.
+            m_buf.write(p, p_quote - p);
+            m_buf.write(m_quote);
+            p = p_quote;
         }
+
+        m_buf.write(m_quote);
     }
 
-    if (outer_quotes)
-        os << '"';
-}
+    void error(const char* p, size_t n) const
+    {
+        m_buf.write(m_quote);
+        m_buf.write(p, n);
+        m_buf.write(m_quote);
+    }
+};
 
-void dump_empty(std::ostream& /*os*/)
+/**
+ * Writes the cell values as CSV fields.
+ */
+class cell_writer
 {
-    // Do nothing.
-}
+    output_buffer& m_buf;
+    const string_writer& m_str_writer;
+
+public:
+    cell_writer(output_buffer& buf, const string_writer& str_writer) :
+        m_buf(buf), m_str_writer(str_writer) {}
+
+    void empty() {}
+
+    void boolean(bool v)
+    {
+        if (v)
+            m_buf.write(ORCUS_ASCII("true"));
+        else
+            m_buf.write(ORCUS_ASCII("false"));
+    }
+
+    void numeric(double v)
+    {
+        m_buf.write(v);
+    }
+
+    void string(const std::string& s)
+    {
+        m_str_writer(s);
+    }
+
+    void error(const char* p, size_t n)
+    {
+        m_str_writer.error(p, n);
+    }
+};
 
 }
 
-csv_dumper::csv_dumper(const document& doc) :
-    m_doc(doc), m_sep(','), m_quote('"')
+csv_dumper::csv_dumper(const document& doc, char sep, char quote) :
+    m_doc(doc), m_sep(sep), m_quote(quote)
 {
 }
 
@@ -76,17 +186,21 @@ void csv_dumper::dump(std::ostream& os, ixion::sheet_t sheet_id) const
     auto iter = cxt.get_model_iterator(
         sheet_id, ixion::rc_direction_t::horizontal, iter_range);
 
+    output_buffer buf(os);
+    string_writer str_writer(buf, m_sep, m_quote);
+    cell_writer writer(buf, str_writer);
+
     for (; iter.has(); iter.next())
     {
         const auto& cell = iter.get();
 
         if (cell.col == 0 && cell.row > 0)
-            os << std::endl;
+            buf.write('\n');
 
         if (cell.col > 0)
-            os << m_sep;
+            buf.write(m_sep);
 
-        dump_cell_value(os, cxt, cell, dump_string, dump_empty);
+        dump_cell_value(cxt, cell, writer);
     }
 }
 
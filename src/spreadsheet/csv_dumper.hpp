@@ -25,7 +25,7 @@ class csv_dumper
     const char m_quote;
 
 public:
-    csv_dumper(const document& doc);
+    csv_dumper(const document& doc, char sep = ',', char quote = '"');
 
     void dump(std::ostream& os, ixion::sheet_t sheet_id) const;
 };
@@ -18,12 +18,19 @@
 #include "orcus/types.hpp"
 #include "orcus/string_pool.hpp"
 #include "orcus/global.hpp"
+#include "orcus/stream.hpp"
+#include "orcus/exception.hpp"
+
+#include "snapshot.hpp"
+#include "spill_store.hpp"
+#include "xlsx_exporter.hpp"
 
 #include <ixion/formula.hpp>
 #include <ixion/formula_result.hpp>
 #include <ixion/matrix.hpp>
 #include <ixion/model_context.hpp>
 #include <ixion/formula_name_resolver.hpp>
+#include <ixion/named_expressions_iterator.hpp>
 #include <ixion/interface/table_handler.hpp>
 #include <ixion/config.hpp>
 #include <boost/filesystem.hpp>
@@ -32,6 +39,7 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <thread>
 
 using namespace std;
 namespace fs = boost::filesystem;
@@ -311,6 +319,9 @@ struct document_impl
     table_store_type m_tables;
     table_handler m_table_handler;
 
+    /** Only present when the cell values may get spilled to disk. */
+    std::unique_ptr<detail::spill_store> mp_spill_store;
+
     document_impl(document& doc, const range_size_t& sheet_size) :
         m_doc(doc),
         m_context({sheet_size.rows, sheet_size.columns}),
@@ -329,6 +340,31 @@ struct document_impl
     {
         delete mp_strings;
     }
+
+    void reset_spill_store()
+    {
+        if (mp_spill_store)
+        {
+            // The spilled cell values would be lost with the store.
+            mp_spill_store->page_in_all();
+            mp_spill_store.reset();
+        }
+
+        if (!m_doc_config.spill_threshold)
+            return;
+
+        mp_spill_store = std::make_unique<detail::spill_store>(
+            m_doc_config.spill_threshold, m_doc_config.spill_directory,
+            [this](sheet_t sheet, std::ostream& os)
+            {
+                m_sheets[sheet]->data.spill_cells(os);
+            },
+            [this](sheet_t sheet, const char* p, size_t n)
+            {
+                m_sheets[sheet]->data.restore_cells(p, n);
+            }
+        );
+    }
 };
 
 document::document(const range_size_t& sheet_size) : mp_impl(new document_impl(*this, sheet_size)) {}
@@ -382,10 +418,20 @@ const document_config& document::get_config() const
 
 void document::set_config(const document_config& cfg)
 {
+    if (cfg.csv_separator == cfg.csv_quote)
+        throw invalid_arg_error("document::set_config: the CSV separator and quote characters must differ.");
+
+    bool spill_changed =
+        cfg.spill_threshold != mp_impl->m_doc_config.spill_threshold ||
+        cfg.spill_directory != mp_impl->m_doc_config.spill_directory;
+
     mp_impl->m_doc_config = cfg;
     ixion::config ixion_cfg = mp_impl->m_context.get_config();
     ixion_cfg.output_precision = cfg.output_precision;
     mp_impl->m_context.set_config(ixion_cfg);
+
+    if (spill_changed)
+        mp_impl->reset_spill_store();
 }
 
 string_pool& document::get_string_pool()
@@ -463,8 +509,17 @@ const sheet* document::get_sheet(sheet_t sheet_pos) const
     return &mp_impl->m_sheets[sheet_pos]->data;
 }
 
+void document::page_in_sheet(sheet_t sheet_pos) const
+{
+    if (mp_impl->mp_spill_store)
+        mp_impl->mp_spill_store->page_in(sheet_pos);
+}
+
 void document::recalc_formula_cells()
 {
+    if (mp_impl->mp_spill_store)
+        mp_impl->mp_spill_store->page_in_all();
+
     ixion::abs_range_set_t empty;
 
     ixion::model_context& cxt = get_model_context();
@@ -507,6 +562,23 @@ void document::dump(dump_format_t format, const std::string& output) const
         return;
     }
 
+    if (format == dump_format_t::xlsx)
+    {
+        // For this output, we write to a single file too.
+        if (output.empty())
+            throw std::invalid_argument("No output file.");
+
+        if (fs::is_directory(output))
+        {
+            std::ostringstream os;
+            os << "Output file path points to an existing directory.";
+            throw std::invalid_argument(os.str());
+        }
+
+        save_xlsx(output, std::max(1u, std::thread::hardware_concurrency()));
+        return;
+    }
+
     if (output.empty())
         throw std::invalid_argument("No output directory.");
 
@@ -627,6 +699,383 @@ void document::dump_csv(const std::string& outdir) const
     }
 }
 
+namespace {
+
+void write_named_expressions(
+    detail::snapshot_writer& writer, const ixion::model_context& cxt,
+    const ixion::formula_name_resolver& resolver, ixion::named_expressions_iterator iter)
+{
+    size_t n = 0;
+    for (auto it = iter; it.has(); it.next())
+        ++n;
+
+    writer.write_uint64(n);
+    for (; iter.has(); iter.next())
+    {
+        auto ne = iter.get();
+        const ixion::named_expression_t& exp = *ne.expression;
+        writer.write_string(*ne.name);
+        writer.write_int32(exp.origin.sheet);
+        writer.write_int32(exp.origin.row);
+        writer.write_int32(exp.origin.column);
+        writer.write_string(ixion::print_formula_tokens(cxt, exp.origin, resolver, exp.tokens));
+    }
+}
+
+void read_named_expressions(
+    detail::snapshot_reader& reader, ixion::model_context& cxt,
+    const ixion::formula_name_resolver& resolver, sheet_t sheet)
+{
+    size_t n = reader.read_count();
+    for (size_t i = 0; i < n; ++i)
+    {
+        pstring name = reader.read_string();
+        ixion::abs_address_t origin;
+        origin.sheet = reader.read_int32();
+        origin.row = reader.read_int32();
+        origin.column = reader.read_int32();
+        pstring exp = reader.read_string();
+
+        ixion::formula_tokens_t tokens =
+            ixion::parse_formula_string(cxt, origin, resolver, exp.get(), exp.size());
+
+        if (sheet < 0)
+            cxt.set_named_expression(name.get(), name.size(), origin, std::move(tokens));
+        else
+            cxt.set_named_expression(sheet, name.get(), name.size(), origin, std::move(tokens));
+    }
+}
+
+/**
+ * Swaps in new internals of a document, and puts the original ones back
+ * on destruction unless the new ones have been committed.
+ */
+class impl_restorer
+{
+    std::unique_ptr<document_impl>& m_impl;
+    std::unique_ptr<document_impl> m_original;
+
+public:
+    impl_restorer(std::unique_ptr<document_impl>& impl, std::unique_ptr<document_impl> replacement) :
+        m_impl(impl), m_original(std::move(impl))
+    {
+        m_impl = std::move(replacement);
+    }
+
+    ~impl_restorer()
+    {
+        if (m_original)
+            m_impl = std::move(m_original);
+    }
+
+    void commit()
+    {
+        m_original.reset();
+    }
+};
+
+}
+
+void document::save_xlsx(const std::string& filepath, size_t thread_count) const
+{
+    std::ofstream file(filepath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::ostringstream os;
+        os << "failed to open " << filepath << " for writing.";
+        throw general_error(os.str());
+    }
+
+    if (mp_impl->mp_spill_store)
+        // The sheets get paged in as they get written, which can only be
+        // done one sheet at a time.
+        thread_count = 1;
+
+    detail::xlsx_exporter exporter(*this);
+    exporter.write(file, thread_count);
+}
+
+void document::save_snapshot(
+    const std::string& filepath, uint64_t source_size, const std::string& source_digest) const
+{
+    const ixion::model_context& cxt = mp_impl->m_context;
+    const ixion::formula_name_resolver* resolver = mp_impl->mp_name_resolver_global.get();
+    if (!resolver)
+        throw general_error("document::save_snapshot: no formula name resolver.");
+
+    std::ofstream file(filepath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::ostringstream os;
+        os << "failed to open " << filepath << " for writing.";
+        throw general_error(os.str());
+    }
+
+    detail::snapshot_writer writer(file);
+    writer.write_header();
+    writer.write_uint64(source_size);
+    writer.write_string(source_digest);
+
+    // Document settings.
+
+    range_size_t ss = get_sheet_size();
+    writer.write_int32(ss.rows);
+    writer.write_int32(ss.columns);
+    writer.write_int32(mp_impl->m_doc_config.output_precision);
+    writer.write_int32(mp_impl->m_origin_date.year);
+    writer.write_int32(mp_impl->m_origin_date.month);
+    writer.write_int32(mp_impl->m_origin_date.day);
+    writer.write_enum(mp_impl->m_grammar);
+
+    // Shared strings with their format runs.  They are written in the order
+    // of their IDs, as the string cells refer to them by their IDs.
+
+    size_t string_count = cxt.get_string_count();
+    writer.write_uint64(string_count);
+    for (size_t i = 0; i < string_count; ++i)
+    {
+        const std::string* p = cxt.get_string(i);
+        writer.write_string(p ? *p : std::string());
+
+        const format_runs_t* runs = mp_impl->mp_strings->get_format_runs(i);
+        writer.write_uint64(runs ? runs->size() : 0);
+        if (!runs)
+            continue;
+
+        for (const format_run& fr : *runs)
+        {
+            writer.write_uint64(fr.pos);
+            writer.write_uint64(fr.size);
+            writer.write_string(fr.font);
+            writer.write_double(fr.font_size);
+            writer.write_uint8(fr.color.alpha);
+            writer.write_uint8(fr.color.red);
+            writer.write_uint8(fr.color.green);
+            writer.write_uint8(fr.color.blue);
+            writer.write_bool(fr.bold);
+            writer.write_bool(fr.italic);
+        }
+    }
+
+    detail::write_styles(writer, mp_impl->m_styles);
+
+    // Sheets need to be all present before any formula gets parsed on load.
+
+    writer.write_uint64(mp_impl->m_sheets.size());
+    for (const std::unique_ptr<sheet_item>& sh : mp_impl->m_sheets)
+        writer.write_string(sh->name);
+
+    write_named_expressions(writer, cxt, *resolver, cxt.get_named_expressions_iterator());
+
+    for (const std::unique_ptr<sheet_item>& sh : mp_impl->m_sheets)
+    {
+        sheet_t sheet_index = sh->data.get_index();
+        write_named_expressions(writer, cxt, *resolver, cxt.get_named_expressions_iterator(sheet_index));
+    }
+
+    // Tables.
+
+    writer.write_uint64(mp_impl->m_tables.size());
+    for (const auto& entry : mp_impl->m_tables)
+    {
+        const table_t& tab = *entry.second;
+        writer.write_uint64(tab.identifier);
+        writer.write_string(tab.name);
+        writer.write_string(tab.display_name);
+        writer.write_int32(tab.range.first.sheet);
+        writer.write_int32(tab.range.first.row);
+        writer.write_int32(tab.range.first.column);
+        writer.write_int32(tab.range.last.sheet);
+        writer.write_int32(tab.range.last.row);
+        writer.write_int32(tab.range.last.column);
+        writer.write_uint64(tab.totals_row_count);
+        detail::write_auto_filter(writer, tab.filter);
+
+        writer.write_uint64(tab.columns.size());
+        for (const table_column_t& col : tab.columns)
+        {
+            writer.write_uint64(col.identifier);
+            writer.write_string(col.name);
+            writer.write_string(col.totals_row_label);
+            writer.write_enum(col.totals_row_function);
+        }
+
+        writer.write_string(tab.style.name);
+        writer.write_bool(tab.style.show_first_column);
+        writer.write_bool(tab.style.show_last_column);
+        writer.write_bool(tab.style.show_row_stripes);
+        writer.write_bool(tab.style.show_column_stripes);
+    }
+
+    // Sheet content.
+
+    for (const std::unique_ptr<sheet_item>& sh : mp_impl->m_sheets)
+        sh->data.write_snapshot(writer);
+
+    if (!file)
+    {
+        std::ostringstream os;
+        os << "failed to write the snapshot to " << filepath << ".";
+        throw general_error(os.str());
+    }
+}
+
+void document::load_snapshot(
+    const std::string& filepath, uint64_t source_size, const std::string& source_digest)
+{
+    file_content content(filepath.data());
+    detail::snapshot_reader reader(content.data(), content.size());
+    reader.read_header();
+
+    uint64_t stored_size = reader.read_uint64();
+    pstring stored_digest = reader.read_string();
+    if (!source_digest.empty() && (stored_size != source_size || stored_digest != source_digest))
+        throw general_error("document::load_snapshot: the snapshot was saved from a different source.");
+
+    // Read the content into new internals, and only discard the current
+    // ones once the whole snapshot has been read, so that a corrupt snapshot
+    // leaves the document as it was.
+    impl_restorer restorer(mp_impl, std::make_unique<document_impl>(*this, get_sheet_size()));
+
+    // Document settings.
+
+    range_size_t ss;
+    ss.rows = reader.read_int32();
+    ss.columns = reader.read_int32();
+    if (ss.rows <= 0 || ss.columns <= 0)
+        throw general_error("document::load_snapshot: invalid sheet size.");
+
+    set_sheet_size(ss);
+
+    document_config cfg = get_config();
+    cfg.output_precision = reader.read_int32();
+    set_config(cfg);
+
+    int year = reader.read_int32();
+    int month = reader.read_int32();
+    int day = reader.read_int32();
+    set_origin_date(year, month, day);
+    set_formula_grammar(reader.read_enum<formula_grammar_t>());
+
+    ixion::model_context& cxt = mp_impl->m_context;
+    const ixion::formula_name_resolver* resolver = mp_impl->mp_name_resolver_global.get();
+    if (!resolver)
+        throw general_error("document::load_snapshot: no formula name resolver.");
+
+    // Shared strings.
+
+    import_shared_strings& strings = *mp_impl->mp_strings;
+    size_t string_count = reader.read_count();
+    for (size_t i = 0; i < string_count; ++i)
+    {
+        pstring str = reader.read_string();
+        size_t run_count = reader.read_count();
+        size_t sid = 0;
+
+        if (!run_count)
+            sid = strings.append(str.get(), str.size());
+        else
+        {
+            // Re-build the format runs through the segment interface.
+            size_t pos = 0;
+            for (size_t j = 0; j < run_count; ++j)
+            {
+                size_t run_pos = reader.read_uint64();
+                size_t run_size = reader.read_uint64();
+                if (run_pos < pos || run_size > str.size() || run_pos > str.size() - run_size)
+                    throw general_error("document::load_snapshot: invalid format run.");
+
+                if (run_pos > pos)
+                    // Unformatted segment before this run.
+                    strings.append_segment(str.get() + pos, run_pos - pos);
+
+                pstring font = reader.read_string();
+                strings.set_segment_font_name(font.get(), font.size());
+                strings.set_segment_font_size(reader.read_double());
+                color_elem_t alpha = reader.read_uint8();
+                color_elem_t red = reader.read_uint8();
+                color_elem_t green = reader.read_uint8();
+                color_elem_t blue = reader.read_uint8();
+                strings.set_segment_font_color(alpha, red, green, blue);
+                strings.set_segment_bold(reader.read_bool());
+                strings.set_segment_italic(reader.read_bool());
+                strings.append_segment(str.get() + run_pos, run_size);
+                pos = run_pos + run_size;
+            }
+
+            if (pos < str.size())
+                strings.append_segment(str.get() + pos, str.size() - pos);
+
+            sid = strings.commit_segments();
+        }
+
+        if (sid != i)
+            throw general_error("document::load_snapshot: string IDs are out of sync.");
+    }
+
+    detail::read_styles(reader, mp_impl->m_styles, mp_impl->m_string_pool);
+
+    size_t sheet_count = reader.read_count();
+    for (size_t i = 0; i < sheet_count; ++i)
+        append_sheet(reader.read_string());
+
+    read_named_expressions(reader, cxt, *resolver, -1);
+
+    for (size_t i = 0; i < sheet_count; ++i)
+        read_named_expressions(reader, cxt, *resolver, i);
+
+    // Tables.
+
+    string_pool& sp = mp_impl->m_string_pool;
+    size_t table_count = reader.read_count();
+    for (size_t i = 0; i < table_count; ++i)
+    {
+        auto tab = std::make_unique<table_t>();
+        tab->identifier = reader.read_uint64();
+        tab->name = sp.intern(reader.read_string()).first;
+        tab->display_name = sp.intern(reader.read_string()).first;
+        tab->range.first.sheet = reader.read_int32();
+        tab->range.first.row = reader.read_int32();
+        tab->range.first.column = reader.read_int32();
+        tab->range.last.sheet = reader.read_int32();
+        tab->range.last.row = reader.read_int32();
+        tab->range.last.column = reader.read_int32();
+        tab->totals_row_count = reader.read_uint64();
+        detail::read_auto_filter(reader, tab->filter, sp);
+
+        size_t column_count = reader.read_count();
+        tab->columns.reserve(column_count);
+        for (size_t j = 0; j < column_count; ++j)
+        {
+            table_column_t col;
+            col.identifier = reader.read_uint64();
+            col.name = sp.intern(reader.read_string()).first;
+            col.totals_row_label = sp.intern(reader.read_string()).first;
+            col.totals_row_function = reader.read_enum<totals_row_function_t>();
+            tab->columns.push_back(col);
+        }
+
+        tab->style.name = sp.intern(reader.read_string()).first;
+        tab->style.show_first_column = reader.read_bool();
+        tab->style.show_last_column = reader.read_bool();
+        tab->style.show_row_stripes = reader.read_bool();
+        tab->style.show_column_stripes = reader.read_bool();
+
+        insert_table(tab.release());
+    }
+
+    // Sheet content.
+
+    for (std::unique_ptr<sheet_item>& sh : mp_impl->m_sheets)
+        sh->data.read_snapshot(reader);
+
+    if (!reader.eof())
+        throw general_error("document::load_snapshot: trailing data found.");
+
+    finalize();
+    restorer.commit();
+}
+
 sheet_t document::get_sheet_index(const pstring& name) const
 {
     auto it = std::find_if(
@@ -773,6 +1222,12 @@ const ixion::formula_name_resolver* document::get_formula_name_resolver(formula_
     return mp_impl->mp_name_resolver_global.get();
 }
 
+void document::add_cell_size(sheet_t sheet_pos, size_t size)
+{
+    if (mp_impl->mp_spill_store)
+        mp_impl->mp_spill_store->add_size(sheet_pos, size);
+}
+
 void document::insert_dirty_cell(const ixion::abs_address_t& pos)
 {
     mp_impl->m_dirty_cells.insert(pos);
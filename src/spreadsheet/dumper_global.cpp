@@ -9,76 +9,88 @@
 #include "number_format.hpp"
 
 #include <ixion/formula_name_resolver.hpp>
-#include <ixion/formula_result.hpp>
-#include <ixion/cell.hpp>
+
+#include <algorithm>
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
+output_buffer::output_buffer(std::ostream& os, size_t block_size) :
+    m_os(os), m_block_size(block_size)
+{
+    m_buf.reserve(m_block_size);
+}
+
+output_buffer::~output_buffer()
+{
+    flush();
+}
+
+void output_buffer::write(double v)
+{
+    char buf[32];
+    int n = format_to_file_output(buf, sizeof(buf), v);
+    if (n > 0)
+        write(buf, std::min<size_t>(n, sizeof(buf)-1));
+}
+
+void output_buffer::flush()
+{
+    if (m_buf.empty())
+        return;
+
+    m_os.write(m_buf.data(), m_buf.size());
+    m_buf.clear();
+}
+
+namespace {
+
+class stream_cell_handler
+{
+    std::ostream& m_os;
+    const func_str_handler& m_str_handler;
+    const func_empty_handler& m_empty_handler;
+
+public:
+    stream_cell_handler(std::ostream& os, const func_str_handler& str_handler, const func_empty_handler& empty_handler) :
+        m_os(os), m_str_handler(str_handler), m_empty_handler(empty_handler) {}
+
+    void empty()
+    {
+        m_empty_handler(m_os);
+    }
+
+    void boolean(bool v)
+    {
+        m_os << (v ? "true" : "false");
+    }
+
+    void numeric(double v)
+    {
+        format_to_file_output(m_os, v);
+    }
+
+    void string(const std::string& s)
+    {
+        m_str_handler(m_os, s);
+    }
+
+    void error(const char* p, size_t n)
+    {
+        m_os << '"';
+        m_os.write(p, n);
+        m_os << '"';
+    }
+};
+
+}
+
 void dump_cell_value(
     std::ostream& os, const ixion::model_context& cxt, const ixion::model_iterator::cell& cell,
     func_str_handler str_handler,
     func_empty_handler empty_handler)
 {
-    switch (cell.type)
-    {
-        case ixion::celltype_t::empty:
-            empty_handler(os);
-            break;
-        case ixion::celltype_t::boolean:
-        {
-            os << (cell.value.boolean ? "true" : "false");
-            break;
-        }
-        case ixion::celltype_t::numeric:
-        {
-            format_to_file_output(os, cell.value.numeric);
-            break;
-        }
-        case ixion::celltype_t::string:
-        {
-            const std::string* p = cxt.get_string(cell.value.string);
-            assert(p);
-            str_handler(os, *p);
-            break;
-        }
-        case ixion::celltype_t::formula:
-        {
-            assert(cell.value.formula);
-            ixion::formula_result res;
-
-            try
-            {
-                res = cell.value.formula->get_result_cache(
-                    ixion::formula_result_wait_policy_t::throw_exception);
-            }
-            catch (const std::exception&)
-            {
-                os << "\"#RES!\"";
-                break;
-            }
-
-            switch (res.get_type())
-            {
-                case ixion::formula_result::result_type::value:
-                    format_to_file_output(os, res.get_value());
-                break;
-                case ixion::formula_result::result_type::string:
-                {
-                    const std::string& s = res.get_string();
-                    str_handler(os, s);
-                }
-                break;
-                case ixion::formula_result::result_type::error:
-                    os << "\"#ERR!\"";
-                break;
-                default:
-                    ;
-            }
-            break;
-        }
-        default:
-            ;
-    }
+    stream_cell_handler hdl(os, str_handler, empty_handler);
+    dump_cell_value(cxt, cell, hdl);
 }
 
 }}}
@@ -10,12 +10,141 @@
 
 #include <ixion/model_context.hpp>
 #include <ixion/model_iterator.hpp>
+#include <ixion/formula_result.hpp>
+#include <ixion/cell.hpp>
 
+#include <cassert>
 #include <ostream>
 #include <functional>
+#include <string>
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
+/**
+ * Output buffer that accumulates written bytes in a single block and hands
+ * them to the destination stream in large chunks, rather than going
+ * through the stream's formatting machinery for every character.  The
+ * remaining content gets flushed upon destruction.
+ */
+class output_buffer
+{
+    std::ostream& m_os;
+    std::string m_buf;
+    size_t m_block_size;
+
+public:
+    output_buffer(const output_buffer&) = delete;
+    output_buffer& operator=(const output_buffer&) = delete;
+
+    output_buffer(std::ostream& os, size_t block_size = 64*1024);
+    ~output_buffer();
+
+    void write(const char* p, size_t n)
+    {
+        if (n >= m_block_size)
+        {
+            // Too large to buffer. Write it straight through.
+            flush();
+            m_os.write(p, n);
+            return;
+        }
+
+        m_buf.append(p, n);
+        if (m_buf.size() >= m_block_size)
+            flush();
+    }
+
+    void write(const std::string& s)
+    {
+        write(s.data(), s.size());
+    }
+
+    void write(char c)
+    {
+        m_buf.push_back(c);
+        if (m_buf.size() >= m_block_size)
+            flush();
+    }
+
+    /**
+     * Append the lossless string representation of a numeric value.
+     */
+    void write(double v);
+
+    void flush();
+};
+
+/**
+ * Pass the value of a cell, or the cached result of a formula cell, to the
+ * handler.  The handler must provide the following methods:
+ *
+ * <ul>
+ * <li>void empty()</li>
+ * <li>void boolean(bool v)</li>
+ * <li>void numeric(double v)</li>
+ * <li>void string(const std::string& s)</li>
+ * <li>void error(const char* p, size_t n)</li>
+ * </ul>
+ */
+template<typename _Handler>
+void dump_cell_value(const ixion::model_context& cxt, const ixion::model_iterator::cell& cell, _Handler& hdl)
+{
+    switch (cell.type)
+    {
+        case ixion::celltype_t::empty:
+            hdl.empty();
+            break;
+        case ixion::celltype_t::boolean:
+            hdl.boolean(cell.value.boolean);
+            break;
+        case ixion::celltype_t::numeric:
+            hdl.numeric(cell.value.numeric);
+            break;
+        case ixion::celltype_t::string:
+        {
+            // This passes the string directly from the shared string store.
+            const std::string* p = cxt.get_string(cell.value.string);
+            assert(p);
+            hdl.string(*p);
+            break;
+        }
+        case ixion::celltype_t::formula:
+        {
+            assert(cell.value.formula);
+            ixion::formula_result res;
+
+            try
+            {
+                res = cell.value.formula->get_result_cache(
+                    ixion::formula_result_wait_policy_t::throw_exception);
+            }
+            catch (const std::exception&)
+            {
+                hdl.error("#RES!", 5);
+                break;
+            }
+
+            switch (res.get_type())
+            {
+                case ixion::formula_result::result_type::value:
+                    hdl.numeric(res.get_value());
+                break;
+                case ixion::formula_result::result_type::string:
+                    hdl.string(res.get_string());
+                break;
+                case ixion::formula_result::result_type::error:
+                    hdl.error("#ERR!", 5);
+                break;
+                default:
+                    ;
+            }
+            break;
+        }
+        default:
+            ;
+    }
+}
+
 using func_str_handler = std::function<void(std::ostream&, const std::string&)>;
 using func_empty_handler = std::function<void(std::ostream&)>;
 
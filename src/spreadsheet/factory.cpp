@@ -15,6 +15,8 @@
 #include "orcus/exception.hpp"
 #include "orcus/global.hpp"
 #include "orcus/string_pool.hpp"
+#include "orcus/import_stats.hpp"
+#include "orcus/detail/trace.hpp"
 
 #include "factory_pivot.hpp"
 #include "factory_sheet.hpp"
@@ -25,6 +27,7 @@
 #include <ixion/formula.hpp>
 #include <ixion/model_context.hpp>
 #include <sstream>
+#include <chrono>
 #include <iostream>
 #include <unordered_map>
 
@@ -125,6 +128,7 @@ class import_global_named_exp : public iface::import_named_expression
         assert(resolver);
 
         ixion::model_context& cxt = m_doc.get_model_context();
+        ORCUS_TRACE_SPAN("formula", "parse_formula_string");
         m_tokens = ixion::parse_formula_string(cxt, m_base, *resolver, p_exp, n_exp);
     }
 public:
@@ -182,6 +186,7 @@ struct import_factory::impl
 
     bool m_recalc_formula_cells;
     formula_error_policy_t m_error_policy;
+    import_stats* mp_stats;
 
     impl(import_factory& envelope, document& doc) :
         m_envelope(envelope),
@@ -195,7 +200,8 @@ struct import_factory::impl
         m_global_named_exp(doc),
         m_styles(doc.get_styles(), doc.get_string_pool()),
         m_recalc_formula_cells(false),
-        m_error_policy(formula_error_policy_t::fail) {}
+        m_error_policy(formula_error_policy_t::fail),
+        mp_stats(nullptr) {}
 };
 
 import_factory::import_factory(document& doc) :
@@ -270,12 +276,13 @@ iface::import_sheet* import_factory::append_sheet(
         sv = mp_impl->m_view->get_or_create_sheet_view(sheet_index);
 
     mp_impl->m_sheets.push_back(
-        std::make_unique<import_sheet>(mp_impl->m_doc, *sh, sv));
+        std::make_unique<import_sheet>(mp_impl->m_doc, *sh, sv, mp_impl->m_styles));
 
     import_sheet* p = mp_impl->m_sheets.back().get();
     p->set_character_set(mp_impl->m_charset);
     p->set_fill_missing_formula_results(!mp_impl->m_recalc_formula_cells);
     p->set_formula_error_policy(mp_impl->m_error_policy);
+    p->set_stats(mp_impl->mp_stats);
     return p;
 }
 
@@ -300,8 +307,18 @@ void import_factory::finalize()
 {
     mp_impl->m_doc.finalize();
 
-    if (mp_impl->m_recalc_formula_cells)
-        mp_impl->m_doc.recalc_formula_cells();
+    if (!mp_impl->m_recalc_formula_cells)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    mp_impl->m_doc.recalc_formula_cells();
+
+    if (mp_impl->mp_stats)
+    {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        mp_impl->mp_stats->recalc.duration += d.count();
+        ++mp_impl->mp_stats->recalc.count;
+    }
 }
 
 void import_factory::set_default_row_size(row_t row_size)
@@ -341,6 +358,21 @@ void import_factory::set_formula_error_policy(formula_error_policy_t policy)
     mp_impl->m_error_policy = policy;
 }
 
+void import_factory::set_stats(import_stats* stats)
+{
+    mp_impl->mp_stats = stats;
+    mp_impl->m_styles.set_stats(stats);
+    mp_impl->m_doc.get_shared_strings()->set_stats(stats);
+
+    for (std::unique_ptr<import_sheet>& sheet : mp_impl->m_sheets)
+        sheet->set_stats(stats);
+}
+
+void import_factory::set_deduplicate_styles(bool b)
+{
+    mp_impl->m_styles.set_deduplicate(b);
+}
+
 struct export_factory::impl
 {
     const document& m_doc;
@@ -260,13 +260,14 @@ void import_pivot_cache_def::commit()
 }
 
 import_pivot_cache_records::import_pivot_cache_records(document& doc) :
-    m_doc(doc), m_cache(nullptr) {}
+    m_doc(doc), m_cache(nullptr), m_records(doc.get_string_pool()) {}
 
 import_pivot_cache_records::~import_pivot_cache_records() {}
 
 void import_pivot_cache_records::set_cache(pivot_cache* p)
 {
     m_cache = p;
+    m_records = pivot_cache_records(m_doc.get_string_pool());
 }
 
 void import_pivot_cache_records::set_record_count(size_t n)
@@ -276,28 +277,22 @@ void import_pivot_cache_records::set_record_count(size_t n)
 
 void import_pivot_cache_records::append_record_value_numeric(double v)
 {
-    m_current_record.emplace_back(v);
+    m_records.append_value_numeric(v);
 }
 
 void import_pivot_cache_records::append_record_value_character(const char* p, size_t n)
 {
-    m_current_record.emplace_back(p, n);
+    m_records.append_value_character(p, n);
 }
 
 void import_pivot_cache_records::append_record_value_shared_item(size_t index)
 {
-    m_current_record.emplace_back(index);
+    m_records.append_value_shared_item(index);
 }
 
 void import_pivot_cache_records::commit_record()
 {
-    if (!m_cache)
-    {
-        m_current_record.clear();
-        return;
-    }
-
-    m_records.push_back(std::move(m_current_record));
+    m_records.commit_record();
 }
 
 void import_pivot_cache_records::commit()
@@ -92,8 +92,7 @@ class import_pivot_cache_records : public iface::import_pivot_cache_records
     document& m_doc;
     pivot_cache* m_cache; //< cache to push the records to at the very end.
 
-    pivot_cache_record_t m_current_record;
-    pivot_cache::records_type m_records;
+    pivot_cache_records m_records;
 
 public:
     import_pivot_cache_records(document& doc);
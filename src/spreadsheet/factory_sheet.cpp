@@ -7,11 +7,14 @@
 
 #include "factory_sheet.hpp"
 #include "orcus/spreadsheet/sheet.hpp"
+#include "orcus/spreadsheet/factory.hpp"
 #include "orcus/spreadsheet/document.hpp"
 #include "orcus/spreadsheet/view.hpp"
 #include "orcus/global.hpp"
 #include "orcus/measurement.hpp"
 #include "orcus/string_pool.hpp"
+#include "orcus/import_stats.hpp"
+#include "orcus/detail/trace.hpp"
 
 #include "formula_global.hpp"
 
@@ -35,6 +38,7 @@ void import_sheet_named_exp::define(const char* p_name, size_t n_name, const cha
     assert(resolver);
 
     ixion::model_context& cxt = m_doc.get_model_context();
+    ORCUS_TRACE_SPAN("formula", "parse_formula_string");
     m_tokens = ixion::parse_formula_string(cxt, m_base, *resolver, p_exp, n_exp);
 }
 
@@ -139,7 +143,8 @@ void import_auto_filter::commit()
 }
 
 import_array_formula::import_array_formula(document& doc, sheet& sheet) :
-    m_doc(doc), m_sheet(sheet), m_missing_formula_result(), m_error_policy(formula_error_policy_t::fail)
+    m_doc(doc), m_sheet(sheet), m_missing_formula_result(), m_error_policy(formula_error_policy_t::fail),
+    mp_stats(nullptr)
 {
     m_range.first.column = -1;
     m_range.first.row = -1;
@@ -207,6 +212,7 @@ void import_array_formula::set_formula(formula_grammar_t grammar, const char* p,
 
     try
     {
+        ORCUS_TRACE_SPAN("formula", "parse_formula_string");
         m_tokens = ixion::parse_formula_string(cxt, pos, *resolver, p, n);
     }
     catch (const std::exception& e)
@@ -244,6 +250,9 @@ void import_array_formula::commit()
 {
     ixion::formula_result cached_results(std::move(m_result_mtx));
     m_sheet.set_grouped_formula(m_range, std::move(m_tokens), std::move(cached_results));
+
+    if (mp_stats)
+        ++mp_stats->cells.formula;
 }
 
 void import_array_formula::set_missing_formula_result(ixion::formula_result result)
@@ -256,6 +265,11 @@ void import_array_formula::set_formula_error_policy(formula_error_policy_t polic
     m_error_policy = policy;
 }
 
+void import_array_formula::set_stats(import_stats* stats)
+{
+    mp_stats = stats;
+}
+
 void import_array_formula::reset()
 {
     m_tokens.clear();
@@ -274,7 +288,8 @@ import_formula::import_formula(document& doc, sheet& sheet, shared_formula_pool&
     m_col(-1),
     m_shared_index(0),
     m_shared(false),
-    m_error_policy(formula_error_policy_t::fail) {}
+    m_error_policy(formula_error_policy_t::fail),
+    mp_stats(nullptr) {}
 
 import_formula::~import_formula() {}
 
@@ -301,6 +316,7 @@ void import_formula::set_formula(formula_grammar_t grammar, const char* p, size_
     ixion::formula_tokens_t tokens;
     try
     {
+        ORCUS_TRACE_SPAN("formula", "parse_formula_string");
         tokens = ixion::parse_formula_string(cxt, pos, *resolver, p, n);
     }
     catch (const std::exception& e)
@@ -351,6 +367,9 @@ void import_formula::commit()
                 m_sheet.set_formula(m_row, m_col, m_tokens_store);
 
             m_shared_formula_pool.add(m_shared_index, m_tokens_store);
+
+            if (mp_stats)
+                ++mp_stats->cells.formula;
         }
         else
         {
@@ -362,6 +381,9 @@ void import_formula::commit()
                 m_sheet.set_formula(m_row, m_col, ts, *m_result);
             else
                 m_sheet.set_formula(m_row, m_col, ts);
+
+            if (mp_stats)
+                ++mp_stats->cells.formula;
         }
         return;
     }
@@ -370,6 +392,9 @@ void import_formula::commit()
         m_sheet.set_formula(m_row, m_col, m_tokens_store, *m_result);
     else
         m_sheet.set_formula(m_row, m_col, m_tokens_store);
+
+    if (mp_stats)
+        ++mp_stats->cells.formula;
 }
 
 void import_formula::set_missing_formula_result(ixion::formula_result result)
@@ -382,6 +407,11 @@ void import_formula::set_formula_error_policy(formula_error_policy_t policy)
     m_error_policy = policy;
 }
 
+void import_formula::set_stats(import_stats* stats)
+{
+    mp_stats = stats;
+}
+
 void import_formula::reset()
 {
     m_tokens_store.reset();
@@ -392,9 +422,10 @@ void import_formula::reset()
     m_shared = false;
 }
 
-import_sheet::import_sheet(document& doc, sheet& sh, sheet_view* view) :
+import_sheet::import_sheet(document& doc, sheet& sh, sheet_view* view, const import_styles& styles) :
     m_doc(doc),
     m_sheet(sh),
+    m_styles(styles),
     m_formula(doc, sh, m_shared_formula_pool),
     m_array_formula(doc, sh),
     m_named_exp(doc, sh.get_index()),
@@ -403,7 +434,8 @@ import_sheet::import_sheet(document& doc, sheet& sh, sheet_view* view) :
     m_auto_filter(sh, doc.get_string_pool()),
     m_table(doc, sh),
     m_charset(character_set_t::unspecified),
-    m_fill_missing_formula_results(false)
+    m_fill_missing_formula_results(false),
+    mp_stats(nullptr)
 {
     if (view)
         m_sheet_view = std::make_unique<import_sheet_view>(*view, sh.get_index());
@@ -476,38 +508,76 @@ iface::import_array_formula* import_sheet::get_array_formula()
 
 void import_sheet::set_auto(row_t row, col_t col, const char* p, size_t n)
 {
-    m_sheet.set_auto(row, col, p, n);
+    if (!mp_stats)
+    {
+        m_sheet.set_auto(row, col, p, n);
+        return;
+    }
+
+    // The sheet decides the type of the value, and a string value goes
+    // straight into the string pool of the model without going through the
+    // shared strings.  A new string grows the pool.
+    ixion::model_context& cxt = m_doc.get_model_context();
+    size_t string_count = cxt.get_string_count();
+
+    switch (m_sheet.set_auto(row, col, p, n))
+    {
+        case ixion::celltype_t::numeric:
+            ++mp_stats->cells.numeric;
+            break;
+        case ixion::celltype_t::string:
+            ++mp_stats->cells.string;
+            if (cxt.get_string_count() > string_count)
+                ++mp_stats->strings.interned;
+            else
+                ++mp_stats->strings.deduplicated;
+            break;
+        default:
+            ;
+    }
 }
 
 void import_sheet::set_bool(row_t row, col_t col, bool value)
 {
     m_sheet.set_bool(row, col, value);
+
+    if (mp_stats)
+        ++mp_stats->cells.boolean;
 }
 
 void import_sheet::set_date_time(row_t row, col_t col, int year, int month, int day, int hour, int minute, double second)
 {
     m_sheet.set_date_time(row, col, year, month, day, hour, minute, second);
+
+    if (mp_stats)
+        ++mp_stats->cells.date_time;
 }
 
 void import_sheet::set_format(row_t row, col_t col, size_t xf_index)
 {
-    m_sheet.set_format(row, col, xf_index);
+    m_sheet.set_format(row, col, m_styles.get_cell_format_index(xf_index));
 }
 
 void import_sheet::set_format(
     row_t row_start, col_t col_start, row_t row_end, col_t col_end, size_t xf_index)
 {
-    m_sheet.set_format(row_start, col_start, row_end, col_end, xf_index);
+    m_sheet.set_format(row_start, col_start, row_end, col_end, m_styles.get_cell_format_index(xf_index));
 }
 
 void import_sheet::set_string(row_t row, col_t col, size_t sindex)
 {
     m_sheet.set_string(row, col, sindex);
+
+    if (mp_stats)
+        ++mp_stats->cells.string;
 }
 
 void import_sheet::set_value(row_t row, col_t col, double value)
 {
     m_sheet.set_value(row, col, value);
+
+    if (mp_stats)
+        ++mp_stats->cells.numeric;
 }
 
 void import_sheet::fill_down_cells(row_t src_row, col_t src_col, row_t range_size)
@@ -520,6 +590,11 @@ range_size_t import_sheet::get_sheet_size() const
     return m_doc.get_sheet_size();
 }
 
+void import_sheet::set_data_range_hint(const range_t& range)
+{
+    m_sheet.set_data_range_hint(range);
+}
+
 void import_sheet::set_character_set(character_set_t charset)
 {
     m_charset = charset;
@@ -536,6 +611,13 @@ void import_sheet::set_formula_error_policy(formula_error_policy_t policy)
     m_array_formula.set_formula_error_policy(policy);
 }
 
+void import_sheet::set_stats(import_stats* stats)
+{
+    mp_stats = stats;
+    m_formula.set_stats(stats);
+    m_array_formula.set_stats(stats);
+}
+
 import_sheet_view::import_sheet_view(sheet_view& view, sheet_t si) :
     m_view(view), m_sheet_index(si) {}
 
@@ -607,6 +689,8 @@ export_sheet::~export_sheet() {}
 
 void export_sheet::write_string(std::ostream& os, row_t row, col_t col) const
 {
+    m_doc.page_in_sheet(m_sheet.get_index());
+
     const ixion::model_context& cxt = m_doc.get_model_context();
     ixion::abs_address_t pos(m_sheet.get_index(), row, col);
 
@@ -26,6 +26,7 @@
 namespace orcus {
 
 class string_pool;
+struct import_stats;
 
 namespace spreadsheet {
 
@@ -33,6 +34,7 @@ class document;
 class sheet_view;
 class sheet;
 class import_sheet_view;
+class import_styles;
 
 class import_sheet_named_exp : public iface::import_named_expression
 {
@@ -127,6 +129,7 @@ class import_array_formula : public iface::import_array_formula
     ixion::formula_result m_missing_formula_result;
     ixion::matrix m_result_mtx;
     formula_error_policy_t m_error_policy;
+    import_stats* mp_stats;
 
 public:
     import_array_formula(document& doc, sheet& sheet);
@@ -150,6 +153,8 @@ public:
 
     void set_formula_error_policy(formula_error_policy_t policy);
 
+    void set_stats(import_stats* stats);
+
     void reset();
 };
 
@@ -167,6 +172,7 @@ class import_formula : public iface::import_formula
     ixion::formula_tokens_store_ptr_t m_tokens_store;
     boost::optional<ixion::formula_result> m_result;
     formula_error_policy_t m_error_policy;
+    import_stats* mp_stats;
 
 public:
     import_formula(document& doc, sheet& sheet, shared_formula_pool& pool);
@@ -183,6 +189,7 @@ public:
 
     void set_missing_formula_result(ixion::formula_result result);
     void set_formula_error_policy(formula_error_policy_t policy);
+    void set_stats(import_stats* stats);
 
     void reset();
 };
@@ -191,6 +198,7 @@ class import_sheet : public iface::import_sheet
 {
     document& m_doc;
     sheet& m_sheet;
+    const import_styles& m_styles;
     shared_formula_pool m_shared_formula_pool;
     import_formula m_formula;
     import_array_formula m_array_formula;
@@ -205,8 +213,10 @@ class import_sheet : public iface::import_sheet
 
     bool m_fill_missing_formula_results;
 
+    import_stats* mp_stats;
+
 public:
-    import_sheet(document& doc, sheet& sh, sheet_view* view);
+    import_sheet(document& doc, sheet& sh, sheet_view* view, const import_styles& styles);
     virtual ~import_sheet() override;
 
     virtual iface::import_sheet_view* get_sheet_view() override;
@@ -227,10 +237,17 @@ public:
     virtual void set_value(row_t row, col_t col, double value) override;
     virtual void fill_down_cells(row_t src_row, col_t src_col, row_t range_size) override;
     virtual range_size_t get_sheet_size() const override;
+    virtual void set_data_range_hint(const range_t& range) override;
 
     void set_character_set(character_set_t charset);
     void set_fill_missing_formula_results(bool b);
     void set_formula_error_policy(formula_error_policy_t policy);
+
+    /**
+     * Set the statistics instance to record the number of imported cells
+     * by type into.
+     */
+    void set_stats(import_stats* stats);
 };
 
 class import_sheet_view : public iface::import_sheet_view
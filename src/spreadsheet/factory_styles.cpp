@@ -9,13 +9,179 @@
 #include "orcus/spreadsheet/styles.hpp"
 #include "orcus/global.hpp"
 #include "orcus/string_pool.hpp"
+#include "orcus/import_stats.hpp"
+
+#include <unordered_map>
+#include <vector>
+#include <functional>
 
 namespace orcus { namespace spreadsheet {
 
+namespace {
+
+class style_hasher
+{
+    size_t m_value = 0;
+
+public:
+    template<typename T>
+    style_hasher& operator<< (const T& v)
+    {
+        m_value ^= std::hash<T>()(v) + 0x9e3779b9 + (m_value << 6) + (m_value >> 2);
+        return *this;
+    }
+
+    style_hasher& operator<< (const pstring& v)
+    {
+        return *this << pstring::hash()(v);
+    }
+
+    style_hasher& operator<< (const color_t& v)
+    {
+        return *this << v.alpha << v.red << v.green << v.blue;
+    }
+
+    style_hasher& operator<< (const border_attrs_t& v)
+    {
+        return *this << v.style << v.border_color << v.border_width.unit << v.border_width.value;
+    }
+
+    size_t get() const { return m_value; }
+};
+
+/**
+ * Hash and equality functions for the style entries.  These take every
+ * attribute of each entry into account.
+ */
+struct style_entry_func
+{
+    size_t operator() (const font_t& v) const
+    {
+        style_hasher h;
+        h << v.name << v.size << bool(v.bold) << bool(v.italic)
+          << v.underline_style << v.underline_width << v.underline_mode << v.underline_type
+          << v.underline_color << v.color
+          << v.strikethrough_style << v.strikethrough_width << v.strikethrough_type << v.strikethrough_text;
+        return h.get();
+    }
+
+    bool operator() (const font_t& l, const font_t& r) const
+    {
+        return l.name == r.name && l.size == r.size && l.bold == r.bold && l.italic == r.italic
+            && l.underline_style == r.underline_style && l.underline_width == r.underline_width
+            && l.underline_mode == r.underline_mode && l.underline_type == r.underline_type
+            && l.underline_color == r.underline_color && l.color == r.color
+            && l.strikethrough_style == r.strikethrough_style && l.strikethrough_width == r.strikethrough_width
+            && l.strikethrough_type == r.strikethrough_type && l.strikethrough_text == r.strikethrough_text;
+    }
+
+    size_t operator() (const fill_t& v) const
+    {
+        style_hasher h;
+        h << v.pattern_type << v.fg_color << v.bg_color;
+        return h.get();
+    }
+
+    bool operator() (const fill_t& l, const fill_t& r) const
+    {
+        return l.pattern_type == r.pattern_type && l.fg_color == r.fg_color && l.bg_color == r.bg_color;
+    }
+
+    size_t operator() (const border_t& v) const
+    {
+        style_hasher h;
+        h << v.top << v.bottom << v.left << v.right << v.diagonal << v.diagonal_bl_tr << v.diagonal_tl_br;
+        return h.get();
+    }
+
+    bool operator() (const border_attrs_t& l, const border_attrs_t& r) const
+    {
+        return l.style == r.style && l.border_color == r.border_color
+            && l.border_width.unit == r.border_width.unit && l.border_width.value == r.border_width.value;
+    }
+
+    bool operator() (const border_t& l, const border_t& r) const
+    {
+        const style_entry_func& eq = *this;
+        return eq(l.top, r.top) && eq(l.bottom, r.bottom) && eq(l.left, r.left) && eq(l.right, r.right)
+            && eq(l.diagonal, r.diagonal) && eq(l.diagonal_bl_tr, r.diagonal_bl_tr)
+            && eq(l.diagonal_tl_br, r.diagonal_tl_br);
+    }
+
+    size_t operator() (const protection_t& v) const
+    {
+        style_hasher h;
+        h << v.locked << v.hidden << v.print_content << v.formula_hidden;
+        return h.get();
+    }
+
+    bool operator() (const protection_t& l, const protection_t& r) const
+    {
+        return l.locked == r.locked && l.hidden == r.hidden
+            && l.print_content == r.print_content && l.formula_hidden == r.formula_hidden;
+    }
+
+    size_t operator() (const cell_format_t& v) const
+    {
+        style_hasher h;
+        h << v.font << v.fill << v.border << v.protection << v.number_format << v.style_xf
+          << v.hor_align << v.ver_align
+          << bool(v.apply_num_format) << bool(v.apply_font) << bool(v.apply_fill)
+          << bool(v.apply_border) << bool(v.apply_alignment) << bool(v.apply_protection);
+        return h.get();
+    }
+
+    bool operator() (const cell_format_t& l, const cell_format_t& r) const
+    {
+        return l.font == r.font && l.fill == r.fill && l.border == r.border
+            && l.protection == r.protection && l.number_format == r.number_format
+            && l.style_xf == r.style_xf && l.hor_align == r.hor_align && l.ver_align == r.ver_align
+            && l.apply_num_format == r.apply_num_format && l.apply_font == r.apply_font
+            && l.apply_fill == r.apply_fill && l.apply_border == r.apply_border
+            && l.apply_alignment == r.apply_alignment && l.apply_protection == r.apply_protection;
+    }
+};
+
+/**
+ * Keeps track of the stored entries of one style type, and maps the
+ * indices of the committed entries to the indices of the stored entries.
+ */
+template<typename T>
+struct dedup_map
+{
+    std::unordered_map<T, size_t, style_entry_func, style_entry_func> stored;
+    std::vector<size_t> indices;
+
+    /**
+     * Entries not yet committed are referenced as-is.
+     */
+    size_t get(size_t index) const
+    {
+        return index < indices.size() ? indices[index] : index;
+    }
+
+    void reserve(size_t n)
+    {
+        stored.reserve(n);
+        indices.reserve(n);
+    }
+};
+
+}
+
 struct import_styles::impl
 {
     styles& m_styles;
     string_pool& m_string_pool;
+    import_stats* mp_stats = nullptr;
+
+    bool m_dedup = false;
+    dedup_map<font_t> m_font_map;
+    dedup_map<fill_t> m_fill_map;
+    dedup_map<border_t> m_border_map;
+    dedup_map<protection_t> m_protection_map;
+    dedup_map<cell_format_t> m_cell_style_format_map;
+    dedup_map<cell_format_t> m_cell_format_map;
 
     font_t m_cur_font;
     fill_t m_cur_fill;
@@ -28,6 +194,58 @@ struct import_styles::impl
     impl(styles& styles, string_pool& sp) :
         m_styles(styles),
         m_string_pool(sp) {}
+
+    /**
+     * Store a committed entry unless an identical entry has already been
+     * stored.
+     *
+     * @return index of the committed entry in the order of the commits when
+     *         deduplicating, otherwise index of the stored entry.
+     */
+    template<typename T, typename AppendFunc>
+    size_t commit(dedup_map<T>& map, const T& entry, AppendFunc append)
+    {
+        if (!m_dedup)
+            return append(entry);
+
+        size_t index = map.indices.size();
+
+        auto it = map.stored.find(entry);
+        if (it != map.stored.end())
+        {
+            map.indices.push_back(it->second);
+            if (mp_stats)
+                ++mp_stats->style_entries.deduplicated;
+            return index;
+        }
+
+        size_t stored_index = append(entry);
+        map.stored.emplace(entry, stored_index);
+        map.indices.push_back(stored_index);
+        if (mp_stats)
+            ++mp_stats->style_entries.stored;
+        return index;
+    }
+
+    /**
+     * Map the indices referenced by the current cell format to the indices
+     * of the stored entries.  The number format is not mapped since some
+     * importers reference it by its identifier rather than by its index.
+     */
+    void map_cell_format_indices(bool cell_format)
+    {
+        if (!m_dedup)
+            return;
+
+        cell_format_t& cf = m_cur_cell_format;
+        cf.font = m_font_map.get(cf.font);
+        cf.fill = m_fill_map.get(cf.fill);
+        cf.border = m_border_map.get(cf.border);
+        cf.protection = m_protection_map.get(cf.protection);
+
+        if (cell_format)
+            cf.style_xf = m_cell_style_format_map.get(cf.style_xf);
+    }
 };
 
 import_styles::import_styles(styles& styles, string_pool& sp) :
@@ -35,9 +253,26 @@ import_styles::import_styles(styles& styles, string_pool& sp) :
 
 import_styles::~import_styles() {}
 
+void import_styles::set_deduplicate(bool b)
+{
+    mp_impl->m_dedup = b;
+}
+
+void import_styles::set_stats(import_stats* stats)
+{
+    mp_impl->mp_stats = stats;
+}
+
+size_t import_styles::get_cell_format_index(size_t index) const
+{
+    return mp_impl->m_cell_format_map.get(index);
+}
+
 void import_styles::set_font_count(size_t n)
 {
     mp_impl->m_styles.reserve_font_store(n);
+    if (mp_impl->m_dedup)
+        mp_impl->m_font_map.reserve(n);
 }
 
 void import_styles::set_font_bold(bool b)
@@ -112,7 +347,9 @@ void import_styles::set_strikethrough_text(strikethrough_text_t s)
 
 size_t import_styles::commit_font()
 {
-    size_t font_id = mp_impl->m_styles.append_font(mp_impl->m_cur_font);
+    size_t font_id = mp_impl->commit(
+        mp_impl->m_font_map, mp_impl->m_cur_font,
+        [this](const font_t& v) { return mp_impl->m_styles.append_font(v); });
     mp_impl->m_cur_font.reset();
     return font_id;
 }
@@ -120,6 +357,8 @@ size_t import_styles::commit_font()
 void import_styles::set_fill_count(size_t n)
 {
     mp_impl->m_styles.reserve_fill_store(n);
+    if (mp_impl->m_dedup)
+        mp_impl->m_fill_map.reserve(n);
 }
 
 void import_styles::set_fill_pattern_type(fill_pattern_t fp)
@@ -139,7 +378,9 @@ void import_styles::set_fill_bg_color(color_elem_t alpha, color_elem_t red, colo
 
 size_t import_styles::commit_fill()
 {
-    size_t fill_id = mp_impl->m_styles.append_fill(mp_impl->m_cur_fill);
+    size_t fill_id = mp_impl->commit(
+        mp_impl->m_fill_map, mp_impl->m_cur_fill,
+        [this](const fill_t& v) { return mp_impl->m_styles.append_fill(v); });
     mp_impl->m_cur_fill.reset();
     return fill_id;
 }
@@ -147,6 +388,8 @@ size_t import_styles::commit_fill()
 void import_styles::set_border_count(size_t n)
 {
     mp_impl->m_styles.reserve_border_store(n);
+    if (mp_impl->m_dedup)
+        mp_impl->m_border_map.reserve(n);
 }
 
 namespace {
@@ -213,7 +456,9 @@ void import_styles::set_border_width(border_direction_t dir, double width, orcus
 
 size_t import_styles::commit_border()
 {
-    size_t border_id = mp_impl->m_styles.append_border(mp_impl->m_cur_border);
+    size_t border_id = mp_impl->commit(
+        mp_impl->m_border_map, mp_impl->m_cur_border,
+        [this](const border_t& v) { return mp_impl->m_styles.append_border(v); });
     mp_impl->m_cur_border.reset();
     return border_id;
 }
@@ -240,7 +485,9 @@ void import_styles::set_cell_formula_hidden(bool b)
 
 size_t import_styles::commit_cell_protection()
 {
-    size_t cp_id = mp_impl->m_styles.append_protection(mp_impl->m_cur_protection);
+    size_t cp_id = mp_impl->commit(
+        mp_impl->m_protection_map, mp_impl->m_cur_protection,
+        [this](const protection_t& v) { return mp_impl->m_styles.append_protection(v); });
     mp_impl->m_cur_protection.reset();
     return cp_id;
 }
@@ -270,11 +517,15 @@ size_t import_styles::commit_number_format()
 void import_styles::set_cell_xf_count(size_t n)
 {
     mp_impl->m_styles.reserve_cell_format_store(n);
+    if (mp_impl->m_dedup)
+        mp_impl->m_cell_format_map.reserve(n);
 }
 
 void import_styles::set_cell_style_xf_count(size_t n)
 {
     mp_impl->m_styles.reserve_cell_style_format_store(n);
+    if (mp_impl->m_dedup)
+        mp_impl->m_cell_style_format_map.reserve(n);
 }
 
 void import_styles::set_dxf_count(size_t n)
@@ -333,20 +584,27 @@ void import_styles::set_xf_vertical_alignment(orcus::spreadsheet::ver_alignment_
 
 size_t import_styles::commit_cell_xf()
 {
-    size_t n = mp_impl->m_styles.append_cell_format(mp_impl->m_cur_cell_format);
+    mp_impl->map_cell_format_indices(true);
+    size_t n = mp_impl->commit(
+        mp_impl->m_cell_format_map, mp_impl->m_cur_cell_format,
+        [this](const cell_format_t& v) { return mp_impl->m_styles.append_cell_format(v); });
     mp_impl->m_cur_cell_format.reset();
     return n;
 }
 
 size_t import_styles::commit_cell_style_xf()
 {
-    size_t n = mp_impl->m_styles.append_cell_style_format(mp_impl->m_cur_cell_format);
+    mp_impl->map_cell_format_indices(false);
+    size_t n = mp_impl->commit(
+        mp_impl->m_cell_style_format_map, mp_impl->m_cur_cell_format,
+        [this](const cell_format_t& v) { return mp_impl->m_styles.append_cell_style_format(v); });
     mp_impl->m_cur_cell_format.reset();
     return n;
 }
 
 size_t import_styles::commit_dxf()
 {
+    mp_impl->map_cell_format_indices(false);
     size_t n = mp_impl->m_styles.append_diff_cell_format(mp_impl->m_cur_cell_format);
     mp_impl->m_cur_cell_format.reset();
     return n;
@@ -381,6 +639,12 @@ void import_styles::set_cell_style_parent_name(const char* s, size_t n)
 
 size_t import_styles::commit_cell_style()
 {
+    if (mp_impl->m_dedup)
+    {
+        cell_style_t& cs = mp_impl->m_cur_cell_style;
+        cs.xf = mp_impl->m_cell_style_format_map.get(cs.xf);
+    }
+
     size_t n = mp_impl->m_styles.append_cell_style(mp_impl->m_cur_cell_style);
     mp_impl->m_cur_cell_style.reset();
     return n;
@@ -6,22 +6,28 @@
  */
 
 #include "html_dumper.hpp"
-#include "impl_types.hpp"
-#include "number_format.hpp"
+#include "sheet_impl.hpp"
+#include "dumper_global.hpp"
 
 #include "orcus/spreadsheet/styles.hpp"
 #include "orcus/spreadsheet/shared_strings.hpp"
 #include "orcus/spreadsheet/document.hpp"
 #include "orcus/spreadsheet/sheet.hpp"
 #include "orcus/global.hpp"
+#include "orcus/exception.hpp"
 
 #include <ixion/address.hpp>
 #include <ixion/model_context.hpp>
+#include <ixion/model_iterator.hpp>
 #include <ixion/formula.hpp>
 #include <ixion/formula_result.hpp>
 #include <ixion/cell.hpp>
 
 #include <sstream>
+#include <cstring>
+#include <cassert>
+#include <unordered_map>
+#include <algorithm>
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
@@ -77,56 +83,47 @@ const char* css_style_global =
     "color : white; "
 "}\n";
 
+/**
+ * Write a string literal without having to measure its length at run time.
+ */
+template<size_t N>
+void write_literal(output_buffer& buf, const char (&s)[N])
+{
+    buf.write(s, N-1);
+}
+
 class html_elem
 {
 public:
-    struct attr
+    html_elem(output_buffer& buf, const char* name, const char* style = nullptr) :
+        m_buf(buf), m_name(name)
     {
-        std::string name;
-        std::string value;
-
-        attr(const std::string& _name, const std::string& _value) : name(_name), value(_value) {}
-    };
-
-    typedef std::vector<attr> attrs_type;
-
-    html_elem(std::ostream& strm, const char* name, const char* style = nullptr, const char* style_class = nullptr) :
-        m_strm(strm), m_name(name)
-    {
-        m_strm << '<' << m_name;
+        m_buf.write('<');
+        m_buf.write(m_name, std::strlen(m_name));
 
         if (style)
-            m_strm << " style=\"" << style << "\"";
-
-        if (style_class)
-            m_strm << " class=\"" << style_class << "\"";
-
-        m_strm << '>';
-    }
-
-    html_elem(std::ostream& strm, const char* name, const attrs_type& attrs) :
-        m_strm(strm), m_name(name)
-    {
-        m_strm << '<' << m_name;
-
-        attrs_type::const_iterator it = attrs.begin(), it_end = attrs.end();
-        for (; it != it_end; ++it)
-            m_strm << " " << it->name << "=\"" << it->value << "\"";
+        {
+            write_literal(m_buf, " style=\"");
+            m_buf.write(style, std::strlen(style));
+            m_buf.write('"');
+        }
 
-        m_strm << '>';
+        m_buf.write('>');
     }
 
     ~html_elem()
     {
-        m_strm << "</" << m_name << '>';
+        write_literal(m_buf, "</");
+        m_buf.write(m_name, std::strlen(m_name));
+        m_buf.write('>');
     }
 
 private:
-    std::ostream& m_strm;
+    output_buffer& m_buf;
     const char* m_name;
 };
 
-void print_formatted_text(std::ostream& strm, const std::string& text, const format_runs_t& formats)
+void print_formatted_text(output_buffer& buf, const std::string& text, const format_runs_t& formats)
 {
     typedef html_elem elem;
 
@@ -140,7 +137,7 @@ void print_formatted_text(std::ostream& strm, const std::string& text, const for
         if (pos < run.pos)
         {
             // flush unformatted text.
-            strm << std::string(&text[pos], run.pos-pos);
+            buf.write(&text[pos], run.pos-pos);
             pos = run.pos;
         }
 
@@ -179,11 +176,11 @@ void print_formatted_text(std::ostream& strm, const std::string& text, const for
         }
 
         if (style.empty())
-            strm << std::string(&text[pos], run.size);
+            buf.write(&text[pos], run.size);
         else
         {
-            elem span(strm, p_span, style.c_str());
-            strm << std::string(&text[pos], run.size);
+            elem span(buf, p_span, style.c_str());
+            buf.write(&text[pos], run.size);
         }
 
         pos += run.size;
@@ -192,7 +189,7 @@ void print_formatted_text(std::ostream& strm, const std::string& text, const for
     if (pos < text.size())
     {
         // flush the remaining unformatted text.
-        strm << std::string(&text[pos], text.size() - pos);
+        buf.write(&text[pos], text.size() - pos);
     }
 }
 
@@ -360,310 +357,404 @@ void build_style_string(std::string& str, const styles& styles, const cell_forma
     str += os.str();
 }
 
-void dump_html_head(std::ostream& os)
+void dump_html_head(output_buffer& buf)
 {
     typedef html_elem elem;
 
     const char* p_head = "head";
     const char* p_style = "style";
 
-    elem elem_head(os, p_head);
+    elem elem_head(buf, p_head);
     {
-        elem elem_style(os, p_style);
-        os << css_style_global;
+        elem elem_style(buf, p_style);
+        buf.write(css_style_global, std::strlen(css_style_global));
     }
 }
 
-void build_html_elem_attributes(html_elem::attrs_type& attrs, const std::string& style, const merge_size* p_merge_size)
+void write_td_open(output_buffer& buf, const std::string& style, const merge_size* p_merge_size, bool empty)
 {
-    attrs.push_back(html_elem::attr("style", style));
+    write_literal(buf, "<td style=\"");
+    buf.write(style);
+    buf.write('"');
+
     if (p_merge_size)
     {
         if (p_merge_size->width > 1)
         {
-            std::ostringstream os2;
-            os2 << p_merge_size->width;
-            attrs.push_back(html_elem::attr("colspan", os2.str()));
+            write_literal(buf, " colspan=\"");
+            buf.write(std::to_string(p_merge_size->width));
+            buf.write('"');
         }
 
         if (p_merge_size->height > 1)
         {
-            std::ostringstream os2;
-            os2 << p_merge_size->height;
-            attrs.push_back(html_elem::attr("rowspan", os2.str()));
+            write_literal(buf, " rowspan=\"");
+            buf.write(std::to_string(p_merge_size->height));
+            buf.write('"');
         }
     }
-}
 
-}
+    if (empty)
+        write_literal(buf, " class=\"empty\"");
 
-html_dumper::html_dumper(
-    const document& doc,
-    const col_merge_size_type& merge_ranges,
-    sheet_t sheet_id) :
-    m_doc(doc),
-    m_merge_ranges(merge_ranges),
-    m_sheet_id(sheet_id)
-{
-    build_overlapped_ranges();
+    buf.write('>');
 }
 
-void html_dumper::dump(std::ostream& os) const
+/**
+ * Index of the merged ranges of a sheet, with one entry for each row a
+ * merged range covers, sorted in row-major order.  The cells must be
+ * looked up in row-major order, which lets the cursor only move forward.
+ */
+class merge_cursor
 {
-    const sheet* sh = m_doc.get_sheet(m_sheet_id);
-    if (!sh)
-        return;
+public:
+    struct entry
+    {
+        row_t row;
+        col_t first_col;
+        col_t last_col;
 
-    typedef html_elem elem;
+        /** Non-null only on the top row of the merged range. */
+        const merge_size* origin;
+    };
 
-    const char* p_html  = "html";
-    const char* p_body  = "body";
-    const char* p_table = "table";
-    const char* p_tr    = "tr";
-    const char* p_td    = "td";
+private:
+    std::vector<entry> m_entries;
+    size_t m_pos;
+
+public:
+    merge_cursor(const col_merge_size_type& merge_ranges) : m_pos(0)
+    {
+        for (const auto& col_entry : merge_ranges)
+        {
+            col_t col = col_entry.first;
 
-    ixion::abs_range_t range = sh->get_data_range();
+            for (const auto& row_entry : *col_entry.second)
+            {
+                const merge_size& item = row_entry.second;
+                if (item.width <= 0)
+                    continue;
+
+                for (row_t i = 0; i < item.height; ++i)
+                {
+                    const merge_size* origin = i ? nullptr : &item;
+                    m_entries.push_back({row_entry.first + i, col, col + item.width - 1, origin});
+                }
+            }
+        }
 
-    elem root(os, p_html);
-    dump_html_head(os);
+        std::sort(m_entries.begin(), m_entries.end(),
+            [](const entry& left, const entry& right)
+            {
+                if (left.row != right.row)
+                    return left.row < right.row;
+                return left.first_col < right.first_col;
+            }
+        );
+    }
 
+    /**
+     * @return merged range entry covering the cell, or nullptr if the cell
+     *         is not part of any merged range.
+     */
+    const entry* find(row_t row, col_t col)
     {
-        elem elem_body(os, p_body);
+        for (; m_pos < m_entries.size(); ++m_pos)
+        {
+            const entry& e = m_entries[m_pos];
+            if (e.row > row || (e.row == row && e.last_col >= col))
+                break;
+        }
 
-        if (!range.valid())
-            // Sheet is empty.  Nothing to print.
-            return;
+        if (m_pos == m_entries.size())
+            return nullptr;
 
-        const ixion::model_context& cxt = m_doc.get_model_context();
-        const ixion::formula_name_resolver* resolver =
-            m_doc.get_formula_name_resolver(spreadsheet::formula_ref_context_t::global);
-        const import_shared_strings* sstrings = m_doc.get_shared_strings();
+        const entry& e = m_entries[m_pos];
+        if (e.row != row || col < e.first_col)
+            return nullptr;
 
-        elem table(os, p_table);
+        return &e;
+    }
+};
 
-        row_t row_count = range.last.row + 1;
-        col_t col_count = range.last.column + 1;
-        for (row_t row = 0; row < row_count; ++row)
+/**
+ * Looks up the cell format indices in row-major order, by keeping a
+ * position in the runs of each column.
+ */
+class format_cursor
+{
+    std::vector<std::vector<cell_format_store::range>> m_columns;
+    std::vector<size_t> m_pos;
+
+public:
+    format_cursor(const cell_format_store& store, col_t col_count) :
+        m_columns(col_count), m_pos(col_count, 0)
+    {
+        for (const cell_format_store::range& r : store)
         {
-            // Set the row height.
-            std::string row_style;
-            row_height_t rh = sh->get_row_height(row, nullptr, nullptr);
+            if (r.column < col_count)
+                m_columns[r.column].push_back(r);
+        }
+    }
 
-            // Convert height from twip to inches.
-            if (rh != get_default_row_height())
-            {
-                std::string style;
-                double val = orcus::convert(rh, length_unit_t::twip, length_unit_t::inch);
-                std::ostringstream os_style;
-                os_style << "height: " << val << "in;";
-                row_style += os_style.str();
-            }
+    size_t get(row_t row, col_t col)
+    {
+        const std::vector<cell_format_store::range>& runs = m_columns[col];
+        size_t& pos = m_pos[col];
 
-            const char* style_str = nullptr;
-            if (!row_style.empty())
-                style_str = row_style.c_str();
-            elem tr(os, p_tr, style_str);
+        for (; pos < runs.size(); ++pos)
+        {
+            if (runs[pos].last_row >= row)
+                break;
+        }
 
-            const detail::overlapped_col_index_type* p_overlapped = get_overlapped_ranges(row);
+        if (pos == runs.size() || runs[pos].first_row > row)
+            return 0;
 
-            for (col_t col = 0; col < col_count; ++col)
-            {
-                ixion::abs_address_t pos(m_sheet_id, row, col);
+        return runs[pos].index;
+    }
+};
 
-                const merge_size* p_merge_size = get_merge_size(row, col);
-                if (!p_merge_size && p_overlapped)
-                {
-                    // Check if this cell is overlapped by a merged cell.
-                    col_t overlapped_origin = -1;
-                    col_t last_col = -1;
-                    if (p_overlapped->search_tree(col, overlapped_origin, nullptr, &last_col).second && overlapped_origin >= 0)
-                    {
-                        // Skip all overlapped cells on this row.
-                        col = last_col - 1;
-                        continue;
-                    }
-                }
-                size_t xf_id = sh->get_cell_format(row, col);
-                std::string style;
+/**
+ * Builds the style string of each cell format once, the first time it's
+ * requested.
+ */
+class style_cache
+{
+    const styles& m_styles;
+    std::unordered_map<size_t, std::string> m_store;
 
-                if (row == 0)
-                {
-                    // Set the column width.
-                    col_width_t cw = sh->get_col_width(col, nullptr, nullptr);
-
-                    // Convert width from twip to inches.
-                    if (cw != get_default_column_width())
-                    {
-                        double val = orcus::convert(cw, length_unit_t::twip, length_unit_t::inch);
-                        std::ostringstream os_style;
-                        os_style << "width: " << val << "in;";
-                        style += os_style.str();
-                    }
-                }
+public:
+    style_cache(const styles& styles) : m_styles(styles) {}
 
-                if (xf_id)
-                {
-                    // Apply cell format.
-                    const styles& styles = m_doc.get_styles();
-                    const cell_format_t* fmt = styles.get_cell_format(xf_id);
-                    if (fmt)
-                        build_style_string(style, styles, *fmt);
-                }
+    const std::string& get(size_t xf_id)
+    {
+        auto it = m_store.find(xf_id);
+        if (it != m_store.end())
+            return it->second;
 
-                ixion::celltype_t ct = cxt.get_celltype(pos);
-                if (ct == ixion::celltype_t::empty)
-                {
-                    html_elem::attrs_type attrs;
-                    build_html_elem_attributes(attrs, style, p_merge_size);
-                    attrs.push_back(html_elem::attr("class", "empty"));
-                    elem td(os, p_td, attrs);
-                    os << '-'; // empty cell.
-                    continue;
-                }
+        std::string style;
+        if (xf_id)
+        {
+            const cell_format_t* fmt = m_styles.get_cell_format(xf_id);
+            if (fmt)
+                build_style_string(style, m_styles, *fmt);
+        }
 
-                html_elem::attrs_type attrs;
-                build_html_elem_attributes(attrs, style, p_merge_size);
-                elem td(os, p_td, attrs);
+        return m_store.emplace(xf_id, std::move(style)).first->second;
+    }
+};
 
-                switch (ct)
-                {
-                    case ixion::celltype_t::string:
-                    {
-                        size_t sindex = cxt.get_string_identifier(pos);
-                        const std::string* p = cxt.get_string(sindex);
-                        assert(p);
-                        const format_runs_t* pformat = sstrings->get_format_runs(sindex);
-                        if (pformat)
-                            print_formatted_text(os, *p, *pformat);
-                        else
-                            os << *p;
-
-                        break;
-                    }
-                    case ixion::celltype_t::numeric:
-                        format_to_file_output(os, cxt.get_numeric_value(pos));
-                        break;
-                    case ixion::celltype_t::boolean:
-                        os << (cxt.get_boolean_value(pos) ? "true" : "false");
-                        break;
-                    case ixion::celltype_t::formula:
-                    {
-                        // print the formula and the formula result.
-                        const ixion::formula_cell* cell = cxt.get_formula_cell(pos);
-                        assert(cell);
-                        const ixion::formula_tokens_store_ptr_t& ts = cell->get_tokens();
-                        if (ts)
-                        {
-                            const ixion::formula_tokens_t& tokens = ts->get();
-
-                            std::string formula;
-                            if (resolver)
-                            {
-                                pos = cell->get_parent_position(pos);
-                                formula = ixion::print_formula_tokens(
-                                    m_doc.get_model_context(), pos, *resolver, tokens);
-                            }
-                            else
-                                formula = "???";
-
-                            ixion::formula_group_t fg = cell->get_group_properties();
-
-                            if (fg.grouped)
-                                os << '{' << formula << '}';
-                            else
-                                os << formula;
-
-                            try
-                            {
-                                ixion::formula_result res = cell->get_result_cache(
-                                    ixion::formula_result_wait_policy_t::throw_exception);
-                                os << " (" << res.str(m_doc.get_model_context()) << ")";
-                            }
-                            catch (const std::exception&)
-                            {
-                                os << " (#RES!)";
-                            }
-                        }
-
-                        break;
-                    }
-                    default:
-                        ;
-                }
-            }
-        }
+void print_formula(
+    output_buffer& buf, const ixion::model_context& cxt, const ixion::formula_name_resolver* resolver,
+    ixion::abs_address_t pos, const ixion::formula_cell& cell)
+{
+    const ixion::formula_tokens_store_ptr_t& ts = cell.get_tokens();
+    if (!ts)
+        return;
+
+    const ixion::formula_tokens_t& tokens = ts->get();
+
+    std::string formula;
+    if (resolver)
+    {
+        pos = cell.get_parent_position(pos);
+        formula = ixion::print_formula_tokens(cxt, pos, *resolver, tokens);
+    }
+    else
+        formula = "???";
+
+    ixion::formula_group_t fg = cell.get_group_properties();
+
+    if (fg.grouped)
+    {
+        buf.write('{');
+        buf.write(formula);
+        buf.write('}');
+    }
+    else
+        buf.write(formula);
+
+    try
+    {
+        ixion::formula_result res = cell.get_result_cache(
+            ixion::formula_result_wait_policy_t::throw_exception);
+        write_literal(buf, " (");
+        buf.write(res.str(cxt));
+        buf.write(')');
+    }
+    catch (const std::exception&)
+    {
+        write_literal(buf, " (#RES!)");
     }
 }
 
-const overlapped_col_index_type* html_dumper::get_overlapped_ranges(row_t row) const
-{
-    overlapped_cells_type::const_iterator it = m_overlapped_ranges.find(row);
-    if (it == m_overlapped_ranges.end())
-        return nullptr;
+}
 
-    return it->second.get();
+html_dumper::html_dumper(const sheet_impl& sheet) :
+    m_sheet(sheet)
+{
 }
 
-const merge_size* html_dumper::get_merge_size(row_t row, col_t col) const
+void html_dumper::dump(std::ostream& os) const
 {
-    col_merge_size_type::const_iterator it_col = m_merge_ranges.find(col);
-    if (it_col == m_merge_ranges.end())
-        return nullptr;
+    typedef html_elem elem;
+
+    const char* p_html  = "html";
+    const char* p_body  = "body";
+    const char* p_table = "table";
 
-    merge_size_type& col_merge_sizes = *it_col->second;
-    merge_size_type::const_iterator it_row = col_merge_sizes.find(row);
-    if (it_row == col_merge_sizes.end())
-        return nullptr;
+    ixion::abs_range_t range = m_sheet.get_data_range();
 
-    return &it_row->second;
-}
+    output_buffer buf(os);
+    elem root(buf, p_html);
+    dump_html_head(buf);
 
-void html_dumper::build_overlapped_ranges()
-{
-    const sheet* sh = m_doc.get_sheet(m_sheet_id);
-    if (!sh)
+    elem elem_body(buf, p_body);
+
+    if (!range.valid())
+        // Sheet is empty.  Nothing to print.
         return;
 
-    range_size_t sheet_size = m_doc.get_sheet_size();
+    const document& doc = m_sheet.m_doc;
+    const ixion::model_context& cxt = doc.get_model_context();
+    const ixion::formula_name_resolver* resolver =
+        doc.get_formula_name_resolver(spreadsheet::formula_ref_context_t::global);
+    const import_shared_strings* sstrings = doc.get_shared_strings();
+
+    col_t col_count = range.last.column + 1;
+
+    merge_cursor merges(m_sheet.m_merge_ranges);
+    format_cursor formats(m_sheet.m_cell_formats, col_count);
+    style_cache cell_styles(doc.get_styles());
+
+    ixion::abs_rc_range_t iter_range;
+    iter_range.first.column = 0;
+    iter_range.first.row = 0;
+    iter_range.last.column = range.last.column;
+    iter_range.last.row = range.last.row;
+
+    auto iter = cxt.get_model_iterator(m_sheet.m_sheet, ixion::rc_direction_t::horizontal, iter_range);
+
+    // Heights and widths are stored as segments, so they only need to be
+    // looked up again when the current segment ends.
+    row_height_t rh = 0;
+    row_t rh_end = 0;
+    col_width_t cw = 0;
+    col_t cw_end = 0;
 
-    detail::col_merge_size_type::const_iterator it_col = m_merge_ranges.begin(), it_col_end = m_merge_ranges.end();
-    for (; it_col != it_col_end; ++it_col)
+    std::string style;
+
+    elem table(buf, p_table);
+
+    for (; iter.has(); iter.next())
     {
-        col_t col = it_col->first;
-        const detail::merge_size_type& data = *it_col->second;
-        detail::merge_size_type::const_iterator it = data.begin(), it_end = data.end();
-        for (; it != it_end; ++it)
+        const ixion::model_iterator::cell& cell = iter.get();
+        row_t row = cell.row;
+        col_t col = cell.col;
+
+        if (col == 0)
         {
-            row_t row = it->first;
-            const detail::merge_size& item = it->second;
-            for (row_t i = 0; i < item.height; ++i, ++row)
+            if (row > 0)
+                write_literal(buf, "</tr>");
+
+            if (row >= rh_end && !m_sheet.m_row_heights.search_tree(row, rh, nullptr, &rh_end).second)
+                throw orcus::general_error("html_dumper::dump: failed to search tree.");
+
+            write_literal(buf, "<tr");
+
+            // Convert height from twip to inches.
+            if (rh != get_default_row_height())
             {
-                // Get the container for this row.
-                detail::overlapped_cells_type::iterator it_cont = m_overlapped_ranges.find(row);
-                if (it_cont == m_overlapped_ranges.end())
-                {
-                    auto p = std::make_unique<detail::overlapped_col_index_type>(0, sheet_size.columns, -1);
-                    std::pair<detail::overlapped_cells_type::iterator, bool> r =
-                        m_overlapped_ranges.insert(detail::overlapped_cells_type::value_type(row, std::move(p)));
+                double val = orcus::convert(rh, length_unit_t::twip, length_unit_t::inch);
+                std::ostringstream os_style;
+                os_style << " style=\"height: " << val << "in;\"";
+                buf.write(os_style.str());
+            }
 
-                    if (!r.second)
-                    {
-                        // Insertion failed.
-                        return;
-                    }
+            buf.write('>');
+        }
 
-                    it_cont = r.first;
-                }
+        const merge_cursor::entry* p_merge = merges.find(row, col);
+        const merge_size* p_merge_size = nullptr;
+        if (p_merge)
+        {
+            if (!p_merge->origin || col != p_merge->first_col)
+                // This cell is overlapped by a merged cell.  Skip it.
+                continue;
+
+            p_merge_size = p_merge->origin;
+        }
+
+        style.clear();
 
-                detail::overlapped_col_index_type& cont = *it_cont->second;
-                cont.insert_back(col, col+item.width, col);
+        if (row == 0)
+        {
+            // Set the column width.
+            if (col >= cw_end && !m_sheet.m_col_widths.search_tree(col, cw, nullptr, &cw_end).second)
+                throw orcus::general_error("html_dumper::dump: failed to search tree.");
+
+            // Convert width from twip to inches.
+            if (cw != get_default_column_width())
+            {
+                double val = orcus::convert(cw, length_unit_t::twip, length_unit_t::inch);
+                std::ostringstream os_style;
+                os_style << "width: " << val << "in;";
+                style += os_style.str();
+            }
+        }
+
+        // Apply cell format.
+        style += cell_styles.get(formats.get(row, col));
+
+        if (cell.type == ixion::celltype_t::empty)
+        {
+            write_td_open(buf, style, p_merge_size, true);
+            write_literal(buf, "-</td>"); // empty cell.
+            continue;
+        }
+
+        write_td_open(buf, style, p_merge_size, false);
+
+        switch (cell.type)
+        {
+            case ixion::celltype_t::string:
+            {
+                const std::string* p = cxt.get_string(cell.value.string);
+                assert(p);
+                const format_runs_t* pformat = sstrings->get_format_runs(cell.value.string);
+                if (pformat)
+                    print_formatted_text(buf, *p, *pformat);
+                else
+                    buf.write(*p);
+
+                break;
+            }
+            case ixion::celltype_t::numeric:
+                buf.write(cell.value.numeric);
+                break;
+            case ixion::celltype_t::boolean:
+                if (cell.value.boolean)
+                    write_literal(buf, "true");
+                else
+                    write_literal(buf, "false");
+                break;
+            case ixion::celltype_t::formula:
+            {
+                // print the formula and the formula result.
+                assert(cell.value.formula);
+                ixion::abs_address_t pos(m_sheet.m_sheet, row, col);
+                print_formula(buf, cxt, resolver, pos, *cell.value.formula);
+                break;
             }
+            default:
+                ;
         }
+
+        write_literal(buf, "</td>");
     }
 
-    // Build trees.
-    for (auto& range : m_overlapped_ranges)
-        range.second->build_tree();
+    write_literal(buf, "</tr>");
 }
 
 }}}
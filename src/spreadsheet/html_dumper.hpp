@@ -8,35 +8,25 @@
 #ifndef INCLUDED_ORCUS_SPREADSHEET_HTML_DUMPER_HPP
 #define INCLUDED_ORCUS_SPREADSHEET_HTML_DUMPER_HPP
 
-#include <string>
 #include <ostream>
-#include <ixion/types.hpp>
-
-#include "impl_types.hpp"
 
 namespace orcus { namespace spreadsheet {
 
-class document;
+struct sheet_impl;
 
 namespace detail {
 
+/**
+ * Dumps the content of a sheet as an HTML table.  The cells get visited in
+ * a single pass in row-major order, with the cell formats and the merged
+ * ranges looked up via cursors that advance along with it.
+ */
 class html_dumper
 {
-    const document& m_doc;
-    overlapped_cells_type m_overlapped_ranges;
-    const col_merge_size_type& m_merge_ranges;
-    sheet_t m_sheet_id;
-
-    const overlapped_col_index_type* get_overlapped_ranges(row_t row) const;
-    const merge_size* get_merge_size(row_t row, col_t col) const;
-
-    void build_overlapped_ranges();
+    const sheet_impl& m_sheet;
 
 public:
-    html_dumper(
-        const document& doc,
-        const col_merge_size_type& merge_ranges,
-        sheet_t sheet_id);
+    html_dumper(const sheet_impl& sheet);
 
     void dump(std::ostream& os) const;
 };
@@ -0,0 +1,158 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/spreadsheet/document.hpp"
+#include "orcus/spreadsheet/sheet.hpp"
+#include "orcus/spreadsheet/styles.hpp"
+#include "orcus/string_pool.hpp"
+#include "orcus/stream.hpp"
+#include "orcus/pstring.hpp"
+
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace orcus;
+using namespace orcus::spreadsheet;
+
+namespace {
+
+void set_string(sheet& sh, row_t row, col_t col, const char* s)
+{
+    sh.set_auto(row, col, s, std::strlen(s));
+}
+
+range_t to_range(row_t row1, col_t col1, row_t row2, col_t col2)
+{
+    range_t range;
+    range.first.row = row1;
+    range.first.column = col1;
+    range.last.row = row2;
+    range.last.column = col2;
+    return range;
+}
+
+/**
+ * Dump a sheet with merged ranges spanning columns, rows and both, custom
+ * row heights and column widths, and formatted cells, and compare the
+ * output with that of the dumper before it was rewritten to walk the sheet
+ * in a single pass.
+ */
+void test_html_dump()
+{
+    document doc{{1048576, 16384}};
+    styles& st = doc.get_styles();
+
+    font_t font;
+    st.append_font(font);
+    font.name = doc.get_string_pool().intern("Arial").first;
+    font.size = 12.0;
+    font.bold = true;
+    font.color = color_t(255, 255, 0, 0);
+    size_t font_bold = st.append_font(font);
+
+    st.append_fill(fill_t());
+    fill_t fill;
+    fill.pattern_type = fill_pattern_t::solid;
+    fill.fg_color = color_t(255, 255, 255, 0);
+    size_t fill_yellow = st.append_fill(fill);
+
+    st.append_border(border_t());
+    border_t border;
+    for (border_attrs_t* p : { &border.top, &border.bottom, &border.left, &border.right })
+    {
+        p->style = border_style_t::thin;
+        p->border_color = color_t(255, 0, 0, 0);
+    }
+    size_t border_thin = st.append_border(border);
+
+    cell_format_t cf;
+    st.append_cell_format(cf);
+
+    cf.font = font_bold;
+    cf.apply_font = true;
+    size_t xf_bold = st.append_cell_format(cf);
+
+    cf.reset();
+    cf.fill = fill_yellow;
+    cf.border = border_thin;
+    cf.apply_fill = true;
+    cf.apply_border = true;
+    size_t xf_boxed = st.append_cell_format(cf);
+
+    cf.reset();
+    cf.hor_align = hor_alignment_t::center;
+    cf.ver_align = ver_alignment_t::middle;
+    cf.apply_alignment = true;
+    size_t xf_centered = st.append_cell_format(cf);
+
+    sheet* sh = doc.append_sheet("Sheet1");
+    assert(sh);
+
+    // The width of the second column is never written, since the top cell
+    // of that column is covered by a merged range.
+    sh->set_col_width(0, 2880);
+    sh->set_col_width(1, 1440);
+    sh->set_col_width(3, 1080);
+    sh->set_row_height(1, 720);
+    sh->set_row_height(4, 1080);
+
+    set_string(*sh, 0, 0, "Title");
+    sh->set_merge_cell_range(to_range(0, 0, 0, 2));
+    sh->set_value(0, 3, 1.0);
+
+    set_string(*sh, 1, 0, "Side");
+    sh->set_format(1, 0, xf_centered);
+    sh->set_merge_cell_range(to_range(1, 0, 3, 0));
+    sh->set_value(1, 1, 2.5);
+    sh->set_format(1, 1, xf_bold);
+    sh->set_format(1, 2, xf_boxed);
+    sh->set_bool(1, 3, true);
+
+    set_string(*sh, 2, 1, "Block");
+    sh->set_merge_cell_range(to_range(2, 1, 3, 2));
+    sh->set_value(2, 3, 3.0);
+    sh->set_format(2, 3, xf_boxed);
+
+    set_string(*sh, 3, 3, "End");
+
+    sh->set_value(4, 0, 10.0);
+
+    doc.finalize();
+
+    std::ostringstream os;
+    sh->dump_html(os);
+    std::string check = os.str();
+
+    file_content control(SRCDIR"/test/spreadsheet/html-dump/check.html");
+
+    assert(!check.empty());
+    assert(!control.empty());
+
+    pstring s1(check.data(), check.size());
+    pstring s2 = control.str();
+    if (s1.trim() != s2.trim())
+    {
+        std::cerr << "expected:" << std::endl << s2 << std::endl;
+        std::cerr << "actual:" << std::endl << s1 << std::endl;
+        assert(!"html output differs");
+    }
+}
+
+}
+
+int main()
+{
+    test_html_dump();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -10,6 +10,7 @@
 #include <ostream>
 #include <iomanip>
 #include <limits>
+#include <cstdio>
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
@@ -18,6 +19,12 @@ void format_to_file_output(std::ostream& os, double v)
     os << std::setprecision(std::numeric_limits<double>::digits10 + 1) << v;
 }
 
+int format_to_file_output(char* buf, size_t n, double v)
+{
+    // The default floatfield of std::ostream maps to the %g conversion.
+    return std::snprintf(buf, n, "%.*g", std::numeric_limits<double>::digits10 + 1, v);
+}
+
 }}}
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -9,11 +9,12 @@
 #define INCLUDED_ORCUS_SPREADSHEET_NUMBER_FORMAT_HPP
 
 #include <iosfwd>
+#include <cstdlib>
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
 /**
- * Format a numeric value to a lossless string representation appripriate
+ * Format a numeric value to a lossless string representation appropriate
  * for file output.
  *
  * @param os output stream to add the string representation to.
@@ -21,6 +22,19 @@ namespace orcus { namespace spreadsheet { namespace detail {
  */
 void format_to_file_output(std::ostream& os, double v);
 
+/**
+ * Format a numeric value to a lossless string representation appropriate
+ * for file output, into a caller-provided character buffer.  The output is
+ * identical to that of the stream variant.
+ *
+ * @param buf destination buffer.
+ * @param n size of the destination buffer.
+ * @param v source numeric value to format.
+ *
+ * @return number of characters written, excluding the terminating null.
+ */
+int format_to_file_output(char* buf, size_t n, double v);
+
 }}}
 
 #endif
@@ -13,7 +13,11 @@
 #include <ixion/address.hpp>
 
 #include <unordered_map>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <sstream>
 
 namespace orcus { namespace spreadsheet {
@@ -315,6 +319,603 @@ pivot_cache_field_t::pivot_cache_field_t(pivot_cache_field_t&& other) :
     other.name.clear();
 }
 
+namespace {
+
+using value_type = pivot_cache_record_value_t::value_type;
+
+constexpr uint32_t no_group = std::numeric_limits<uint32_t>::max();
+
+bool has_payload(value_type type)
+{
+    switch (type)
+    {
+        case value_type::boolean:
+        case value_type::date_time:
+        case value_type::character:
+        case value_type::numeric:
+        case value_type::shared_item_index:
+            return true;
+        default:
+            ;
+    }
+
+    return false;
+}
+
+uint64_t to_payload(double v)
+{
+    uint64_t payload;
+    std::memcpy(&payload, &v, sizeof(payload));
+    return payload;
+}
+
+double to_double(uint64_t payload)
+{
+    double v;
+    std::memcpy(&v, &payload, sizeof(v));
+    return v;
+}
+
+/**
+ * Pack a date-time value into 64 bits: 18 bits for the year biased to
+ * allow negative years, 4 for the month, 5 each for the day and hour, 6 for
+ * the minute, and the remaining 26 for the seconds in microseconds.
+ */
+uint64_t pack_date_time(const pivot_cache_record_value_t& v)
+{
+    constexpr int64_t year_bias = 1 << 17;
+
+    uint64_t usec = static_cast<uint64_t>(std::llround(v.value.date_time.second * 1000000.0));
+    uint64_t packed = static_cast<uint64_t>(v.value.date_time.year + year_bias) & 0x3FFFF;
+    packed = (packed << 4) | (v.value.date_time.month & 0x0F);
+    packed = (packed << 5) | (v.value.date_time.day & 0x1F);
+    packed = (packed << 5) | (v.value.date_time.hour & 0x1F);
+    packed = (packed << 6) | (v.value.date_time.minute & 0x3F);
+    packed = (packed << 26) | (usec & 0x3FFFFFF);
+    return packed;
+}
+
+void unpack_date_time(uint64_t packed, pivot_cache_record_value_t& v)
+{
+    constexpr int64_t year_bias = 1 << 17;
+
+    v.value.date_time.second = (packed & 0x3FFFFFF) / 1000000.0;
+    packed >>= 26;
+    v.value.date_time.minute = packed & 0x3F;
+    packed >>= 6;
+    v.value.date_time.hour = packed & 0x1F;
+    packed >>= 5;
+    v.value.date_time.day = packed & 0x1F;
+    packed >>= 5;
+    v.value.date_time.month = packed & 0x0F;
+    packed >>= 4;
+    v.value.date_time.year = static_cast<int>(static_cast<int64_t>(packed & 0x3FFFF) - year_bias);
+}
+
+/**
+ * Stores the values of one field of all records.  A column stays typed by
+ * its first value until a value of a different type arrives, at which
+ * point it switches to storing a type tag next to each value.
+ */
+class record_column
+{
+    value_type m_type = value_type::unknown;
+    bool m_mixed = false;
+    size_t m_size = 0;
+
+    /** Values of a column storing only shared item indices. */
+    std::vector<uint32_t> m_indices;
+
+    /** Packed values of all other columns, except for those without payload. */
+    std::vector<uint64_t> m_values;
+
+    /** Value types of a mixed column. */
+    std::vector<uint8_t> m_types;
+
+    std::vector<pstring> m_strings;
+    std::unordered_map<pstring, uint32_t, pstring::hash> m_string_ids;
+
+    void to_mixed()
+    {
+        m_types.assign(m_size, static_cast<uint8_t>(m_type));
+
+        if (m_type == value_type::shared_item_index)
+        {
+            m_values.assign(m_indices.begin(), m_indices.end());
+            m_indices.clear();
+            m_indices.shrink_to_fit();
+        }
+        else if (!has_payload(m_type))
+            m_values.assign(m_size, 0);
+
+        m_mixed = true;
+    }
+
+public:
+    void reserve(size_t n)
+    {
+        if (m_mixed)
+        {
+            m_types.reserve(n);
+            m_values.reserve(n);
+        }
+        else if (m_type == value_type::shared_item_index)
+            m_indices.reserve(n);
+        else if (has_payload(m_type))
+            m_values.reserve(n);
+    }
+
+    void append(value_type type, uint64_t payload)
+    {
+        if (!m_mixed)
+        {
+            if (!m_size)
+                m_type = type;
+
+            if (type != m_type ||
+                (type == value_type::shared_item_index && payload > std::numeric_limits<uint32_t>::max()))
+                to_mixed();
+        }
+
+        if (m_mixed)
+        {
+            m_types.push_back(static_cast<uint8_t>(type));
+            m_values.push_back(payload);
+        }
+        else if (m_type == value_type::shared_item_index)
+            m_indices.push_back(static_cast<uint32_t>(payload));
+        else if (has_payload(m_type))
+            m_values.push_back(payload);
+
+        ++m_size;
+    }
+
+    void append_blanks(size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            append(value_type::blank, 0);
+    }
+
+    uint64_t get_string_id(string_pool& sp, const pstring& s)
+    {
+        auto it = m_string_ids.find(s);
+        if (it != m_string_ids.end())
+            return it->second;
+
+        pstring interned = sp.intern(s).first;
+        uint32_t id = m_strings.size();
+        m_strings.push_back(interned);
+        m_string_ids.emplace(interned, id);
+        return id;
+    }
+
+    size_t size() const { return m_size; }
+
+    /**
+     * @return pointer to the shared item indices if the column stores
+     *         nothing else, or nullptr otherwise.
+     */
+    const uint32_t* get_indices() const
+    {
+        return !m_mixed && m_type == value_type::shared_item_index ? m_indices.data() : nullptr;
+    }
+
+    /**
+     * @return pointer to the numeric values if the column stores nothing
+     *         else, or nullptr otherwise.
+     */
+    const uint64_t* get_numerics() const
+    {
+        return !m_mixed && m_type == value_type::numeric ? m_values.data() : nullptr;
+    }
+
+    value_type get_type(size_t pos) const
+    {
+        return m_mixed ? static_cast<value_type>(m_types[pos]) : m_type;
+    }
+
+    uint64_t get_payload(size_t pos) const
+    {
+        if (m_mixed)
+            return m_values[pos];
+
+        if (m_type == value_type::shared_item_index)
+            return m_indices[pos];
+
+        return has_payload(m_type) ? m_values[pos] : 0;
+    }
+
+    pivot_cache_record_value_t get(size_t pos) const
+    {
+        pivot_cache_record_value_t v;
+        v.type = get_type(pos);
+        uint64_t payload = get_payload(pos);
+
+        switch (v.type)
+        {
+            case value_type::boolean:
+                v.value.boolean = payload != 0;
+                break;
+            case value_type::date_time:
+                unpack_date_time(payload, v);
+                break;
+            case value_type::character:
+            {
+                const pstring& s = m_strings[payload];
+                v.value.character.p = s.get();
+                v.value.character.n = s.size();
+                break;
+            }
+            case value_type::numeric:
+                v.value.numeric = to_double(payload);
+                break;
+            case value_type::shared_item_index:
+                v.value.shared_item_index = payload;
+                break;
+            default:
+                ;
+        }
+
+        return v;
+    }
+};
+
+/**
+ * Replace the keys with dense group numbers, assigned in the order of the
+ * keys' first appearance.
+ *
+ * @param keys keys to replace.
+ * @param key_space upper bound of the key values.
+ * @param first_rows if not null, receives the position of the first
+ *                   appearance of each group.
+ *
+ * @return number of groups.
+ */
+size_t compact_keys(std::vector<uint64_t>& keys, uint64_t key_space, std::vector<size_t>* first_rows)
+{
+    uint32_t group_count = 0;
+
+    auto assign = [&](uint32_t& group, size_t row) -> uint32_t
+    {
+        if (group == no_group)
+        {
+            group = group_count++;
+            if (first_rows)
+                first_rows->push_back(row);
+        }
+        return group;
+    };
+
+    if (key_space <= std::max<uint64_t>(keys.size(), 1u << 16))
+    {
+        // The keys are few enough to map through a flat table.
+        std::vector<uint32_t> groups(key_space, no_group);
+        for (size_t row = 0; row < keys.size(); ++row)
+            keys[row] = assign(groups[keys[row]], row);
+    }
+    else
+    {
+        std::unordered_map<uint64_t, uint32_t> groups;
+        groups.reserve(keys.size());
+        for (size_t row = 0; row < keys.size(); ++row)
+            keys[row] = assign(groups.emplace(keys[row], no_group).first->second, row);
+    }
+
+    return group_count;
+}
+
+/**
+ * Encode the values of a column into dense codes.
+ *
+ * @return number of distinct codes.
+ */
+size_t encode_column(const record_column& col, std::vector<uint32_t>& codes)
+{
+    struct hash
+    {
+        size_t operator() (const std::pair<value_type, uint64_t>& v) const
+        {
+            return std::hash<uint64_t>()(v.second) ^ static_cast<size_t>(v.first);
+        }
+    };
+
+    std::unordered_map<std::pair<value_type, uint64_t>, uint32_t, hash> code_map;
+
+    codes.resize(col.size());
+    for (size_t row = 0; row < col.size(); ++row)
+    {
+        auto key = std::make_pair(col.get_type(row), col.get_payload(row));
+        codes[row] = code_map.emplace(key, code_map.size()).first->second;
+    }
+
+    return code_map.size();
+}
+
+}
+
+struct pivot_cache_records::impl
+{
+    string_pool& m_string_pool;
+
+    std::vector<record_column> m_columns;
+
+    size_t m_record_count;
+    size_t m_reserved;
+    size_t m_cur_field;
+
+    impl(string_pool& sp) :
+        m_string_pool(sp), m_record_count(0), m_reserved(0), m_cur_field(0) {}
+
+    record_column& next_column()
+    {
+        if (m_cur_field == m_columns.size())
+        {
+            m_columns.emplace_back();
+            m_columns.back().reserve(m_reserved);
+            m_columns.back().append_blanks(m_record_count);
+        }
+
+        return m_columns[m_cur_field++];
+    }
+};
+
+pivot_cache_records::pivot_cache_records(string_pool& sp) :
+    mp_impl(std::make_unique<impl>(sp)) {}
+
+pivot_cache_records::pivot_cache_records(pivot_cache_records&& other) :
+    mp_impl(std::move(other.mp_impl))
+{
+    other.mp_impl = std::make_unique<impl>(mp_impl->m_string_pool);
+}
+
+pivot_cache_records::~pivot_cache_records() {}
+
+pivot_cache_records& pivot_cache_records::operator= (pivot_cache_records&& other)
+{
+    mp_impl.swap(other.mp_impl);
+    return *this;
+}
+
+void pivot_cache_records::reserve(size_t n)
+{
+    mp_impl->m_reserved = n;
+
+    for (record_column& col : mp_impl->m_columns)
+        col.reserve(n);
+}
+
+void pivot_cache_records::append_value(const pivot_cache_record_value_t& v)
+{
+    record_column& col = mp_impl->next_column();
+
+    switch (v.type)
+    {
+        case value_type::boolean:
+            col.append(v.type, v.value.boolean ? 1 : 0);
+            break;
+        case value_type::date_time:
+            col.append(v.type, pack_date_time(v));
+            break;
+        case value_type::character:
+        {
+            pstring s(v.value.character.p, v.value.character.n);
+            col.append(v.type, col.get_string_id(mp_impl->m_string_pool, s));
+            break;
+        }
+        case value_type::numeric:
+            col.append(v.type, to_payload(v.value.numeric));
+            break;
+        case value_type::shared_item_index:
+            col.append(v.type, v.value.shared_item_index);
+            break;
+        default:
+            col.append(v.type, 0);
+    }
+}
+
+void pivot_cache_records::append_value_numeric(double v)
+{
+    mp_impl->next_column().append(value_type::numeric, to_payload(v));
+}
+
+void pivot_cache_records::append_value_character(const char* p, size_t n)
+{
+    record_column& col = mp_impl->next_column();
+    col.append(value_type::character, col.get_string_id(mp_impl->m_string_pool, pstring(p, n)));
+}
+
+void pivot_cache_records::append_value_shared_item(size_t index)
+{
+    mp_impl->next_column().append(value_type::shared_item_index, index);
+}
+
+void pivot_cache_records::commit_record()
+{
+    ++mp_impl->m_record_count;
+
+    // Pad the columns not reached by this record.
+    for (record_column& col : mp_impl->m_columns)
+    {
+        if (col.size() < mp_impl->m_record_count)
+            col.append_blanks(mp_impl->m_record_count - col.size());
+    }
+
+    mp_impl->m_cur_field = 0;
+}
+
+size_t pivot_cache_records::get_record_count() const
+{
+    return mp_impl->m_record_count;
+}
+
+size_t pivot_cache_records::get_field_count() const
+{
+    return mp_impl->m_columns.size();
+}
+
+pivot_cache_record_value_t pivot_cache_records::get_value(size_t record, size_t field) const
+{
+    if (record >= mp_impl->m_record_count || field >= mp_impl->m_columns.size())
+        return pivot_cache_record_value_t();
+
+    return mp_impl->m_columns[field].get(record);
+}
+
+pivot_cache_record_t pivot_cache_records::get_record(size_t record) const
+{
+    pivot_cache_record_t ret;
+    if (record >= mp_impl->m_record_count)
+        return ret;
+
+    ret.reserve(mp_impl->m_columns.size());
+    for (const record_column& col : mp_impl->m_columns)
+        ret.push_back(col.get(record));
+
+    return ret;
+}
+
+pivot_cache_aggregate_t pivot_cache_records::aggregate(
+    const std::vector<size_t>& group_fields, size_t data_field,
+    const std::vector<pivot_cache_field_t>& fields) const
+{
+    const std::vector<record_column>& columns = mp_impl->m_columns;
+    const size_t n = mp_impl->m_record_count;
+
+    auto check_field = [&columns](size_t field)
+    {
+        if (field >= columns.size())
+        {
+            std::ostringstream os;
+            os << "Pivot cache field index " << field << " is out of range.";
+            throw std::invalid_argument(os.str());
+        }
+    };
+
+    check_field(data_field);
+    for (size_t field : group_fields)
+        check_field(field);
+
+    pivot_cache_aggregate_t ret;
+    if (!n)
+        return ret;
+
+    // Build a combined key for each record, one group field at a time.
+    std::vector<uint64_t> keys(n, 0);
+    std::vector<uint32_t> codes;
+    uint64_t key_space = 1;
+
+    for (size_t field : group_fields)
+    {
+        const record_column& col = columns[field];
+        const uint32_t* p = col.get_indices();
+        uint64_t code_count = 0;
+
+        if (p)
+            code_count = uint64_t(*std::max_element(p, p + n)) + 1;
+        else
+        {
+            code_count = encode_column(col, codes);
+            p = codes.data();
+        }
+
+        if (key_space > std::numeric_limits<uint64_t>::max() / code_count)
+            // The combined key would overflow.  Shrink the key space first.
+            key_space = compact_keys(keys, key_space, nullptr);
+
+        for (size_t row = 0; row < n; ++row)
+            keys[row] = keys[row] * code_count + p[row];
+
+        key_space *= code_count;
+    }
+
+    std::vector<size_t> first_rows;
+    size_t group_count = compact_keys(keys, key_space, &first_rows);
+
+    ret.keys.reserve(group_count);
+    for (size_t row : first_rows)
+    {
+        pivot_cache_record_t key;
+        key.reserve(group_fields.size());
+        for (size_t field : group_fields)
+            key.push_back(columns[field].get(row));
+
+        ret.keys.push_back(std::move(key));
+    }
+
+    ret.sums.assign(group_count, 0.0);
+    ret.counts.assign(group_count, 0);
+
+    // Numeric value of each shared item of the data field, and whether it
+    // counts as a non-blank value.
+    std::vector<double> item_values;
+    std::vector<uint8_t> item_counted;
+
+    if (data_field < fields.size())
+    {
+        const pivot_cache_items_t& items = fields[data_field].items;
+        item_values.assign(items.size(), 0.0);
+        item_counted.assign(items.size(), 1);
+
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            if (items[i].type == pivot_cache_item_t::item_type::numeric)
+                item_values[i] = items[i].value.numeric;
+            else if (items[i].type == pivot_cache_item_t::item_type::blank)
+                item_counted[i] = 0;
+        }
+    }
+
+    auto add_shared_item = [&](size_t group, uint64_t index)
+    {
+        if (index < item_values.size())
+        {
+            ret.sums[group] += item_values[index];
+            ret.counts[group] += item_counted[index];
+        }
+        else
+            ++ret.counts[group];
+    };
+
+    const record_column& data = columns[data_field];
+
+    if (const uint64_t* p = data.get_numerics())
+    {
+        for (size_t row = 0; row < n; ++row)
+        {
+            ret.sums[keys[row]] += to_double(p[row]);
+            ++ret.counts[keys[row]];
+        }
+    }
+    else if (const uint32_t* p = data.get_indices())
+    {
+        for (size_t row = 0; row < n; ++row)
+            add_shared_item(keys[row], p[row]);
+    }
+    else
+    {
+        for (size_t row = 0; row < n; ++row)
+        {
+            switch (data.get_type(row))
+            {
+                case value_type::numeric:
+                    ret.sums[keys[row]] += to_double(data.get_payload(row));
+                    ++ret.counts[keys[row]];
+                    break;
+                case value_type::shared_item_index:
+                    add_shared_item(keys[row], data.get_payload(row));
+                    break;
+                case value_type::blank:
+                case value_type::unknown:
+                    break;
+                default:
+                    ++ret.counts[keys[row]];
+            }
+        }
+    }
+
+    return ret;
+}
+
 struct pivot_cache::impl
 {
     pivot_cache_id_t m_cache_id;
@@ -325,10 +926,13 @@ struct pivot_cache::impl
 
     pivot_cache::fields_type m_fields;
 
-    pivot_cache::records_type m_records;
+    pivot_cache_records m_records;
+
+    /** Row-oriented records, built from m_records on demand. */
+    mutable std::unique_ptr<pivot_cache::records_type> m_row_records;
 
     impl(pivot_cache_id_t cache_id, string_pool& sp) :
-        m_cache_id(cache_id), m_string_pool(sp) {}
+        m_cache_id(cache_id), m_string_pool(sp), m_records(sp) {}
 };
 
 pivot_cache::pivot_cache(pivot_cache_id_t cache_id, string_pool& sp) :
@@ -342,8 +946,25 @@ void pivot_cache::insert_fields(fields_type fields)
 }
 
 void pivot_cache::insert_records(records_type records)
+{
+    pivot_cache_records store(mp_impl->m_string_pool);
+    store.reserve(records.size());
+
+    for (const pivot_cache_record_t& record : records)
+    {
+        for (const pivot_cache_record_value_t& v : record)
+            store.append_value(v);
+
+        store.commit_record();
+    }
+
+    insert_records(std::move(store));
+}
+
+void pivot_cache::insert_records(pivot_cache_records records)
 {
     mp_impl->m_records = std::move(records);
+    mp_impl->m_row_records.reset();
 }
 
 size_t pivot_cache::get_field_count() const
@@ -361,11 +982,38 @@ pivot_cache_id_t pivot_cache::get_id() const
     return mp_impl->m_cache_id;
 }
 
-const pivot_cache::records_type& pivot_cache::get_all_records() const
+size_t pivot_cache::get_record_count() const
+{
+    return mp_impl->m_records.get_record_count();
+}
+
+const pivot_cache_records& pivot_cache::get_records() const
 {
     return mp_impl->m_records;
 }
 
+const pivot_cache::records_type& pivot_cache::get_all_records() const
+{
+    if (!mp_impl->m_row_records)
+    {
+        const pivot_cache_records& store = mp_impl->m_records;
+        auto records = std::make_unique<records_type>();
+        records->reserve(store.get_record_count());
+
+        for (size_t i = 0; i < store.get_record_count(); ++i)
+            records->push_back(store.get_record(i));
+
+        mp_impl->m_row_records = std::move(records);
+    }
+
+    return *mp_impl->m_row_records;
+}
+
+pivot_cache_aggregate_t pivot_cache::aggregate(const std::vector<size_t>& group_fields, size_t data_field) const
+{
+    return mp_impl->m_records.aggregate(group_fields, data_field, mp_impl->m_fields);
+}
+
 namespace {
 
 constexpr const ixion::sheet_t ignored_sheet = -1;
@@ -0,0 +1,226 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "orcus/spreadsheet/pivot.hpp"
+#include "orcus/string_pool.hpp"
+#include "orcus/global.hpp"
+
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+using namespace orcus;
+using namespace orcus::spreadsheet;
+
+namespace {
+
+using value_type = pivot_cache_record_value_t::value_type;
+
+void test_records_uniform()
+{
+    string_pool sp;
+    pivot_cache_records store(sp);
+    store.reserve(3);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        store.append_value_shared_item(i % 2);
+        store.append_value_numeric(i * 1.5);
+        store.commit_record();
+    }
+
+    assert(store.get_record_count() == 3);
+    assert(store.get_field_count() == 2);
+
+    pivot_cache_record_t expected = {
+        pivot_cache_record_value_t(size_t(0)), pivot_cache_record_value_t(3.0)
+    };
+    assert(store.get_record(2) == expected);
+    assert(store.get_value(1, 0) == pivot_cache_record_value_t(size_t(1)));
+
+    // Out-of-range positions.
+    assert(store.get_value(3, 0).type == value_type::unknown);
+    assert(store.get_value(0, 2).type == value_type::unknown);
+    assert(store.get_record(3).empty());
+}
+
+void test_records_mixed()
+{
+    string_pool sp;
+    pivot_cache_records store(sp);
+
+    // The first column starts with shared item indices, then gets a string
+    // and a numeric value.  The string must get interned.
+    std::string buf = "text";
+    store.append_value_shared_item(5);
+    store.commit_record();
+    store.append_value_character(buf.data(), buf.size());
+    store.append_value_numeric(2.0);
+    store.commit_record();
+    store.append_value_numeric(-1.0);
+    store.commit_record();
+
+    pivot_cache_record_value_t dt;
+    dt.type = value_type::date_time;
+    dt.value.date_time.year = 2021;
+    dt.value.date_time.month = 12;
+    dt.value.date_time.day = 31;
+    dt.value.date_time.hour = 23;
+    dt.value.date_time.minute = 59;
+    dt.value.date_time.second = 30.25;
+    store.append_value(dt);
+
+    pivot_cache_record_value_t b;
+    b.type = value_type::boolean;
+    b.value.boolean = true;
+    store.append_value(b);
+    store.commit_record();
+
+    buf = "XXXX";
+
+    assert(store.get_record_count() == 4);
+    assert(store.get_field_count() == 2);
+
+    assert(store.get_value(0, 0) == pivot_cache_record_value_t(size_t(5)));
+
+    // The second column was added by the second record, and gets padded
+    // with blank values for the records that don't reach it.
+    assert(store.get_value(0, 1).type == value_type::blank);
+    assert(store.get_value(2, 1).type == value_type::blank);
+
+    pivot_cache_record_value_t v = store.get_value(1, 0);
+    assert(v == pivot_cache_record_value_t(ORCUS_ASCII("text")));
+    assert(v.value.character.p != buf.data());
+
+    assert(store.get_value(2, 0) == pivot_cache_record_value_t(-1.0));
+    assert(store.get_value(3, 0) == dt);
+    assert(store.get_value(3, 1) == b);
+}
+
+void test_cache_records()
+{
+    string_pool sp;
+    pivot_cache cache(0, sp);
+
+    pivot_cache::records_type records =
+    {
+        { pivot_cache_record_value_t(size_t(0)), pivot_cache_record_value_t(1.0) },
+        { pivot_cache_record_value_t(size_t(1)), pivot_cache_record_value_t(2.0) },
+        { pivot_cache_record_value_t(ORCUS_ASCII("Z")), pivot_cache_record_value_t(3.0) },
+    };
+
+    cache.insert_records(records);
+    assert(cache.get_record_count() == 3);
+    assert(cache.get_records().get_field_count() == 2);
+    assert(cache.get_all_records() == records);
+}
+
+void test_aggregate()
+{
+    string_pool sp;
+    pivot_cache cache(0, sp);
+
+    pivot_cache::fields_type fields;
+    fields.reserve(3);
+    fields.emplace_back(sp.intern("Region").first);
+    fields.back().items.emplace_back(ORCUS_ASCII("East"));
+    fields.back().items.emplace_back(ORCUS_ASCII("West"));
+    fields.emplace_back(sp.intern("Product").first);
+    fields.emplace_back(sp.intern("Sales").first);
+    fields.back().items.emplace_back(100.0);
+    fields.back().items.emplace_back(pivot_cache_item_t(ORCUS_ASCII("n/a")));
+    cache.insert_fields(std::move(fields));
+
+    pivot_cache_records store(sp);
+    auto add_record = [&store](size_t region, const char* product, double sales)
+    {
+        store.append_value_shared_item(region);
+        store.append_value_character(product, std::strlen(product));
+        store.append_value_numeric(sales);
+        store.commit_record();
+    };
+
+    add_record(1, "Apple", 10.0);
+    add_record(0, "Apple", 20.0);
+    add_record(1, "Pear", 30.0);
+    add_record(1, "Apple", 40.0);
+    add_record(0, "Pear", 50.0);
+
+    cache.insert_records(std::move(store));
+
+    // Group by region.
+    pivot_cache_aggregate_t res = cache.aggregate({0}, 2);
+    assert(res.keys.size() == 2);
+    assert(res.keys[0] == pivot_cache_record_t{pivot_cache_record_value_t(size_t(1))});
+    assert(res.keys[1] == pivot_cache_record_t{pivot_cache_record_value_t(size_t(0))});
+    assert(res.sums.size() == 2);
+    assert(res.sums[0] == 80.0);
+    assert(res.sums[1] == 70.0);
+    assert(res.counts.size() == 2);
+    assert(res.counts[0] == 3);
+    assert(res.counts[1] == 2);
+
+    // Group by product, then region.
+    res = cache.aggregate({1, 0}, 2);
+    assert(res.keys.size() == 4);
+    pivot_cache_record_t key = {
+        pivot_cache_record_value_t(ORCUS_ASCII("Apple")), pivot_cache_record_value_t(size_t(1))
+    };
+    assert(res.keys[0] == key);
+    assert(res.sums[0] == 50.0);
+    assert(res.counts[0] == 2);
+    key = { pivot_cache_record_value_t(ORCUS_ASCII("Pear")), pivot_cache_record_value_t(size_t(0)) };
+    assert(res.keys[3] == key);
+    assert(res.sums[3] == 50.0);
+    assert(res.counts[3] == 1);
+
+    // No group fields.
+    res = cache.aggregate({}, 2);
+    assert(res.keys.size() == 1);
+    assert(res.keys[0].empty());
+    assert(res.sums[0] == 150.0);
+    assert(res.counts[0] == 5);
+
+    // Data values referencing the shared items of the data field.
+    store = pivot_cache_records(sp);
+    store.append_value_shared_item(0);
+    store.append_value_character(ORCUS_ASCII("Apple"));
+    store.append_value_shared_item(0);
+    store.commit_record();
+    store.append_value_shared_item(0);
+    store.append_value_character(ORCUS_ASCII("Apple"));
+    store.append_value_shared_item(1);
+    store.commit_record();
+    cache.insert_records(std::move(store));
+
+    res = cache.aggregate({0}, 2);
+    assert(res.keys.size() == 1);
+    assert(res.sums[0] == 100.0);
+    assert(res.counts[0] == 2);
+
+    try
+    {
+        cache.aggregate({3}, 2);
+        assert(!"exception was expected");
+    }
+    catch (const std::invalid_argument&) {}
+}
+
+}
+
+int main()
+{
+    test_records_uniform();
+    test_records_mixed();
+    test_cache_records();
+    test_aggregate();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
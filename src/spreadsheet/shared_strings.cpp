@@ -11,6 +11,8 @@
 #include "orcus/pstring.hpp"
 #include "orcus/global.hpp"
 #include "orcus/string_pool.hpp"
+#include "orcus/import_stats.hpp"
+#include "orcus/detail/trace.hpp"
 
 #include <ixion/model_context.hpp>
 
@@ -56,7 +58,7 @@ bool format_run::formatted() const
 }
 
 import_shared_strings::import_shared_strings(orcus::string_pool& sp, ixion::model_context& cxt, styles& styles) :
-    m_string_pool(sp), m_cxt(cxt), m_styles(styles), mp_cur_format_runs(nullptr) {}
+    m_string_pool(sp), m_cxt(cxt), m_styles(styles), mp_cur_format_runs(nullptr), mp_stats(nullptr) {}
 
 import_shared_strings::~import_shared_strings()
 {
@@ -70,12 +72,28 @@ import_shared_strings::~import_shared_strings()
 
 size_t import_shared_strings::append(const char* s, size_t n)
 {
+    ORCUS_TRACE_SPAN("string", "import_shared_strings::append");
+    if (mp_stats)
+        ++mp_stats->strings.interned;
+
     return m_cxt.append_string(s, n);
 }
 
 size_t import_shared_strings::add(const char* s, size_t n)
 {
-    return m_cxt.add_string(s, n);
+    ORCUS_TRACE_SPAN("string", "import_shared_strings::add");
+    if (!mp_stats)
+        return m_cxt.add_string(s, n);
+
+    // A new string always gets an ID past the last one.
+    size_t string_count = m_cxt.get_string_count();
+    size_t sid = m_cxt.add_string(s, n);
+    if (sid >= string_count)
+        ++mp_stats->strings.interned;
+    else
+        ++mp_stats->strings.deduplicated;
+
+    return sid;
 }
 
 const format_runs_t* import_shared_strings::get_format_runs(size_t index) const
@@ -156,6 +174,9 @@ void import_shared_strings::append_segment(const char* s, size_t n)
 size_t import_shared_strings::commit_segments()
 {
     size_t sindex = m_cxt.append_string(m_cur_segment_string.data(), m_cur_segment_string.size());
+    if (mp_stats)
+        ++mp_stats->strings.interned;
+
     m_cur_segment_string.clear();
     m_formats.insert(format_runs_map_type::value_type(sindex, mp_cur_format_runs));
     mp_cur_format_runs = nullptr;
@@ -182,5 +203,10 @@ void import_shared_strings::dump() const
     cout << "number of shared strings: " << m_cxt.get_string_count() << endl;
 }
 
+void import_shared_strings::set_stats(import_stats* stats)
+{
+    mp_stats = stats;
+}
+
 }}
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
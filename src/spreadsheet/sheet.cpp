@@ -7,7 +7,9 @@
 
 #include "orcus/spreadsheet/sheet.hpp"
 #include "orcus/spreadsheet/document.hpp"
+#include "orcus/spreadsheet/config.hpp"
 #include "orcus/exception.hpp"
+#include "orcus/detail/trace.hpp"
 
 #include "json_dumper.hpp"
 #include "check_dumper.hpp"
@@ -15,15 +17,23 @@
 #include "flat_dumper.hpp"
 #include "html_dumper.hpp"
 #include "sheet_impl.hpp"
+#include "snapshot.hpp"
 
 #include <iostream>
 #include <algorithm>
 #include <vector>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <unordered_map>
 
+#include <ixion/cell.hpp>
 #include <ixion/formula.hpp>
+#include <ixion/formula_name_resolver.hpp>
+#include <ixion/formula_result.hpp>
+#include <ixion/matrix.hpp>
 #include <ixion/model_context.hpp>
+#include <ixion/model_iterator.hpp>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/gregorian/greg_date.hpp>
@@ -51,6 +61,419 @@ ixion::abs_range_t to_ixion_range(sheet_t sheet, const range_t& range)
     return pos;
 }
 
+/**
+ * Estimated amount of memory a cell value occupies in the model context, to
+ * keep the cell values of the sheets within the spill threshold.
+ */
+constexpr size_t cell_value_size = 16;
+
+/**
+ * Estimated amount of memory a formula cell occupies, along with its tokens
+ * and cached result.
+ */
+constexpr size_t formula_cell_size = 128;
+
+/**
+ * Type of each cell record in a snapshot.  A sheet's cell records are
+ * terminated by a record of type cell_end.
+ */
+enum snapshot_cell_t : uint8_t
+{
+    snapshot_cell_end = 0,
+    snapshot_cell_numeric,
+    snapshot_cell_string,
+    snapshot_cell_boolean,
+    snapshot_cell_formula,
+};
+
+enum snapshot_formula_t : uint8_t
+{
+    /** Formula with its own tokens, stored as formula string. */
+    snapshot_formula_new = 0,
+    /** Formula sharing the tokens of a formula cell recorded earlier. */
+    snapshot_formula_shared,
+    /** Top-left cell of a grouped formula range. */
+    snapshot_formula_grouped,
+};
+
+enum snapshot_result_t : uint8_t
+{
+    snapshot_result_none = 0,
+    snapshot_result_value,
+    snapshot_result_string,
+    snapshot_result_error,
+};
+
+void write_formula_result(detail::snapshot_writer& writer, const ixion::formula_cell& fc)
+{
+    try
+    {
+        ixion::formula_result res = fc.get_result_cache(
+            ixion::formula_result_wait_policy_t::throw_exception);
+
+        switch (res.get_type())
+        {
+            case ixion::formula_result::result_type::value:
+                writer.write_uint8(snapshot_result_value);
+                writer.write_double(res.get_value());
+                return;
+            case ixion::formula_result::result_type::string:
+                writer.write_uint8(snapshot_result_string);
+                writer.write_string(res.get_string());
+                return;
+            case ixion::formula_result::result_type::error:
+                writer.write_uint8(snapshot_result_error);
+                writer.write_enum(res.get_error());
+                return;
+            default:
+                ;
+        }
+    }
+    catch (const std::exception&)
+    {
+        // No cached result.
+    }
+
+    writer.write_uint8(snapshot_result_none);
+}
+
+std::unique_ptr<ixion::formula_result> read_formula_result(detail::snapshot_reader& reader)
+{
+    std::unique_ptr<ixion::formula_result> res;
+
+    switch (reader.read_uint8())
+    {
+        case snapshot_result_none:
+            break;
+        case snapshot_result_value:
+            res = std::make_unique<ixion::formula_result>(reader.read_double());
+            break;
+        case snapshot_result_string:
+            res = std::make_unique<ixion::formula_result>(reader.read_string().str());
+            break;
+        case snapshot_result_error:
+            res = std::make_unique<ixion::formula_result>(reader.read_enum<ixion::formula_error_t>());
+            break;
+        default:
+            throw general_error("sheet::read_snapshot: unknown formula result type.");
+    }
+
+    return res;
+}
+
+/**
+ * Write the segments of a flat segment tree whose values differ from the
+ * default value.
+ */
+template<typename StoreT, typename WriteFuncT>
+void write_segments(
+    detail::snapshot_writer& writer, const StoreT& store,
+    const typename StoreT::value_type& default_value, WriteFuncT write_value)
+{
+    using key_type = typename StoreT::key_type;
+    using value_type = typename StoreT::value_type;
+
+    struct segment
+    {
+        key_type start;
+        key_type end;
+        value_type value;
+    };
+
+    std::vector<segment> segments;
+    auto it = store.begin(), it_end = store.end();
+    if (it != it_end)
+    {
+        for (auto prev = it++; it != it_end; prev = it++)
+        {
+            if (prev->second != default_value)
+                segments.push_back({prev->first, it->first, prev->second});
+        }
+    }
+
+    writer.write_uint64(segments.size());
+    for (const segment& seg : segments)
+    {
+        writer.write_int32(seg.start);
+        writer.write_int32(seg.end);
+        write_value(seg.value);
+    }
+}
+
+template<typename StoreT, typename ReadFuncT>
+void read_segments(detail::snapshot_reader& reader, StoreT& store, ReadFuncT read_value)
+{
+    size_t n = reader.read_count();
+    for (size_t i = 0; i < n; ++i)
+    {
+        typename StoreT::key_type start = reader.read_int32();
+        typename StoreT::key_type end = reader.read_int32();
+        typename StoreT::value_type value = read_value();
+        if (start >= end || !store.insert_back(start, end, value).second)
+            throw general_error("sheet::read_snapshot: invalid segment.");
+    }
+}
+
+ixion::formula_tokens_t parse_snapshot_formula(
+    ixion::model_context& cxt, const ixion::abs_address_t& pos,
+    const ixion::formula_name_resolver& resolver, const pstring& formula)
+{
+    try
+    {
+        ORCUS_TRACE_SPAN("formula", "parse_formula_string");
+        return ixion::parse_formula_string(cxt, pos, resolver, formula.get(), formula.size());
+    }
+    catch (const std::exception& e)
+    {
+        // The formula was already a formula with errors at the time of the
+        // snapshot.
+        const char* p_error = e.what();
+        return ixion::create_formula_error_tokens(
+            cxt, formula.get(), formula.size(), p_error, std::strlen(p_error));
+    }
+}
+
+/**
+ * Writes the cell records of a sheet, remembering the formula tokens written
+ * so far so that the formula cells sharing their tokens still share them
+ * once read back.
+ */
+class cell_record_writer
+{
+    detail::snapshot_writer& m_writer;
+    const ixion::model_context& m_cxt;
+    const ixion::formula_name_resolver& m_resolver;
+    sheet_t m_sheet;
+
+    /** Indices of the token stores written so far. */
+    std::unordered_map<const ixion::formula_tokens_store*, uint64_t> m_stores;
+
+public:
+    cell_record_writer(
+        detail::snapshot_writer& writer, const ixion::model_context& cxt,
+        const ixion::formula_name_resolver& resolver, sheet_t sheet) :
+        m_writer(writer), m_cxt(cxt), m_resolver(resolver), m_sheet(sheet) {}
+
+    void write(const ixion::model_iterator::cell& c)
+    {
+        switch (c.type)
+        {
+            case ixion::celltype_t::numeric:
+                m_writer.write_uint8(snapshot_cell_numeric);
+                m_writer.write_int32(c.row);
+                m_writer.write_int32(c.col);
+                m_writer.write_double(c.value.numeric);
+                break;
+            case ixion::celltype_t::string:
+                m_writer.write_uint8(snapshot_cell_string);
+                m_writer.write_int32(c.row);
+                m_writer.write_int32(c.col);
+                m_writer.write_uint64(c.value.string);
+                break;
+            case ixion::celltype_t::boolean:
+                m_writer.write_uint8(snapshot_cell_boolean);
+                m_writer.write_int32(c.row);
+                m_writer.write_int32(c.col);
+                m_writer.write_bool(c.value.boolean);
+                break;
+            case ixion::celltype_t::formula:
+            {
+                const ixion::formula_cell* fc = c.value.formula;
+                const ixion::formula_tokens_store_ptr_t& ts = fc->get_tokens();
+                if (!ts)
+                    break;
+
+                ixion::abs_address_t pos(m_sheet, c.row, c.col);
+                ixion::formula_group_t fg = fc->get_group_properties();
+
+                if (fg.grouped)
+                {
+                    if (fc->get_parent_position(pos) != pos)
+                        // The whole group is written with its top-left cell.
+                        break;
+
+                    m_writer.write_uint8(snapshot_cell_formula);
+                    m_writer.write_int32(c.row);
+                    m_writer.write_int32(c.col);
+                    m_writer.write_uint8(snapshot_formula_grouped);
+                    m_writer.write_int32(fg.size.row);
+                    m_writer.write_int32(fg.size.column);
+                    m_writer.write_string(ixion::print_formula_tokens(m_cxt, pos, m_resolver, ts->get()));
+
+                    // The cached results of all member cells, in row-major
+                    // order.
+                    for (row_t r = 0; r < fg.size.row; ++r)
+                    {
+                        for (col_t col = 0; col < fg.size.column; ++col)
+                        {
+                            ixion::abs_address_t member(m_sheet, c.row + r, c.col + col);
+                            write_formula_result(m_writer, *m_cxt.get_formula_cell(member));
+                        }
+                    }
+                    break;
+                }
+
+                m_writer.write_uint8(snapshot_cell_formula);
+                m_writer.write_int32(c.row);
+                m_writer.write_int32(c.col);
+
+                auto it = m_stores.find(ts.get());
+                if (it == m_stores.end())
+                {
+                    m_stores.insert({ts.get(), m_stores.size()});
+                    m_writer.write_uint8(snapshot_formula_new);
+                    m_writer.write_string(ixion::print_formula_tokens(m_cxt, pos, m_resolver, ts->get()));
+                }
+                else
+                {
+                    m_writer.write_uint8(snapshot_formula_shared);
+                    m_writer.write_uint64(it->second);
+                }
+
+                write_formula_result(m_writer, *fc);
+                break;
+            }
+            default:
+                ;
+        }
+    }
+};
+
+/**
+ * Read the cell records written by cell_record_writer, up to the end record,
+ * into a sheet.
+ */
+void read_cell_records(
+    detail::snapshot_reader& reader, sheet& sh, document& doc,
+    const ixion::formula_name_resolver& resolver)
+{
+    ixion::model_context& cxt = doc.get_model_context();
+    range_size_t sheet_size = doc.get_sheet_size();
+    size_t string_count = cxt.get_string_count();
+    std::vector<ixion::formula_tokens_store_ptr_t> stores;
+
+    for (uint8_t type = reader.read_uint8(); type != snapshot_cell_end; type = reader.read_uint8())
+    {
+        row_t row = reader.read_int32();
+        col_t col = reader.read_int32();
+        if (row < 0 || row >= sheet_size.rows || col < 0 || col >= sheet_size.columns)
+            throw general_error("sheet::read_snapshot: cell position is outside the sheet.");
+
+        switch (type)
+        {
+            case snapshot_cell_numeric:
+                sh.set_value(row, col, reader.read_double());
+                break;
+            case snapshot_cell_string:
+            {
+                uint64_t sindex = reader.read_uint64();
+                if (sindex >= string_count)
+                    throw general_error("sheet::read_snapshot: invalid string index.");
+
+                sh.set_string(row, col, sindex);
+                break;
+            }
+            case snapshot_cell_boolean:
+                sh.set_bool(row, col, reader.read_bool());
+                break;
+            case snapshot_cell_formula:
+            {
+                ixion::abs_address_t pos(sh.get_index(), row, col);
+                ixion::formula_tokens_store_ptr_t ts;
+
+                switch (reader.read_uint8())
+                {
+                    case snapshot_formula_new:
+                    {
+                        ts = ixion::formula_tokens_store::create();
+                        ts->get() = parse_snapshot_formula(cxt, pos, resolver, reader.read_string());
+                        stores.push_back(ts);
+                        break;
+                    }
+                    case snapshot_formula_shared:
+                    {
+                        uint64_t index = reader.read_uint64();
+                        if (index >= stores.size())
+                            throw general_error("sheet::read_snapshot: invalid shared formula index.");
+
+                        ts = stores[index];
+                        break;
+                    }
+                    case snapshot_formula_grouped:
+                    {
+                        row_t rows = reader.read_int32();
+                        col_t cols = reader.read_int32();
+                        if (rows <= 0 || cols <= 0 || rows > sheet_size.rows - row || cols > sheet_size.columns - col)
+                            throw general_error("sheet::read_snapshot: invalid formula group size.");
+
+                        range_t range;
+                        range.first.row = row;
+                        range.first.column = col;
+                        range.last.row = row + rows - 1;
+                        range.last.column = col + cols - 1;
+
+                        ixion::formula_tokens_t tokens =
+                            parse_snapshot_formula(cxt, pos, resolver, reader.read_string());
+
+                        ixion::matrix mtx(rows, cols);
+                        bool has_results = false;
+
+                        for (row_t r = 0; r < rows; ++r)
+                        {
+                            for (col_t c = 0; c < cols; ++c)
+                            {
+                                std::unique_ptr<ixion::formula_result> res = read_formula_result(reader);
+                                if (!res)
+                                    continue;
+
+                                has_results = true;
+
+                                switch (res->get_type())
+                                {
+                                    case ixion::formula_result::result_type::value:
+                                        mtx.set(r, c, res->get_value());
+                                        break;
+                                    case ixion::formula_result::result_type::string:
+                                        mtx.set(r, c, res->get_string());
+                                        break;
+                                    case ixion::formula_result::result_type::error:
+                                        mtx.set(r, c, res->get_error());
+                                        break;
+                                    default:
+                                        ;
+                                }
+                            }
+                        }
+
+                        if (has_results)
+                            sh.set_grouped_formula(range, std::move(tokens), ixion::formula_result(std::move(mtx)));
+                        else
+                            sh.set_grouped_formula(range, std::move(tokens));
+
+                        break;
+                    }
+                    default:
+                        throw general_error("sheet::read_snapshot: unknown formula type.");
+                }
+
+                if (!ts)
+                    // Grouped formula, which has already been inserted.
+                    break;
+
+                std::unique_ptr<ixion::formula_result> res = read_formula_result(reader);
+                if (res)
+                    sh.set_formula(row, col, ts, std::move(*res));
+                else
+                    sh.set_formula(row, col, ts);
+
+                break;
+            }
+            default:
+                throw general_error("sheet::read_snapshot: unknown cell type.");
+        }
+    }
+}
+
 }
 
 const row_t sheet::max_row_limit = 1048575;
@@ -64,11 +487,12 @@ sheet::~sheet()
     delete mp_impl;
 }
 
-void sheet::set_auto(row_t row, col_t col, const char* p, size_t n)
+ixion::celltype_t sheet::set_auto(row_t row, col_t col, const char* p, size_t n)
 {
     if (!p || !n)
-        return;
+        return ixion::celltype_t::empty;
 
+    mp_impl->m_doc.add_cell_size(mp_impl->m_sheet, cell_value_size);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
 
     // First, see if this can be parsed as a number.
@@ -76,15 +500,20 @@ void sheet::set_auto(row_t row, col_t col, const char* p, size_t n)
     double val = strtod(p, &endptr);
     const char* endptr_check = p + n;
     if (endptr == endptr_check)
+    {
         // Treat this as a numeric value.
         cxt.set_numeric_cell(ixion::abs_address_t(mp_impl->m_sheet,row,col), val);
-    else
-        // Treat this as a string value.
-        cxt.set_string_cell(ixion::abs_address_t(mp_impl->m_sheet,row,col), p, n);
+        return ixion::celltype_t::numeric;
+    }
+
+    // Treat this as a string value.
+    cxt.set_string_cell(ixion::abs_address_t(mp_impl->m_sheet,row,col), p, n);
+    return ixion::celltype_t::string;
 }
 
 void sheet::set_string(row_t row, col_t col, size_t sindex)
 {
+    mp_impl->m_doc.add_cell_size(mp_impl->m_sheet, cell_value_size);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
     cxt.set_string_cell(ixion::abs_address_t(mp_impl->m_sheet,row,col), sindex);
 
@@ -95,12 +524,14 @@ void sheet::set_string(row_t row, col_t col, size_t sindex)
 
 void sheet::set_value(row_t row, col_t col, double value)
 {
+    mp_impl->m_doc.add_cell_size(mp_impl->m_sheet, cell_value_size);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
     cxt.set_numeric_cell(ixion::abs_address_t(mp_impl->m_sheet,row,col), value);
 }
 
 void sheet::set_bool(row_t row, col_t col, bool value)
 {
+    mp_impl->m_doc.add_cell_size(mp_impl->m_sheet, cell_value_size);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
     cxt.set_boolean_cell(ixion::abs_address_t(mp_impl->m_sheet,row,col), value);
 }
@@ -138,32 +569,12 @@ void sheet::set_format(row_t row, col_t col, size_t index)
 
 void sheet::set_format(row_t row_start, col_t col_start, row_t row_end, col_t col_end, size_t index)
 {
-    for (col_t col = col_start; col <= col_end; ++col)
-    {
-        cell_format_type::iterator itr = mp_impl->m_cell_formats.find(col);
-        if (itr == mp_impl->m_cell_formats.end())
-        {
-            auto p = std::make_unique<segment_row_index_type>(0, mp_impl->m_doc.get_sheet_size().rows+1, 0);
-
-            pair<cell_format_type::iterator, bool> r =
-                mp_impl->m_cell_formats.insert(cell_format_type::value_type(col, std::move(p)));
-
-            if (!r.second)
-            {
-                cerr << "insertion of new cell format container failed!" << endl;
-                return;
-            }
-
-            itr = r.first;
-        }
-
-        segment_row_index_type& con = *itr->second;
-        con.insert_back(row_start, row_end+1, index);
-    }
+    mp_impl->m_cell_formats.set(row_start, col_start, row_end, col_end, index);
 }
 
 void sheet::set_formula(row_t row, col_t col, const ixion::formula_tokens_store_ptr_t& tokens)
 {
+    mp_impl->m_doc.add_cell_size(mp_impl->m_sheet, formula_cell_size);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
     ixion::abs_address_t pos(mp_impl->m_sheet, row, col);
 
@@ -185,6 +596,7 @@ void sheet::set_formula(
     row_t row, col_t col, const ixion::formula_tokens_store_ptr_t& tokens,
     ixion::formula_result result)
 {
+    mp_impl->m_doc.add_cell_size(mp_impl->m_sheet, formula_cell_size);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
     ixion::abs_address_t pos(mp_impl->m_sheet, row, col);
 
@@ -205,6 +617,10 @@ void sheet::set_formula(
 
 void sheet::set_grouped_formula(const range_t& range, ixion::formula_tokens_t tokens)
 {
+    mp_impl->m_doc.add_cell_size(
+        mp_impl->m_sheet,
+        formula_cell_size * (range.last.row - range.first.row + 1) * (range.last.column - range.first.column + 1));
+
     ixion::abs_range_t pos = to_ixion_range(mp_impl->m_sheet, range);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
 
@@ -224,6 +640,10 @@ void sheet::set_grouped_formula(const range_t& range, ixion::formula_tokens_t to
 
 void sheet::set_grouped_formula(const range_t& range, ixion::formula_tokens_t tokens, ixion::formula_result result)
 {
+    mp_impl->m_doc.add_cell_size(
+        mp_impl->m_sheet,
+        formula_cell_size * (range.last.row - range.first.row + 1) * (range.last.column - range.first.column + 1));
+
     ixion::abs_range_t pos = to_ixion_range(mp_impl->m_sheet, range);
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
 
@@ -340,8 +760,19 @@ void sheet::set_merge_cell_range(const range_t& range)
         detail::merge_size_type::value_type(range.first.row, sz));
 }
 
+void sheet::set_data_range_hint(const range_t& range)
+{
+    col_t n = std::min(
+        range.last.column - range.first.column + 1, mp_impl->m_doc.get_sheet_size().columns);
+
+    if (n > 0)
+        mp_impl->m_cell_formats.reserve(n);
+}
+
 void sheet::fill_down_cells(row_t src_row, col_t src_col, row_t range_size)
 {
+    mp_impl->m_doc.add_cell_size(mp_impl->m_sheet, cell_value_size * range_size);
+
     ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
     ixion::abs_address_t src_pos(mp_impl->m_sheet, src_row, src_col);
     cxt.fill_down_cells(src_pos, range_size);
@@ -373,6 +804,7 @@ range_t sheet::get_merge_cell_range(row_t row, col_t col) const
 
 size_t sheet::get_string_identifier(row_t row, col_t col) const
 {
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
     const ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
     return cxt.get_string_identifier(ixion::abs_address_t(mp_impl->m_sheet, row, col));
 }
@@ -394,6 +826,7 @@ void sheet::set_auto_filter_data(auto_filter_t* p)
 
 ixion::abs_range_t sheet::get_data_range() const
 {
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
     return mp_impl->get_data_range();
 }
 
@@ -404,6 +837,7 @@ sheet_t sheet::get_index() const
 
 date_time_t sheet::get_date_time(row_t row, col_t col) const
 {
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
     const ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
 
     // raw value as days since epoch.
@@ -461,55 +895,264 @@ void sheet::finalize()
 
 void sheet::dump_flat(std::ostream& os) const
 {
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
     detail::flat_dumper dumper(mp_impl->m_doc);
     dumper.dump(os, mp_impl->m_sheet);
 }
 
 void sheet::dump_check(ostream& os, const pstring& sheet_name) const
 {
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
     detail::check_dumper dumper(*mp_impl, sheet_name);
     dumper.dump(os);
 }
 
 void sheet::dump_html(std::ostream& os) const
 {
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
     if (!mp_impl->m_col_widths.is_tree_valid())
         mp_impl->m_col_widths.build_tree();
 
     if (!mp_impl->m_row_heights.is_tree_valid())
         mp_impl->m_row_heights.build_tree();
 
-    detail::html_dumper dumper(mp_impl->m_doc, mp_impl->m_merge_ranges, mp_impl->m_sheet);
+    detail::html_dumper dumper(*mp_impl);
     dumper.dump(os);
 }
 
 void sheet::dump_json(std::ostream& os) const
 {
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
     detail::json_dumper dumper(mp_impl->m_doc);
     dumper.dump(os, mp_impl->m_sheet);
 }
 
 void sheet::dump_csv(std::ostream& os) const
 {
-    detail::csv_dumper dumper(mp_impl->m_doc);
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
+    const document_config& cfg = mp_impl->m_doc.get_config();
+    detail::csv_dumper dumper(mp_impl->m_doc, cfg.csv_separator, cfg.csv_quote);
     dumper.dump(os, mp_impl->m_sheet);
 }
 
-size_t sheet::get_cell_format(row_t row, col_t col) const
+void sheet::write_snapshot(detail::snapshot_writer& writer) const
 {
-    cell_format_type::const_iterator itr = mp_impl->m_cell_formats.find(col);
-    if (itr == mp_impl->m_cell_formats.end())
-        return 0;
+    mp_impl->m_doc.page_in_sheet(mp_impl->m_sheet);
+    const ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
+    const ixion::formula_name_resolver* resolver =
+        mp_impl->m_doc.get_formula_name_resolver(formula_ref_context_t::global);
+    if (!resolver)
+        throw general_error("sheet::write_snapshot: no formula name resolver.");
 
-    segment_row_index_type& con = *itr->second;
-    if (!con.is_tree_valid())
-        con.build_tree();
+    // Cell values.
 
-    size_t index;
-    if (!con.search_tree(row, index).second)
-        return 0;
+    ixion::abs_range_t range = mp_impl->get_data_range();
+    if (range.valid())
+    {
+        cell_record_writer records(writer, cxt, *resolver, mp_impl->m_sheet);
+        ixion::model_iterator iter = cxt.get_model_iterator(
+            mp_impl->m_sheet, ixion::rc_direction_t::horizontal, range);
 
-    return index;
+        for (; iter.has(); iter.next())
+            records.write(iter.get());
+    }
+
+    writer.write_uint8(snapshot_cell_end);
+
+    // Cell formats.
+
+    writer.write_uint64(mp_impl->m_cell_formats.run_count());
+    for (const detail::cell_format_store::range& r : mp_impl->m_cell_formats)
+    {
+        writer.write_int32(r.column);
+        writer.write_int32(r.first_row);
+        writer.write_int32(r.last_row);
+        writer.write_uint64(r.index);
+    }
+
+    // Column widths, row heights and their hidden states.
+
+    auto write_size = [&writer](const col_width_t& v) { writer.write_uint64(v); };
+    auto write_hidden = [&writer](const bool& v) { writer.write_bool(v); };
+
+    write_segments(writer, mp_impl->m_col_widths, get_default_column_width(), write_size);
+    write_segments(writer, mp_impl->m_row_heights, get_default_row_height(), write_size);
+    write_segments(writer, mp_impl->m_col_hidden, false, write_hidden);
+    write_segments(writer, mp_impl->m_row_hidden, false, write_hidden);
+
+    // Merged cell ranges.
+
+    size_t merge_count = 0;
+    for (const auto& col_entry : mp_impl->m_merge_ranges)
+        merge_count += col_entry.second->size();
+
+    writer.write_uint64(merge_count);
+    for (const auto& col_entry : mp_impl->m_merge_ranges)
+    {
+        for (const auto& row_entry : *col_entry.second)
+        {
+            writer.write_int32(col_entry.first);
+            writer.write_int32(row_entry.first);
+            writer.write_int32(row_entry.second.width);
+            writer.write_int32(row_entry.second.height);
+        }
+    }
+
+    // Auto filter.
+
+    const auto_filter_t* filter = mp_impl->mp_auto_filter_data.get();
+    writer.write_bool(filter != nullptr);
+    if (filter)
+        detail::write_auto_filter(writer, *filter);
+}
+
+void sheet::read_snapshot(detail::snapshot_reader& reader)
+{
+    document& doc = mp_impl->m_doc;
+    const ixion::formula_name_resolver* resolver =
+        doc.get_formula_name_resolver(formula_ref_context_t::global);
+    if (!resolver)
+        throw general_error("sheet::read_snapshot: no formula name resolver.");
+
+    // Cell values.
+
+    read_cell_records(reader, *this, doc, *resolver);
+
+    // Cell formats.
+
+    size_t n = reader.read_count();
+    for (size_t i = 0; i < n; ++i)
+    {
+        col_t col = reader.read_int32();
+        row_t first_row = reader.read_int32();
+        row_t last_row = reader.read_int32();
+        size_t index = reader.read_uint64();
+        mp_impl->m_cell_formats.set(first_row, col, last_row, col, index);
+    }
+
+    // Column widths, row heights and their hidden states.
+
+    auto read_size = [&reader]() { return reader.read_uint64(); };
+    auto read_hidden = [&reader]() { return reader.read_bool(); };
+
+    read_segments(reader, mp_impl->m_col_widths, read_size);
+    read_segments(reader, mp_impl->m_row_heights, read_size);
+    read_segments(reader, mp_impl->m_col_hidden, read_hidden);
+    read_segments(reader, mp_impl->m_row_hidden, read_hidden);
+
+    mp_impl->m_col_width_pos = mp_impl->m_col_widths.begin();
+    mp_impl->m_row_height_pos = mp_impl->m_row_heights.begin();
+    mp_impl->m_col_hidden_pos = mp_impl->m_col_hidden.begin();
+    mp_impl->m_row_hidden_pos = mp_impl->m_row_hidden.begin();
+
+    // Merged cell ranges.
+
+    n = reader.read_count();
+    for (size_t i = 0; i < n; ++i)
+    {
+        range_t range;
+        range.first.column = reader.read_int32();
+        range.first.row = reader.read_int32();
+        range.last.column = range.first.column + reader.read_int32() - 1;
+        range.last.row = range.first.row + reader.read_int32() - 1;
+        set_merge_cell_range(range);
+    }
+
+    // Auto filter.
+
+    if (reader.read_bool())
+    {
+        auto filter = std::make_unique<auto_filter_t>();
+        detail::read_auto_filter(reader, *filter, doc.get_string_pool());
+        mp_impl->mp_auto_filter_data = std::move(filter);
+    }
+}
+
+void sheet::spill_cells(std::ostream& os)
+{
+    ixion::model_context& cxt = mp_impl->m_doc.get_model_context();
+    const ixion::formula_name_resolver* resolver =
+        mp_impl->m_doc.get_formula_name_resolver(formula_ref_context_t::global);
+    if (!resolver)
+        throw general_error("sheet::spill_cells: no formula name resolver.");
+
+    detail::snapshot_writer writer(os);
+
+    ixion::abs_range_t range = mp_impl->get_data_range();
+    if (range.valid())
+    {
+        cell_record_writer records(writer, cxt, *resolver, mp_impl->m_sheet);
+
+        // Rows of the non-empty cells in the current column, in runs of
+        // consecutive rows.
+        std::vector<std::pair<row_t, row_t>> runs;
+
+        // Go one column at a time so that the cells of each column can be
+        // removed as soon as they have been written.
+        for (col_t col = range.first.column; col <= range.last.column; ++col)
+        {
+            ixion::abs_rc_range_t col_range;
+            col_range.first.row = range.first.row;
+            col_range.first.column = col;
+            col_range.last.row = range.last.row;
+            col_range.last.column = col;
+
+            runs.clear();
+
+            ixion::model_iterator iter = cxt.get_model_iterator(
+                mp_impl->m_sheet, ixion::rc_direction_t::vertical, col_range);
+
+            for (; iter.has(); iter.next())
+            {
+                const ixion::model_iterator::cell& c = iter.get();
+                if (c.type == ixion::celltype_t::empty)
+                    continue;
+
+                records.write(c);
+
+                if (!runs.empty() && runs.back().second + 1 == c.row)
+                    runs.back().second = c.row;
+                else
+                    runs.emplace_back(c.row, c.row);
+            }
+
+            // Remove the cells from the bottom up, which only ever shrinks
+            // the cell blocks from their ends.
+            for (auto it = runs.rbegin(); it != runs.rend(); ++it)
+            {
+                for (row_t row = it->second; row >= it->first; --row)
+                {
+                    ixion::abs_address_t pos(mp_impl->m_sheet, row, col);
+                    if (cxt.get_celltype(pos) == ixion::celltype_t::formula)
+                        ixion::unregister_formula_cell(cxt, pos);
+
+                    cxt.erase_cell(pos);
+                }
+            }
+        }
+    }
+
+    writer.write_uint8(snapshot_cell_end);
+}
+
+void sheet::restore_cells(const char* p, size_t n)
+{
+    document& doc = mp_impl->m_doc;
+    const ixion::formula_name_resolver* resolver =
+        doc.get_formula_name_resolver(formula_ref_context_t::global);
+    if (!resolver)
+        throw general_error("sheet::restore_cells: no formula name resolver.");
+
+    detail::snapshot_reader reader(p, n);
+    read_cell_records(reader, *this, doc, *resolver);
+
+    if (!reader.eof())
+        throw general_error("sheet::restore_cells: trailing data found.");
+}
+
+size_t sheet::get_cell_format(row_t row, col_t col) const
+{
+    return mp_impl->m_cell_formats.get(row, col);
 }
 
 }}
@@ -9,6 +9,7 @@
 #define INCLUDED_ORCUS_SPREADSHEET_SHEET_IMPL_HPP
 
 #include "impl_types.hpp"
+#include "cell_format_store.hpp"
 #include "orcus/spreadsheet/auto_filter.hpp"
 
 namespace orcus { namespace spreadsheet {
@@ -16,9 +17,6 @@ namespace orcus { namespace spreadsheet {
 class document;
 class sheet;
 
-typedef mdds::flat_segment_tree<row_t, size_t>  segment_row_index_type;
-typedef std::unordered_map<col_t, std::unique_ptr<segment_row_index_type>> cell_format_type;
-
 // Widths and heights are stored in twips.
 typedef mdds::flat_segment_tree<col_t, col_width_t> col_widths_store_type;
 typedef mdds::flat_segment_tree<row_t, row_height_t> row_heights_store_type;
@@ -45,7 +43,7 @@ struct sheet_impl
 
     std::unique_ptr<auto_filter_t> mp_auto_filter_data;
 
-    cell_format_type m_cell_formats;
+    detail::cell_format_store m_cell_formats;
     const sheet_t m_sheet; /// sheet ID
 
     sheet_impl() = delete;
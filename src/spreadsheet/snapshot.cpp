@@ -0,0 +1,496 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "snapshot.hpp"
+
+#include "orcus/spreadsheet/styles.hpp"
+#include "orcus/spreadsheet/auto_filter.hpp"
+#include "orcus/string_pool.hpp"
+#include "orcus/exception.hpp"
+
+#include <cstring>
+#include <sstream>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+namespace {
+
+const char magic[] = "ORCUSSNP";
+const size_t magic_size = sizeof(magic) - 1;
+
+/**
+ * Bump this whenever the layout of the snapshot changes.  Snapshots of
+ * other versions are rejected on load.
+ */
+const int32_t snapshot_version = 3;
+
+void write_color(snapshot_writer& writer, const color_t& c)
+{
+    writer.write_uint8(c.alpha);
+    writer.write_uint8(c.red);
+    writer.write_uint8(c.green);
+    writer.write_uint8(c.blue);
+}
+
+color_t read_color(snapshot_reader& reader)
+{
+    color_t c;
+    c.alpha = reader.read_uint8();
+    c.red = reader.read_uint8();
+    c.green = reader.read_uint8();
+    c.blue = reader.read_uint8();
+    return c;
+}
+
+void write_border_attrs(snapshot_writer& writer, const border_attrs_t& attrs)
+{
+    writer.write_enum(attrs.style);
+    write_color(writer, attrs.border_color);
+    writer.write_enum(attrs.border_width.unit);
+    writer.write_double(attrs.border_width.value);
+}
+
+border_attrs_t read_border_attrs(snapshot_reader& reader)
+{
+    border_attrs_t attrs;
+    attrs.style = reader.read_enum<border_style_t>();
+    attrs.border_color = read_color(reader);
+    attrs.border_width.unit = reader.read_enum<length_unit_t>();
+    attrs.border_width.value = reader.read_double();
+    return attrs;
+}
+
+void write_cell_format(snapshot_writer& writer, const cell_format_t& cf)
+{
+    writer.write_uint64(cf.font);
+    writer.write_uint64(cf.fill);
+    writer.write_uint64(cf.border);
+    writer.write_uint64(cf.protection);
+    writer.write_uint64(cf.number_format);
+    writer.write_uint64(cf.style_xf);
+    writer.write_enum(cf.hor_align);
+    writer.write_enum(cf.ver_align);
+    writer.write_bool(cf.apply_num_format);
+    writer.write_bool(cf.apply_font);
+    writer.write_bool(cf.apply_fill);
+    writer.write_bool(cf.apply_border);
+    writer.write_bool(cf.apply_alignment);
+    writer.write_bool(cf.apply_protection);
+}
+
+cell_format_t read_cell_format(snapshot_reader& reader)
+{
+    cell_format_t cf;
+    cf.font = reader.read_uint64();
+    cf.fill = reader.read_uint64();
+    cf.border = reader.read_uint64();
+    cf.protection = reader.read_uint64();
+    cf.number_format = reader.read_uint64();
+    cf.style_xf = reader.read_uint64();
+    cf.hor_align = reader.read_enum<hor_alignment_t>();
+    cf.ver_align = reader.read_enum<ver_alignment_t>();
+    cf.apply_num_format = reader.read_bool();
+    cf.apply_font = reader.read_bool();
+    cf.apply_fill = reader.read_bool();
+    cf.apply_border = reader.read_bool();
+    cf.apply_alignment = reader.read_bool();
+    cf.apply_protection = reader.read_bool();
+    return cf;
+}
+
+}
+
+snapshot_writer::snapshot_writer(std::ostream& os) : m_os(os) {}
+
+void snapshot_writer::write_header()
+{
+    m_os.write(magic, magic_size);
+    write_int32(snapshot_version);
+}
+
+void snapshot_writer::write_uint8(uint8_t v)
+{
+    m_os.put(static_cast<char>(v));
+}
+
+void snapshot_writer::write_int32(int32_t v)
+{
+    uint32_t uv = static_cast<uint32_t>(v);
+    char buf[4];
+    for (size_t i = 0; i < 4; ++i)
+        buf[i] = static_cast<char>((uv >> (i * 8)) & 0xFF);
+
+    m_os.write(buf, 4);
+}
+
+void snapshot_writer::write_uint64(uint64_t v)
+{
+    char buf[8];
+    for (size_t i = 0; i < 8; ++i)
+        buf[i] = static_cast<char>((v >> (i * 8)) & 0xFF);
+
+    m_os.write(buf, 8);
+}
+
+void snapshot_writer::write_double(double v)
+{
+    static_assert(sizeof(double) == sizeof(uint64_t), "unexpected size of double.");
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    write_uint64(bits);
+}
+
+void snapshot_writer::write_bool(bool v)
+{
+    write_uint8(v ? 1 : 0);
+}
+
+void snapshot_writer::write_string(const char* p, size_t n)
+{
+    write_uint64(n);
+    m_os.write(p, n);
+}
+
+void snapshot_writer::write_string(const pstring& s)
+{
+    write_string(s.get(), s.size());
+}
+
+void snapshot_writer::write_string(const std::string& s)
+{
+    write_string(s.data(), s.size());
+}
+
+snapshot_reader::snapshot_reader(const char* p, size_t n) :
+    mp_cur(p), mp_end(p + n) {}
+
+const char* snapshot_reader::advance(size_t n)
+{
+    if (size_t(mp_end - mp_cur) < n)
+        throw general_error("snapshot_reader: snapshot ended prematurely.");
+
+    const char* p = mp_cur;
+    mp_cur += n;
+    return p;
+}
+
+void snapshot_reader::read_header()
+{
+    if (size_t(mp_end - mp_cur) < magic_size || std::memcmp(mp_cur, magic, magic_size))
+        throw general_error("snapshot_reader: not a snapshot.");
+
+    mp_cur += magic_size;
+    int32_t version = read_int32();
+    if (version != snapshot_version)
+    {
+        std::ostringstream os;
+        os << "snapshot_reader: unsupported snapshot version " << version << '.';
+        throw general_error(os.str());
+    }
+}
+
+uint8_t snapshot_reader::read_uint8()
+{
+    return static_cast<uint8_t>(*advance(1));
+}
+
+int32_t snapshot_reader::read_int32()
+{
+    const char* p = advance(4);
+    uint32_t v = 0;
+    for (size_t i = 0; i < 4; ++i)
+        v |= uint32_t(static_cast<uint8_t>(p[i])) << (i * 8);
+
+    return static_cast<int32_t>(v);
+}
+
+uint64_t snapshot_reader::read_uint64()
+{
+    const char* p = advance(8);
+    uint64_t v = 0;
+    for (size_t i = 0; i < 8; ++i)
+        v |= uint64_t(static_cast<uint8_t>(p[i])) << (i * 8);
+
+    return v;
+}
+
+double snapshot_reader::read_double()
+{
+    uint64_t bits = read_uint64();
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+bool snapshot_reader::read_bool()
+{
+    return read_uint8() != 0;
+}
+
+size_t snapshot_reader::read_count()
+{
+    uint64_t n = read_uint64();
+    if (n > uint64_t(mp_end - mp_cur))
+        throw general_error("snapshot_reader: element count exceeds the size of the snapshot.");
+
+    return n;
+}
+
+pstring snapshot_reader::read_string()
+{
+    size_t n = read_count();
+    return pstring(advance(n), n);
+}
+
+bool snapshot_reader::eof() const
+{
+    return mp_cur == mp_end;
+}
+
+void write_styles(snapshot_writer& writer, const styles& st)
+{
+    size_t n = st.get_font_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const font_t& font = *st.get_font(i);
+        writer.write_string(font.name);
+        writer.write_double(font.size);
+        writer.write_bool(font.bold);
+        writer.write_bool(font.italic);
+        writer.write_enum(font.underline_style);
+        writer.write_enum(font.underline_width);
+        writer.write_enum(font.underline_mode);
+        writer.write_enum(font.underline_type);
+        write_color(writer, font.underline_color);
+        write_color(writer, font.color);
+        writer.write_enum(font.strikethrough_style);
+        writer.write_enum(font.strikethrough_width);
+        writer.write_enum(font.strikethrough_type);
+        writer.write_enum(font.strikethrough_text);
+    }
+
+    n = st.get_fill_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const fill_t& fill = *st.get_fill(i);
+        writer.write_enum(fill.pattern_type);
+        write_color(writer, fill.fg_color);
+        write_color(writer, fill.bg_color);
+    }
+
+    n = st.get_border_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const border_t& border = *st.get_border(i);
+        write_border_attrs(writer, border.top);
+        write_border_attrs(writer, border.bottom);
+        write_border_attrs(writer, border.left);
+        write_border_attrs(writer, border.right);
+        write_border_attrs(writer, border.diagonal);
+        write_border_attrs(writer, border.diagonal_bl_tr);
+        write_border_attrs(writer, border.diagonal_tl_br);
+    }
+
+    n = st.get_protection_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const protection_t& protection = *st.get_protection(i);
+        writer.write_bool(protection.locked);
+        writer.write_bool(protection.hidden);
+        writer.write_bool(protection.print_content);
+        writer.write_bool(protection.formula_hidden);
+    }
+
+    n = st.get_number_format_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const number_format_t& nf = *st.get_number_format(i);
+        writer.write_uint64(nf.identifier);
+        writer.write_string(nf.format_string);
+    }
+
+    n = st.get_cell_style_formats_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+        write_cell_format(writer, *st.get_cell_style_format(i));
+
+    n = st.get_cell_formats_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+        write_cell_format(writer, *st.get_cell_format(i));
+
+    n = st.get_dxf_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+        write_cell_format(writer, *st.get_dxf_format(i));
+
+    n = st.get_cell_styles_count();
+    writer.write_uint64(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const cell_style_t& cs = *st.get_cell_style(i);
+        writer.write_string(cs.name);
+        writer.write_uint64(cs.xf);
+        writer.write_uint64(cs.builtin);
+        writer.write_string(cs.parent_name);
+    }
+}
+
+void read_styles(snapshot_reader& reader, styles& st, string_pool& sp)
+{
+    auto intern = [&sp](const pstring& s) -> pstring
+    {
+        return s.empty() ? pstring() : sp.intern(s).first;
+    };
+
+    size_t n = reader.read_count();
+    st.reserve_font_store(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        font_t font;
+        font.name = intern(reader.read_string());
+        font.size = reader.read_double();
+        font.bold = reader.read_bool();
+        font.italic = reader.read_bool();
+        font.underline_style = reader.read_enum<underline_t>();
+        font.underline_width = reader.read_enum<underline_width_t>();
+        font.underline_mode = reader.read_enum<underline_mode_t>();
+        font.underline_type = reader.read_enum<underline_type_t>();
+        font.underline_color = read_color(reader);
+        font.color = read_color(reader);
+        font.strikethrough_style = reader.read_enum<strikethrough_style_t>();
+        font.strikethrough_width = reader.read_enum<strikethrough_width_t>();
+        font.strikethrough_type = reader.read_enum<strikethrough_type_t>();
+        font.strikethrough_text = reader.read_enum<strikethrough_text_t>();
+        st.append_font(font);
+    }
+
+    n = reader.read_count();
+    st.reserve_fill_store(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        fill_t fill;
+        fill.pattern_type = reader.read_enum<fill_pattern_t>();
+        fill.fg_color = read_color(reader);
+        fill.bg_color = read_color(reader);
+        st.append_fill(fill);
+    }
+
+    n = reader.read_count();
+    st.reserve_border_store(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        border_t border;
+        border.top = read_border_attrs(reader);
+        border.bottom = read_border_attrs(reader);
+        border.left = read_border_attrs(reader);
+        border.right = read_border_attrs(reader);
+        border.diagonal = read_border_attrs(reader);
+        border.diagonal_bl_tr = read_border_attrs(reader);
+        border.diagonal_tl_br = read_border_attrs(reader);
+        st.append_border(border);
+    }
+
+    n = reader.read_count();
+    for (size_t i = 0; i < n; ++i)
+    {
+        protection_t protection;
+        protection.locked = reader.read_bool();
+        protection.hidden = reader.read_bool();
+        protection.print_content = reader.read_bool();
+        protection.formula_hidden = reader.read_bool();
+        st.append_protection(protection);
+    }
+
+    n = reader.read_count();
+    st.reserve_number_format_store(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        number_format_t nf;
+        nf.identifier = reader.read_uint64();
+        nf.format_string = intern(reader.read_string());
+        st.append_number_format(nf);
+    }
+
+    n = reader.read_count();
+    st.reserve_cell_style_format_store(n);
+    for (size_t i = 0; i < n; ++i)
+        st.append_cell_style_format(read_cell_format(reader));
+
+    n = reader.read_count();
+    st.reserve_cell_format_store(n);
+    for (size_t i = 0; i < n; ++i)
+        st.append_cell_format(read_cell_format(reader));
+
+    n = reader.read_count();
+    st.reserve_diff_cell_format_store(n);
+    for (size_t i = 0; i < n; ++i)
+        st.append_diff_cell_format(read_cell_format(reader));
+
+    n = reader.read_count();
+    st.reserve_cell_style_store(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        cell_style_t cs;
+        cs.name = intern(reader.read_string());
+        cs.xf = reader.read_uint64();
+        cs.builtin = reader.read_uint64();
+        cs.parent_name = intern(reader.read_string());
+        st.append_cell_style(cs);
+    }
+}
+
+void write_auto_filter(snapshot_writer& writer, const auto_filter_t& filter)
+{
+    writer.write_int32(filter.range.first.sheet);
+    writer.write_int32(filter.range.first.row);
+    writer.write_int32(filter.range.first.column);
+    writer.write_int32(filter.range.last.sheet);
+    writer.write_int32(filter.range.last.row);
+    writer.write_int32(filter.range.last.column);
+
+    writer.write_uint64(filter.columns.size());
+    for (const auto& entry : filter.columns)
+    {
+        writer.write_int32(entry.first);
+        writer.write_uint64(entry.second.match_values.size());
+        for (const pstring& v : entry.second.match_values)
+            writer.write_string(v);
+    }
+}
+
+void read_auto_filter(snapshot_reader& reader, auto_filter_t& filter, string_pool& sp)
+{
+    filter.reset();
+    filter.range.first.sheet = reader.read_int32();
+    filter.range.first.row = reader.read_int32();
+    filter.range.first.column = reader.read_int32();
+    filter.range.last.sheet = reader.read_int32();
+    filter.range.last.row = reader.read_int32();
+    filter.range.last.column = reader.read_int32();
+
+    size_t n = reader.read_count();
+    for (size_t i = 0; i < n; ++i)
+    {
+        col_t col = reader.read_int32();
+        auto_filter_column_t column;
+        size_t value_count = reader.read_count();
+        for (size_t j = 0; j < value_count; ++j)
+            column.match_values.insert(sp.intern(reader.read_string()).first);
+
+        filter.commit_column(col, column);
+    }
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,123 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_SPREADSHEET_SNAPSHOT_HPP
+#define INCLUDED_ORCUS_SPREADSHEET_SNAPSHOT_HPP
+
+#include "orcus/pstring.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace orcus {
+
+class string_pool;
+
+namespace spreadsheet {
+
+class styles;
+struct auto_filter_t;
+
+namespace detail {
+
+/**
+ * Writes the values that make up a document snapshot to a binary stream.
+ * Integers are always written in little endian, and doubles by their bit
+ * patterns, so that the output does not depend on the host.
+ */
+class snapshot_writer
+{
+    std::ostream& m_os;
+
+public:
+    snapshot_writer(std::ostream& os);
+
+    void write_header();
+
+    void write_uint8(uint8_t v);
+    void write_int32(int32_t v);
+    void write_uint64(uint64_t v);
+    void write_double(double v);
+    void write_bool(bool v);
+    void write_string(const char* p, size_t n);
+    void write_string(const pstring& s);
+    void write_string(const std::string& s);
+
+    template<typename T>
+    void write_enum(T v)
+    {
+        write_int32(static_cast<int32_t>(v));
+    }
+};
+
+/**
+ * Reads the values written by snapshot_writer back from a memory buffer.
+ * It throws general_error when the buffer ends prematurely or when it does
+ * not begin with a valid header.
+ */
+class snapshot_reader
+{
+    const char* mp_cur;
+    const char* mp_end;
+
+    const char* advance(size_t n);
+
+public:
+    snapshot_reader(const char* p, size_t n);
+
+    void read_header();
+
+    uint8_t read_uint8();
+    int32_t read_int32();
+    uint64_t read_uint64();
+    double read_double();
+    bool read_bool();
+
+    /**
+     * Read a count of the elements to follow.  The count is checked against
+     * the size of the remaining buffer, assuming that each element takes up
+     * at least one byte, so that a corrupt count cannot trigger a huge
+     * allocation.
+     */
+    size_t read_count();
+
+    /**
+     * @return string that points into the buffer being read.
+     */
+    pstring read_string();
+
+    template<typename T>
+    T read_enum()
+    {
+        return static_cast<T>(read_int32());
+    }
+
+    bool eof() const;
+};
+
+void write_styles(snapshot_writer& writer, const styles& st);
+
+/**
+ * Read the styles written by write_styles() and append them to the styles
+ * store.  The strings get interned with the passed string pool.
+ */
+void read_styles(snapshot_reader& reader, styles& st, string_pool& sp);
+
+void write_auto_filter(snapshot_writer& writer, const auto_filter_t& filter);
+
+/**
+ * Read the auto filter data written by write_auto_filter().  The match
+ * values get interned with the passed string pool.
+ */
+void read_auto_filter(snapshot_reader& reader, auto_filter_t& filter, string_pool& sp);
+
+}}}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,248 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "snapshot.hpp"
+
+#include "orcus/spreadsheet/styles.hpp"
+#include "orcus/spreadsheet/auto_filter.hpp"
+#include "orcus/string_pool.hpp"
+#include "orcus/exception.hpp"
+
+#include <cstdlib>
+#include <cassert>
+#include <limits>
+#include <sstream>
+
+using namespace orcus;
+using namespace orcus::spreadsheet;
+using orcus::spreadsheet::detail::snapshot_writer;
+using orcus::spreadsheet::detail::snapshot_reader;
+
+namespace {
+
+void test_values()
+{
+    std::ostringstream os;
+    snapshot_writer writer(os);
+    writer.write_header();
+    writer.write_uint8(0xFE);
+    writer.write_int32(-12345);
+    writer.write_uint64(std::numeric_limits<uint64_t>::max() - 1);
+    writer.write_double(-0.125);
+    writer.write_bool(true);
+    writer.write_string(std::string("text"));
+    writer.write_string(pstring());
+    writer.write_enum(hor_alignment_t::justified);
+
+    std::string buf = os.str();
+    snapshot_reader reader(buf.data(), buf.size());
+    reader.read_header();
+    assert(reader.read_uint8() == 0xFE);
+    assert(reader.read_int32() == -12345);
+    assert(reader.read_uint64() == std::numeric_limits<uint64_t>::max() - 1);
+    assert(reader.read_double() == -0.125);
+    assert(reader.read_bool());
+    assert(reader.read_string() == "text");
+    assert(reader.read_string().empty());
+    assert(reader.read_enum<hor_alignment_t>() == hor_alignment_t::justified);
+    assert(reader.eof());
+
+    // Reading past the end must throw.
+    try
+    {
+        reader.read_uint8();
+        assert(!"exception was expected");
+    }
+    catch (const general_error&) {}
+}
+
+void test_invalid()
+{
+    // Not a snapshot.
+    std::string buf = "ORCUS";
+    try
+    {
+        snapshot_reader reader(buf.data(), buf.size());
+        reader.read_header();
+        assert(!"exception was expected");
+    }
+    catch (const general_error&) {}
+
+    // A string whose size exceeds the rest of the buffer.
+    std::ostringstream os;
+    snapshot_writer writer(os);
+    writer.write_uint64(1000);
+    writer.write_uint8('a');
+    buf = os.str();
+
+    try
+    {
+        snapshot_reader reader(buf.data(), buf.size());
+        reader.read_string();
+        assert(!"exception was expected");
+    }
+    catch (const general_error&) {}
+}
+
+void test_styles()
+{
+    string_pool sp;
+    styles src;
+
+    pstring font_name = sp.intern("Liberation Sans").first;
+
+    font_t font;
+    font.name = font_name;
+    font.size = 11.5;
+    font.bold = true;
+    font.underline_style = underline_t::double_line;
+    font.color = color_t(255, 10, 20, 30);
+    src.append_font(font);
+    font.reset();
+    src.append_font(font);
+
+    fill_t fill;
+    fill.pattern_type = fill_pattern_t::solid;
+    fill.fg_color = color_t(255, 1, 2, 3);
+    src.append_fill(fill);
+
+    border_t border;
+    border.left.style = border_style_t::thin;
+    border.left.border_width.unit = length_unit_t::point;
+    border.left.border_width.value = 0.5;
+    src.append_border(border);
+
+    protection_t protection;
+    protection.hidden = true;
+    src.append_protection(protection);
+
+    number_format_t nf;
+    nf.identifier = 164;
+    nf.format_string = sp.intern("0.00%").first;
+    src.append_number_format(nf);
+
+    cell_format_t cf;
+    cf.font = 1;
+    cf.number_format = 0;
+    cf.hor_align = hor_alignment_t::center;
+    cf.apply_font = true;
+    src.append_cell_style_format(cf);
+    cf.style_xf = 0;
+    cf.fill = 0;
+    src.append_cell_format(cf);
+    src.append_cell_format(cell_format_t());
+    src.append_diff_cell_format(cf);
+
+    cell_style_t cs;
+    cs.name = sp.intern("Normal").first;
+    cs.builtin = 0;
+    src.append_cell_style(cs);
+
+    std::ostringstream os;
+    snapshot_writer writer(os);
+    spreadsheet::detail::write_styles(writer, src);
+    std::string buf = os.str();
+
+    // Load into a separate string pool, to make sure the strings don't point
+    // to the original ones.
+    string_pool sp2;
+    styles dest;
+    snapshot_reader reader(buf.data(), buf.size());
+    spreadsheet::detail::read_styles(reader, dest, sp2);
+    assert(reader.eof());
+
+    assert(dest.get_font_count() == 2);
+    const font_t* p_font = dest.get_font(0);
+    assert(p_font->name == "Liberation Sans");
+    assert(p_font->name.get() != font_name.get());
+    assert(p_font->size == 11.5);
+    assert(p_font->bold);
+    assert(!p_font->italic);
+    assert(p_font->underline_style == underline_t::double_line);
+    assert(p_font->color == color_t(255, 10, 20, 30));
+    assert(dest.get_font(1)->name.empty());
+
+    assert(dest.get_fill_count() == 1);
+    assert(dest.get_fill(0)->pattern_type == fill_pattern_t::solid);
+    assert(dest.get_fill(0)->fg_color == color_t(255, 1, 2, 3));
+
+    assert(dest.get_border_count() == 1);
+    const border_t* p_border = dest.get_border(0);
+    assert(p_border->left.style == border_style_t::thin);
+    assert(p_border->left.border_width.unit == length_unit_t::point);
+    assert(p_border->left.border_width.value == 0.5);
+    assert(p_border->right.style == border_style_t::unknown);
+
+    assert(dest.get_protection_count() == 1);
+    assert(dest.get_protection(0)->hidden);
+
+    assert(dest.get_number_format_count() == 1);
+    assert(dest.get_number_format(0)->identifier == 164);
+    assert(dest.get_number_format(0)->format_string == "0.00%");
+
+    assert(dest.get_cell_style_formats_count() == 1);
+    assert(dest.get_cell_formats_count() == 2);
+    assert(dest.get_dxf_count() == 1);
+    const cell_format_t* p_cf = dest.get_cell_format(0);
+    assert(p_cf->font == 1);
+    assert(p_cf->hor_align == hor_alignment_t::center);
+    assert(p_cf->apply_font);
+    assert(!p_cf->apply_fill);
+
+    assert(dest.get_cell_styles_count() == 1);
+    assert(dest.get_cell_style(0)->name == "Normal");
+}
+
+void test_auto_filter()
+{
+    string_pool sp;
+    auto_filter_t src;
+    src.range.first.sheet = 1;
+    src.range.first.row = 2;
+    src.range.first.column = 3;
+    src.range.last.sheet = 1;
+    src.range.last.row = 20;
+    src.range.last.column = 5;
+
+    auto_filter_column_t column;
+    column.match_values.insert(sp.intern("A").first);
+    column.match_values.insert(sp.intern("B").first);
+    src.commit_column(4, column);
+
+    std::ostringstream os;
+    snapshot_writer writer(os);
+    spreadsheet::detail::write_auto_filter(writer, src);
+    std::string buf = os.str();
+
+    string_pool sp2;
+    auto_filter_t dest;
+    snapshot_reader reader(buf.data(), buf.size());
+    spreadsheet::detail::read_auto_filter(reader, dest, sp2);
+    assert(reader.eof());
+
+    assert(dest.range == src.range);
+    assert(dest.columns.size() == 1);
+    const auto_filter_column_t& dest_column = dest.columns.begin()->second;
+    assert(dest.columns.begin()->first == 4);
+    assert(dest_column.match_values.size() == 2);
+    assert(dest_column.match_values.count("A") > 0);
+    assert(dest_column.match_values.count("B") > 0);
+}
+
+}
+
+int main()
+{
+    test_values();
+    test_invalid();
+    test_styles();
+    test_auto_filter();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
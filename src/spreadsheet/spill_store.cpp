@@ -0,0 +1,235 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "spill_store.hpp"
+
+#include "orcus/exception.hpp"
+#include "orcus/stream.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+namespace {
+
+struct sheet_state
+{
+    /** Estimated amount of memory occupied by the cell values in memory. */
+    size_t size = 0;
+    uint64_t last_access = 0;
+    bool spilled = false;
+};
+
+}
+
+struct spill_store::impl
+{
+    size_t m_threshold;
+    fs::path m_dir;
+    spill_func_type m_spill;
+    restore_func_type m_restore;
+
+    std::vector<sheet_state> m_sheets;
+    size_t m_resident_size;
+    sheet_t m_active;
+    uint64_t m_clock;
+    bool m_suspended;
+
+    impl(size_t threshold, const std::string& parent_dir, spill_func_type spill, restore_func_type restore) :
+        m_threshold(threshold),
+        m_spill(std::move(spill)),
+        m_restore(std::move(restore)),
+        m_resident_size(0),
+        m_active(-1),
+        m_clock(0),
+        m_suspended(false)
+    {
+        fs::path parent = parent_dir.empty() ? fs::temp_directory_path() : fs::path(parent_dir);
+        m_dir = parent / fs::unique_path("orcus-spill-%%%%-%%%%-%%%%-%%%%");
+
+        boost::system::error_code ec;
+        fs::create_directories(m_dir, ec);
+        if (ec)
+        {
+            std::ostringstream os;
+            os << "failed to create the spill directory " << m_dir.string() << ": " << ec.message();
+            throw general_error(os.str());
+        }
+    }
+
+    ~impl()
+    {
+        boost::system::error_code ec;
+        fs::remove_all(m_dir, ec);
+    }
+
+    fs::path get_sheet_path(sheet_t sheet) const
+    {
+        return m_dir / ("sheet-" + std::to_string(sheet) + ".bin");
+    }
+
+    sheet_state& get_state(sheet_t sheet)
+    {
+        if (sheet < 0)
+            throw general_error("spill_store: invalid sheet index.");
+
+        if (size_t(sheet) >= m_sheets.size())
+            m_sheets.resize(sheet + 1);
+
+        return m_sheets[sheet];
+    }
+
+    void activate(sheet_t sheet)
+    {
+        sheet_state& state = get_state(sheet);
+        m_active = sheet;
+        state.last_access = ++m_clock;
+
+        if (state.spilled)
+            restore_sheet(sheet);
+    }
+
+    void spill_sheet(sheet_t sheet)
+    {
+        sheet_state& state = m_sheets[sheet];
+        fs::path path = get_sheet_path(sheet);
+
+        std::ofstream file(path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file)
+            throw general_error("failed to open the spill file " + path.string() + " for writing.");
+
+        m_spill(sheet, file);
+        file.close();
+
+        if (!file)
+            throw general_error("failed to write the spill file " + path.string() + ".");
+
+        m_resident_size -= state.size;
+        state.size = 0;
+        state.spilled = true;
+    }
+
+    void restore_sheet(sheet_t sheet)
+    {
+        fs::path path = get_sheet_path(sheet);
+
+        {
+            file_content content(path.string().c_str());
+            m_sheets[sheet].spilled = false;
+            m_restore(sheet, content.data(), content.size());
+        }
+
+        boost::system::error_code ec;
+        fs::remove(path, ec);
+    }
+
+    /**
+     * Spill the least recently accessed sheets until the resident size is
+     * within the threshold.  The sheet being accessed is never spilled.
+     */
+    void enforce_threshold()
+    {
+        if (m_suspended)
+            return;
+
+        while (m_resident_size > m_threshold)
+        {
+            sheet_t victim = -1;
+            for (size_t i = 0; i < m_sheets.size(); ++i)
+            {
+                const sheet_state& state = m_sheets[i];
+                if (sheet_t(i) == m_active || state.spilled || !state.size)
+                    continue;
+
+                if (victim < 0 || state.last_access < m_sheets[victim].last_access)
+                    victim = i;
+            }
+
+            if (victim < 0)
+                // Only the sheet being accessed is left.
+                return;
+
+            spill_sheet(victim);
+        }
+    }
+};
+
+spill_store::spill_store(
+    size_t threshold, const std::string& parent_dir,
+    spill_func_type spill, restore_func_type restore) :
+    mp_impl(std::make_unique<impl>(threshold, parent_dir, std::move(spill), std::move(restore))) {}
+
+spill_store::~spill_store() {}
+
+void spill_store::page_in(sheet_t sheet)
+{
+    if (sheet == mp_impl->m_active)
+        return;
+
+    mp_impl->activate(sheet);
+    mp_impl->enforce_threshold();
+}
+
+void spill_store::add_size(sheet_t sheet, size_t size)
+{
+    if (sheet != mp_impl->m_active)
+        mp_impl->activate(sheet);
+
+    mp_impl->m_sheets[sheet].size += size;
+    mp_impl->m_resident_size += size;
+    mp_impl->enforce_threshold();
+}
+
+void spill_store::page_in_all()
+{
+    mp_impl->m_suspended = true;
+
+    try
+    {
+        for (size_t i = 0; i < mp_impl->m_sheets.size(); ++i)
+        {
+            if (mp_impl->m_sheets[i].spilled)
+                mp_impl->activate(i);
+        }
+    }
+    catch (...)
+    {
+        mp_impl->m_suspended = false;
+        throw;
+    }
+
+    mp_impl->m_suspended = false;
+}
+
+bool spill_store::is_spilled(sheet_t sheet) const
+{
+    if (sheet < 0 || size_t(sheet) >= mp_impl->m_sheets.size())
+        return false;
+
+    return mp_impl->m_sheets[sheet].spilled;
+}
+
+size_t spill_store::get_resident_size() const
+{
+    return mp_impl->m_resident_size;
+}
+
+std::string spill_store::get_directory() const
+{
+    return mp_impl->m_dir.string();
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
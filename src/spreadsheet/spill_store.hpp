@@ -0,0 +1,112 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_SPREADSHEET_SPILL_STORE_HPP
+#define INCLUDED_ORCUS_SPREADSHEET_SPILL_STORE_HPP
+
+#include "orcus/spreadsheet/types.hpp"
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+/**
+ * Keeps the estimated amount of memory occupied by the cell values of the
+ * sheets under a threshold, by spilling the cell values of the least
+ * recently accessed sheets to disk.  The cell values of a spilled sheet get
+ * memory-mapped and read back as soon as the sheet gets accessed again.
+ *
+ * Each spilled sheet has its own file in a directory created for the
+ * instance, which gets removed along with the instance.  The conversion of
+ * the cell values is left to the functions passed to the constructor.
+ */
+class spill_store
+{
+public:
+    /**
+     * Write the cell values of a sheet to a stream, and remove them from
+     * memory.
+     */
+    using spill_func_type = std::function<void(sheet_t, std::ostream&)>;
+
+    /**
+     * Put the cell values of a sheet back from the buffer previously written
+     * by the spill function.  The sizes of the cell values are expected to
+     * be reported back via add_size() as they get inserted.
+     */
+    using restore_func_type = std::function<void(sheet_t, const char*, size_t)>;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+
+public:
+    /**
+     * @param threshold estimated amount of memory in bytes the cell values
+     *                  of all sheets may occupy.
+     * @param parent_dir directory to create the directory holding the
+     *                   spilled cell values in.  The system's temporary
+     *                   directory is used when it's empty.
+     * @param spill function to write the cell values of a sheet.
+     * @param restore function to read the cell values of a sheet back.
+     */
+    spill_store(
+        size_t threshold, const std::string& parent_dir,
+        spill_func_type spill, restore_func_type restore);
+
+    ~spill_store();
+
+    spill_store(const spill_store&) = delete;
+    spill_store& operator= (const spill_store&) = delete;
+
+    /**
+     * Make a sheet the one being accessed, and read its cell values back if
+     * they have been spilled.  Other sheets may get spilled as a result.
+     *
+     * @param sheet index of the sheet being accessed.
+     */
+    void page_in(sheet_t sheet);
+
+    /**
+     * Account for the cell values being inserted into a sheet, and spill
+     * other sheets when the threshold is exceeded.  The sheet becomes the
+     * one being accessed.
+     *
+     * @param sheet index of the sheet the cell values get inserted into.
+     * @param size estimated amount of memory the cell values occupy.
+     */
+    void add_size(sheet_t sheet, size_t size);
+
+    /**
+     * Read the cell values of all spilled sheets back, regardless of the
+     * threshold.  The threshold is enforced again the next time a sheet
+     * other than the last one read back gets accessed.
+     */
+    void page_in_all();
+
+    bool is_spilled(sheet_t sheet) const;
+
+    /**
+     * @return estimated amount of memory occupied by the cell values that
+     *         are not spilled.
+     */
+    size_t get_resident_size() const;
+
+    /**
+     * @return path of the directory holding the spilled cell values.
+     */
+    std::string get_directory() const;
+};
+
+}}}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
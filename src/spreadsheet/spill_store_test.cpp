@@ -0,0 +1,174 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "spill_store.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+using namespace orcus::spreadsheet;
+using orcus::spreadsheet::detail::spill_store;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+/**
+ * Stand-in for the document model, where each value occupies 4 bytes.
+ */
+class model
+{
+    std::map<sheet_t, std::vector<int32_t>> m_values;
+    spill_store m_store;
+
+public:
+    model(size_t threshold) :
+        m_store(threshold, std::string(),
+            [this](sheet_t sheet, std::ostream& os)
+            {
+                std::vector<int32_t>& values = m_values[sheet];
+                os.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int32_t));
+                values.clear();
+            },
+            [this](sheet_t sheet, const char* p, size_t n)
+            {
+                assert(n % sizeof(int32_t) == 0);
+                for (size_t i = 0; i < n; i += sizeof(int32_t))
+                {
+                    int32_t v;
+                    std::memcpy(&v, p + i, sizeof(v));
+                    insert(sheet, v);
+                }
+            })
+    {
+    }
+
+    void insert(sheet_t sheet, int32_t v)
+    {
+        m_store.add_size(sheet, sizeof(v));
+        m_values[sheet].push_back(v);
+    }
+
+    const std::vector<int32_t>& get(sheet_t sheet)
+    {
+        m_store.page_in(sheet);
+        return m_values[sheet];
+    }
+
+    bool in_memory(sheet_t sheet)
+    {
+        return !m_values[sheet].empty();
+    }
+
+    spill_store& store()
+    {
+        return m_store;
+    }
+};
+
+void test_spill()
+{
+    std::string dir;
+
+    {
+        // Room for 10 values.
+        model m(40);
+
+        for (int32_t i = 0; i < 6; ++i)
+            m.insert(0, i);
+
+        for (int32_t i = 0; i < 4; ++i)
+            m.insert(1, 100 + i);
+
+        // Right at the threshold.
+        assert(m.store().get_resident_size() == 40);
+        assert(!m.store().is_spilled(0));
+
+        // Sheet 0 is the least recently accessed.
+        m.insert(2, 200);
+        assert(m.store().is_spilled(0));
+        assert(!m.in_memory(0));
+        assert(!m.store().is_spilled(1));
+        assert(m.store().get_resident_size() == 20);
+
+        dir = m.store().get_directory();
+        assert(fs::exists(fs::path(dir) / "sheet-0.bin"));
+
+        // Reading sheet 0 back makes sheet 1 the least recently accessed.
+        const std::vector<int32_t>& values = m.get(0);
+        assert((values == std::vector<int32_t>{0, 1, 2, 3, 4, 5}));
+        assert(!m.store().is_spilled(0));
+        assert(m.store().is_spilled(1));
+        assert(!m.store().is_spilled(2));
+        assert(m.store().get_resident_size() == 28);
+        assert(!fs::exists(fs::path(dir) / "sheet-0.bin"));
+
+        // A sheet larger than the threshold stays in memory while it's being
+        // accessed, at the expense of all the others.
+        for (int32_t i = 0; i < 20; ++i)
+            m.insert(3, 300 + i);
+
+        assert(m.store().is_spilled(0));
+        assert(m.store().is_spilled(1));
+        assert(m.store().is_spilled(2));
+        assert(m.store().get_resident_size() == 80);
+
+        assert((m.get(1) == std::vector<int32_t>{100, 101, 102, 103}));
+        assert(m.store().is_spilled(3));
+        assert(m.store().get_resident_size() == 16);
+    }
+
+    // The directory is gone along with the store.
+    assert(!dir.empty());
+    assert(!fs::exists(dir));
+}
+
+void test_page_in_all()
+{
+    model m(8);
+
+    for (sheet_t sheet = 0; sheet < 4; ++sheet)
+    {
+        for (int32_t i = 0; i < 2; ++i)
+            m.insert(sheet, sheet * 10 + i);
+    }
+
+    for (sheet_t sheet = 0; sheet < 3; ++sheet)
+        assert(m.store().is_spilled(sheet));
+
+    m.store().page_in_all();
+
+    for (sheet_t sheet = 0; sheet < 4; ++sheet)
+    {
+        assert(!m.store().is_spilled(sheet));
+        assert(m.in_memory(sheet));
+    }
+
+    assert(m.store().get_resident_size() == 32);
+
+    // Accessing another sheet enforces the threshold again.
+    assert((m.get(0) == std::vector<int32_t>{0, 1}));
+    assert(m.store().get_resident_size() == 8);
+    assert(!m.store().is_spilled(0));
+}
+
+}
+
+int main()
+{
+    test_spill();
+    test_page_in_all();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,589 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "xlsx_exporter.hpp"
+#include "number_format.hpp"
+
+#include "orcus/spreadsheet/document.hpp"
+#include "orcus/xml_writer.hpp"
+#include "orcus/xml_namespace.hpp"
+#include "orcus/zip_archive_writer.hpp"
+#include "orcus/detail/thread.hpp"
+
+#include <ixion/model_context.hpp>
+#include <ixion/model_iterator.hpp>
+#include <ixion/formula.hpp>
+#include <ixion/formula_name_resolver.hpp>
+#include <ixion/formula_result.hpp>
+#include <ixion/cell.hpp>
+
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+namespace {
+
+const char* NS_ct = "http://schemas.openxmlformats.org/package/2006/content-types";
+const char* NS_opc_rel = "http://schemas.openxmlformats.org/package/2006/relationships";
+const char* NS_ooxml_r = "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+const char* NS_ooxml_xlsx = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+
+const char* CT_xlsx_workbook = "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml";
+const char* CT_xlsx_sheet = "application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml";
+const char* CT_xlsx_styles = "application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml";
+const char* CT_xlsx_shared_strings = "application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml";
+
+const char* SCH_od_rels_office_doc = "http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument";
+const char* SCH_od_rels_worksheet = "http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet";
+const char* SCH_od_rels_styles = "http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles";
+const char* SCH_od_rels_shared_strings = "http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings";
+
+/**
+ * Append the A1-style address of a cell.
+ */
+void append_address(std::string& buf, row_t row, col_t col)
+{
+    char letters[8];
+    char* p = letters + sizeof(letters);
+    for (++col; col > 0; col = (col - 1) / 26)
+        *--p = 'A' + (col - 1) % 26;
+
+    buf.append(p, letters + sizeof(letters) - p);
+    buf.append(std::to_string(row + 1));
+}
+
+std::string to_sheet_part_name(size_t index)
+{
+    return "worksheets/sheet" + std::to_string(index + 1) + ".xml";
+}
+
+std::string to_rid(size_t index)
+{
+    return "rId" + std::to_string(index + 1);
+}
+
+class sheet_part_writer
+{
+    const ixion::model_context& m_cxt;
+    const ixion::sheet_t m_sheet;
+    std::unique_ptr<ixion::formula_name_resolver> mp_resolver;
+
+    xml_writer& m_writer;
+    const xmlns_id_t m_ns;
+
+    std::string m_buf;
+    char m_num_buf[32];
+
+    pstring to_string(double v)
+    {
+        int n = format_to_file_output(m_num_buf, sizeof(m_num_buf), v);
+        return pstring(m_num_buf, std::max(0, std::min<int>(n, sizeof(m_num_buf) - 1)));
+    }
+
+    void write_value(const pstring& s)
+    {
+        m_writer.push_element({m_ns, "v"});
+        m_writer.add_content(s);
+        m_writer.pop_element();
+    }
+
+    void write_formula(const ixion::model_iterator::cell& cell)
+    {
+        const ixion::formula_cell* fc = cell.value.formula;
+        ixion::abs_address_t pos(m_sheet, cell.row, cell.col);
+
+        ixion::formula_result res;
+        bool has_result = true;
+
+        try
+        {
+            res = fc->get_result_cache(ixion::formula_result_wait_policy_t::throw_exception);
+        }
+        catch (const std::exception&)
+        {
+            has_result = false;
+        }
+
+        if (has_result)
+        {
+            switch (res.get_type())
+            {
+                case ixion::formula_result::result_type::string:
+                    m_writer.add_attribute({nullptr, "t"}, "str");
+                    break;
+                case ixion::formula_result::result_type::error:
+                    m_writer.add_attribute({nullptr, "t"}, "e");
+                    break;
+                default:
+                    ;
+            }
+        }
+
+        m_writer.push_element({m_ns, "c"});
+
+        const ixion::formula_tokens_store_ptr_t& ts = fc->get_tokens();
+        ixion::formula_group_t fg = fc->get_group_properties();
+
+        if (ts && (!fg.grouped || fc->get_parent_position(pos) == pos))
+        {
+            // Only the top-left cell of a grouped formula range stores the
+            // formula expression.
+            if (fg.grouped)
+            {
+                m_buf.clear();
+                append_address(m_buf, cell.row, cell.col);
+                m_buf.push_back(':');
+                append_address(m_buf, cell.row + fg.size.row - 1, cell.col + fg.size.column - 1);
+
+                m_writer.add_attribute({nullptr, "t"}, "array");
+                m_writer.add_attribute({nullptr, "ref"}, m_buf);
+            }
+
+            std::string formula = ixion::print_formula_tokens(m_cxt, pos, *mp_resolver, ts->get());
+            m_writer.push_element({m_ns, "f"});
+            m_writer.add_content(formula);
+            m_writer.pop_element();
+        }
+
+        if (has_result)
+        {
+            switch (res.get_type())
+            {
+                case ixion::formula_result::result_type::value:
+                    write_value(to_string(res.get_value()));
+                    break;
+                case ixion::formula_result::result_type::string:
+                    write_value(res.get_string());
+                    break;
+                case ixion::formula_result::result_type::error:
+                    write_value(res.str(m_cxt));
+                    break;
+                default:
+                    ;
+            }
+        }
+
+        m_writer.pop_element();
+    }
+
+public:
+    sheet_part_writer(const ixion::model_context& cxt, ixion::sheet_t sheet, xml_writer& writer, xmlns_id_t ns) :
+        m_cxt(cxt),
+        m_sheet(sheet),
+        mp_resolver(ixion::formula_name_resolver::get(ixion::formula_name_resolver_t::excel_a1, &cxt)),
+        m_writer(writer),
+        m_ns(ns) {}
+
+    void write()
+    {
+        ixion::abs_range_t data_range = m_cxt.get_data_range(m_sheet);
+        if (!data_range.valid())
+        {
+            m_writer.push_element({m_ns, "sheetData"});
+            m_writer.pop_element();
+            return;
+        }
+
+        m_buf.clear();
+        append_address(m_buf, data_range.first.row, data_range.first.column);
+        if (data_range.first.row != data_range.last.row || data_range.first.column != data_range.last.column)
+        {
+            m_buf.push_back(':');
+            append_address(m_buf, data_range.last.row, data_range.last.column);
+        }
+
+        m_writer.add_attribute({nullptr, "ref"}, m_buf);
+        m_writer.push_element({m_ns, "dimension"});
+        m_writer.pop_element();
+
+        auto scope_sheet_data = m_writer.push_element_scope({m_ns, "sheetData"});
+
+        ixion::abs_rc_range_t iter_range;
+        iter_range.first.column = data_range.first.column;
+        iter_range.first.row = data_range.first.row;
+        iter_range.last.column = data_range.last.column;
+        iter_range.last.row = data_range.last.row;
+
+        auto iter = m_cxt.get_model_iterator(m_sheet, ixion::rc_direction_t::horizontal, iter_range);
+
+        row_t cur_row = -1;
+
+        for (; iter.has(); iter.next())
+        {
+            const ixion::model_iterator::cell& cell = iter.get();
+            if (cell.type == ixion::celltype_t::empty)
+                continue;
+
+            if (cell.row != cur_row)
+            {
+                if (cur_row >= 0)
+                    m_writer.pop_element();
+
+                m_writer.add_attribute({nullptr, "r"}, std::to_string(cell.row + 1));
+                m_writer.push_element({m_ns, "row"});
+                cur_row = cell.row;
+            }
+
+            m_buf.clear();
+            append_address(m_buf, cell.row, cell.col);
+            m_writer.add_attribute({nullptr, "r"}, m_buf);
+
+            switch (cell.type)
+            {
+                case ixion::celltype_t::string:
+                {
+                    m_writer.add_attribute({nullptr, "t"}, "s");
+                    m_writer.push_element({m_ns, "c"});
+                    write_value(std::to_string(cell.value.string));
+                    m_writer.pop_element();
+                    break;
+                }
+                case ixion::celltype_t::numeric:
+                {
+                    m_writer.push_element({m_ns, "c"});
+                    write_value(to_string(cell.value.numeric));
+                    m_writer.pop_element();
+                    break;
+                }
+                case ixion::celltype_t::boolean:
+                {
+                    m_writer.add_attribute({nullptr, "t"}, "b");
+                    m_writer.push_element({m_ns, "c"});
+                    write_value(cell.value.boolean ? "1" : "0");
+                    m_writer.pop_element();
+                    break;
+                }
+                case ixion::celltype_t::formula:
+                    write_formula(cell);
+                    break;
+                default:
+                    m_writer.push_element({m_ns, "c"});
+                    m_writer.pop_element();
+            }
+        }
+
+        if (cur_row >= 0)
+            m_writer.pop_element();
+    }
+};
+
+void write_content_types(std::ostream& os, size_t sheet_count)
+{
+    xmlns_repository repo;
+    xml_writer writer(repo, os);
+    xmlns_id_t ns = writer.add_namespace("", NS_ct);
+    auto scope_types = writer.push_element_scope({ns, "Types"});
+
+    writer.add_attribute({nullptr, "Extension"}, "rels");
+    writer.add_attribute({nullptr, "ContentType"}, "application/vnd.openxmlformats-package.relationships+xml");
+    writer.push_element({ns, "Default"});
+    writer.pop_element();
+
+    writer.add_attribute({nullptr, "Extension"}, "xml");
+    writer.add_attribute({nullptr, "ContentType"}, "application/xml");
+    writer.push_element({ns, "Default"});
+    writer.pop_element();
+
+    auto add_override = [&writer, ns](const std::string& part_name, const char* content_type)
+    {
+        writer.add_attribute({nullptr, "PartName"}, part_name);
+        writer.add_attribute({nullptr, "ContentType"}, content_type);
+        writer.push_element({ns, "Override"});
+        writer.pop_element();
+    };
+
+    add_override("/xl/workbook.xml", CT_xlsx_workbook);
+
+    for (size_t i = 0; i < sheet_count; ++i)
+        add_override("/xl/" + to_sheet_part_name(i), CT_xlsx_sheet);
+
+    add_override("/xl/styles.xml", CT_xlsx_styles);
+    add_override("/xl/sharedStrings.xml", CT_xlsx_shared_strings);
+}
+
+void write_package_rels(std::ostream& os)
+{
+    xmlns_repository repo;
+    xml_writer writer(repo, os);
+    xmlns_id_t ns = writer.add_namespace("", NS_opc_rel);
+    auto scope_rels = writer.push_element_scope({ns, "Relationships"});
+
+    writer.add_attribute({nullptr, "Id"}, "rId1");
+    writer.add_attribute({nullptr, "Type"}, SCH_od_rels_office_doc);
+    writer.add_attribute({nullptr, "Target"}, "xl/workbook.xml");
+    writer.push_element({ns, "Relationship"});
+    writer.pop_element();
+}
+
+void write_workbook(std::ostream& os, const document& doc)
+{
+    xmlns_repository repo;
+    xml_writer writer(repo, os);
+    xmlns_id_t ns = writer.add_namespace("", NS_ooxml_xlsx);
+    xmlns_id_t ns_r = writer.add_namespace("r", NS_ooxml_r);
+    auto scope_workbook = writer.push_element_scope({ns, "workbook"});
+    auto scope_sheets = writer.push_element_scope({ns, "sheets"});
+
+    for (size_t i = 0; i < doc.get_sheet_count(); ++i)
+    {
+        std::string sheet_id = std::to_string(i + 1);
+        std::string rid = to_rid(i);
+        writer.add_attribute({nullptr, "name"}, doc.get_sheet_name(i));
+        writer.add_attribute({nullptr, "sheetId"}, sheet_id);
+        writer.add_attribute({ns_r, "id"}, rid);
+        writer.push_element({ns, "sheet"});
+        writer.pop_element();
+    }
+}
+
+void write_workbook_rels(std::ostream& os, size_t sheet_count)
+{
+    xmlns_repository repo;
+    xml_writer writer(repo, os);
+    xmlns_id_t ns = writer.add_namespace("", NS_opc_rel);
+    auto scope_rels = writer.push_element_scope({ns, "Relationships"});
+
+    auto add_rel = [&writer, ns](size_t index, const char* type, const std::string& target)
+    {
+        std::string rid = to_rid(index);
+        writer.add_attribute({nullptr, "Id"}, rid);
+        writer.add_attribute({nullptr, "Type"}, type);
+        writer.add_attribute({nullptr, "Target"}, target);
+        writer.push_element({ns, "Relationship"});
+        writer.pop_element();
+    };
+
+    for (size_t i = 0; i < sheet_count; ++i)
+        add_rel(i, SCH_od_rels_worksheet, to_sheet_part_name(i));
+
+    add_rel(sheet_count, SCH_od_rels_styles, "styles.xml");
+    add_rel(sheet_count + 1, SCH_od_rels_shared_strings, "sharedStrings.xml");
+}
+
+/**
+ * Write the minimal style sheet with a single default cell format.
+ */
+void write_styles(std::ostream& os)
+{
+    xmlns_repository repo;
+    xml_writer writer(repo, os);
+    xmlns_id_t ns = writer.add_namespace("", NS_ooxml_xlsx);
+    auto scope_styles = writer.push_element_scope({ns, "styleSheet"});
+
+    auto add_empty = [&writer, ns](const char* name)
+    {
+        writer.push_element({ns, name});
+        writer.pop_element();
+    };
+
+    auto add_xf = [&writer, ns](bool with_style)
+    {
+        writer.add_attribute({nullptr, "numFmtId"}, "0");
+        writer.add_attribute({nullptr, "fontId"}, "0");
+        writer.add_attribute({nullptr, "fillId"}, "0");
+        writer.add_attribute({nullptr, "borderId"}, "0");
+        if (with_style)
+            writer.add_attribute({nullptr, "xfId"}, "0");
+        writer.push_element({ns, "xf"});
+        writer.pop_element();
+    };
+
+    {
+        writer.add_attribute({nullptr, "count"}, "1");
+        auto scope = writer.push_element_scope({ns, "fonts"});
+        auto scope_font = writer.push_element_scope({ns, "font"});
+        writer.add_attribute({nullptr, "val"}, "11");
+        add_empty("sz");
+        writer.add_attribute({nullptr, "val"}, "Calibri");
+        add_empty("name");
+    }
+
+    {
+        writer.add_attribute({nullptr, "count"}, "2");
+        auto scope = writer.push_element_scope({ns, "fills"});
+
+        for (const char* pattern : {"none", "gray125"})
+        {
+            auto scope_fill = writer.push_element_scope({ns, "fill"});
+            writer.add_attribute({nullptr, "patternType"}, pattern);
+            add_empty("patternFill");
+        }
+    }
+
+    {
+        writer.add_attribute({nullptr, "count"}, "1");
+        auto scope = writer.push_element_scope({ns, "borders"});
+        auto scope_border = writer.push_element_scope({ns, "border"});
+        for (const char* name : {"left", "right", "top", "bottom", "diagonal"})
+            add_empty(name);
+    }
+
+    {
+        writer.add_attribute({nullptr, "count"}, "1");
+        auto scope = writer.push_element_scope({ns, "cellStyleXfs"});
+        add_xf(false);
+    }
+
+    {
+        writer.add_attribute({nullptr, "count"}, "1");
+        auto scope = writer.push_element_scope({ns, "cellXfs"});
+        add_xf(true);
+    }
+
+    {
+        writer.add_attribute({nullptr, "count"}, "1");
+        auto scope = writer.push_element_scope({ns, "cellStyles"});
+        writer.add_attribute({nullptr, "name"}, "Normal");
+        writer.add_attribute({nullptr, "xfId"}, "0");
+        writer.add_attribute({nullptr, "builtinId"}, "0");
+        add_empty("cellStyle");
+    }
+}
+
+void write_shared_strings(std::ostream& os, const ixion::model_context& cxt)
+{
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+
+    xmlns_repository repo;
+    xml_writer writer(repo, os, xml_writer::string_mode::transient);
+    xmlns_id_t ns = writer.add_namespace("", NS_ooxml_xlsx);
+
+    size_t n = cxt.get_string_count();
+    std::string count = std::to_string(n);
+    writer.add_attribute({nullptr, "uniqueCount"}, count);
+    auto scope_sst = writer.push_element_scope({ns, "sst"});
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const std::string* p = cxt.get_string(i);
+        pstring s = p ? pstring(*p) : pstring();
+
+        auto scope_si = writer.push_element_scope({ns, "si"});
+
+        if (!s.empty() && (is_space(s[0]) || is_space(s[s.size()-1])))
+            writer.add_attribute({nullptr, "xml:space"}, "preserve");
+
+        writer.push_element({ns, "t"});
+        writer.add_content(s);
+        writer.pop_element();
+    }
+}
+
+void write_sheet(std::ostream& os, const ixion::model_context& cxt, ixion::sheet_t sheet)
+{
+    xmlns_repository repo;
+    xml_writer writer(repo, os, xml_writer::string_mode::transient);
+    xmlns_id_t ns = writer.add_namespace("", NS_ooxml_xlsx);
+    auto scope_worksheet = writer.push_element_scope({ns, "worksheet"});
+
+    sheet_part_writer part(cxt, sheet, writer, ns);
+    part.write();
+}
+
+struct part_task
+{
+    zip_entry_deflater entry;
+    std::function<void(std::ostream&)> func;
+    std::exception_ptr error;
+
+    part_task(std::string name, std::function<void(std::ostream&)> _func) :
+        entry(std::move(name)), func(std::move(_func)) {}
+};
+
+}
+
+xlsx_exporter::xlsx_exporter(const document& doc) : m_doc(doc) {}
+
+void xlsx_exporter::write(std::ostream& os, size_t thread_count) const
+{
+    const ixion::model_context& cxt = m_doc.get_model_context();
+    const document& doc = m_doc;
+    size_t sheet_count = m_doc.get_sheet_count();
+
+    std::vector<std::unique_ptr<part_task>> tasks;
+    tasks.reserve(sheet_count + 6);
+
+    tasks.push_back(std::make_unique<part_task>(
+        "[Content_Types].xml",
+        [sheet_count](std::ostream& _os) { write_content_types(_os, sheet_count); }));
+
+    tasks.push_back(std::make_unique<part_task>("_rels/.rels", write_package_rels));
+
+    tasks.push_back(std::make_unique<part_task>(
+        "xl/workbook.xml",
+        [&doc](std::ostream& _os) { write_workbook(_os, doc); }));
+
+    tasks.push_back(std::make_unique<part_task>(
+        "xl/_rels/workbook.xml.rels",
+        [sheet_count](std::ostream& _os) { write_workbook_rels(_os, sheet_count); }));
+
+    tasks.push_back(std::make_unique<part_task>("xl/styles.xml", write_styles));
+
+    tasks.push_back(std::make_unique<part_task>(
+        "xl/sharedStrings.xml",
+        [&cxt](std::ostream& _os) { write_shared_strings(_os, cxt); }));
+
+    for (size_t i = 0; i < sheet_count; ++i)
+    {
+        tasks.push_back(std::make_unique<part_task>(
+            "xl/" + to_sheet_part_name(i),
+            [&doc, &cxt, i](std::ostream& _os)
+            {
+                doc.page_in_sheet(i);
+                write_sheet(_os, cxt, i);
+            }));
+    }
+
+    std::atomic<size_t> next_task(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next_task++; i < tasks.size(); i = next_task++)
+        {
+            try
+            {
+                tasks[i]->func(tasks[i]->entry.get_stream());
+                tasks[i]->entry.finish();
+            }
+            catch (...)
+            {
+                tasks[i]->error = std::current_exception();
+            }
+        }
+    };
+
+    if (thread_count <= 1)
+        worker();
+    else
+    {
+        std::vector<orcus::detail::thread::scoped_guard> threads;
+        size_t n = std::min(thread_count, tasks.size());
+        threads.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            threads.emplace_back(std::thread(worker));
+    }
+
+    zip_archive_writer archive(os);
+
+    for (std::unique_ptr<part_task>& task : tasks)
+    {
+        if (task->error)
+            std::rethrow_exception(task->error);
+
+        archive.add_file_entry(task->entry);
+    }
+
+    archive.close();
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
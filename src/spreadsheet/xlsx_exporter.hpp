@@ -0,0 +1,45 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCLUDED_ORCUS_SPREADSHEET_XLSX_EXPORTER_HPP
+#define INCLUDED_ORCUS_SPREADSHEET_XLSX_EXPORTER_HPP
+
+#include <ostream>
+
+namespace orcus { namespace spreadsheet {
+
+class document;
+
+namespace detail {
+
+/**
+ * Writes the content of a document as an Excel 2007 XML workbook.  The
+ * shared strings and the sheets are written by separate tasks which stream
+ * their parts through their own deflaters, and the compressed parts then
+ * get added to the package in order.
+ */
+class xlsx_exporter
+{
+    const document& m_doc;
+
+public:
+    xlsx_exporter(const document& doc);
+
+    /**
+     * Write the workbook package.
+     *
+     * @param os stream to write the package to.
+     * @param thread_count maximum number of threads to write the parts with.
+     */
+    void write(std::ostream& os, size_t thread_count) const;
+};
+
+}}}
+
+#endif
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */